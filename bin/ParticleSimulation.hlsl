@@ -34,6 +34,9 @@ void IntegrateCS(uint3 DispatchThreadID : SV_DispatchThreadID)
 
 	// Particle ID to operate on
 	const unsigned int P_ID = DispatchThreadID.x;
+	// the last group of the dispatch is partial
+	if (P_ID >= numParticles)
+		return;
 	// Particle p = CurrentSimulationState.Consume();
 
 	// retrieve positions from particle
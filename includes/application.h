@@ -3,10 +3,21 @@
 // EXTERNAL INCLUDES
 // INTERNAL INCLUDES
 #include "math/vec2.h"
-#include "particlerenderer.h"
 #include "types.h"
 
+class FrameGovernor;
+class MetricsRegistry;
+class MetricsServer;
+class ParticleRenderer;
+class ParticleSimulation;
+class Presenter;
+class SharedStateWriter;
+class SimulationThread;
+class StreamServer;
+class ThreadPool;
 class Window;
+struct SimulationSnapshot;
+template <class T> class TripleBuffer;
 
 /**
  * @brief	This is the main application class
@@ -25,15 +36,23 @@ public:
 		Stopped		/**< defines the applications stopped state */
 	};
 
+	Application();
 	~Application();
 
 	/**
 	 * @brief 	This method starts and initializes the application
 	 * 			It creates a window and a D3D11 renderer.
+	 * 			Without Windows it runs headless with a NullPresenter.
 	 * @param	title is the title of the window
 	 * @param	resolution is the resolution of the window
+	 * @param	maxRunTime is the time in seconds after which the game loop stops (0 runs until the window is closed)
+	 * @param	metricsPort is the local port the metrics are served on (0 doesn't serve them)
+	 * @param	pSharedStateName is the name of the shared memory ring every state is published to (nullptr doesn't publish them)
+	 * @param	streamPort is the port every state is streamed to remote viewers on (0 doesn't stream them)
+	 * @param	adaptiveTimestep picks the timestep of every step from an error estimate instead of the fixed 1/60 s
 	 */
-	void Init(const char* title, Math::Vec2 resolution = { 800, 600 });
+	void Init(const char* title, Math::Vec2 resolution = { 800, 600 }, float maxRunTime = 0.0f, uint16 metricsPort = 0, const char* pSharedStateName = nullptr,
+		uint16 streamPort = 0, bool adaptiveTimestep = false);
 	/**
 	 * @brief	This method contains the main update loop of the application.
 	 * 			Call this after you called the Init function.
@@ -52,5 +71,21 @@ private:
 	Window* window;
 	State appstate;
 	ParticleRenderer* renderer;
+	Presenter* presenter;
+	float maxRunTime;
+	bool adaptiveTimestep;
+
+	ThreadPool* threadPool;
+	ParticleSimulation* simulation;
+	SimulationThread* simulationThread;
+	TripleBuffer<SimulationSnapshot>* snapshots;
+	FrameGovernor* governor;
+
+	uint16 metricsPort;
+	MetricsRegistry* metrics;
+	MetricsServer* metricsServer;
+
+	SharedStateWriter* sharedState;
+	StreamServer* streamServer;
 
 };
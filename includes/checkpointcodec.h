@@ -0,0 +1,124 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+class ThreadPool;
+
+/**
+ * @brief	This namespace defines the lossless format of checkpoints
+ * 			The data is split into chunks that are coded independently, so
+ * 			they are compressed and decompressed in parallel. Every chunk is
+ * 			read as an array of elements (e.g. particles):
+ * 			1. the bytes are XORed with the bytes of the previous checkpoint (if it
+ * 			   is relative), equal bits of a value that barely moved become zeros
+ * 			2. the elements are shuffled into one plane per byte of an element, so
+ * 			   the same byte of the same field of all elements lie next to each other
+ * 			   (the sign and exponent bytes of a float rarely differ)
+ * 			3. the planes are compressed with an LZ77 coder (LZ4 style sequences)
+ * 			A chunk that doesn't shrink is stored after step 2.
+ */
+namespace CheckpointCodec
+{
+	constexpr uint32 magic = 0x504B4350;		/**< "PCKP" */
+	constexpr uint16 version = 1;
+	constexpr uint32 chunkSize = 256 * 1024;	/**< the bytes of a chunk (rounded down to whole elements) */
+	constexpr uint32 storedChunk = 1u << 31;	/**< set in the size of a chunk that isn't LZ compressed */
+
+	/**
+	 * @brief	This struct defines the start of a checkpoint
+	 * 			It is followed by the size of every chunk (uint32) and the chunks.
+	 */
+	struct Header
+	{
+		uint32 magic;
+		uint16 version;
+		uint8 isRelative;	/**< the data was XORed with the previous checkpoint */
+		uint8 reserved;
+		uint32 elementSize;
+		uint32 chunkSize;
+		uint32 numChunks;
+		uint64 size;		/**< the size of the uncompressed data */
+	};
+}
+
+/**
+ * @brief	This class compresses checkpoints
+ * 			It remembers the data of the last checkpoint as the reference
+ * 			of the next relative one.
+ */
+class CheckpointEncoder
+{
+public:
+
+	/**
+	 * @brief	Construct a new CheckpointEncoder object
+	 * @param	pThreadPool is the pool the chunks are compressed on (nullptr compresses them on the calling thread)
+	 */
+	CheckpointEncoder(ThreadPool* pThreadPool = nullptr);
+
+	/**
+	 * @brief	This method compresses a checkpoint
+	 * @param	pData is the data
+	 * @param	size is the size of the data in bytes
+	 * @param	elementSize is the size of an element of the data in bytes (e.g. sizeof(ParticleSimulation::Particle))
+	 * @param	relative codes the data relative to the last checkpoint (ignored if its size differs)
+	 * @param	checkpoint is the returned checkpoint (it is overwritten)
+	 */
+	void Encode(const void* pData, size_t size, uint elementSize, bool relative, std::vector<byte>& checkpoint);
+	/**
+	 * @brief	This method forgets the last checkpoint, so the next one is independent
+	 */
+	void Reset(void);
+
+private:
+
+	/**
+	 * @brief	This struct defines the buffers of one thread
+	 */
+	struct Scratch
+	{
+		std::vector<byte> planes;		/**< the shuffled elements of the current chunk */
+		std::vector<uint32> hashTable;	/**< the last position of every hashed four byte sequence */
+	};
+
+	ThreadPool* pThreadPool;
+	std::vector<byte> reference;
+	std::vector<std::vector<byte>> chunks;	/**< the compressed chunks of the current checkpoint */
+	std::vector<Scratch> scratch;
+
+};
+
+/**
+ * @brief	This class decompresses checkpoints
+ * 			Relative checkpoints have to be decoded in the order they were encoded.
+ */
+class CheckpointDecoder
+{
+public:
+
+	/**
+	 * @brief	Construct a new CheckpointDecoder object
+	 * @param	pThreadPool is the pool the chunks are decompressed on (nullptr decompresses them on the calling thread)
+	 */
+	CheckpointDecoder(ThreadPool* pThreadPool = nullptr);
+
+	/**
+	 * @brief	This method decompresses a checkpoint
+	 * @param	pCheckpoint is the checkpoint
+	 * @param	size is the size of the checkpoint in bytes
+	 * @param	data is the returned data (it is overwritten)
+	 * @return	false if the checkpoint is broken or its reference is missing
+	 */
+	bool Decode(const byte* pCheckpoint, size_t size, std::vector<byte>& data);
+
+private:
+
+	ThreadPool* pThreadPool;
+	std::vector<byte> reference;
+	std::vector<std::vector<byte>> planes;	/**< the shuffled elements of the chunk of every thread */
+
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the checkpoint codec on real simulation states
+ */
+namespace CheckpointStudy
+{
+	/**
+	 * @brief	This method simulates particles and compresses a checkpoint of them at a fixed interval
+	 * 			It prints the compression ratio and the throughput of independent and
+	 * 			relative checkpoints next to the time writing the raw bytes takes.
+	 * @param	numParticles is the number of simulated particles
+	 * @param	numSteps is the number of simulated steps
+	 * @param	interval is the number of steps between two checkpoints
+	 * @return	false if a checkpoint didn't decompress to the state it was made of
+	 */
+	bool Run(size_t numParticles, uint numSteps, uint interval);
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "threadpool.h"
+#include "types.h"
+
+/**
+ * @brief	This namespace executes compute kernels on the CPU with the semantics of D3D11 compute shaders
+ * 			A kernel is a functor that is called once per thread of a group with the
+ * 			system values of that thread. Barriers (GroupMemoryBarrierWithGroupSync) split
+ * 			a kernel into phases: all threads of a group finish a phase before any thread
+ * 			starts the next one. A group runs on one thread of the pool, so its phases are
+ * 			plain loops over its threads and the group shared memory stays in the cache.
+ * 			Values a thread keeps across a barrier live in its ThreadPrivate struct.
+ * 			The buffers check every access like a D3D11 structured buffer: reads outside
+ * 			the buffer return zeros, writes outside the buffer are dropped and both are counted.
+ */
+namespace Compute
+{
+	constexpr uint maxGroupsPerDimension = 65535;	/**< D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION */
+	constexpr uint maxThreadsPerGroup = 1024;		/**< D3D11_CS_THREAD_GROUP_MAX_THREADS_PER_GROUP */
+	constexpr uint maxThreadsZ = 64;				/**< D3D11_CS_THREAD_GROUP_MAX_Z */
+
+	/**
+	 * @brief	This struct defines a uint3 of HLSL
+	 */
+	struct UInt3
+	{
+		uint x;
+		uint y;
+		uint z;
+	};
+
+	/**
+	 * @brief	This struct defines the system values of a thread
+	 */
+	struct ThreadContext
+	{
+		UInt3 groupID;			/**< SV_GroupID */
+		UInt3 groupThreadID;	/**< SV_GroupThreadID */
+		UInt3 dispatchThreadID;	/**< SV_DispatchThreadID */
+		uint groupIndex;		/**< SV_GroupIndex (the flattened SV_GroupThreadID) */
+	};
+
+	/**
+	 * @brief	This struct is the base of every kernel
+	 * 			A kernel hides the members it needs and implements
+	 * 			void operator()(uint phase, const ThreadContext&, GroupShared&, ThreadPrivate&) const.
+	 * @tparam	X, Y and Z are the numthreads of the kernel
+	 */
+	template <uint X, uint Y = 1, uint Z = 1>
+	struct Kernel
+	{
+		static_assert(X > 0 && Y > 0 && Z > 0 && Z <= maxThreadsZ && X * Y * Z <= maxThreadsPerGroup, "numthreads exceeds the limits of D3D11");
+
+		static constexpr UInt3 numThreads = { X, Y, Z };
+		static constexpr uint numPhases = 1;	/**< the number of barriers + 1 */
+
+		struct GroupShared {};		/**< the groupshared variables (not initialized, like on the GPU) */
+		struct ThreadPrivate {};	/**< the variables a thread keeps across barriers */
+	};
+
+	/**
+	 * @brief	This method calculates the number of groups that cover a number of threads
+	 * @param	numThreads is the number of threads that are needed
+	 * @param	groupSize is the number of threads of a group along the dimension
+	 * @return	uint is the number of groups (the last one may be partial, the kernel has to check its ids)
+	 */
+	inline uint NumGroups(size_t numThreads, uint groupSize)
+	{
+		return static_cast<uint>((numThreads + groupSize - 1) / groupSize);
+	}
+
+	/**
+	 * @brief	This class defines a RWStructuredBuffer
+	 * 			It is a view of memory it doesn't own.
+	 */
+	template <class T>
+	class StructuredBuffer
+	{
+	public:
+
+		StructuredBuffer(T* pData, size_t numElements) :
+			pData(pData),
+			numElements(numElements),
+			numOutOfBounds(0)
+		{
+
+		}
+
+		T& operator[](size_t index)
+		{
+			return (index < this->numElements) ? this->pData[index] : this->OutOfBounds();
+		}
+
+		size_t GetNumElements(void) const
+		{
+			return this->numElements;
+		}
+		uint64 GetNumOutOfBounds(void) const
+		{
+			return this->numOutOfBounds.load(std::memory_order_relaxed);
+		}
+		void ResetNumOutOfBounds(void)
+		{
+			this->numOutOfBounds.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+
+		/**
+		 * @brief	This method counts an access outside the buffer
+		 * @return	T& is a zeroed element, what is written into it is lost
+		 */
+		T& OutOfBounds(void)
+		{
+			static thread_local T outOfBounds;
+			outOfBounds = T();
+			this->numOutOfBounds.fetch_add(1, std::memory_order_relaxed);
+
+			return outOfBounds;
+		}
+
+		T* pData;
+		size_t numElements;
+		std::atomic<uint64> numOutOfBounds;
+
+	};
+
+	/**
+	 * @brief	This class defines an AppendStructuredBuffer and a ConsumeStructuredBuffer
+	 * 			Both share the hidden counter of the UAV. Appending to a full buffer and
+	 * 			consuming from an empty one are counted and have no effect (a consume
+	 * 			returns a zeroed element). The order of the appended elements is undefined.
+	 */
+	template <class T>
+	class AppendConsumeBuffer
+	{
+	public:
+
+		AppendConsumeBuffer(T* pData, size_t capacity, uint initialCount = 0) :
+			pData(pData),
+			capacity(capacity),
+			count(initialCount),
+			numOutOfBounds(0)
+		{
+
+		}
+
+		void Append(const T& element)
+		{
+			uint index = this->count.fetch_add(1, std::memory_order_relaxed);
+			if (index < this->capacity)
+			{
+				this->pData[index] = element;
+				return;
+			}
+
+			this->count.fetch_sub(1, std::memory_order_relaxed);
+			this->numOutOfBounds.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		T Consume(void)
+		{
+			uint count = this->count.load(std::memory_order_relaxed);
+			while (count > 0)
+			{
+				if (this->count.compare_exchange_weak(count, count - 1, std::memory_order_relaxed))
+					return this->pData[count - 1];
+			}
+
+			this->numOutOfBounds.fetch_add(1, std::memory_order_relaxed);
+			return T();
+		}
+
+		/**
+		 * @brief	This method sets the hidden counter (the initial count of CSSetUnorderedAccessViews)
+		 * @param	count is the number of valid elements
+		 */
+		void SetCount(uint count)
+		{
+			this->count.store(static_cast<uint>(std::min<size_t>(count, this->capacity)), std::memory_order_relaxed);
+		}
+
+		uint GetCount(void) const
+		{
+			return this->count.load(std::memory_order_relaxed);
+		}
+		size_t GetCapacity(void) const
+		{
+			return this->capacity;
+		}
+		uint64 GetNumOutOfBounds(void) const
+		{
+			return this->numOutOfBounds.load(std::memory_order_relaxed);
+		}
+		void ResetNumOutOfBounds(void)
+		{
+			this->numOutOfBounds.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+
+		T* pData;
+		size_t capacity;
+		std::atomic<uint> count;
+		std::atomic<uint64> numOutOfBounds;
+
+	};
+
+	/**
+	 * @brief	This class dispatches kernels on a thread pool
+	 * 			The groups are split into one contiguous range per thread, every
+	 * 			thread reuses one GroupShared and one set of ThreadPrivate for all
+	 * 			of its groups.
+	 */
+	class Dispatcher
+	{
+	public:
+
+		/**
+		 * @brief	Construct a new Dispatcher object
+		 * @param	pThreadPool is the pool the groups run on (nullptr runs them on the calling thread)
+		 */
+		Dispatcher(ThreadPool* pThreadPool = nullptr);
+
+		/**
+		 * @brief	This method runs a kernel like ID3D11DeviceContext::Dispatch
+		 * @tparam	KernelT is the kernel (derived from Kernel)
+		 * @param	kernel is the kernel with its resources
+		 * @param	numGroupsX is the number of groups along x
+		 * @param	numGroupsY is the number of groups along y
+		 * @param	numGroupsZ is the number of groups along z
+		 * @return	false if the group counts exceed the limits of D3D11 (nothing runs then, like on the GPU)
+		 */
+		template <class KernelT>
+		bool Dispatch(const KernelT& kernel, uint numGroupsX, uint numGroupsY = 1, uint numGroupsZ = 1)
+		{
+			if (!ValidateDispatch(numGroupsX, numGroupsY, numGroupsZ))
+				return false;
+
+			constexpr UInt3 numThreads = KernelT::numThreads;
+			constexpr uint numGroupThreads = numThreads.x * numThreads.y * numThreads.z;
+			const size_t numGroups = static_cast<size_t>(numGroupsX) * numGroupsY * numGroupsZ;
+
+			auto run = [&](size_t begin, size_t end, uint) {
+				typename KernelT::GroupShared shared;
+				std::unique_ptr<typename KernelT::ThreadPrivate[]> pPrivates(new typename KernelT::ThreadPrivate[numGroupThreads]);
+
+				for (size_t group = begin; group < end; group++)
+				{
+					ThreadContext context;
+					context.groupID.x = static_cast<uint>(group % numGroupsX);
+					context.groupID.y = static_cast<uint>((group / numGroupsX) % numGroupsY);
+					context.groupID.z = static_cast<uint>(group / (static_cast<size_t>(numGroupsX) * numGroupsY));
+
+					// a barrier is the end of a loop over all threads of the group
+					for (uint phase = 0; phase < KernelT::numPhases; phase++)
+					{
+						context.groupIndex = 0;
+
+						for (uint z = 0; z < numThreads.z; z++)
+						{
+							context.groupThreadID.z = z;
+							context.dispatchThreadID.z = context.groupID.z * numThreads.z + z;
+
+							for (uint y = 0; y < numThreads.y; y++)
+							{
+								context.groupThreadID.y = y;
+								context.dispatchThreadID.y = context.groupID.y * numThreads.y + y;
+
+								for (uint x = 0; x < numThreads.x; x++, context.groupIndex++)
+								{
+									context.groupThreadID.x = x;
+									context.dispatchThreadID.x = context.groupID.x * numThreads.x + x;
+
+									kernel(phase, context, shared, pPrivates[context.groupIndex]);
+								}
+							}
+						}
+					}
+				}
+			};
+
+			if (this->pThreadPool)
+				this->pThreadPool->ParallelFor(numGroups, run);
+			else
+				run(0, numGroups, 0);
+
+			this->numGroups += numGroups;
+			this->numThreads += numGroups * numGroupThreads;
+			return true;
+		}
+
+		uint64 GetNumGroups(void) const;
+		uint64 GetNumThreads(void) const;
+
+	private:
+
+		/**
+		 * @brief	This method checks the group counts of a dispatch
+		 * @return	false if a count exceeds maxGroupsPerDimension
+		 */
+		static bool ValidateDispatch(uint numGroupsX, uint numGroupsY, uint numGroupsZ);
+
+		ThreadPool* pThreadPool;
+		uint64 numGroups;		/**< the groups of all dispatches */
+		uint64 numThreads;		/**< the threads of all dispatches */
+
+	};
+}
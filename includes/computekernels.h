@@ -0,0 +1,80 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <cmath>
+// INTERNAL INCLUDES
+#include "computedispatch.h"
+#include "math/vec2.h"
+#include "particlesimulation.h"
+
+/**
+ * @brief	This namespace contains the compute shaders ported to Compute kernels
+ * 			Every kernel has the numthreads, the resources and the arithmetic of its
+ * 			HLSL counterpart in bin/, so dispatch sizes and kernel logic can be checked
+ * 			without a GPU. A change to a shader has to be made here as well.
+ */
+namespace ComputeKernels
+{
+	typedef ParticleSimulation::Particle Particle;
+
+	/**
+	 * @brief	This is IntegrateCS of ParticleSimulation.hlsl
+	 * 			The last group of a dispatch is partial, its surplus threads return.
+	 */
+	struct Integrate : Compute::Kernel<64>
+	{
+		Compute::StructuredBuffer<Particle>* pCurrentSimulationState;	/**< u0 */
+		ParticleSimulation::SimulationConstants constants;				/**< b0 */
+
+		void operator()(uint /*phase*/, const Compute::ThreadContext& context, GroupShared& /*shared*/, ThreadPrivate& /*local*/) const
+		{
+			if (context.dispatchThreadID.x >= this->constants.numParticles)
+				return;
+
+			this->IntegrateParticle(context.dispatchThreadID.x);
+		}
+
+		/**
+		 * @brief	This method is the body of the shader without the check of the particle id
+		 * @param	id is the particle id (SV_DispatchThreadID.x)
+		 */
+		void IntegrateParticle(uint id) const
+		{
+			Compute::StructuredBuffer<Particle>& currentSimulationState = *this->pCurrentSimulationState;
+			const ParticleSimulation::SimulationConstants& c = this->constants;
+
+			Math::Vec2 prevPosition = currentSimulationState[id].position;
+			Math::Vec2 position = currentSimulationState[id].nextPosition;
+
+			Math::Vec2 vecDist = c.gravitySource - position;
+			Math::Vec2 deltaPos = position - prevPosition;
+			float vecDist2 = vecDist.x * vecDist.x + vecDist.y * vecDist.y;
+
+			// normalize(vecDist) * step(0.000001, vecDist2), without the NaN of normalizing a zero vector
+			Math::Vec2 acceleration = (vecDist2 >= 0.000001f) ? vecDist * (c.gravityStrength / sqrtf(vecDist2)) : Math::Vec2::zero;
+
+			currentSimulationState[id].position = position;
+			currentSimulationState[id].nextPosition = position + (deltaPos * c.timestep / c.lastTimestep + (acceleration * (c.timestep + c.lastTimestep) * c.timestep * 0.5f)) * c.damping;
+		}
+	};
+
+	/**
+	 * @brief	This is CreateParticleCS of ParticleCreation.hlsl
+	 * 			Every thread appends one particle at the emitter.
+	 */
+	struct CreateParticle : Compute::Kernel<8>
+	{
+		Compute::AppendConsumeBuffer<Particle>* pCurrentSimulationState;	/**< u0 */
+		Math::Vec2 emitterLocation;											/**< EmitterLocation.xy */
+
+		void operator()(uint /*phase*/, const Compute::ThreadContext& /*context*/, GroupShared& /*shared*/, ThreadPrivate& /*local*/) const
+		{
+			Particle particle;
+			particle.position = this->emitterLocation;
+			particle.prevPosition = this->emitterLocation;
+			particle.nextPosition = this->emitterLocation;
+
+			this->pCurrentSimulationState->Append(particle);
+		}
+	};
+}
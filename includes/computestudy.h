@@ -0,0 +1,25 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace runs the compute shaders on the CPU dispatcher
+ */
+namespace ComputeStudy
+{
+	/**
+	 * @brief	This method checks the dispatch sizes and the kernels and prints their throughput
+	 * 			IntegrateCS is dispatched with one group per particle (as UpdateParticles did),
+	 * 			with one thread per particle without the check of the particle id and as it
+	 * 			is now. Its results are compared with the CPU integration. A groupshared
+	 * 			reduction with barriers and CreateParticleCS check the group scheduling
+	 * 			and the append buffers.
+	 * @param	numParticles is the number of particles
+	 * @param	numSteps is the number of measured steps
+	 * @return	false if a kernel touched memory outside its buffers or got a wrong result
+	 */
+	bool Run(size_t numParticles, uint numSteps);
+}
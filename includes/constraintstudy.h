@@ -0,0 +1,27 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the distance constraint solvers on a cloth
+ * 			The cloth is a square grid of particles, every particle is tied to its
+ * 			horizontal, vertical and diagonal neighbours (about four constraints per particle).
+ */
+namespace ConstraintStudy
+{
+	/**
+	 * @brief	This method prints the convergence and the throughput of Gauss-Seidel and Jacobi
+	 * 			The convergence is measured on a cloth whose particles are jittered off the grid,
+	 * 			the throughput in constraints per second, and finally the cloth is stepped in a
+	 * 			ParticleWorld with the constraints solved after every step.
+	 * @param	numParticles is the number of particles of the cloth (rounded down to a square)
+	 * @param	numIterations is the number of iterations of the throughput measurement and of every step
+	 * @param	numSteps is the number of steps in the world
+	 * @return	false if Gauss-Seidel depends on the number of threads, doesn't converge or
+	 * 			doesn't keep the cloth in the world twice as close to its rest lengths as no constraints
+	 */
+	bool Run(size_t numParticles, uint numIterations, uint numSteps);
+}
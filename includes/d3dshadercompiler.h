@@ -0,0 +1,31 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "shadercompiler.h"
+#include "types.h"
+
+/**
+ * @brief	This class compiles shaders with the D3D shader compiler
+ */
+class D3DShaderCompiler : public ShaderCompiler
+{
+public:
+
+	/**
+	 * @brief	Construct a new D3DShaderCompiler object
+	 */
+	D3DShaderCompiler();
+
+	const char* GetVersion(void) const override;
+	/**
+	 * @brief	This method compiles shader source text with D3DCompile
+	 * 			Errors and warnings of the compiler are logged.
+	 */
+	bool Compile(const std::string& source, const char* pFileName, const char* pEntryPoint, const char* pShaderModel, uint32 flags, std::vector<byte>& bytecode) override;
+
+private:
+
+	char version[32];
+
+};
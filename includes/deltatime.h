@@ -26,4 +26,11 @@ namespace Time
 	 * @param	is the time struct containing the new delta time 
 	 */
 	void GetDetlaTime(Time &time);
+
+	/**
+	 * @brief	This method returns the current time of a monotonic clock
+	 * 			It is used to timestamp events across threads.
+	 * @return	uint64 is the current time in microseconds
+	 */
+	uint64 Now(void);
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the cost of the per-step diagnostics
+ */
+namespace DiagnosticsStudy
+{
+	/**
+	 * @brief	This method prints the cost of a step with and without the diagnostics
+	 * 			Position Verlet derives the velocities of the diagnostics from the positions,
+	 * 			velocity Verlet keeps them. Every run is measured a few times, the fastest counts.
+	 * @param	numParticles is the number of simulated particles
+	 * @param	numSteps is the number of measured steps
+	 * @return	false if the diagnostics aren't finite or the speed histogram misses particles
+	 */
+	bool Run(size_t numParticles, uint numSteps);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares the 2D and the 3D instantiation of the simulation
+ */
+namespace DimensionStudy
+{
+	/**
+	 * @brief	This method steps a 2D and a 3D ParticleWorld with the same particles and prints their throughput
+	 * 			Both worlds hold one system that starts on a grid around its attractor.
+	 * @param	numParticles is the number of particles of both worlds
+	 * @param	numSteps is the number of measured steps of every run
+	 */
+	void Run(size_t numParticles, uint numSteps);
+}
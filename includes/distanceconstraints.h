@@ -0,0 +1,160 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "math/vec3.h"
+#include "particle.h"
+#include "types.h"
+
+class ThreadPool;
+
+/**
+ * @brief	This class keeps pairs of particles at a distance (position based dynamics)
+ * 			The constraints move the current positions ("nextPosition") of the particles
+ * 			after an integration step, the position Verlet turns the correction into a
+ * 			velocity on its own. All particles have unit mass.
+ * 			Gauss-Seidel solves the constraints one after another, so every constraint sees
+ * 			the corrections of the ones before it. The particles are split into blocks by their
+ * 			index: the constraints within a block are solved in the order they were added, so an
+ * 			iteration carries a correction across the whole block, and the blocks in parallel.
+ * 			The constraints between blocks are coloured such that no two constraints of a colour
+ * 			share a particle: they are solved in parallel without atomics after the blocks, the
+ * 			colours one after another. The result doesn't depend on the number of threads. Jacobi solves all constraints
+ * 			from the same positions and averages the corrections of every particle instead,
+ * 			it needs no colouring but converges slower.
+ * @tparam	Vector is the vector of the positions (Math::Vec2 or Math::Vec3)
+ */
+template <class Vector>
+class BasicDistanceConstraints
+{
+public:
+
+	typedef BasicParticle<Vector> Particle;
+
+	static constexpr uint maxColours = 64; /**< constraints that don't fit into a colour are solved on one thread after the colours */
+	static constexpr uint32 numBlockParticles = 16384; /**< the particles of a block whose constraints are solved in order on one thread */
+
+	/**
+	 * @brief	SolverMethod defines how the constraints are solved
+	 */
+	enum SolverMethod
+	{
+		GaussSeidel,	/**< coloured Gauss-Seidel, the colours are solved one after another (default) */
+		Jacobi			/**< every particle moves by the average correction of its constraints */
+	};
+
+	/**
+	 * @brief	This struct defines the distance between two particles
+	 */
+	struct Constraint
+	{
+		uint32 particleA;	/**< the index of the first particle */
+		uint32 particleB;	/**< the index of the second particle */
+		float restLength;	/**< the distance the particles are kept at */
+		float stiffness;	/**< the fraction of the error an iteration removes (0 to 1) */
+	};
+
+	/**
+	 * @brief	Construct a new BasicDistanceConstraints object
+	 * @param	pThreadPool is the pool the constraints are solved on (nullptr solves them on the calling thread)
+	 */
+	BasicDistanceConstraints(ThreadPool* pThreadPool = nullptr);
+
+	/**
+	 * @brief	This method adds a constraint
+	 * 			The colouring is recomputed on the next Solve.
+	 * @param	particleA is the index of the first particle
+	 * @param	particleB is the index of the second particle (not particleA)
+	 * @param	restLength is the distance the particles are kept at
+	 * @param	stiffness is the fraction of the error an iteration removes (0 to 1)
+	 */
+	void Add(uint32 particleA, uint32 particleB, float restLength, float stiffness = 1.0f);
+	/**
+	 * @brief	This method removes all constraints
+	 */
+	void Clear(void);
+
+	/**
+	 * @brief	This method selects how the following Solve calls work
+	 * @param	method is the solver to be used
+	 * @param	relaxation scales the averaged Jacobi corrections (1 to 2, unused by Gauss-Seidel)
+	 */
+	void SetSolverMethod(SolverMethod method, float relaxation = 1.0f);
+
+	/**
+	 * @brief	This method moves the particles towards their rest lengths
+	 * @param	pParticles are the particles the constraints refer to (by their index)
+	 * @param	numParticles is the number of particles (every constraint has to refer to one of them)
+	 * @param	numIterations is the number of passes over all constraints
+	 */
+	void Solve(Particle* pParticles, size_t numParticles, uint numIterations);
+	/**
+	 * @brief	This method measures how far the constraints are violated
+	 * @param	pParticles are the particles the constraints refer to
+	 * @return	double is the root mean square of the relative errors |length - rest| / rest
+	 */
+	double MeasureError(const Particle* pParticles) const;
+
+	size_t GetNumConstraints(void) const;
+	SolverMethod GetSolverMethod(void) const;
+	/**
+	 * @brief	Retrieves the number of blocks of particles
+	 * @return	size_t is the number of blocks (0 until the first Gauss-Seidel Solve)
+	 */
+	size_t GetNumBlocks(void) const;
+	/**
+	 * @brief	Retrieves the number of colours the constraints between blocks are partitioned into
+	 * @return	uint is the number of colours (0 until the first Gauss-Seidel Solve)
+	 */
+	uint GetNumColours(void) const;
+	/**
+	 * @brief	Retrieves the number of constraints that didn't fit into a colour
+	 * @return	size_t is the number of constraints solved on one thread
+	 */
+	size_t GetNumSerialConstraints(void) const;
+	/**
+	 * @brief	Retrieves the time the last colouring took
+	 * @return	uint64 is the colouring time in microseconds
+	 */
+	uint64 GetColouringTime(void) const;
+	/**
+	 * @brief	Retrieves the number of single constraint projections since the construction
+	 * @return	uint64 is the number of solved constraints
+	 */
+	uint64 GetNumSolvedConstraints(void) const;
+
+private:
+
+	void Colour(void);
+	void BuildIncidences(void);
+	void SolveGaussSeidel(Particle* pParticles, uint numIterations);
+	void SolveJacobi(Particle* pParticles, uint numIterations);
+
+	ThreadPool* pThreadPool;
+	SolverMethod method;
+	float relaxation;
+	uint64 numSolvedConstraints;
+
+	std::vector<Constraint> constraints;	/**< in the order they were added */
+	size_t numReferencedParticles;			/**< the largest particle index of the constraints + 1 */
+
+	// gauss-seidel (the constraints sorted by block and colour)
+	bool isColoured;
+	uint64 colouringTime;
+	std::vector<Constraint> colouredConstraints;
+	std::vector<size_t> blockEnds;			/**< the constraint after the last of every block, the colours follow */
+	std::vector<size_t> colourEnds;			/**< the constraint after the last of every colour, the serial ones follow */
+
+	// jacobi (the constraints of every particle)
+	bool areIncidencesBuilt;
+	std::vector<uint32> incidenceStarts;	/**< the first incidence of every particle */
+	std::vector<uint32> incidences;			/**< the constraint index << 1, the low bit is set for particleB */
+	std::vector<Vector> corrections;		/**< the correction of particleA of every constraint */
+
+};
+
+typedef BasicDistanceConstraints<Math::Vec2> DistanceConstraints;
+typedef BasicDistanceConstraints<Math::Vec3> DistanceConstraints3D;
@@ -0,0 +1,117 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "types.h"
+
+/**
+ * @brief	This class holds the frame time within a budget by trading quality for time
+ * 			It watches the time of the stages of every frame and walks a ladder of quality
+ * 			levels: the block timesteps go first if the settings allow them (all at once,
+ * 			fewer time bins don't save time), then fewer states are presented if the settings allow it, then fewer
+ * 			particles are integrated. To keep it from oscillating the
+ * 			quality only drops after several frames over the budget and only rises again
+ * 			after many frames well below it, frames in between change nothing. A raised
+ * 			quality that soon drops again doubles the wait for the next raise.
+ */
+class FrameGovernor
+{
+public:
+
+	/**
+	 * @brief	Stage defines the stages of a frame the time is measured for
+	 */
+	enum Stage
+	{
+		Pump,		/**< the window messages */
+		Acquire,	/**< taking over the newest simulated state */
+		Simulate,	/**< the simulation step of that state (on its own thread, it overlaps the others) */
+		numStages
+	};
+
+	/**
+	 * @brief	This struct defines the quality of a level
+	 */
+	struct Quality
+	{
+		uint numTimeBins;			/**< the block timesteps of the simulation (0 is one step for all particles) */
+		size_t particleBudget;		/**< the number of particles that are integrated */
+		uint renderDecimation;		/**< only every n-th simulated state is presented */
+	};
+
+	/**
+	 * @brief	This struct defines the settings of the governor
+	 */
+	struct Settings
+	{
+		float targetFrameTime = Time::maxTimeStep;	/**< the budget of a frame in seconds */
+		float recoverThreshold = 0.7f;				/**< the fraction of the budget the frame time has to stay below to raise the quality */
+		uint numDegradeFrames = 5;					/**< the frames in a row over the budget that drop the quality (a shorter spike doesn't) */
+		uint numRecoverFrames = 30;					/**< the frames in a row below the recover threshold that raise the quality */
+		uint maxRecoverFrames = 480;				/**< the longest wait for a raise after raised qualities failed again */
+		float smoothing = 0.1f;						/**< the weight of a new frame time in the smoothed frame time */
+		uint maxTimeBins = 0;						/**< the block timesteps of the best quality (0 keeps them off the ladder: sorting the particles into their bins costs more than their substeps save) */
+		size_t numParticles = 0;					/**< the particles of the best quality */
+		uint numParticleHalvings = 2;				/**< the times the particle budget may be halved */
+		uint maxRenderDecimation = 1;				/**< the largest render decimation (a power of two, 1 keeps it off the ladder: a skipped state only saves its copy) */
+	};
+
+	/**
+	 * @brief	Construct a new FrameGovernor object
+	 * @param	settings are the budget, the hysteresis and the range of the quality
+	 */
+	FrameGovernor(const Settings& settings);
+
+	/**
+	 * @brief	This method adds the time of a stage to the current frame
+	 * @param	stage is the measured stage
+	 * @param	time is the time of the stage in microseconds
+	 */
+	void AddStageTime(Stage stage, uint64 time);
+	/**
+	 * @brief	This method ends the current frame and picks the quality of the next one
+	 * @return	const Quality& is the quality of the next frame
+	 */
+	const Quality& EndFrame(void);
+
+	const Quality& GetQuality(void) const;
+	uint GetLevel(void) const;
+	uint GetNumLevels(void) const;
+	uint64 GetNumFrames(void) const;
+	/**
+	 * @brief	Retrieves the number of frames that stayed within the budget
+	 * @return	uint64 is the number of frames within the budget
+	 */
+	uint64 GetNumFramesWithinBudget(void) const;
+	/**
+	 * @brief	Retrieves the number of times the quality changed
+	 * @return	uint64 is the number of level changes
+	 */
+	uint64 GetNumLevelChanges(void) const;
+	/**
+	 * @brief	Retrieves the smoothed time of the last frames
+	 * @return	float is the smoothed frame time in seconds
+	 */
+	float GetSmoothedFrameTime(void) const;
+	const Settings& GetSettings(void) const;
+
+private:
+
+	Settings settings;
+	std::vector<Quality> levels;	/**< the quality of every level, the best first */
+	uint level;
+	uint64 stageTimes[numStages];
+	float smoothedFrameTime;
+	uint numFramesAtLevel;
+	uint numFramesOverBudget;		/**< the frames in a row over the budget */
+	uint numFramesUnderThreshold;	/**< the frames in a row below the recover threshold */
+	uint numRecoverFrames;			/**< the current wait for a raise */
+	bool isTrialLevel;				/**< the quality was raised and hasn't held for a whole wait yet */
+	uint64 numFrames;
+	uint64 numFramesWithinBudget;
+	uint64 numLevelChanges;
+
+};
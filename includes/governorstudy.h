@@ -0,0 +1,27 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace runs the frame governor against a synthetic load
+ */
+namespace GovernorStudy
+{
+	/**
+	 * @brief	This method prints how often the frames stay within their budget with and without the governor
+	 * 			The cost of every quality level is measured on the simulation once, then the frames
+	 * 			of a load trace (calm, heavy, overloaded and noisy phases with short spikes) get the
+	 * 			cost of their level scaled by the load. The same trace runs at a fixed quality, with
+	 * 			a governor without hysteresis and with the default governor, on a virtual clock, next
+	 * 			to the ideal levels that know the load of every frame in advance.
+	 * @param	numParticles is the number of particles the levels are measured with
+	 * @param	numFrames is the number of frames of the trace
+	 * @return	false if the governor doesn't meet the budget more often than the fixed quality,
+	 * 			changes the quality at least as often as the governor without hysteresis or keeps
+	 * 			less than three quarters of the ideal frames at the best quality
+	 */
+	bool Run(size_t numParticles, uint numFrames);
+}
@@ -1,12 +1,130 @@
 #pragma once
 
 // EXTERNAL INCLUDES
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
 #include <stdint.h>
 // INTERNAL INCLUDES
 #include "math/vec2.h"
+#include "types.h"
 
-typedef void(*MouseClickedScreenSpaceCallback)(Math::Vec2 position); /**< callback for the left mouse button */
-typedef void(*LeftArrowPressedCallback)(void);  /**< callback for the left arrow */
-typedef void(*RightArrowPressedCallback)(void);  /**< callback for the right arrow */
-typedef void(*UpArrowPressedCallback)(void);  /**< callback for the up arrow */
-typedef void(*DownArrowPressedCallback)(void);  /**< callback for the down arrow */
+/**
+ * @brief	This struct defines a single input event
+ * 			It is produced by the window message pump and
+ * 			consumed by the simulation before the step (or the substep) it was received in
+ */
+struct InputEvent
+{
+	/**
+	 * @brief	Type defines the kind of input that was received
+	 */
+	enum Type : uint32
+	{
+		MouseClickedScreenSpace,	/**< the left mouse button was pressed (position is set) */
+		UpArrowPressed,				/**< the up arrow was pressed */
+		DownArrowPressed,			/**< the down arrow was pressed */
+		RightArrowPressed,			/**< the right arrow was pressed */
+		LeftArrowPressed			/**< the left arrow was pressed */
+	};
+
+	Type type;				/**< the kind of input that was received */
+	uint64 timestamp;		/**< the time the input was received (microseconds, see Time::Now) */
+	Math::Vec2 position;	/**< the screen space position of mouse events */
+};
+
+/**
+ * @brief	This class defines a bounded lock-free queue of input events
+ * 			Any number of threads may push events (e.g. the window message pump)
+ * 			but only one thread may pop them (the simulation).
+ * 			Events are popped in the order in which they were pushed, the
+ * 			pushes of several producers may interleave out of timestamp order.
+ * 			Drain hands them over in the order of their timestamps instead.
+ */
+class InputEventQueue
+{
+public:
+
+	static constexpr size_t capacity = 1024; /**< the maximum number of pending events (power of two) */
+
+	/**
+	 * @brief	Construct a new empty InputEventQueue object
+	 */
+	InputEventQueue();
+
+	/**
+	 * @brief	This method appends an event to the end of the queue
+	 * 			It never blocks and may be called from any thread.
+	 * @param	event is the event to be appended
+	 * @return	false if the queue is full and the event was dropped
+	 */
+	bool Push(const InputEvent& event);
+	/**
+	 * @brief	This method removes the oldest event from the queue
+	 * 			if it was received up to a given point in time.
+	 * 			Only the consuming thread may call this method.
+	 * @param	until is the latest timestamp that may be popped
+	 * @param	event is the returned event
+	 * @return	false if the queue is empty or the oldest event is newer than until
+	 */
+	bool Pop(uint64 until, InputEvent& event);
+
+	/**
+	 * @brief	This method hands all events that were received up to a given point in time
+	 * 			to a functor in the order of their timestamps. Newer events are held back,
+	 * 			so that they are applied in the simulation step they belong to, but they
+	 * 			don't hold back older events that were pushed after them by another producer.
+	 * 			Only the consuming thread may call this method (and not mix it with Pop).
+	 * @tparam	Fn is a callable with the signature void(const InputEvent&)
+	 * @param	until is the latest timestamp that is handed over (usually the end of the step)
+	 * @param	fn is the functor that is called for each event
+	 * @return	uint32 is the number of events that were applied
+	 */
+	template <class Fn>
+	uint32 Drain(uint64 until, Fn fn)
+	{
+		auto isEarlier = [](const InputEvent& lhs, const InputEvent& rhs) { return lhs.timestamp < rhs.timestamp; };
+
+		// take over everything that was pushed, the held back events stay sorted
+		const size_t numSortedEvents = this->numPendingEvents;
+		while (this->numPendingEvents < capacity && this->Pop(~0ull, this->pendingEvents[this->numPendingEvents]))
+			this->numPendingEvents++;
+
+		// equal timestamps keep the order of their pushes
+		if (this->numPendingEvents > numSortedEvents)
+		{
+			std::stable_sort(this->pendingEvents + numSortedEvents, this->pendingEvents + this->numPendingEvents, isEarlier);
+			std::inplace_merge(this->pendingEvents, this->pendingEvents + numSortedEvents, this->pendingEvents + this->numPendingEvents, isEarlier);
+		}
+
+		uint32 numEvents = 0;
+		while (numEvents < this->numPendingEvents && this->pendingEvents[numEvents].timestamp <= until)
+		{
+			fn(this->pendingEvents[numEvents]);
+			numEvents++;
+		}
+
+		std::move(this->pendingEvents + numEvents, this->pendingEvents + this->numPendingEvents, this->pendingEvents);
+		this->numPendingEvents -= numEvents;
+
+		return numEvents;
+	}
+
+private:
+
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		InputEvent event;
+	};
+
+	// the producers and the consumer work on separate cache lines
+	alignas(64) std::atomic<size_t> enqueuePos;
+	alignas(64) size_t dequeuePos;
+	alignas(64) Cell cells[capacity];
+
+	// the events the consumer popped but held back, sorted by their timestamps
+	InputEvent pendingEvents[capacity];
+	size_t numPendingEvents;
+
+};
@@ -0,0 +1,323 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <cmath>
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "math/vec3.h"
+#include "particle.h"
+
+/**
+ * @brief	This namespace contains the integrators of the CPU simulation
+ * 			Every integrator is a struct with a static Integrate method, the
+ * 			kernel is instantiated per integrator so the inner loop never dispatches.
+ * 			All integrators share the particle layout of IntegrateCS: after a step
+ * 			"position" holds the former and "nextPosition" the current position.
+ * 			Integrators that need a velocity keep it in a separate array.
+ * 			The integrators and the forces are templates on the vector of the positions,
+ * 			the dimension is fixed at compile time (Math::Vec2 or Math::Vec3).
+ */
+namespace Integrators
+{
+	typedef BasicParticle<Math::Vec2> Particle;
+
+	/**
+	 * @brief	This struct defines the constants of one integration step
+	 * @tparam	Vector is the vector of the positions
+	 */
+	template <class Vector>
+	struct BasicStepConstants
+	{
+		Vector gravitySource;		/**< the position of the attractor */
+		float gravityStrength;		/**< the magnitude of the acceleration towards the attractor */
+		float lastTimestep;			/**< the timestep of the previous step in seconds */
+		float timestep;				/**< the timestep of this step in seconds */
+		float damping;				/**< the damping factor of this step (already scaled to the timestep) */
+	};
+
+	typedef BasicStepConstants<Math::Vec2> StepConstants;
+
+	/**
+	 * @brief	This method calculates the acceleration at a position
+	 * 			It is the same constant magnitude pull as in IntegrateCS.
+	 * @param	position is the position the particle is at
+	 * @param	constants are the constants of the step
+	 * @return	Vector is the acceleration (zero inside the attractor itself)
+	 */
+	template <class Vector>
+	inline Vector Acceleration(const Vector& position, const BasicStepConstants<Vector>& constants)
+	{
+		Vector vecDist = constants.gravitySource - position;
+		float vecDist2 = Math::SquareLength(vecDist);
+
+		return (vecDist2 >= 0.000001f) ? vecDist * (constants.gravityStrength / sqrtf(vecDist2)) : Vector::zero;
+	}
+
+	/**
+	 * @brief	This is the time corrected position Verlet integration of IntegrateCS
+	 * 			It doesn't use the velocity. The positions are accumulated in plain floats,
+	 * 			every step rounds the new position and takes the displacement from rounded
+	 * 			positions, so the rounding error of long runs grows with the number of steps.
+	 */
+	struct FloatPositionVerlet
+	{
+		template <class Vector>
+		static void Integrate(BasicParticle<Vector>& particle, Vector& /*velocity*/, const BasicStepConstants<Vector>& constants)
+		{
+			Vector prevPosition = particle.position;
+			Vector position = particle.nextPosition;
+			Vector acceleration = Acceleration(position, constants);
+
+			float timestepRatio = constants.timestep / constants.lastTimestep;
+			float accelerationFactor = (constants.timestep + constants.lastTimestep) * constants.timestep * 0.5f;
+
+			particle.position = position;
+			particle.nextPosition = position + ((position - prevPosition) * timestepRatio + acceleration * accelerationFactor) * constants.damping;
+		}
+
+		template <class Vector>
+		static void Reset(BasicParticle<Vector>& /*particle*/, Vector& /*velocity*/) {}
+
+		/**
+		 * @brief	This method calculates the displacement of the last step
+		 */
+		template <class Vector>
+		static Vector Displacement(const BasicParticle<Vector>& particle, const Vector& /*velocity*/)
+		{
+			return particle.nextPosition - particle.position;
+		}
+	};
+
+	/**
+	 * @brief	This is the position Verlet integration with Kahan compensated positions
+	 * 			The rounding error of a stored position is carried to the next step instead
+	 * 			of being lost, the exact position is the stored one plus its error. The error of
+	 * 			"nextPosition" is kept in "prevPosition" (which the CPU simulation doesn't use
+	 * 			otherwise), the error of "position" in the velocity. The step is calculated in
+	 * 			doubles from the exact positions: with float arithmetic the rounding of the
+	 * 			acceleration alone lets the orbits drift after some ten thousand steps.
+	 * 			Reset has to be called whenever something else wrote the particle or the velocity.
+	 */
+	struct CompensatedPositionVerlet
+	{
+		template <class Vector>
+		static void Integrate(BasicParticle<Vector>& particle, Vector& velocity, const BasicStepConstants<Vector>& constants)
+		{
+			constexpr uint numDims = numDimensions<Vector>;
+			double prevPosition[numDims], position[numDims], dist[numDims];
+			double dist2 = 0.0;
+
+			for (uint d = 0; d < numDims; d++)
+			{
+				prevPosition[d] = static_cast<double>(Component(particle.position, d)) + Component(velocity, d);
+				position[d] = static_cast<double>(Component(particle.nextPosition, d)) + Component(particle.prevPosition, d);
+				dist[d] = static_cast<double>(Component(constants.gravitySource, d)) - position[d];
+				dist2 += dist[d] * dist[d];
+			}
+
+			// the same pull as Acceleration
+			double pull = (dist2 >= 0.000001) ? constants.gravityStrength / sqrt(dist2) : 0.0;
+
+			double timestep = constants.timestep, lastTimestep = constants.lastTimestep;
+			double timestepRatio = timestep / lastTimestep;
+			double accelerationFactor = (timestep + lastTimestep) * timestep * 0.5 * pull;
+
+			velocity = particle.prevPosition;
+			particle.position = particle.nextPosition;
+
+			// the stored position and what its rounding lost
+			for (uint d = 0; d < numDims; d++)
+			{
+				double nextPosition = position[d] + ((position[d] - prevPosition[d]) * timestepRatio + dist[d] * accelerationFactor) * constants.damping;
+				float storedPosition = static_cast<float>(nextPosition);
+
+				Component(particle.nextPosition, d) = storedPosition;
+				Component(particle.prevPosition, d) = static_cast<float>(nextPosition - storedPosition);
+			}
+		}
+
+		template <class Vector>
+		static void Reset(BasicParticle<Vector>& particle, Vector& velocity)
+		{
+			particle.prevPosition = Vector::zero;
+			velocity = Vector::zero;
+		}
+
+		/**
+		 * @brief	This method calculates the displacement of the last step between the exact positions
+		 */
+		template <class Vector>
+		static Vector Displacement(const BasicParticle<Vector>& particle, const Vector& velocity)
+		{
+			return (particle.nextPosition - particle.position) + (particle.prevPosition - velocity);
+		}
+	};
+
+	/**
+	 * @brief	This is the position Verlet integration calculated in doubles
+	 * 			The acceleration and the update are exact to double precision, but the
+	 * 			positions are still stored as floats and rounded every step, so it only
+	 * 			removes the error of the arithmetic, not the one of the accumulation.
+	 */
+	struct DoublePositionVerlet
+	{
+		template <class Vector>
+		static void Integrate(BasicParticle<Vector>& particle, Vector& /*velocity*/, const BasicStepConstants<Vector>& constants)
+		{
+			constexpr uint numDims = numDimensions<Vector>;
+			double prevPosition[numDims], position[numDims], dist[numDims];
+			double dist2 = 0.0;
+
+			for (uint d = 0; d < numDims; d++)
+			{
+				prevPosition[d] = Component(particle.position, d);
+				position[d] = Component(particle.nextPosition, d);
+				dist[d] = static_cast<double>(Component(constants.gravitySource, d)) - position[d];
+				dist2 += dist[d] * dist[d];
+			}
+
+			// the same pull as Acceleration
+			double pull = (dist2 >= 0.000001) ? constants.gravityStrength / sqrt(dist2) : 0.0;
+
+			double timestep = constants.timestep, lastTimestep = constants.lastTimestep;
+			double timestepRatio = timestep / lastTimestep;
+			double accelerationFactor = (timestep + lastTimestep) * timestep * 0.5 * pull;
+
+			particle.position = particle.nextPosition;
+			for (uint d = 0; d < numDims; d++)
+				Component(particle.nextPosition, d) = static_cast<float>(position[d] + ((position[d] - prevPosition[d]) * timestepRatio + dist[d] * accelerationFactor) * constants.damping);
+		}
+
+		template <class Vector>
+		static void Reset(BasicParticle<Vector>& /*particle*/, Vector& /*velocity*/) {}
+
+		/**
+		 * @brief	This method calculates the displacement of the last step
+		 */
+		template <class Vector>
+		static Vector Displacement(const BasicParticle<Vector>& particle, const Vector& /*velocity*/)
+		{
+			return particle.nextPosition - particle.position;
+		}
+	};
+
+	/**
+	 * @brief	This is the position Verlet integration the simulations use
+	 * 			The precision is chosen at compile time (the SIMULATION_PRECISION option),
+	 * 			the other variants stay available for comparisons.
+	 */
+#if defined(COMPENSATED_PRECISION)
+	typedef CompensatedPositionVerlet PositionVerlet;
+#elif defined(DOUBLE_PRECISION)
+	typedef DoublePositionVerlet PositionVerlet;
+#else
+	typedef FloatPositionVerlet PositionVerlet;
+#endif
+
+	/**
+	 * @brief	This is the velocity Verlet integration (kick, drift, kick)
+	 * 			The velocity is synchronized with the position.
+	 */
+	struct VelocityVerlet
+	{
+		template <class Vector>
+		static void Integrate(BasicParticle<Vector>& particle, Vector& velocity, const BasicStepConstants<Vector>& constants)
+		{
+			const float halfTimestep = constants.timestep * 0.5f;
+			Vector position = particle.nextPosition;
+
+			Vector halfVelocity = velocity + Acceleration(position, constants) * halfTimestep;
+			Vector nextPosition = position + halfVelocity * constants.timestep;
+
+			velocity = (halfVelocity + Acceleration(nextPosition, constants) * halfTimestep) * constants.damping;
+
+			particle.position = position;
+			particle.nextPosition = nextPosition;
+		}
+	};
+
+	/**
+	 * @brief	This is the leapfrog integration
+	 * 			The velocity is staggered by half a step, the kick spans
+	 * 			the mean of the last and the current timestep so that it
+	 * 			stays time symmetric with changing timesteps.
+	 */
+	struct Leapfrog
+	{
+		template <class Vector>
+		static void Integrate(BasicParticle<Vector>& particle, Vector& velocity, const BasicStepConstants<Vector>& constants)
+		{
+			const float kickTimestep = (constants.lastTimestep + constants.timestep) * 0.5f;
+			Vector position = particle.nextPosition;
+
+			velocity = (velocity + Acceleration(position, constants) * kickTimestep) * constants.damping;
+
+			particle.position = position;
+			particle.nextPosition = position + velocity * constants.timestep;
+		}
+	};
+
+	/**
+	 * @brief	This is the semi-implicit (symplectic) Euler integration
+	 * 			The position is advanced with the already updated velocity.
+	 */
+	struct SemiImplicitEuler
+	{
+		template <class Vector>
+		static void Integrate(BasicParticle<Vector>& particle, Vector& velocity, const BasicStepConstants<Vector>& constants)
+		{
+			Vector position = particle.nextPosition;
+
+			velocity = (velocity + Acceleration(position, constants) * constants.timestep) * constants.damping;
+
+			particle.position = position;
+			particle.nextPosition = position + velocity * constants.timestep;
+		}
+	};
+
+	/**
+	 * @brief	This is the classic fourth order Runge-Kutta integration
+	 * 			It evaluates the acceleration four times per step.
+	 */
+	struct RungeKutta4
+	{
+		template <class Vector>
+		static void Integrate(BasicParticle<Vector>& particle, Vector& velocity, const BasicStepConstants<Vector>& constants)
+		{
+			const float h = constants.timestep;
+			const float halfH = h * 0.5f;
+			Vector position = particle.nextPosition;
+
+			Vector k1x = velocity;
+			Vector k1v = Acceleration(position, constants);
+			Vector k2x = velocity + k1v * halfH;
+			Vector k2v = Acceleration(position + k1x * halfH, constants);
+			Vector k3x = velocity + k2v * halfH;
+			Vector k3v = Acceleration(position + k2x * halfH, constants);
+			Vector k4x = velocity + k3v * h;
+			Vector k4v = Acceleration(position + k3x * h, constants);
+
+			particle.position = position;
+			particle.nextPosition = position + (k1x + (k2x + k3x) * 2.0f + k4x) * (h / 6.0f);
+			velocity = (velocity + (k1v + (k2v + k3v) * 2.0f + k4v) * (h / 6.0f)) * constants.damping;
+		}
+	};
+
+	/**
+	 * @brief	This is the integration kernel
+	 * 			It is instantiated once per integrator and dimension.
+	 * @tparam	Integrator is one of the integrators above
+	 * @param	pParticles are the particles to be integrated
+	 * @param	pVelocities are the velocities of the particles
+	 * @param	begin is the first particle of the range
+	 * @param	end is the particle after the last particle of the range
+	 * @param	constants are the constants of the step
+	 */
+	template <class Integrator, class Vector>
+	void IntegrateRange(BasicParticle<Vector>* pParticles, Vector* pVelocities, size_t begin, size_t end, const BasicStepConstants<Vector>& constants)
+	{
+		for (size_t i = begin; i < end; i++)
+			Integrator::Integrate(pParticles[i], pVelocities[i], constants);
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares the integrators of the CPU simulation
+ */
+namespace IntegratorStudy
+{
+	/**
+	 * @brief	This method prints the cost and the accuracy of every integrator
+	 * 			The cost is measured on the simulation with the integrator selected. The accuracy
+	 * 			is measured on single orbits around the attractor without damping: the distance
+	 * 			to the analytic position of a circular orbit and the largest energy error of an
+	 * 			eccentric one, each at the timestep of the simulation and at a quarter of it.
+	 * 			Over many revolutions the rounding of the float positions outgrows the error
+	 * 			of the second order integrators at the shorter timestep. Rotated copies of the
+	 * 			circular orbit measure that rounding, the order is only fitted where both
+	 * 			distances are well above it.
+	 * @param	numParticles is the number of particles the cost is measured with
+	 * @param	numSteps is the number of measured steps of the simulation
+	 * @param	numOrbits is the number of revolutions of the circular orbit
+	 * @return	false if an integrator above the rounding doesn't get closer to the orbit with the shorter timestep
+	 */
+	bool Run(size_t numParticles, uint numSteps, uint numOrbits);
+}
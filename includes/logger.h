@@ -0,0 +1,249 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+// messages below this level are removed at compile time (0 = Info, 1 = Warning, 2 = Error)
+#if !defined(LOG_MIN_LEVEL)
+#if defined(_DEBUG)
+#define LOG_MIN_LEVEL 0
+#else
+#define LOG_MIN_LEVEL 1
+#endif
+#endif
+
+/**
+ * @brief	This class defines an asynchronous logger
+ * 			A call only copies the format string pointer and its arguments
+ * 			into a lock-free ring buffer of the calling thread, the messages
+ * 			are formatted and printed on a background thread. A full ring
+ * 			drops the message instead of waiting (the drops are reported).
+ * 			Format strings must be literals, string arguments are copied.
+ */
+class Logger
+{
+public:
+
+	/**
+	 * @brief	Level defines the severity of a message
+	 */
+	enum Level
+	{
+		Info,		/**< printed as [INFO] */
+		Warning,	/**< printed as [WARNING] with the source location */
+		Error		/**< printed as [ERROR] with the source location */
+	};
+
+	static constexpr size_t ringCapacity = 64 * 1024;	/**< the bytes of messages a thread may have in flight */
+	static constexpr size_t maxStringLength = 1023;		/**< string arguments are cut after this length */
+
+	/**
+	 * @brief	This method records a message
+	 * 			It never blocks and never formats on the calling thread.
+	 * @param	level is the severity of the message
+	 * @param	pFile is the source file of the call
+	 * @param	line is the source line of the call
+	 * @param	pFormat is the printf format string (must outlive the program, e.g. a literal)
+	 * @param	args are the arguments of the format string (arithmetic, pointers or strings)
+	 */
+	template <class... Args>
+	static void Write(Level level, const char* pFile, int line, const char* pFormat, const Args&... args)
+	{
+		if (level < GetLevel())
+			return;
+
+		Record record;
+		record.pFormatFn = &FormatRecord<typename ArgType<Args>::Type...>;
+		record.pFormat = pFormat;
+		record.pFile = pFile;
+		record.line = line;
+		record.level = level;
+		record.size = static_cast<uint32>(AlignedSize(sizeof(Record) + ArgsSize(args...)));
+
+		byte* pRecord = Get().Reserve(record.size);
+		if (!pRecord)
+			return;
+
+		memcpy(pRecord, &record, sizeof(Record));
+		WriteArgs(pRecord + sizeof(Record), args...);
+		Get().Commit(record.size);
+	}
+
+	/**
+	 * @brief	This method sets the lowest level that is recorded at runtime
+	 * 			Levels below LOG_MIN_LEVEL are removed at compile time anyway.
+	 * @param	level is the lowest recorded level
+	 */
+	static void SetLevel(Level level);
+	static Level GetLevel(void);
+
+	/**
+	 * @brief	This method waits until every recorded message is printed
+	 */
+	static void Flush(void);
+
+private:
+
+	typedef int (*FormatFn)(char* pBuffer, size_t size, const char* pFormat, const byte* pArgs);
+
+	/**
+	 * @brief	This struct defines the header of a recorded message
+	 * 			The serialized arguments follow it. A header without
+	 * 			format function pads the end of the ring.
+	 */
+	struct Record
+	{
+		uint32 size;
+		int32 line;
+		Level level;
+		FormatFn pFormatFn;
+		const char* pFormat;
+		const char* pFile;
+	};
+
+	/**
+	 * @brief	This struct defines the ring buffer of one thread
+	 * 			Only the owning thread writes and only the logger thread reads.
+	 */
+	struct Ring
+	{
+		alignas(64) std::atomic<size_t> head;	/**< written by the owning thread */
+		alignas(64) std::atomic<size_t> tail;	/**< written by the logger thread */
+		std::atomic<uint64> numDropped;
+		std::atomic<bool> isAbandoned;			/**< the owning thread exited */
+		alignas(64) byte buffer[ringCapacity];
+	};
+
+	// string arguments are stored inline, everything else by value
+	template <class T>
+	struct ArgType
+	{
+		typedef typename std::decay<T>::type Type;
+		static_assert(std::is_arithmetic<Type>::value || std::is_enum<Type>::value || std::is_pointer<Type>::value, "log arguments must be arithmetic, enums, pointers or strings");
+	};
+
+	template <class T>
+	static size_t ArgSize(const T&)
+	{
+		return sizeof(typename ArgType<T>::Type);
+	}
+	static size_t ArgSize(const char* pString)
+	{
+		return sizeof(uint16) + StringLength(pString) + 1;
+	}
+	static size_t ArgSize(char* pString)
+	{
+		return ArgSize(static_cast<const char*>(pString));
+	}
+
+	template <class T>
+	static byte* WriteArg(byte* pArgs, const T& arg)
+	{
+		typename ArgType<T>::Type value = arg;
+		memcpy(pArgs, &value, sizeof(value));
+		return pArgs + sizeof(value);
+	}
+	static byte* WriteArg(byte* pArgs, const char* pString)
+	{
+		uint16 length = static_cast<uint16>(StringLength(pString));
+		memcpy(pArgs, &length, sizeof(length));
+		memcpy(pArgs + sizeof(length), (pString) ? pString : "(null)", length);
+		pArgs[sizeof(length) + length] = '\0';
+		return pArgs + sizeof(length) + length + 1;
+	}
+	static byte* WriteArg(byte* pArgs, char* pString)
+	{
+		return WriteArg(pArgs, static_cast<const char*>(pString));
+	}
+
+	template <class T>
+	static const byte* ReadArg(const byte* pArgs, T& value)
+	{
+		memcpy(&value, pArgs, sizeof(value));
+		return pArgs + sizeof(value);
+	}
+	static const byte* ReadArg(const byte* pArgs, const char*& pString)
+	{
+		uint16 length;
+		memcpy(&length, pArgs, sizeof(length));
+		pString = reinterpret_cast<const char*>(pArgs + sizeof(length));
+		return pArgs + sizeof(length) + length + 1;
+	}
+	static const byte* ReadArg(const byte* pArgs, char*& pString)
+	{
+		const char* pConstString;
+		pArgs = ReadArg(pArgs, pConstString);
+		pString = const_cast<char*>(pConstString);
+		return pArgs;
+	}
+
+	static size_t ArgsSize(void)
+	{
+		return 0;
+	}
+	template <class T, class... Rest>
+	static size_t ArgsSize(const T& arg, const Rest&... rest)
+	{
+		return ArgSize(arg) + ArgsSize(rest...);
+	}
+	static void WriteArgs(byte*)
+	{
+	}
+	template <class T, class... Rest>
+	static void WriteArgs(byte* pArgs, const T& arg, const Rest&... rest)
+	{
+		WriteArgs(WriteArg(pArgs, arg), rest...);
+	}
+
+	/**
+	 * @brief	This method formats a recorded message (on the logger thread)
+	 * 			It is instantiated once per argument list.
+	 */
+	template <class... Args>
+	static int FormatRecord(char* pBuffer, size_t size, const char* pFormat, const byte* pArgs)
+	{
+		std::tuple<Args...> args;
+		std::apply([&](Args&... values) { ((pArgs = ReadArg(pArgs, values)), ...); }, args);
+
+		return std::apply([&](const Args&... values) { return snprintf(pBuffer, size, pFormat, values...); }, args);
+	}
+
+	static size_t StringLength(const char* pString)
+	{
+		return (pString) ? strnlen(pString, maxStringLength) : 6;
+	}
+	static size_t AlignedSize(size_t size)
+	{
+		return (size + 7) & ~size_t(7);
+	}
+
+	Logger();
+	~Logger();
+
+	static Logger& Get(void);
+
+	byte* Reserve(uint32 size);
+	void Commit(uint32 size);
+	Ring* GetThreadRing(void);
+
+	void Run(void);
+	bool Drain(void);
+	void Print(const Record& record, const byte* pArgs);
+
+	std::atomic<int> level;
+	std::mutex ringsMutex;
+	std::vector<Ring*> rings;
+	std::thread thread;
+	std::atomic<bool> isRunning;
+
+};
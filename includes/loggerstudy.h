@@ -0,0 +1,22 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the cost of a log call on the calling thread
+ */
+namespace LoggerStudy
+{
+	/**
+	 * @brief	This method prints the time a log call takes next to the former synchronous macros
+	 * 			The former macros formatted into a 128 byte buffer and printed on the calling
+	 * 			thread, the Logger only records the arguments. The calls run in batches that fit
+	 * 			into a ring, the logger thread prints every batch before the next one starts.
+	 * 			The standard output is redirected to a temporary file meanwhile.
+	 * @param	numCalls is the number of calls of every kind
+	 * @return	false if a recorded call isn't cheaper than a call of the former macros
+	 */
+	bool Run(uint numCalls);
+}
@@ -49,13 +49,13 @@ namespace Math
 		 * @param other is the rhs matrix
 		 * @return Mat4x4 a new matrix that is created by the operation.
 		 */
-		Mat4x4 Mat4x4::operator+ (const Mat4x4& other) const;
+		Mat4x4 operator+ (const Mat4x4& other) const;
 		/**
 		 * @brief This method subtracts a matrix from this matrix
 		 * @param other is the rhs matrix
 		 * @return Mat4x4 a new matrix that is created by the operation.
 		 */
-		Mat4x4 Mat4x4::operator- (const Mat4x4& other) const;
+		Mat4x4 operator- (const Mat4x4& other) const;
 
 		Mat4x4 operator* (const Mat4x4& other) const;
 		void operator*= (const Mat4x4& other) const;
@@ -0,0 +1,101 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This class defines a linear memory arena
+ * 			The memory is reserved from the operating system once,
+ * 			preferably backed by huge pages to keep TLB misses low.
+ * 			Allocations are never freed on their own, the whole arena
+ * 			is released at once when it is destroyed.
+ */
+class MemoryArena
+{
+public:
+
+	/**
+	 * @brief	PageSize defines the pages that back the arena
+	 */
+	enum PageSize
+	{
+		SmallPages,				/**< regular 4 KiB pages */
+		TransparentHugePages,	/**< regular pages the kernel may merge into huge pages (Linux only) */
+		ExplicitHugePages		/**< huge pages that must be available up front (hugetlbfs or large pages on Windows) */
+	};
+
+	static constexpr size_t alignment = 64;	/**< every allocation starts on its own cache line */
+
+	/**
+	 * @brief	Construct a new MemoryArena object
+	 * 			Huge pages that aren't available fall back to the next smaller page size.
+	 * @param	capacity is the number of bytes to be reserved
+	 * @param	pageSize is the desired size of the backing pages
+	 */
+	MemoryArena(size_t capacity, PageSize pageSize = TransparentHugePages);
+	/**
+	 * @brief	Destroy the MemoryArena object
+	 * 			This is the single point that releases all allocations.
+	 */
+	~MemoryArena();
+
+	MemoryArena(const MemoryArena&) = delete;
+	MemoryArena& operator=(const MemoryArena&) = delete;
+
+	/**
+	 * @brief	This method allocates an aligned block of memory
+	 * 			The memory is neither initialized nor touched, so the first
+	 * 			thread writing to it decides where its pages are placed.
+	 * @param	size is the number of bytes
+	 * @return	void* is the allocated memory (nullptr if the arena is exhausted)
+	 */
+	void* Allocate(size_t size);
+	/**
+	 * @brief	This method allocates an aligned array
+	 * @tparam	T is the element type (trivially constructible, it isn't constructed)
+	 * @param	count is the number of elements
+	 * @return	T* is the allocated array (nullptr if the arena is exhausted)
+	 */
+	template <class T>
+	T* Allocate(size_t count)
+	{
+		return static_cast<T*>(this->Allocate(sizeof(T) * count));
+	}
+
+	/**
+	 * @brief	This method calculates the capacity needed for a set of allocations
+	 * @param	size is the number of bytes of one allocation
+	 * @return	size_t is the size including its alignment padding
+	 */
+	static size_t AlignedSize(size_t size);
+
+	/**
+	 * @brief	This method retrieves how much of the arena is resident and on which pages
+	 * 			The page size of the arena is only what was requested from the operating system,
+	 * 			this is what it actually backs the arena with (read from /proc/self/smaps on Linux).
+	 * @param	residentSize is the returned number of resident bytes
+	 * @param	hugePageSize is the returned number of resident bytes on huge pages
+	 * @return	false if the backing can't be retrieved
+	 */
+	bool GetResidentSize(size_t& residentSize, size_t& hugePageSize) const;
+
+	size_t GetCapacity(void) const;
+	size_t GetUsedSize(void) const;
+	PageSize GetPageSize(void) const;
+	/**
+	 * @brief	Retrieves the time the operating system took to reserve the arena
+	 * @return	uint64 is the reservation time in microseconds
+	 */
+	uint64 GetReserveTime(void) const;
+
+private:
+
+	byte* pMemory;
+	size_t capacity;
+	size_t usedSize;
+	PageSize pageSize;
+	uint64 reserveTime;
+
+};
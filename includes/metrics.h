@@ -0,0 +1,181 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This class defines a registry of metrics in the Prometheus text format
+ * 			Counters and histograms keep one cache line per thread slot, updates
+ * 			are single relaxed atomic additions that never wait. The slots are only
+ * 			summed up when the metrics are formatted (scraped).
+ * 			Metrics are registered during the setup, the returned pointers stay
+ * 			valid as long as the registry exists.
+ */
+class MetricsRegistry
+{
+public:
+
+	static constexpr uint numThreadSlots = 16;	/**< threads beyond this share slots (still correct, only contended) */
+	static constexpr uint maxBuckets = 16;		/**< the largest number of histogram buckets (without +Inf) */
+
+	/**
+	 * @brief	This class defines the interface of a registered metric
+	 */
+	class Metric
+	{
+	public:
+
+		Metric(const char* pName, const char* pHelp, const char* pLabels, const char* pType);
+		virtual ~Metric() { }
+
+		/**
+		 * @brief	This method appends the samples of the metric
+		 * @param	text is the text the samples are appended to
+		 */
+		virtual void FormatSamples(std::string& text) const = 0;
+
+		std::string name;
+		std::string help;
+		std::string labels;
+		const char* pType;
+	};
+
+	/**
+	 * @brief	This class defines a monotonic counter
+	 */
+	class Counter : public Metric
+	{
+	public:
+
+		Counter(const char* pName, const char* pHelp, const char* pLabels);
+
+		/**
+		 * @brief	This method increases the counter (lock-free)
+		 * @param	value is added to the counter
+		 */
+		void Add(uint64 value = 1);
+		uint64 GetValue(void) const;
+
+		void FormatSamples(std::string& text) const override;
+
+	private:
+
+		struct alignas(64) Slot
+		{
+			std::atomic<uint64> value;
+		};
+
+		Slot slots[numThreadSlots];
+	};
+
+	/**
+	 * @brief	This class defines a value that can go up and down
+	 * 			It is either set or read from a callback on every scrape.
+	 */
+	class Gauge : public Metric
+	{
+	public:
+
+		Gauge(const char* pName, const char* pHelp, const char* pLabels, std::function<double(void)> callback);
+
+		/**
+		 * @brief	This method sets the value of the gauge (lock-free)
+		 * @param	value is the new value
+		 */
+		void Set(double value);
+		double GetValue(void) const;
+
+		void FormatSamples(std::string& text) const override;
+
+	private:
+
+		std::atomic<double> value;
+		std::function<double(void)> callback;
+	};
+
+	/**
+	 * @brief	This class defines a histogram with fixed bucket bounds
+	 */
+	class Histogram : public Metric
+	{
+	public:
+
+		Histogram(const char* pName, const char* pHelp, const char* pLabels, const std::vector<double>& bounds);
+
+		/**
+		 * @brief	This method records an observation (lock-free)
+		 * @param	value is the observed value
+		 */
+		void Observe(double value);
+
+		void FormatSamples(std::string& text) const override;
+
+	private:
+
+		struct alignas(64) Slot
+		{
+			std::atomic<uint64> counts[maxBuckets + 1];
+			std::atomic<double> sum;
+		};
+
+		double bounds[maxBuckets];
+		uint numBounds;
+		Slot slots[numThreadSlots];
+	};
+
+	/**
+	 * @brief	This method registers a counter
+	 * @param	pName is the metric name (e.g. "particle_simulation_steps_total")
+	 * @param	pHelp is the description of the metric
+	 * @param	pLabels are the labels of the metric without braces (e.g. "stage=\"present\"")
+	 * @return	Counter* is the registered counter
+	 */
+	Counter* AddCounter(const char* pName, const char* pHelp, const char* pLabels = "");
+	/**
+	 * @brief	This method registers a gauge
+	 * @param	callback is called on every scrape if set, otherwise the value of Set is reported
+	 * @return	Gauge* is the registered gauge
+	 */
+	Gauge* AddGauge(const char* pName, const char* pHelp, const char* pLabels = "", std::function<double(void)> callback = nullptr);
+	/**
+	 * @brief	This method registers a histogram
+	 * @param	bounds are the increasing upper bounds of the buckets (at most maxBuckets)
+	 * @return	Histogram* is the registered histogram
+	 */
+	Histogram* AddHistogram(const char* pName, const char* pHelp, const char* pLabels, const std::vector<double>& bounds);
+	/**
+	 * @brief	This method registers the resident memory of the process
+	 */
+	void AddProcessMetrics(void);
+
+	/**
+	 * @brief	This method formats all metrics in the Prometheus text format
+	 * 			It may be called from any thread.
+	 * @return	std::string is the exposition text
+	 */
+	std::string Format(void) const;
+
+	/**
+	 * @brief	This method calculates bucket bounds that grow by a constant factor
+	 * @param	start is the first upper bound
+	 * @param	factor is the ratio between two bounds
+	 * @param	count is the number of bounds
+	 * @return	std::vector<double> are the bounds
+	 */
+	static std::vector<double> ExponentialBounds(double start, double factor, uint count);
+
+private:
+
+	static uint GetThreadSlot(void);
+
+	mutable std::mutex mutex;
+	std::vector<std::unique_ptr<Metric>> metrics;
+
+};
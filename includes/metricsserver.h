@@ -0,0 +1,55 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+#include <thread>
+// INTERNAL INCLUDES
+#include "types.h"
+
+class MetricsRegistry;
+
+/**
+ * @brief	This class serves the metrics of a registry over HTTP
+ * 			It only listens on the loopback interface and answers
+ * 			"GET /metrics" in the Prometheus text format on its own thread.
+ */
+class MetricsServer
+{
+public:
+
+	/**
+	 * @brief	Construct a new MetricsServer object
+	 * @param	pRegistry is the registry that is served (not owned)
+	 */
+	MetricsServer(const MetricsRegistry* pRegistry);
+	~MetricsServer();
+
+	/**
+	 * @brief	This method starts listening on 127.0.0.1
+	 * @param	port is the TCP port
+	 * @return	false if the port can't be bound
+	 */
+	bool Start(uint16 port);
+	/**
+	 * @brief	This method closes the listener and waits for the serving thread
+	 */
+	void Stop(void);
+
+	/**
+	 * @brief	Retrieves the number of answered scrapes
+	 * @return	uint64 is the number of requests of /metrics
+	 */
+	uint64 GetNumScrapes(void) const;
+
+private:
+
+	void Run(void);
+	void Serve(uint64 clientSocket);
+
+	const MetricsRegistry* pRegistry;
+	uint64 listenSocket;
+	std::thread thread;
+	std::atomic<bool> isRunning;
+	std::atomic<uint64> numScrapes;
+
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <string>
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "types.h"
+
+class ParticleSimulation;
+class ThreadPool;
+
+/**
+ * @brief	This namespace writes arrays in the NumPy formats
+ * 			The arrays are written straight from their memory with vectored
+ * 			writes, only the small headers are formatted. A .npz bundle is an
+ * 			uncompressed zip archive of .npy files (like numpy.savez), so its
+ * 			only extra pass over the data is the CRC-32 of every entry, which
+ * 			is computed in parallel. Sizes beyond 4 GiB use the zip64 extensions.
+ */
+namespace NpyExport
+{
+	/**
+	 * @brief	This struct defines an array that is exported
+	 */
+	struct Array
+	{
+		std::string name;			/**< the name of the array (the file name without .npy) */
+		std::string descr;			/**< the NumPy type description (e.g. '<f4') */
+		std::vector<size_t> shape;	/**< the extent of every dimension */
+		const void* pData;			/**< the elements in C order (not owned) */
+		size_t size;				/**< the size of the elements in bytes */
+	};
+
+	/**
+	 * @brief	This method describes the particle arrays of a simulation
+	 * 			The particles are a structured array with the fields of ParticleSimulation::Particle
+	 * 			and aren't copied: particles['position'] is the former position, particles['nextPosition']
+	 * 			the current one. particles['prevPosition'] keeps the start position with float and
+	 * 			double precision and holds the rounding error of nextPosition with compensated precision.
+	 * 			The velocities are calculated (see ParticleSimulation::CalculateVelocities). The arrays
+	 * 			are in the order the simulation keeps them in, ids[i] is the original index of particle i.
+	 * @param	simulation is the simulation (it must not step while the arrays are written)
+	 * @param	velocities are the returned velocities the velocities array points to
+	 * @return	std::vector<Array> are the particles, velocities and ids
+	 */
+	std::vector<Array> GetParticleArrays(const ParticleSimulation& simulation, std::vector<Math::Vec2>& velocities);
+
+	/**
+	 * @brief	This method formats the header of a .npy file (version 1.0)
+	 * @param	array is the array
+	 * @return	std::string is the header padded to a multiple of 64 bytes
+	 */
+	std::string FormatHeader(const Array& array);
+
+	/**
+	 * @brief	This method writes an array into a .npy file
+	 * @param	pPath is the path of the file
+	 * @param	array is the array
+	 * @return	false if the file couldn't be written
+	 */
+	bool WriteNpy(const char* pPath, const Array& array);
+	/**
+	 * @brief	This method writes arrays into a .npz bundle
+	 * @param	pPath is the path of the file
+	 * @param	arrays are the arrays (their names must be unique)
+	 * @param	pThreadPool is the pool the checksums are computed on (nullptr computes them on the calling thread)
+	 * @return	false if the file couldn't be written
+	 */
+	bool WriteNpz(const char* pPath, const std::vector<Array>& arrays, ThreadPool* pThreadPool = nullptr);
+
+	/**
+	 * @brief	This method simulates particles and exports their state
+	 * 			A path ending in .npz writes a bundle, any other path is a directory
+	 * 			that receives one .npy file per array. The write rate is printed.
+	 * @param	pPath is the path of the bundle or the directory
+	 * @param	numParticles is the number of simulated particles
+	 * @param	numSteps is the number of steps before the export
+	 * @return	false if the export failed
+	 */
+	bool Run(const char* pPath, size_t numParticles, uint numSteps);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "presenter.h"
+#include "types.h"
+
+/**
+ * @brief	This class defines a presenter that shows nothing
+ * 			It only waits for the next simulated vertical blank,
+ * 			so the application can run headless with a realistic present rate.
+ */
+class NullPresenter : public Presenter
+{
+public:
+
+	/**
+	 * @brief	Construct a new NullPresenter object
+	 * @param	refreshRate is the simulated display refresh rate in Hz
+	 */
+	NullPresenter(float refreshRate = 60.0f);
+
+	/**
+	 * @brief	This method waits for the next simulated vertical blank
+	 * @param	snapshot is the newest completed simulation state (unused)
+	 */
+	void PresentSnapshot(const SimulationSnapshot& snapshot) override;
+
+private:
+
+	uint64 interval;
+	uint64 nextVerticalBlank;
+
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares pinned and unpinned threads on the particle memory
+ */
+namespace NumaStudy
+{
+	/**
+	 * @brief	This method prints the throughput of every NUMA node with pinned and unpinned threads
+	 * 			Both pools place the particles themselves (the first touch decides the node of a page)
+	 * 			and step them with all particles and with half of them in the budget, where the
+	 * 			pinned threads keep their parts and the threads of the inactive half idle.
+	 * @param	numParticles is the number of simulated particles
+	 * @param	numSteps is the number of measured steps of every budget
+	 * @return	false if the particle memory couldn't be reserved
+	 */
+	bool Run(size_t numParticles, uint numSteps);
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "particle.h"
+#include "types.h"
+
+class ThreadPool;
+
+/**
+ * @brief	This class describes static obstacles as a signed distance field
+ * 			The obstacles are added as shapes and baked once into a grid of distances
+ * 			(negative inside an obstacle). A collision then costs one bilinear lookup of
+ * 			four grid nodes per particle, no matter how many shapes there are. Only
+ * 			distances up to maxDistance are baked, every shape only touches the nodes
+ * 			of its bounding box grown by that band, further nodes keep maxDistance.
+ * 			Overlapping shapes are merged by taking the smallest distance.
+ */
+class ObstacleField
+{
+public:
+
+	typedef BasicParticle<Math::Vec2> Particle;
+
+	/**
+	 * @brief	ShapeType defines the shapes obstacles are made of
+	 */
+	enum ShapeType
+	{
+		Circle,		/**< a disc around a center */
+		Box,		/**< an axis aligned rectangle, optionally with rounded corners */
+		Capsule		/**< a segment grown by a radius */
+	};
+
+	/**
+	 * @brief	This struct defines a shape
+	 */
+	struct Shape
+	{
+		ShapeType type;
+		Math::Vec2 a;		/**< the center (circle and box) or the first end of the segment (capsule) */
+		Math::Vec2 b;		/**< the half extents (box) or the second end of the segment (capsule), unused by circles */
+		float radius;		/**< the radius (circle and capsule) or the rounding of the corners (box) */
+	};
+
+	/**
+	 * @brief	Construct a new ObstacleField object
+	 * @param	boundsMin is the lower corner of the area the grid covers
+	 * @param	boundsMax is the upper corner of the area the grid covers
+	 * @param	cellSize is the distance between two grid nodes
+	 * @param	maxDistance is the largest baked distance (it has to exceed the particle radius by a cell)
+	 */
+	ObstacleField(Math::Vec2 boundsMin, Math::Vec2 boundsMax, float cellSize, float maxDistance);
+
+	void AddCircle(Math::Vec2 center, float radius);
+	void AddBox(Math::Vec2 center, Math::Vec2 halfExtents, float rounding = 0.0f);
+	void AddCapsule(Math::Vec2 a, Math::Vec2 b, float radius);
+	/**
+	 * @brief	This method removes all shapes (the grid keeps the baked distances until the next Bake)
+	 */
+	void Clear(void);
+
+	/**
+	 * @brief	This method bakes the distances of all shapes into the grid
+	 * 			Every thread bakes its own rows, so the nodes are written without atomics.
+	 * @param	pThreadPool is the pool the rows are baked on (nullptr bakes them on the calling thread)
+	 */
+	void Bake(ThreadPool* pThreadPool = nullptr);
+
+	/**
+	 * @brief	This method samples the baked distance and its gradient
+	 * 			The distance is interpolated bilinearly between the four surrounding nodes.
+	 * 			Outside the grid the border is sampled and the distance to the grid is added.
+	 * @param	position is the position to be sampled
+	 * @param	gradient is the returned gradient of the distance (not normalized)
+	 * @return	float is the distance to the nearest obstacle (negative inside)
+	 */
+	inline float Sample(const Math::Vec2& position, Math::Vec2& gradient) const
+	{
+		float x = (position.x - this->boundsMin.x) * this->invCellSize;
+		float y = (position.y - this->boundsMin.y) * this->invCellSize;
+		float clampedX = std::min(std::max(x, 0.0f), this->maxCoordinate.x);
+		float clampedY = std::min(std::max(y, 0.0f), this->maxCoordinate.y);
+
+		int column = static_cast<int>(clampedX);
+		int row = static_cast<int>(clampedY);
+		float tx = clampedX - static_cast<float>(column);
+		float ty = clampedY - static_cast<float>(row);
+
+		const float* pNodes = this->distances.data() + static_cast<size_t>(row) * this->numColumns + column;
+		float d00 = pNodes[0], d10 = pNodes[1];
+		float d01 = pNodes[this->numColumns], d11 = pNodes[this->numColumns + 1];
+
+		float bottom = d00 + (d10 - d00) * tx;
+		float top = d01 + (d11 - d01) * tx;
+
+		gradient.x = ((d10 - d00) + (d11 - d01 - d10 + d00) * ty) * this->invCellSize;
+		gradient.y = (top - bottom) * this->invCellSize;
+
+		float distance = bottom + (top - bottom) * ty;
+		if (x != clampedX || y != clampedY)
+		{
+			float outsideX = (x - clampedX) * this->cellSize, outsideY = (y - clampedY) * this->cellSize;
+			distance += sqrtf(outsideX * outsideX + outsideY * outsideY);
+		}
+
+		return distance;
+	}
+	/**
+	 * @brief	This method evaluates every shape at a position (what the baked grid replaces)
+	 * @param	position is the position to be evaluated
+	 * @param	gradient is the returned direction away from the nearest shape (normalized)
+	 * @return	float is the exact distance to the nearest shape (negative inside)
+	 */
+	float Evaluate(const Math::Vec2& position, Math::Vec2& gradient) const;
+
+	/**
+	 * @brief	This method pushes a range of particles out of the obstacles
+	 * 			A particle closer than its radius to an obstacle is moved along the gradient onto the
+	 * 			surface and its velocity towards the obstacle is reflected, scaled by the restitution.
+	 * 			Without velocities (position Verlet) the velocity is the last displacement, so the
+	 * 			former position is moved instead (the compensated position Verlet keeps the stale error).
+	 * @param	pParticles are the particles, they are sampled at their current position ("nextPosition")
+	 * @param	pVelocities are the velocities of the velocity based integrators (nullptr for position Verlet)
+	 * @param	begin is the first particle of the range
+	 * @param	end is the particle after the last particle of the range
+	 * @param	radius is the radius of a particle
+	 * @param	restitution is the fraction of the normal velocity a particle bounces off with (0 to 1)
+	 * @return	size_t is the number of particles that collided
+	 */
+	size_t Collide(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float radius, float restitution) const;
+	/**
+	 * @brief	This method pushes a range of particles out of the obstacles by evaluating every shape
+	 * 			It is the reference of Collide, see there.
+	 * @return	size_t is the number of particles that collided
+	 */
+	size_t CollideAnalytic(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float radius, float restitution) const;
+
+	size_t GetNumShapes(void) const;
+	size_t GetNumNodes(void) const;
+	float GetCellSize(void) const;
+	float GetMaxDistance(void) const;
+	/**
+	 * @brief	Retrieves the time the last Bake took
+	 * @return	uint64 is the bake time in microseconds
+	 */
+	uint64 GetBakeTime(void) const;
+
+private:
+
+	template <bool isBaked>
+	size_t CollideRange(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float radius, float restitution) const;
+
+	Math::Vec2 boundsMin;
+	float cellSize;
+	float invCellSize;
+	float maxDistance;
+	uint numColumns;
+	uint numRows;
+	Math::Vec2 maxCoordinate;		/**< the largest grid coordinate a sample starts from (just below the last node) */
+	uint64 bakeTime;
+
+	std::vector<Shape> shapes;
+	std::vector<float> distances;	/**< the distance at every node, row by row */
+
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares the baked obstacle field with evaluating every shape
+ */
+namespace ObstacleStudy
+{
+	/**
+	 * @brief	This method prints the cost of a collision for growing numbers of shapes and a simulation with obstacles
+	 * 			The particles are scattered over the obstacles, every one is collided once with
+	 * 			the baked field and once by evaluating all shapes. Then the simulation falls
+	 * 			onto a set of obstacles around its attractor, with and without the collisions.
+	 * @param	numParticles is the number of particles
+	 * @param	numSteps is the number of simulated steps
+	 * @return	false if the baked distances deviate from the shapes by more than a cell
+	 */
+	bool Run(size_t numParticles, uint numSteps);
+}
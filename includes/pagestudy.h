@@ -0,0 +1,23 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares the pages that back the particle arrays
+ */
+namespace PageStudy
+{
+	/**
+	 * @brief	This method prints the cost of the particle memory on every page size side by side
+	 * 			Every page size reserves its own arena, the page size it actually got (huge pages
+	 * 			that aren't available fall back), the time of the reservation, of the first touch and
+	 * 			of the steps with block timesteps are printed.
+	 * @param	numParticles is the number of simulated particles
+	 * @param	numSteps is the number of measured steps
+	 * @return	false if no page size could reserve the particle memory
+	 */
+	bool Run(size_t numParticles, uint numSteps);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "math/vec3.h"
+#include "types.h"
+
+/**
+ * @brief	This struct defines a single particle of any dimension
+ * 			The 2D layout matches the particle structure of the shaders.
+ * @tparam	Vector is the vector of the positions (Math::Vec2 or Math::Vec3)
+ */
+template <class Vector>
+struct BasicParticle
+{
+	Vector position;		/**< the position of the last step (this is rendered) */
+	Vector prevPosition;	/**< unused by the integration, kept for the shader layout (see Integrators::CompensatedPositionVerlet) */
+	Vector nextPosition;	/**< the position of the current step */
+};
+
+/**
+ * @brief	This is the number of dimensions of a vector
+ * 			The vectors are plain structs of floats, so loops over the
+ * 			dimensions have a constant trip count and are unrolled.
+ */
+template <class Vector>
+constexpr uint numDimensions = sizeof(Vector) / sizeof(float);
+
+/**
+ * @brief	This method retrieves a component of a vector by its index
+ * @param	vector is the vector
+ * @param	dimension is the index of the component (0 is x)
+ * @return	float& is the component
+ */
+template <class Vector>
+inline float& Component(Vector& vector, uint dimension)
+{
+	return (&vector.x)[dimension];
+}
+template <class Vector>
+inline float Component(const Vector& vector, uint dimension)
+{
+	return (&vector.x)[dimension];
+}
@@ -3,36 +3,42 @@
 // EXTERNAL INCLUDES
 // INTERNAL INCLUDES
 #include "math/mat4x4.h"
+#include "particlesimulation.h"
+#include "presenter.h"
 #include "renderer.h"
 #include "types.h"
 
-class ParticleRenderer : public Renderer
+class ParticleRenderer : public Renderer, public Presenter
 {
 public:
 
-	struct Particle
-	{
-		Math::Vec2 position;
-		Math::Vec2 prevPosition;
-		Math::Vec2 nextPosition;
-	};
-	__declspec(align(16)) struct SimulationConstants
-	{
-		uint numParticles;
-		Math::Vec2 gravitySource;
-		float gravityStrength;
-		float lastTimestep;
-		float timestep;
-		float damping;
-	};
+	typedef ParticleSimulation::Particle Particle;
+	typedef ParticleSimulation::SimulationConstants SimulationConstants;
 
 	ParticleRenderer();
 	~ParticleRenderer();
 
-	HRESULT SetupParticles();
-	void UpdateParticles(float deltaTime);
+	/**
+	 * @brief	This method creates the particle buffers on the graphics card
+	 * @param	simulation is the simulation whose particles are uploaded initially
+	 * @return	HRESULT is the resulting error code ('S_OK' means 'no error')
+	 */
+	HRESULT SetupParticles(const ParticleSimulation& simulation);
+	/**
+	 * @brief	This method integrates the particles on the graphics card
+	 * 			It is only used when the simulation runs on the GPU (GPU_SIMULATION).
+	 * @param	constants are the constants of this simulation step
+	 */
+	void UpdateParticles(const SimulationConstants& constants);
 	void RenderParticles(float deltaTime);
 
+	/**
+	 * @brief	This method uploads a completed state and presents it
+	 * 			It blocks on vsync.
+	 * @param	snapshot is the newest completed simulation state
+	 */
+	void PresentSnapshot(const SimulationSnapshot& snapshot) override;
+
 private:
 
 	HRESULT CompileShaders();
@@ -58,7 +64,6 @@ private:
 	ID3D11UnorderedAccessView* pNextSimulationStateUAV;
 
 	size_t numMaxParticles;
-	Particle* pCurrentSimulationData;
-	Particle* pNextSimulationData;
+	uint64 uploadedStep;	/**< the step of the uploaded snapshot, a decimated simulation publishes a new one only every n-th frame */
 
 };
@@ -0,0 +1,381 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "inputevent.h"
+#include "math/vec2.h"
+#include "memoryarena.h"
+#include "particle.h"
+#include "types.h"
+
+class ObstacleField;
+class SegmentBVH;
+class ThreadPool;
+struct DiagnosticsPartial;
+struct SimulationSnapshot;
+
+/**
+ * @brief	This class contains the CPU side particle simulation
+ * 			It integrates the particles with the same time corrected
+ * 			Verlet formula as the IntegrateCS compute shader and owns
+ * 			the simulation constants that are modified by the input.
+ */
+class ParticleSimulation
+{
+public:
+
+	/**
+	 * @brief	This is a single particle, its layout matches the particle structure of the shaders
+	 */
+	typedef BasicParticle<Math::Vec2> Particle;
+	/**
+	 * @brief	This struct defines the constants of a simulation step
+	 * 			The layout matches the SimulationConstants constant buffer.
+	 */
+	struct alignas(16) SimulationConstants
+	{
+		uint numParticles;
+		Math::Vec2 gravitySource;
+		float gravityStrength;
+		float lastTimestep;
+		float timestep;
+		float damping;
+	};
+
+	/**
+	 * @brief	IntegrationMethod defines the integrators of the CPU simulation
+	 * 			(see the Integrators namespace)
+	 */
+	enum IntegrationMethod
+	{
+		PositionVerlet,		/**< the time corrected position Verlet of IntegrateCS (default) */
+		VelocityVerlet,		/**< velocity Verlet, two acceleration evaluations per step */
+		Leapfrog,			/**< leapfrog with a half step staggered velocity */
+		SemiImplicitEuler,	/**< symplectic Euler, first order */
+		RungeKutta4			/**< classic fourth order Runge-Kutta, four acceleration evaluations per step */
+	};
+
+	/**
+	 * @brief	This struct defines the diagnostics of the particle set after a step
+	 * 			All particles have unit mass.
+	 */
+	struct Diagnostics
+	{
+		static constexpr uint numSpeedBins = 16;
+
+		double kineticEnergy;					/**< the sum of v^2 / 2 */
+		double potentialEnergy;					/**< the sum of g * r (the pull has a constant magnitude) */
+		Math::Vec2 boundsMin;					/**< the lower corner of the bounding box */
+		Math::Vec2 boundsMax;					/**< the upper corner of the bounding box */
+		Math::Vec2 centroid;					/**< the mean position */
+		float maxSpeed;							/**< the largest speed */
+		float speedBinWidth;					/**< the speed range of a histogram bin */
+		uint64 speedHistogram[numSpeedBins];	/**< the number of particles per speed range (the last bin has every faster particle) */
+		uint64 step;							/**< the step the diagnostics belong to (0 if they were never computed) */
+	};
+
+	static constexpr uint maxTimeBins = 8; /**< the largest number of time bins (finest step is timestep / 2^maxTimeBins) */
+
+	/**
+	 * @brief	Construct a new ParticleSimulation object
+	 * @param	numMaxParticles is the number of particles that are simulated
+	 * @param	pThreadPool is the pool the particles are processed on (nullptr processes them on the calling thread)
+	 */
+	ParticleSimulation(size_t numMaxParticles, ThreadPool* pThreadPool = nullptr);
+	~ParticleSimulation();
+
+	/**
+	 * @brief	This method allocates the particles and places them on their start grid
+	 * 			All particle arrays are placed in one aligned memory arena. They are
+	 * 			initialized in parallel with the same ranges the steps use, so every
+	 * 			page is first touched by the thread that will process it.
+	 * @param	pageSize is the size of the pages backing the particle arrays
+	 * @return	false if the memory of the particles couldn't be reserved (the simulation must not be stepped then)
+	 */
+	bool SetupParticles(MemoryArena::PageSize pageSize = MemoryArena::TransparentHugePages);
+
+	/**
+	 * @brief	This method selects the integrator of the following steps
+	 * 			The velocities are derived from the last two positions on a switch.
+	 * @param	method is the integrator to be used
+	 */
+	void SetIntegrationMethod(IntegrationMethod method);
+	/**
+	 * @brief	This method enables hierarchical block timesteps
+	 * 			Every step is split into power of two substeps. Each particle is put
+	 * 			into the time bin of the largest timestep its error estimate allows
+	 * 			(same criterion as EstimateTimestep) and is only integrated in the
+	 * 			substeps of its bin. The particles are sorted by bin, finest first,
+	 * 			so the particles of each substep are a contiguous prefix.
+	 * @param	numTimeBins is the number of halvings of the timestep (0 integrates all particles with the same timestep)
+	 * @param	accuracy is the fraction of the distance to the gravity source a step may cover
+	 * @param	softening is added to the distance to the gravity source
+	 */
+	void SetTimeBins(uint numTimeBins, float accuracy = 0.1f, float softening = 0.05f);
+	/**
+	 * @brief	This method lets every step estimate the timestep of the next one
+	 * 			Every block of particles is estimated right after its update while it is
+	 * 			still cached, so EstimateTimestep with the same accuracy and softening
+	 * 			takes no pass of its own. Block timesteps and a particle budget below the
+	 * 			awake particles still take the pass, and so does anything that changes
+	 * 			the particles between the steps. The particles that fell asleep in the
+	 * 			step still count.
+	 * @param	accuracy is the fraction of the distance to the gravity source a step may cover (0 turns it off)
+	 * @param	softening is added to the distance to the gravity source
+	 */
+	void SetTimestepEstimate(float accuracy, float softening);
+
+	/**
+	 * @brief	This method enables the per-step diagnostics
+	 * 			They are fused into the integration: every block of particles is
+	 * 			diagnosed right after its last update of the step while it is still
+	 * 			cached. The partial results of the threads are reduced as a tree.
+	 * @param	enabled computes the diagnostics after every step
+	 * @param	maxHistogramSpeed is the speed the last bin of the speed histogram starts at
+	 */
+	void SetDiagnostics(bool enabled, float maxHistogramSpeed = 2.0f);
+	/**
+	 * @brief	This method lets quiescent particles fall asleep
+	 * 			A particle whose displacement stays below the threshold for a number
+	 * 			of steps comes to rest and is moved behind the awake particles, so
+	 * 			the steps only loop over the awake particles at the front. All
+	 * 			particles wake up when the gravity source or its strength changes.
+	 * @param	enabled puts quiescent particles to sleep
+	 * @param	threshold is the displacement per step a particle has to stay below
+	 * @param	numQuietSteps is the number of steps in a row a particle has to stay below it (at most 255)
+	 */
+	void SetSleeping(bool enabled, float threshold = 0.001f, uint numQuietSteps = 30);
+	/**
+	 * @brief	This method wakes all sleeping particles up and restarts their quiet steps
+	 */
+	void WakeParticles(void);
+
+	/**
+	 * @brief	This method lets the particles collide with static obstacles
+	 * 			Every block of particles is pushed out of the obstacles right after its
+	 * 			integration, with one lookup of the baked distance field per particle.
+	 * 			All particles wake up, so none rests inside a new obstacle.
+	 * @param	pObstacles are the baked obstacles (not owned, nullptr removes them)
+	 * @param	radius is the radius of a particle
+	 * @param	restitution is the fraction of the normal velocity a particle bounces off with (0 to 1)
+	 */
+	void SetObstacles(const ObstacleField* pObstacles, float radius = 0.002f, float restitution = 0.5f);
+	/**
+	 * @brief	This method lets the particles bounce off static walls
+	 * 			Every step of a particle is swept against the walls before the obstacles
+	 * 			push it, so fast particles can't tunnel through thin walls.
+	 * @param	pWalls are the built walls (not owned, nullptr removes them)
+	 * @param	damping is the fraction of the speed a particle keeps on a bounce (0 to 1)
+	 */
+	void SetWalls(const SegmentBVH* pWalls, float damping = 0.8f);
+	/**
+	 * @brief	This method limits the number of particles that are integrated per step
+	 * 			The awake particles behind the budget keep their state until the budget
+	 * 			grows again, the diagnostics don't see them in between.
+	 * @param	particleBudget is the largest number of integrated particles
+	 */
+	void SetParticleBudget(size_t particleBudget);
+
+	/**
+	 * @brief	This method applies all input events that were received until a given time
+	 * 			Call it from the simulating thread before each step or let Step apply them.
+	 * @param	inputEvents is the queue that is drained
+	 * @param	until is the time at the end of the upcoming step (microseconds, see Time::Now)
+	 * @return	uint32 is the number of applied events
+	 */
+	uint32 ApplyInputEvents(InputEventQueue& inputEvents, uint64 until);
+	/**
+	 * @brief	This method advances the timestep constants without integrating the particles
+	 * 			It is used when the particles are integrated on the GPU.
+	 * @param	timestep is the timestep of the upcoming step
+	 */
+	void AdvanceTimestep(float timestep);
+	/**
+	 * @brief	This method advances the timestep constants and integrates all particles
+	 * 			The damping is scaled so that it drains the same amount of motion
+	 * 			per second for any timestep (it is defined per Time::maxTimeStep).
+	 * 			The input events that were received until the end of the step are applied
+	 * 			before it, with block timesteps each before the substep it was received in.
+	 * @param	timestep is the timestep of this step
+	 * @param	pInputEvents is the queue of input events (nullptr applies none)
+	 * @param	stepEnd is the wall clock time at the end of this step (microseconds, see Time::Now)
+	 */
+	void Step(float timestep, InputEventQueue* pInputEvents = nullptr, uint64 stepEnd = 0);
+	/**
+	 * @brief	This method estimates the largest timestep that keeps the integration error in bounds
+	 * 			No particle may move further than a fraction of its distance to the gravity source,
+	 * 			neither by its velocity nor by falling from rest. Close to the source the
+	 * 			direction of the pull turns quickly, so those particles demand small steps.
+	 * 			The minimum over all particles is reduced in parallel. With block timesteps
+	 * 			only the finest substep has to meet it, so the step may be 2^numTimeBins longer.
+	 * @param	accuracy is the fraction of the distance to the gravity source a step may cover
+	 * @param	softening is added to the distance to the gravity source
+	 * @return	float is the estimated timestep in seconds
+	 */
+	float EstimateTimestep(float accuracy, float softening) const;
+	/**
+	 * @brief	This method calculates the velocities of all particles at their current position
+	 * 			The velocity based integrators keep them. The position Verlet derives them
+	 * 			from the last displacement and the timestep of the particle's time bin
+	 * 			(GetVelocities holds its rounding errors with compensated precision).
+	 * 			Sleeping particles rest.
+	 * @param	pVelocities are the returned velocities (GetNumParticles() of them)
+	 */
+	void CalculateVelocities(Math::Vec2* pVelocities) const;
+
+	/**
+	 * @brief	This method copies the current state into a snapshot
+	 * @param	snapshot is the snapshot that receives the state
+	 */
+	void WriteSnapshot(SimulationSnapshot& snapshot) const;
+
+	size_t GetNumParticles(void) const;
+	const Particle* GetParticles(void) const;
+	const Math::Vec2* GetVelocities(void) const;
+	/**
+	 * @brief	Retrieves the original index of every particle
+	 * 			Block timesteps and sleeping reorder the particles, the ids follow them.
+	 * @return	const uint32* are the particle ids (a permutation of 0 to GetNumParticles() - 1)
+	 */
+	const uint32* GetParticleIDs(void) const;
+	IntegrationMethod GetIntegrationMethod(void) const;
+	const SimulationConstants& GetConstants(void) const;
+	uint64 GetNumSteps(void) const;
+	/**
+	 * @brief	Retrieves the number of single particle integrations since the setup
+	 * @return	uint64 is the number of particle updates
+	 */
+	uint64 GetNumParticleUpdates(void) const;
+	/**
+	 * @brief	Retrieves the number of particle integrations block timesteps saved
+	 * 			compared to integrating every particle in every substep
+	 * @return	uint64 is the number of saved particle updates
+	 */
+	uint64 GetNumSavedParticleUpdates(void) const;
+	/**
+	 * @brief	Retrieves the number of particles that are integrated in a step
+	 * @return	size_t is the number of awake particles (all particles unless sleeping is enabled)
+	 */
+	size_t GetNumAwakeParticles(void) const;
+	/**
+	 * @brief	Retrieves the number of particle integrations that were skipped because the particles were asleep
+	 * @return	uint64 is the number of skipped particle updates
+	 */
+	uint64 GetNumSkippedParticleUpdates(void) const;
+	/**
+	 * @brief	Retrieves the number of particle integrations that were deferred because the awake particles exceeded the budget
+	 * @return	uint64 is the number of deferred particle updates
+	 */
+	uint64 GetNumDeferredParticleUpdates(void) const;
+	/**
+	 * @brief	Retrieves the number of particle collisions with the obstacles and walls since the setup
+	 * @return	uint64 is the number of collisions
+	 */
+	uint64 GetNumCollisions(void) const;
+	/**
+	 * @brief	Retrieves the diagnostics of the last step
+	 * @return	const Diagnostics& are the diagnostics (step is 0 if they are disabled)
+	 */
+	const Diagnostics& GetDiagnostics(void) const;
+	/**
+	 * @brief	Retrieves the time spent in Step
+	 * @return	uint64 is the accumulated step time in microseconds
+	 */
+	uint64 GetStepTime(void) const;
+	/**
+	 * @brief	Retrieves the arena holding the particle arrays
+	 * @return	const MemoryArena* is the arena (nullptr before the setup or if it failed)
+	 */
+	const MemoryArena* GetMemoryArena(void) const;
+	/**
+	 * @brief	Retrieves the time the first touch initialization of the particle arrays took
+	 * @return	uint64 is the initialization time in microseconds
+	 */
+	uint64 GetFirstTouchTime(void) const;
+
+private:
+
+	void ApplyInputEvent(const InputEvent& event);
+
+	template <class Integrator>
+	void Integrate(InputEventQueue* pInputEvents, uint64 stepEnd);
+	template <class Integrator>
+	void IntegrateTimeBins(InputEventQueue* pInputEvents, uint64 stepEnd);
+	uint SortIntoTimeBins(float timestep, size_t* pBinEnds);
+	void PutQuietParticlesToSleep(void);
+
+	ThreadPool* pThreadPool;
+	size_t numMaxParticles;
+	MemoryArena* pArena;
+	uint64 firstTouchTime;
+	Particle* pParticles;
+	Math::Vec2* pVelocities;
+	IntegrationMethod integrationMethod;
+	SimulationConstants constants;
+	uint64 numSteps;
+	uint64 numParticleUpdates;
+	uint64 numSavedParticleUpdates;
+	uint64 stepTime;
+
+	// diagnostics
+	bool areDiagnosticsEnabled;
+	float maxHistogramSpeed;
+	Diagnostics diagnostics;
+
+	// sleeping particles (behind the awake ones)
+	bool isSleepingEnabled;
+	float sleepThreshold;
+	uint numQuietSteps;
+	size_t numAwakeParticles;
+	size_t numQuietParticles;
+	size_t particleBudget;			/**< the awake particles that are integrated at most */
+	uint64 numSkippedParticleUpdates;		/**< the updates of sleeping particles */
+	uint64 numDeferredParticleUpdates;		/**< the updates of awake particles behind the budget */
+	uint8* pQuietSteps;
+	DiagnosticsPartial* pSleepingDiagnostics;
+
+	// static obstacles
+	const ObstacleField* pObstacles;
+	float particleRadius;
+	float restitution;
+	const SegmentBVH* pWalls;
+	float wallDamping;
+	uint64 numCollisions;
+
+	// block timesteps
+	uint numTimeBins;
+	float timeBinAccuracy;
+	float timeBinSoftening;
+	float lastBlockTimestep;
+	bool isBlockStepping;
+	uint8* pTimeBins;
+	size_t numSortedParticles;		/**< the leading particles that are in the order of their bins (the next sort may keep them) */
+	Particle* pSortedParticles;
+	Math::Vec2* pSortedVelocities;
+	uint8* pSortedTimeBins;
+
+	// the original index of every particle
+	uint32* pParticleIDs;
+	uint32* pSortedParticleIDs;
+
+	// timestep estimate of the next step
+	float estimateAccuracy;			/**< 0 doesn't estimate during the steps */
+	float estimateSoftening;
+	bool hasTimestepEstimate;		/**< the last step estimated the particles as they are now */
+	float estimatedTimestep2;		/**< the smallest squared timestep the particles allow after the last step */
+
+};
+
+/**
+ * @brief	This struct defines a completed simulation state
+ * 			It is handed from the simulation to the presentation.
+ */
+struct SimulationSnapshot
+{
+	std::vector<ParticleSimulation::Particle> particles;	/**< the particles at the end of the step */
+	ParticleSimulation::Diagnostics diagnostics;			/**< the diagnostics at the end of the step */
+	uint64 step;											/**< the number of steps that were simulated */
+	uint64 timestamp;										/**< the simulation clock at the end of the step (microseconds) */
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "distanceconstraints.h"
+#include "integrators.h"
+#include "math/vec2.h"
+#include "math/vec3.h"
+#include "memoryarena.h"
+#include "particle.h"
+#include "types.h"
+
+class ThreadPool;
+struct SimulationSnapshot;
+
+/**
+ * @brief	This class manages many independent particle systems
+ * 			Every system has its own capacity and simulation constants. The
+ * 			particles of all systems are packed back to back into one set of
+ * 			arrays, so a step integrates all of them in a single parallel pass:
+ * 			the packed range is split evenly among the threads no matter how
+ * 			the particles are distributed over the systems, and a thread only
+ * 			switches the constants where its range crosses into the next system.
+ * 			The systems use the time corrected position Verlet of IntegrateCS.
+ * @tparam	Vector is the vector of the positions, a world is either 2D or 3D
+ */
+template <class Vector>
+class BasicParticleWorld
+{
+public:
+
+	typedef BasicParticle<Vector> Particle;
+	typedef uint SystemID;
+
+	static constexpr SystemID invalidSystem = ~0u; /**< returned if a system doesn't fit into the world */
+
+	/**
+	 * @brief	This struct defines a new particle system
+	 */
+	struct SystemSettings
+	{
+		size_t numParticles;		/**< the number of particles of the system */
+		Vector origin;				/**< the center of the square (or cube) the particles start in */
+		float size;					/**< the edge length of the start square (or cube) */
+		Vector gravitySource;		/**< the position of the attractor */
+		float gravityStrength;		/**< the magnitude of the pull towards the attractor */
+		float damping;				/**< the damping per Time::maxTimeStep */
+	};
+	/**
+	 * @brief	This struct defines the constants of a system
+	 */
+	struct SystemConstants
+	{
+		uint numParticles;
+		Vector gravitySource;
+		float gravityStrength;
+		float lastTimestep;
+		float timestep;
+		float damping;
+	};
+
+	/**
+	 * @brief	Construct a new BasicParticleWorld object
+	 * @param	numMaxParticles is the number of particles all systems together may have
+	 * @param	pThreadPool is the pool the particles are processed on (nullptr processes them on the calling thread)
+	 * @param	pageSize is the size of the pages backing the particle arrays
+	 * 			If they can't be reserved the world has no capacity and rejects every system.
+	 */
+	BasicParticleWorld(size_t numMaxParticles, ThreadPool* pThreadPool = nullptr, MemoryArena::PageSize pageSize = MemoryArena::TransparentHugePages);
+	~BasicParticleWorld();
+
+	/**
+	 * @brief	This method adds a system and places its particles on a grid in its start square (or cube)
+	 * @param	settings define the new system
+	 * @return	SystemID identifies the system (invalidSystem if its particles don't fit anymore or the world has no memory)
+	 */
+	SystemID AddSystem(const SystemSettings& settings);
+	/**
+	 * @brief	This method removes a system
+	 * 			The particles of the following systems move up to close the gap.
+	 * @param	system is the system to be removed
+	 * @return	false if the system doesn't exist
+	 */
+	bool RemoveSystem(SystemID system);
+
+	/**
+	 * @brief	This method moves the attractor of a system
+	 * @param	system is the system to be changed
+	 * @param	gravitySource is the new position of the attractor
+	 * @param	gravityStrength is the new magnitude of the pull
+	 * @return	false if the system doesn't exist
+	 */
+	bool SetGravity(SystemID system, Vector gravitySource, float gravityStrength);
+	/**
+	 * @brief	This method changes the damping of a system
+	 * @param	system is the system to be changed
+	 * @param	damping is the damping per Time::maxTimeStep
+	 * @return	false if the system doesn't exist
+	 */
+	bool SetDamping(SystemID system, float damping);
+
+	/**
+	 * @brief	This method solves distance constraints after every step
+	 * 			The constraints refer to the particles by their index in GetParticles(),
+	 * 			removing a system moves the particles of the following systems.
+	 * @param	pConstraints are the constraints (not owned, nullptr disables them)
+	 * @param	numIterations is the number of solver iterations per step
+	 */
+	void SetConstraints(BasicDistanceConstraints<Vector>* pConstraints, uint numIterations);
+
+	/**
+	 * @brief	This method advances all systems by one step in one parallel pass
+	 * 			The constraints are solved afterwards.
+	 * @param	timestep is the timestep of this step (the same for all systems)
+	 */
+	void Step(float timestep);
+
+	/**
+	 * @brief	This method copies the particles of all systems into a snapshot
+	 * 			Only 2D worlds have snapshots (they are presented like the simulation).
+	 * @param	snapshot is the snapshot that receives the state
+	 */
+	void WriteSnapshot(SimulationSnapshot& snapshot) const;
+
+	size_t GetNumSystems(void) const;
+	size_t GetNumParticles(void) const;
+	size_t GetNumMaxParticles(void) const;
+	uint64 GetNumSteps(void) const;
+	/**
+	 * @brief	Retrieves the particles of all systems (packed in the order the systems were added)
+	 * @return	const Particle* are the particles
+	 */
+	const Particle* GetParticles(void) const;
+	/**
+	 * @brief	Retrieves the particles of one system
+	 * @param	system is the system
+	 * @param	numParticles is the returned number of particles of the system
+	 * @return	const Particle* is the first particle of the system (nullptr if the system doesn't exist)
+	 */
+	const Particle* GetParticles(SystemID system, size_t& numParticles) const;
+	/**
+	 * @brief	Retrieves the constants of a system
+	 * @param	system is the system
+	 * @return	const SystemConstants* are the constants (nullptr if the system doesn't exist)
+	 */
+	const SystemConstants* GetConstants(SystemID system) const;
+
+private:
+
+	/**
+	 * @brief	This struct defines a system inside the packed particle arrays
+	 */
+	struct System
+	{
+		SystemID id;
+		size_t begin;		/**< the first particle of the system */
+		SystemConstants constants;
+	};
+
+	size_t FindSystem(SystemID system) const;
+
+	ThreadPool* pThreadPool;
+	size_t numMaxParticles;
+	size_t numParticles;
+	MemoryArena* pArena;
+	Particle* pParticles;
+	Vector* pVelocities;
+	uint64 numSteps;
+	SystemID nextSystemID;
+	float timestep;
+	BasicDistanceConstraints<Vector>* pConstraints;
+	uint numConstraintIterations;
+
+	std::vector<System> systems;
+	std::vector<size_t> systemEnds;						/**< the particle after the last of every system */
+	std::vector<Integrators::BasicStepConstants<Vector>> stepConstants;
+
+};
+
+typedef BasicParticleWorld<Math::Vec2> ParticleWorld;
+typedef BasicParticleWorld<Math::Vec3> ParticleWorld3D;
@@ -0,0 +1,26 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares the precisions of the position Verlet integration
+ * 			Every variant (float, Kahan compensated and double arithmetic) is measured,
+ * 			no matter which one the simulations were compiled with.
+ */
+namespace PrecisionStudy
+{
+	/**
+	 * @brief	This method measures the throughput and the drift of every precision and prints their table
+	 * 			The throughput is measured on the particle grid of the simulation, the drift on
+	 * 			a circular orbit around the attractor: the distance to the same integration in
+	 * 			long doubles isolates the rounding error from the error of the integration itself.
+	 * @param	numParticles is the number of particles of the throughput measurement
+	 * @param	numSteps is the number of steps of the throughput measurement
+	 * @param	numOrbitSteps is the number of steps of the reference orbit
+	 * @return	false if the compensated positions drifted further than the plain floats
+	 */
+	bool Run(size_t numParticles, uint numSteps, uint numOrbitSteps);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "types.h"
+
+struct SimulationSnapshot;
+
+/**
+ * @brief	This class defines the interface of everything that
+ * 			can show completed simulation states
+ */
+class Presenter
+{
+public:
+
+	virtual ~Presenter() { }
+
+	/**
+	 * @brief	This method shows a completed simulation state
+	 * 			It may block until the state is on screen (e.g. vsync).
+	 * @param	snapshot is the newest completed simulation state
+	 */
+	virtual void PresentSnapshot(const SimulationSnapshot& snapshot) = 0;
+
+};
@@ -7,6 +7,8 @@
 #include "types.h"
 #include "utils.h"
 
+class ShaderCache;
+class ShaderCompiler;
 struct IDXGISwapChain;
 struct ID3D11Device;
 struct ID3D11DeviceContext;
@@ -210,7 +212,8 @@ public:
 
 	/**
 	 * @brief 	This method compiles a shader from a specified filename
-	 * 			It uses the directory of the main executable.
+	 * 			It uses the working directory. The bytecode is taken from
+	 * 			the shader cache if the shader didn't change since it was compiled.
 	 * 
 	 * @param 	szFileName is the filename of the shader to be loaded
 	 * @param	szEntryPoint is the entry point of the shader program
@@ -241,4 +244,7 @@ protected:
 	ID3D11RenderTargetView1* pBackbuffer;
 	ID3D11DepthStencilView* pDepthBuffer;
 
+	ShaderCompiler* pShaderCompiler;
+	ShaderCache* pShaderCache;
+
 };
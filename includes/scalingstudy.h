@@ -0,0 +1,26 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures how the slab decomposition scales with the number of ranks
+ * 			The ranks are processes on this machine connected by a SocketTransport (POSIX only).
+ */
+namespace ScalingStudy
+{
+	/**
+	 * @brief	This method runs the strong and the weak scaling study and prints their tables
+	 * 			Strong scaling keeps the number of particles of all ranks, weak scaling
+	 * 			the number of particles per rank. The rank counts are the powers of two
+	 * 			up to the largest count and the largest count itself. Call it before any
+	 * 			thread was started, the ranks are forked from the calling process.
+	 * @param	maxRanks is the largest number of ranks
+	 * @param	numParticles is the number of particles of one rank
+	 * @param	numSteps is the number of measured steps of every run
+	 * @return	false if a run failed
+	 */
+	bool Run(uint maxRanks, size_t numParticles, uint numSteps);
+}
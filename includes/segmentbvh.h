@@ -0,0 +1,141 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "particle.h"
+#include "types.h"
+
+class ThreadPool;
+
+/**
+ * @brief	This class holds static walls (line segments) in a bounding volume hierarchy
+ * 			A particle's step is swept against the walls as a segment from its former
+ * 			to its current position, so even particles that cross a wall within one step
+ * 			bounce off it. The hierarchy splits the segments at the median of their centers
+ * 			along the longer axis, so the number of nodes of a subtree only depends on its
+ * 			number of segments: every subtree knows where its nodes go before it is built,
+ * 			and the subtrees below the first levels are built in parallel without locks.
+ * 			The nodes are stored depth first, the left child follows its parent.
+ */
+class SegmentBVH
+{
+public:
+
+	typedef BasicParticle<Math::Vec2> Particle;
+
+	static constexpr uint maxLeafSegments = 4;	/**< a node with at most this many segments is a leaf */
+	static constexpr uint maxBounces = 4;		/**< the walls a particle bounces off in one step, it stops at the last one */
+
+	/**
+	 * @brief	This struct defines a wall
+	 */
+	struct Segment
+	{
+		Math::Vec2 a;
+		Math::Vec2 b;
+	};
+
+	/**
+	 * @brief	This struct defines the first wall a sweep hits
+	 */
+	struct Hit
+	{
+		float t;				/**< the fraction of the sweep before the hit */
+		Math::Vec2 normal;		/**< the normal of the wall, facing the start of the sweep */
+	};
+
+	/**
+	 * @brief	Construct a new SegmentBVH object
+	 */
+	SegmentBVH();
+
+	void AddSegment(Math::Vec2 a, Math::Vec2 b);
+	/**
+	 * @brief	This method removes all walls (the hierarchy is empty until the next Build)
+	 */
+	void Clear(void);
+
+	/**
+	 * @brief	This method builds the hierarchy over all walls
+	 * 			The first levels are split on the calling thread (their bounds are reduced on the
+	 * 			pool), then every thread builds whole subtrees.
+	 * @param	pThreadPool is the pool the subtrees are built on (nullptr builds them on the calling thread)
+	 */
+	void Build(ThreadPool* pThreadPool = nullptr);
+
+	/**
+	 * @brief	This method finds the first wall on the way from one point to another
+	 * @param	from is the start of the sweep
+	 * @param	to is the end of the sweep
+	 * @param	hit is the returned first hit
+	 * @param	pNumVisitedNodes is incremented by the number of nodes the traversal visited (nullptr doesn't count)
+	 * @return	true if a wall is hit
+	 */
+	bool Sweep(const Math::Vec2& from, const Math::Vec2& to, Hit& hit, uint64* pNumVisitedNodes = nullptr) const;
+	/**
+	 * @brief	This method finds the first wall by testing every wall (the reference of Sweep)
+	 * @return	true if a wall is hit
+	 */
+	bool SweepAll(const Math::Vec2& from, const Math::Vec2& to, Hit& hit) const;
+
+	/**
+	 * @brief	This method lets a range of particles bounce off the walls
+	 * 			The step from "position" to "nextPosition" is swept. On a hit the rest of the step
+	 * 			and the velocity are reflected at the wall and scaled by the damping, the particle
+	 * 			then continues from just before the wall. Without velocities (position Verlet) the
+	 * 			velocity is the last displacement, so the former position is moved instead.
+	 * @param	pParticles are the particles
+	 * @param	pVelocities are the velocities of the velocity based integrators (nullptr for position Verlet)
+	 * @param	begin is the first particle of the range
+	 * @param	end is the particle after the last particle of the range
+	 * @param	damping is the fraction of the speed a particle keeps on a bounce (0 to 1)
+	 * @return	size_t is the number of particles that hit a wall
+	 */
+	size_t Collide(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float damping) const;
+
+	size_t GetNumSegments(void) const;
+	size_t GetNumNodes(void) const;
+	uint GetDepth(void) const;
+	/**
+	 * @brief	Retrieves the time the last Build took
+	 * @return	uint64 is the build time in microseconds
+	 */
+	uint64 GetBuildTime(void) const;
+
+private:
+
+	/**
+	 * @brief	This struct defines a node of the hierarchy
+	 */
+	struct Node
+	{
+		Math::Vec2 boundsMin;
+		Math::Vec2 boundsMax;
+		uint32 offset;		/**< the first segment (leaf) or the right child (inner node) */
+		uint32 count;		/**< the number of segments (0 for inner nodes) */
+	};
+
+	/**
+	 * @brief	This struct defines a subtree that is still to be built
+	 */
+	struct Subtree
+	{
+		size_t begin;		/**< the first segment */
+		size_t end;			/**< the segment after the last */
+		size_t node;		/**< the index of its root */
+		uint depth;
+	};
+
+	static size_t NumNodes(size_t numSegments);
+	uint BuildSubtree(const Subtree& subtree);
+	void SplitSegments(const Subtree& subtree, const Math::Vec2& centerMin, const Math::Vec2& centerMax, Subtree& left, Subtree& right);
+
+	std::vector<Segment> segments;	/**< in the order of the leaves after a build */
+	std::vector<Node> nodes;
+	uint depth;
+	uint64 buildTime;
+
+};
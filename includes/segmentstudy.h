@@ -0,0 +1,23 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the swept collision with walls in a bounding volume hierarchy
+ */
+namespace SegmentStudy
+{
+	/**
+	 * @brief	This method prints the cost of a sweep for growing numbers of walls and a simulation inside a ring of walls
+	 * 			Every particle's step is swept once through the hierarchy and, for a part of the
+	 * 			particles, against every wall. Then the simulation falls onto a ring of thin walls
+	 * 			around its attractor, once swept and once baked as capsules into an obstacle field.
+	 * @param	numParticles is the number of particles
+	 * @param	numSteps is the number of simulated steps
+	 * @return	false if a sweep through the hierarchy finds another hit than testing every wall
+	 */
+	bool Run(size_t numParticles, uint numSteps);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <string>
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+class ShaderCompiler;
+
+/**
+ * @brief	This class defines a content addressed on-disk cache of shader bytecode
+ * 			The key is a hash of the source text, the text of every included file,
+ * 			the entry point, the shader model, the compile flags and the compiler
+ * 			version. Any change of those compiles the shader again, a cached blob
+ * 			is only used if its header and checksum match.
+ */
+class ShaderCache
+{
+public:
+
+	/**
+	 * @brief	Construct a new ShaderCache object
+	 * @param	pDirectory is the directory the blobs are stored in (created on demand)
+	 * @param	pCompiler is the compiler used on cache misses (not owned)
+	 */
+	ShaderCache(const char* pDirectory, ShaderCompiler* pCompiler);
+
+	/**
+	 * @brief	This method loads the bytecode of a shader
+	 * 			It is read from the cache or compiled and stored in the cache.
+	 * @param	pFileName is the shader file (relative to the working directory)
+	 * @param	pEntryPoint is the entry point of the shader program
+	 * @param	pShaderModel is the desired shader model version
+	 * @param	flags are the compile flags
+	 * @param	bytecode is the returned shader bytecode
+	 * @return	false if the source can't be read or compiled
+	 */
+	bool Load(const char* pFileName, const char* pEntryPoint, const char* pShaderModel, uint32 flags, std::vector<byte>& bytecode);
+
+	uint GetNumHits(void) const;
+	uint GetNumMisses(void) const;
+	/**
+	 * @brief	Retrieves the time spent in Load
+	 * @return	uint64 is the accumulated load time in microseconds
+	 */
+	uint64 GetLoadTime(void) const;
+
+private:
+
+	/**
+	 * @brief	This struct defines the header in front of every cached blob
+	 */
+	struct BlobHeader
+	{
+		uint32 magic;
+		uint32 formatVersion;
+		uint64 key;
+		uint64 size;
+		uint64 checksum;
+	};
+
+	uint64 HashSource(const std::string& fileName, const std::string& source, const char* pEntryPoint, const char* pShaderModel, uint32 flags) const;
+	bool ReadBlob(const std::string& path, uint64 key, std::vector<byte>& bytecode) const;
+	bool WriteBlob(const std::string& path, uint64 key, const std::vector<byte>& bytecode) const;
+
+	std::string directory;
+	ShaderCompiler* pCompiler;
+	uint numHits;
+	uint numMisses;
+	uint64 loadTime;
+
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the shader cache without Direct3D
+ */
+namespace ShaderCacheStudy
+{
+	/**
+	 * @brief	This method loads the shaders of the renderer through the cache and the stub compiler
+	 * 			The shaders are copied into a temporary directory with an empty cache. They are loaded
+	 * 			once cold (every shader misses), then warm over and over (every shader hits) and once
+	 * 			more after one source file was edited (only its shaders miss) and once with other
+	 * 			compile flags (every shader misses and gets other bytecode). The stub compiles
+	 * 			instantly, so the times are those of reading, hashing and writing the blobs.
+	 * @param	pShaderDirectory is the directory the shader files are read from
+	 * @param	numRounds is the number of warm loads of every shader
+	 * @return	false if a shader can't be loaded, a load misses or hits unexpectedly
+	 * 			or a cached blob differs from the compiled bytecode, or other flags share bytecode
+	 */
+	bool Run(const char* pShaderDirectory, uint numRounds);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <string>
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This class defines the interface of a shader compiler
+ * 			It turns shader source text into bytecode, the
+ * 			ShaderCache only calls it for sources it hasn't seen yet.
+ */
+class ShaderCompiler
+{
+public:
+
+	virtual ~ShaderCompiler() { }
+
+	/**
+	 * @brief	Retrieves the version of the compiler
+	 * 			It is part of the cache key, another compiler never reuses cached bytecode.
+	 * @return	const char* is the version string
+	 */
+	virtual const char* GetVersion(void) const = 0;
+
+	/**
+	 * @brief	This method compiles shader source text
+	 * @param	source is the source text of the shader file
+	 * @param	pFileName is the name of the shader file (includes are resolved relative to it)
+	 * @param	pEntryPoint is the entry point of the shader program
+	 * @param	pShaderModel is the desired shader model version
+	 * @param	flags are the compile flags
+	 * @param	bytecode is the returned shader bytecode
+	 * @return	false if the shader couldn't be compiled
+	 */
+	virtual bool Compile(const std::string& source, const char* pFileName, const char* pEntryPoint, const char* pShaderModel, uint32 flags, std::vector<byte>& bytecode) = 0;
+
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace defines the layout of the shared memory ring the states are published in
+ * 			The ring starts with a Header followed by numSlots slots. Every slot is a
+ * 			SlotHeader followed by the particles of one state (the layout of
+ * 			ParticleSimulation::Particle). Frame f goes into slot f % numSlots.
+ * 			A slot is guarded by its sequence number: it is 2f + 1 while frame f
+ * 			is written and 2f + 2 once it is complete. Readers check it before
+ * 			and after they read a slot, the writer never waits for them.
+ */
+namespace SharedState
+{
+	constexpr uint32 magic = 0x52535047;	/**< "GPSR" */
+	constexpr uint32 version = 1;
+	constexpr size_t alignment = 64;		/**< every slot starts on its own cache line */
+
+	/**
+	 * @brief	This struct defines the start of the ring
+	 */
+	struct alignas(alignment) Header
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 numSlots;
+		uint32 particleSize;			/**< the size of one particle in bytes */
+		uint64 maxParticles;			/**< the number of particles a slot has room for */
+		uint64 slotSize;				/**< the distance between two slots in bytes */
+		std::atomic<uint64> numFrames;	/**< the number of completed frames (the newest is numFrames - 1) */
+	};
+
+	/**
+	 * @brief	This struct defines the start of a slot
+	 */
+	struct alignas(alignment) SlotHeader
+	{
+		std::atomic<uint64> sequence;	/**< odd while the slot is written */
+		uint64 frame;					/**< the frame in the slot */
+		uint64 step;					/**< the simulation step of the state */
+		uint64 timestamp;				/**< the simulation clock of the state (microseconds) */
+		uint64 publishTime;				/**< the steady clock when the frame was completed (microseconds, see Time::Now) */
+		uint64 numParticles;			/**< the number of particles in the slot */
+	};
+
+	static_assert(std::atomic<uint64>::is_always_lock_free, "the sequence numbers are shared between processes");
+
+	/**
+	 * @brief	This method calculates the distance between two slots
+	 * @param	maxParticles is the number of particles a slot has room for
+	 * @param	particleSize is the size of one particle in bytes
+	 * @return	size_t is the slot size in bytes
+	 */
+	inline size_t GetSlotSize(size_t maxParticles, size_t particleSize)
+	{
+		return (sizeof(SlotHeader) + maxParticles * particleSize + alignment - 1) & ~(alignment - 1);
+	}
+	/**
+	 * @brief	This method calculates the size of a whole ring
+	 * @param	numSlots is the number of slots
+	 * @param	slotSize is the distance between two slots in bytes
+	 * @return	size_t is the ring size in bytes
+	 */
+	inline size_t GetRingSize(uint numSlots, size_t slotSize)
+	{
+		return sizeof(Header) + numSlots * slotSize;
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "particlesimulation.h"
+#include "sharedstate.h"
+#include "types.h"
+
+/**
+ * @brief	This class reads the states a SharedStateWriter publishes
+ * 			The ring is mapped read only and a frame points right into it.
+ * 			Since the writer may overwrite a slot at any time, check IsValid
+ * 			after the frame was used: if it fails the data was torn and has to
+ * 			be dropped. Nothing is locked, so readers never slow the writer down.
+ */
+class SharedStateReader
+{
+public:
+
+	/**
+	 * @brief	This struct defines a frame in the ring
+	 */
+	struct Frame
+	{
+		const ParticleSimulation::Particle* pParticles;	/**< the particles (inside the shared memory) */
+		size_t numParticles;
+		uint64 frame;			/**< the number of the frame since the ring was created */
+		uint64 step;			/**< the simulation step of the state */
+		uint64 timestamp;		/**< the simulation clock of the state (microseconds) */
+		uint64 publishTime;		/**< the steady clock when the frame was completed (microseconds, see Time::Now) */
+		uint64 sequence;		/**< the sequence number the slot had when the frame was acquired */
+		uint slot;
+	};
+
+	SharedStateReader();
+	~SharedStateReader();
+
+	/**
+	 * @brief	This method maps an existing ring read only
+	 * @param	pName is the name the writer created the ring with
+	 * @return	false if there is no compatible ring of that name
+	 */
+	bool Open(const char* pName);
+	void Close(void);
+
+	/**
+	 * @brief	This method retrieves the newest completed frame
+	 * @param	frame is the returned frame
+	 * @return	false if no frame was completed yet
+	 */
+	bool AcquireLatest(Frame& frame) const;
+	/**
+	 * @brief	This method retrieves a frame by its number
+	 * @param	frameNumber is the number of the frame
+	 * @param	frame is the returned frame
+	 * @return	false if the frame wasn't completed yet or was overwritten already
+	 */
+	bool Acquire(uint64 frameNumber, Frame& frame) const;
+	/**
+	 * @brief	This method checks whether a frame is still intact
+	 * 			Call it after reading the particles of the frame.
+	 * @param	frame is the frame that was read
+	 * @return	false if the writer started to overwrite the frame meanwhile
+	 */
+	bool IsValid(const Frame& frame) const;
+
+	/**
+	 * @brief	Retrieves the number of completed frames
+	 * @return	uint64 is the number of frames the writer published (the newest is this - 1)
+	 */
+	uint64 GetNumFrames(void) const;
+	uint GetNumSlots(void) const;
+	size_t GetMaxParticles(void) const;
+
+private:
+
+	const byte* pRing;
+	size_t ringSize;
+	const SharedState::Header* pHeader;
+
+};
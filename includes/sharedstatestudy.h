@@ -0,0 +1,23 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the shared memory ring the completed states are published in
+ */
+namespace SharedStateStudy
+{
+	/**
+	 * @brief	This method publishes states into a ring as fast as it can while a reader consumes them in place
+	 * 			The reader maps the ring on its own like another process would and reads every frame
+	 * 			it acquires. Every state carries its frame number in its first and last particle.
+	 * @param	numParticles is the number of particles of a state
+	 * @param	numFrames is the number of published states
+	 * @param	numSlots is the number of states the ring holds
+	 * @return	true if the reader got frames and every frame that it validated was intact
+	 */
+	bool Run(size_t numParticles, uint numFrames, uint numSlots);
+}
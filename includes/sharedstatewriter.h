@@ -0,0 +1,55 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <string>
+// INTERNAL INCLUDES
+#include "particlesimulation.h"
+#include "sharedstate.h"
+#include "types.h"
+
+/**
+ * @brief	This class publishes completed states into a POSIX shared memory ring
+ * 			Other processes map the ring read only with a SharedStateReader and
+ * 			read the states in place. The writer never waits for a reader, a
+ * 			reader that is slower than numSlots - 1 frames misses frames.
+ */
+class SharedStateWriter
+{
+public:
+
+	SharedStateWriter();
+	~SharedStateWriter();
+
+	/**
+	 * @brief	This method creates the shared memory ring (an existing one of the same name is replaced)
+	 * @param	pName is the name of the shared memory object (e.g. "/particles")
+	 * @param	numSlots is the number of states the ring holds
+	 * @param	maxParticles is the largest number of particles of a state
+	 * @return	false if the ring couldn't be created (always on Windows)
+	 */
+	bool Create(const char* pName, uint numSlots, size_t maxParticles);
+	/**
+	 * @brief	This method removes the ring, readers that still map it keep their mapping
+	 */
+	void Destroy(void);
+
+	/**
+	 * @brief	This method publishes a state
+	 * @param	pParticles are the particles of the state
+	 * @param	numParticles is the number of particles (at most the maxParticles of the ring)
+	 * @param	step is the simulation step of the state
+	 * @param	timestamp is the simulation clock of the state (microseconds)
+	 */
+	void Publish(const ParticleSimulation::Particle* pParticles, size_t numParticles, uint64 step, uint64 timestamp);
+
+	uint64 GetNumFrames(void) const;
+
+private:
+
+	std::string name;
+	byte* pRing;
+	size_t ringSize;
+	SharedState::Header* pHeader;
+
+};
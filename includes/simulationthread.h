@@ -0,0 +1,109 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+#include <thread>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "framegovernor.h"
+#include "inputevent.h"
+#include "metrics.h"
+#include "particlesimulation.h"
+#include "sharedstatewriter.h"
+#include "streamserver.h"
+#include "timestepcontroller.h"
+#include "triplebuffer.h"
+#include "types.h"
+
+/**
+ * @brief	This class runs a particle simulation on its own thread
+ * 			Every completed step is published into a triple buffer,
+ * 			so presenting never stalls the simulation and vice versa.
+ */
+class SimulationThread
+{
+public:
+
+	/**
+	 * @brief	This struct defines the settings of the simulation thread
+	 */
+	struct Settings
+	{
+		float timestep = Time::maxTimeStep;				/**< the simulated time per step in seconds */
+		bool throttle = true;							/**< keeps the simulation clock in sync with the wall clock */
+		bool adaptiveTimestep = false;					/**< picks the timestep of each step from an error estimate (for the finest substep of block timesteps) */
+		TimestepController::Settings timestepSettings;	/**< the bounds of the adaptive timestep */
+		MetricsRegistry::Counter* pStepCounter = nullptr;	/**< counts the completed steps (optional) */
+		MetricsRegistry::Histogram* pStepTimes = nullptr;	/**< records the wall clock time of every step in seconds (optional) */
+		SharedStateWriter* pSharedState = nullptr;			/**< publishes every completed state to other processes too (optional) */
+		StreamServer* pStreamServer = nullptr;				/**< streams every completed state to remote viewers too (optional) */
+	};
+
+	/**
+	 * @brief	Construct a new SimulationThread object
+	 * @param	pSimulation is the simulation that is stepped (owned by the thread while running)
+	 * @param	pInputEvents is the queue of input events that is drained before every step or substep (nullptr without input)
+	 * @param	pSnapshots is the triple buffer the completed states are published to
+	 */
+	SimulationThread(ParticleSimulation* pSimulation, InputEventQueue* pInputEvents, TripleBuffer<SimulationSnapshot>* pSnapshots);
+	~SimulationThread();
+
+	/**
+	 * @brief	This method starts stepping the simulation on a new thread
+	 * @param	settings are the settings used while the thread is running
+	 */
+	void Start(const Settings& settings);
+	/**
+	 * @brief	This method stops the thread and waits for it to finish its current step
+	 */
+	void Stop(void);
+
+	/**
+	 * @brief	This method changes the quality of the following steps
+	 * 			This may be called from any thread, the simulation thread applies it before its next step.
+	 * 			The render decimation publishes only every n-th step to the presenter.
+	 * @param	quality is the new quality
+	 */
+	void SetQuality(const FrameGovernor::Quality& quality);
+
+	/**
+	 * @brief	Retrieves the number of steps simulated since the thread was started
+	 * 			This may be called from any thread.
+	 * @return	uint64 is the number of completed steps
+	 */
+	uint64 GetNumSteps(void) const;
+	/**
+	 * @brief	Retrieves the simulated time since the thread was started
+	 * 			This may be called from any thread.
+	 * @return	uint64 is the sum of all timesteps in microseconds
+	 */
+	uint64 GetSimulatedTime(void) const;
+	/**
+	 * @brief	Retrieves the wall clock time of the last step including the publishing of its state
+	 * 			This may be called from any thread.
+	 * @return	uint64 is the time of the last step in microseconds
+	 */
+	uint64 GetLastStepTime(void) const;
+
+private:
+
+	void Run(void);
+
+	ParticleSimulation* pSimulation;
+	InputEventQueue* pInputEvents;
+	TripleBuffer<SimulationSnapshot>* pSnapshots;
+
+	Settings settings;
+	std::thread thread;
+	std::atomic<bool> isRunning;
+	std::atomic<uint64> numSteps;
+	std::atomic<uint64> simulatedTime;
+	std::atomic<uint64> lastStepTime;
+
+	// the quality is handed over field by field, the flag publishes it
+	std::atomic<uint> numTimeBins;
+	std::atomic<size_t> particleBudget;
+	std::atomic<uint> renderDecimation;
+	std::atomic<bool> isQualityChanged;
+
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "particlesimulation.h"
+#include "types.h"
+
+class Transport;
+
+/**
+ * @brief	This class simulates the slab of one rank of a distributed simulation
+ * 			The domain is split along x into one slab of equal width per rank (the
+ * 			outer slabs reach to infinity). Every rank integrates the particles of
+ * 			its slab with the time corrected position Verlet of IntegrateCS and
+ * 			hands the particles that left it to its neighbours afterwards. A particle
+ * 			that crossed more than one slab is passed on in the following steps,
+ * 			the particles don't interact so it is integrated correctly meanwhile.
+ * 			Particles within the halo width of a slab boundary are sent along as
+ * 			read only copies, so kernels that need the neighbourhood of a particle
+ * 			see across the boundary.
+ */
+class SlabSimulation
+{
+public:
+
+	/**
+	 * @brief	Construct a new SlabSimulation object
+	 * @param	pTransport connects this rank with the others
+	 * @param	domainMin is the lower x boundary of the domain
+	 * @param	domainMax is the upper x boundary of the domain
+	 * @param	haloWidth is the distance from a slab boundary the neighbours get copies of the particles within (0 sends no halo)
+	 */
+	SlabSimulation(Transport* pTransport, float domainMin, float domainMax, float haloWidth = 0.0f);
+
+	/**
+	 * @brief	This method places the particles of this slab on the start grid
+	 * 			Every rank walks the whole grid of ParticleSimulation and keeps the particles of its slab.
+	 * @param	numParticles is the number of particles of all ranks together
+	 */
+	void SetupParticles(size_t numParticles);
+
+	/**
+	 * @brief	This method integrates the particles of this slab and exchanges them with the neighbours
+	 * 			All ranks have to step together.
+	 * @param	timestep is the timestep of this step
+	 * @return	false if a neighbour is gone
+	 */
+	bool Step(float timestep);
+
+	size_t GetNumParticles(void) const;
+	const std::vector<ParticleSimulation::Particle>& GetParticles(void) const;
+	/**
+	 * @brief	Retrieves the copies of the particles of the neighbours close to the slab boundaries
+	 * @return	const std::vector<ParticleSimulation::Particle>& are the halo particles of the last step
+	 */
+	const std::vector<ParticleSimulation::Particle>& GetHaloParticles(void) const;
+	/**
+	 * @brief	Retrieves the number of particles this rank handed to its neighbours
+	 * @return	uint64 is the number of migrated particles since the setup
+	 */
+	uint64 GetNumMigratedParticles(void) const;
+	/**
+	 * @brief	Retrieves the time spent integrating
+	 * @return	uint64 is the accumulated integration time in microseconds
+	 */
+	uint64 GetIntegrationTime(void) const;
+	/**
+	 * @brief	Retrieves the time spent packing and exchanging particles (including waiting for the neighbours)
+	 * @return	uint64 is the accumulated exchange time in microseconds
+	 */
+	uint64 GetExchangeTime(void) const;
+
+private:
+
+	bool ExchangeWith(uint rank, const std::vector<byte>& sendData);
+
+	Transport* pTransport;
+	float slabMin;
+	float slabMax;
+	float haloWidth;
+	ParticleSimulation::SimulationConstants constants;
+	uint64 numMigratedParticles;
+	uint64 integrationTime;
+	uint64 exchangeTime;
+
+	std::vector<ParticleSimulation::Particle> particles;
+	std::vector<ParticleSimulation::Particle> haloParticles;
+	std::vector<byte> receiveData;
+
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <vector>
+// INTERNAL INCLUDES
+#include "transport.h"
+#include "types.h"
+
+/**
+ * @brief	This class connects ranks on one machine with Unix domain sockets
+ * 			Spawn forks the ranks from the calling process, every pair of ranks
+ * 			shares a socket pair (POSIX only).
+ */
+class SocketTransport : public Transport
+{
+public:
+
+	/**
+	 * @brief	This method forks the processes of all other ranks
+	 * 			Fork before any other thread was started, only the calling thread
+	 * 			continues in the new processes. Every process returns with its own
+	 * 			rank, the calling process is rank 0.
+	 * @param	numRanks is the number of ranks including the calling process
+	 * @return	SocketTransport* is the transport of the returning process (nullptr if the ranks couldn't be created)
+	 */
+	static SocketTransport* Spawn(uint numRanks);
+
+	~SocketTransport();
+
+	/**
+	 * @brief	This method waits until the processes of all other ranks exited (rank 0 only)
+	 * @return	false if a rank failed
+	 */
+	bool WaitForRanks(void);
+
+	uint GetRank(void) const override;
+	uint GetNumRanks(void) const override;
+	bool Exchange(uint rank, const std::vector<byte>& sendData, std::vector<byte>& receiveData) override;
+
+private:
+
+	SocketTransport(uint rank, const std::vector<int>& sockets, const std::vector<int>& processIDs);
+
+	uint rank;
+	std::vector<int> sockets;		/**< the socket to every other rank (-1 for this rank) */
+	std::vector<int> processIDs;	/**< the processes of the other ranks (rank 0 only) */
+
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "streamcodec.h"
+#include "types.h"
+
+/**
+ * @brief	This class receives the states a StreamServer streams
+ * 			It is the network side of a remote viewer.
+ */
+class StreamClient
+{
+public:
+
+	StreamClient();
+	~StreamClient();
+
+	/**
+	 * @brief	This method connects to a stream server
+	 * @param	pHost is the name or address of the server
+	 * @param	port is the TCP port of the server
+	 * @return	false if the server can't be reached
+	 */
+	bool Connect(const char* pHost, uint16 port);
+	/**
+	 * @brief	This method closes the connection
+	 */
+	void Close(void);
+
+	/**
+	 * @brief	This method waits for the next state and decodes it
+	 * @param	header is the returned header of the frame (its level tells the stride of the particles)
+	 * @param	positions are the returned positions of the sent particles (particle id = index * stride)
+	 * @return	false if the connection was closed or the stream is broken
+	 */
+	bool Receive(StreamCodec::FrameHeader& header, std::vector<Math::Vec2>& positions);
+
+	/**
+	 * @brief	Retrieves the number of received bytes
+	 * @return	uint64 is the number of bytes including the message sizes
+	 */
+	uint64 GetNumReceivedBytes(void) const;
+
+private:
+
+	bool ReceiveAll(byte* pData, size_t size);
+
+	uint64 socket;
+	StreamDecoder decoder;
+	std::vector<byte> message;
+	uint64 numReceivedBytes;
+
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "types.h"
+
+/**
+ * @brief	This namespace defines the frames particle states are streamed in
+ * 			The positions are quantized on a grid over fixed bounds. A keyframe
+ * 			codes every position against the one of the previous particle. A
+ * 			delta frame expects every particle to move like the previous one,
+ * 			which moved from a base position: the particle's position in the
+ * 			last frame or where it would be if it moved on as before (see
+ * 			Predictor). Every delta frame picks the base it codes smallest
+ * 			with. The differences are Huffman coded by their bit length (with
+ * 			a table per frame) followed by their remaining bits. The particles
+ * 			have to be in the same order in every frame (ordered by their id).
+ */
+namespace StreamCodec
+{
+	/**
+	 * @brief	This struct defines the precision of a frame
+	 */
+	struct Level
+	{
+		uint bits;		/**< the bits per quantized coordinate */
+		uint stride;	/**< only every stride-th particle is sent */
+	};
+
+	constexpr uint numLevels = 5;
+	constexpr Level levels[numLevels] = { { 16, 1 }, { 12, 1 }, { 10, 1 }, { 10, 2 }, { 8, 4 } }; /**< the levels from the finest to the coarsest */
+
+	/**
+	 * @brief	FrameType defines the messages of a stream
+	 */
+	enum FrameType : uint8
+	{
+		Hello,		/**< the first message, it holds the bounds */
+		Keyframe,	/**< positions that don't depend on another frame */
+		DeltaFrame	/**< positions relative to the frames before */
+	};
+
+	/**
+	 * @brief	Predictor defines the base positions of a frame
+	 * 			A position is predicted as its base plus how far the previous
+	 * 			particle ended up from its own base.
+	 */
+	enum Predictor : uint8
+	{
+		PreviousParticle,	/**< no base, a position follows the previous particle (keyframes) */
+		LastFrame,			/**< the position in the last frame */
+		Extrapolated,		/**< the position in the last frame plus the motion from the frame before */
+		NumPredictors
+	};
+
+	/**
+	 * @brief	This struct defines the start of every frame
+	 */
+	struct FrameHeader
+	{
+		uint8 type;
+		uint8 level;
+		uint8 predictor;		/**< the base positions of the frame (see Predictor) */
+		uint8 reserved;
+		uint32 numParticles;	/**< the number of particles of the state (before the stride) */
+		uint64 step;			/**< the simulation step of the state */
+	};
+
+	/**
+	 * @brief	This method calculates the number of particles a frame holds
+	 * @param	numParticles is the number of particles of the state
+	 * @param	level is the level of the frame
+	 * @return	size_t is the number of sent particles
+	 */
+	inline size_t GetNumSentParticles(size_t numParticles, uint level)
+	{
+		return (numParticles + levels[level].stride - 1) / levels[level].stride;
+	}
+}
+
+/**
+ * @brief	This class encodes the frames of one stream
+ * 			It remembers the quantized positions it sent last, so every
+ * 			stream needs its own encoder.
+ */
+class StreamEncoder
+{
+public:
+
+	/**
+	 * @brief	Construct a new StreamEncoder object
+	 * @param	boundsMin is the lower corner of the quantization grid (positions outside are clamped)
+	 * @param	boundsMax is the upper corner of the quantization grid
+	 */
+	StreamEncoder(Math::Vec2 boundsMin, Math::Vec2 boundsMax);
+
+	/**
+	 * @brief	This method encodes the first message of a stream
+	 * @param	frame is the returned message (it is appended)
+	 */
+	void EncodeHello(std::vector<byte>& frame) const;
+
+	/**
+	 * @brief	This method encodes a frame
+	 * 			A keyframe is encoded whenever the level or the number of particles changed.
+	 * @param	pPositions are the positions of all particles ordered by their id
+	 * @param	numParticles is the number of particles
+	 * @param	step is the simulation step of the state
+	 * @param	level is the level of the frame (see StreamCodec::levels)
+	 * @param	keyframe forces a keyframe
+	 * @param	frame is the returned frame (it is appended)
+	 */
+	void Encode(const Math::Vec2* pPositions, size_t numParticles, uint64 step, uint level, bool keyframe, std::vector<byte>& frame);
+	/**
+	 * @brief	This method forgets the last frame, so the next one is a keyframe
+	 */
+	void Reset(void);
+
+private:
+
+	Math::Vec2 boundsMin;
+	Math::Vec2 boundsMax;
+	uint level;
+	std::vector<uint16> reference;			/**< the quantized coordinates of the last frame */
+	std::vector<uint16> previousReference;	/**< the quantized coordinates of the frame before the last */
+	std::vector<uint32> values;				/**< the quantized coordinates, then the zigzag coded differences of the current frame */
+
+};
+
+/**
+ * @brief	This class decodes the frames of one stream
+ */
+class StreamDecoder
+{
+public:
+
+	StreamDecoder();
+
+	/**
+	 * @brief	This method decodes a message of the stream
+	 * @param	pData is the message
+	 * @param	size is the size of the message in bytes
+	 * @param	header is the returned header of the message
+	 * @param	positions are the returned positions of the sent particles (particle id = index * stride)
+	 * @return	false if the message is broken or a delta frame arrived without its reference
+	 */
+	bool Decode(const byte* pData, size_t size, StreamCodec::FrameHeader& header, std::vector<Math::Vec2>& positions);
+
+private:
+
+	Math::Vec2 boundsMin;
+	Math::Vec2 boundsMax;
+	bool hasBounds;
+	uint level;
+	std::vector<uint16> reference;
+	std::vector<uint16> previousReference;
+
+};
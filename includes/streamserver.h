@@ -0,0 +1,138 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+// INTERNAL INCLUDES
+#include "math/vec2.h"
+#include "particlesimulation.h"
+#include "streamcodec.h"
+#include "triplebuffer.h"
+#include "types.h"
+
+/**
+ * @brief	This class streams the completed states to remote viewers over TCP
+ * 			Every state is encoded for every client on the serving thread (see
+ * 			StreamCodec), the simulation only hands the positions over. A client
+ * 			gets a byte budget per second. A frame is dropped for a client that
+ * 			is over its budget or hasn't received the previous frame yet, and the
+ * 			client moves down to a coarser level. After a run of delivered frames
+ * 			it moves up again. Every message is its size (uint32) followed by a frame.
+ */
+class StreamServer
+{
+public:
+
+	/**
+	 * @brief	This struct defines the settings of a stream server
+	 */
+	struct Settings
+	{
+		double bytesPerSecond = 4000000.0;			/**< the budget of every client */
+		uint keyframeInterval = 120;				/**< a keyframe is sent at least every this many frames */
+		uint numUpgradeFrames = 120;				/**< the delivered frames in a row before a client moves up a level */
+		Math::Vec2 boundsMin = { -1.0f, -1.0f };	/**< the lower corner of the quantization grid */
+		Math::Vec2 boundsMax = { 1.0f, 1.0f };		/**< the upper corner of the quantization grid */
+	};
+
+	StreamServer();
+	~StreamServer();
+
+	/**
+	 * @brief	This method starts listening on all interfaces
+	 * @param	port is the TCP port
+	 * @param	settings are the settings used while the server is running
+	 * @return	false if the port can't be bound
+	 */
+	bool Start(uint16 port, const Settings& settings);
+	/**
+	 * @brief	This method disconnects all clients and waits for the serving thread
+	 */
+	void Stop(void);
+
+	/**
+	 * @brief	This method hands a completed state to the serving thread
+	 * 			The positions are put into id order, so the frames stay comparable
+	 * 			while the simulation reorders its particles. Nothing is copied
+	 * 			while no client is connected.
+	 * @param	pParticles are the particles of the state (their current positions are sent, see Integrators)
+	 * @param	pParticleIDs are the ids of the particles (see ParticleSimulation::GetParticleIDs)
+	 * @param	numParticles is the number of particles
+	 * @param	step is the simulation step of the state
+	 */
+	void Publish(const ParticleSimulation::Particle* pParticles, const uint32* pParticleIDs, size_t numParticles, uint64 step);
+
+	uint64 GetNumClients(void) const;
+	/**
+	 * @brief	Retrieves the number of frames that were encoded for all clients
+	 * @return	uint64 is the number of encoded frames
+	 */
+	uint64 GetNumFrames(void) const;
+	/**
+	 * @brief	Retrieves the number of frames that were dropped for all clients
+	 * @return	uint64 is the number of dropped frames
+	 */
+	uint64 GetNumDroppedFrames(void) const;
+	/**
+	 * @brief	Retrieves the size of all encoded frames
+	 * @return	uint64 is the number of bytes
+	 */
+	uint64 GetNumFrameBytes(void) const;
+	/**
+	 * @brief	Retrieves the number of particles of all encoded states (before the levels left particles out)
+	 * @return	uint64 is the number of particles
+	 */
+	uint64 GetNumFrameParticles(void) const;
+	/**
+	 * @brief	Retrieves the time spent encoding
+	 * @return	uint64 is the accumulated encode time in microseconds
+	 */
+	uint64 GetEncodeTime(void) const;
+
+private:
+
+	/**
+	 * @brief	This struct defines a state handed to the serving thread
+	 */
+	struct Frame
+	{
+		std::vector<Math::Vec2> positions;	/**< the positions ordered by particle id */
+		uint64 step;
+	};
+	/**
+	 * @brief	This struct defines a connected viewer
+	 */
+	struct Client
+	{
+		uint64 socket;
+		StreamEncoder encoder;
+		std::vector<byte> pending;		/**< the messages that weren't sent yet */
+		size_t numPendingSent;			/**< the bytes of pending that were sent */
+		double budget;					/**< the bytes the client may still receive */
+		uint level;
+		uint numDeliveredFrames;		/**< the frames delivered since the last drop */
+		uint numDeltaFrames;			/**< the frames since the last keyframe */
+	};
+
+	void Run(void);
+	void Accept(void);
+	void Encode(Client& client, const Frame& frame);
+	bool Flush(Client& client);
+
+	Settings settings;
+	uint64 listenSocket;
+	std::thread thread;
+	std::atomic<bool> isRunning;
+	TripleBuffer<Frame> frames;
+	std::vector<Client> clients;
+
+	std::atomic<uint64> numClients;
+	std::atomic<uint64> numFrames;
+	std::atomic<uint64> numDroppedFrames;
+	std::atomic<uint64> numFrameBytes;
+	std::atomic<uint64> numFrameParticles;
+	std::atomic<uint64> encodeTime;
+
+};
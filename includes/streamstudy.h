@@ -0,0 +1,21 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace measures the codec the states are streamed in
+ */
+namespace StreamStudy
+{
+	/**
+	 * @brief	This method encodes and decodes the simulated states at every level of the stream codec
+	 * 			Every level codes the first state as a keyframe and the others as delta frames.
+	 * @param	numParticles is the number of simulated particles
+	 * @param	numFrames is the number of coded states
+	 * @return	true if every frame decodes to its quantized positions
+	 */
+	bool Run(size_t numParticles, uint numFrames);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "shadercompiler.h"
+#include "types.h"
+
+/**
+ * @brief	This class defines a shader compiler that doesn't compile
+ * 			The bytecode is the entry point, the shader model, the flags
+ * 			and the source text, so the cache can be exercised without Direct3D.
+ */
+class StubShaderCompiler : public ShaderCompiler
+{
+public:
+
+	/**
+	 * @brief	Construct a new StubShaderCompiler object
+	 */
+	StubShaderCompiler();
+
+	const char* GetVersion(void) const override;
+	/**
+	 * @brief	This method "compiles" shader source text
+	 * 			It fails if the entry point doesn't appear in the source.
+	 */
+	bool Compile(const std::string& source, const char* pFileName, const char* pEntryPoint, const char* pShaderModel, uint32 flags, std::vector<byte>& bytecode) override;
+
+	/**
+	 * @brief	Retrieves how often the compiler was invoked
+	 * @return	uint is the number of compilations
+	 */
+	uint GetNumCompiles(void) const;
+
+private:
+
+	uint numCompiles;
+
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+/**
+ * @brief	This namespace dispatches the studies of the start arguments
+ * 			Every study is an entry of one table with its flag, its arguments
+ * 			and their defaults, a new study only adds an entry there.
+ */
+namespace Studies
+{
+	/**
+	 * @brief	This method runs the study the first start argument names
+	 * 			"--help" prints every study with its arguments.
+	 * @param	argc contains the number of start arguments
+	 * @param	argv contains the start arguments as a list of strings
+	 * @param	exitCode is the returned exit code of the study (0 if it succeeded)
+	 * @return	false if the first start argument names no study (the application runs instead)
+	 */
+	bool Run(int argc, char** argv, int& exitCode);
+
+	/**
+	 * @brief	This method prints every study with its arguments
+	 */
+	void PrintUsage(void);
+}
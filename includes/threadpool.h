@@ -0,0 +1,200 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This class defines a pool of worker threads
+ * 			Work is always split into one contiguous range per thread
+ * 			and the calling thread takes part as thread 0, so a given
+ * 			thread always works on the same range of equally sized inputs.
+ * 			Pinned pools bind every worker to one processor, filling the
+ * 			NUMA nodes one after another. The calling thread only waits
+ * 			then, so the ranges of a node stay on the processors of that node.
+ * 			Ranges with a capacity are split over the capacity on pinned pools,
+ * 			so a thread keeps the part it touched first however many of the
+ * 			elements are in use.
+ */
+class ThreadPool
+{
+public:
+
+	/**
+	 * @brief	Construct a new ThreadPool object
+	 * @param	numThreads is the number of threads including the calling thread (0 uses all hardware threads)
+	 * @param	pinThreads binds every thread to its own processor (the calling thread doesn't take part then)
+	 */
+	ThreadPool(uint numThreads = 0, bool pinThreads = false);
+	~ThreadPool();
+
+	/**
+	 * @brief	Retrieves the number of threads that work on a dispatch
+	 * @return	uint is the number of threads (including the calling thread unless the pool is pinned)
+	 */
+	uint GetNumThreads(void) const;
+	/**
+	 * @brief	Retrieves whether the threads are bound to processors
+	 * @return	true if every thread runs on its own processor
+	 */
+	bool AreThreadsPinned(void) const;
+	/**
+	 * @brief	Retrieves the NUMA node a thread runs on
+	 * @param	threadIndex is the index of the thread
+	 * @return	uint is the node index (the first node for threads that aren't pinned)
+	 */
+	uint GetThreadNode(uint threadIndex) const;
+	/**
+	 * @brief	Retrieves the time a thread spent working on dispatches
+	 * @param	threadIndex is the index of the thread
+	 * @return	uint64 is the busy time in microseconds
+	 */
+	uint64 GetBusyTime(uint threadIndex) const;
+	/**
+	 * @brief	Retrieves the number of elements a thread processed in ParallelFor and ParallelReduce
+	 * @param	threadIndex is the index of the thread
+	 * @return	uint64 is the number of processed elements
+	 */
+	uint64 GetNumProcessedElements(uint threadIndex) const;
+
+	/**
+	 * @brief	This method runs a task once on every thread and waits for all of them
+	 * @param	task is called with the index of the thread it runs on
+	 */
+	void Dispatch(const std::function<void(uint)>& task);
+
+	/**
+	 * @brief	This method splits a range into one contiguous part per thread
+	 * 			and processes the parts in parallel
+	 * @tparam	Fn is a callable with the signature void(size_t begin, size_t end, uint threadIndex)
+	 * @param	count is the number of elements in the range
+	 * @param	fn is called once per thread with its part of the range
+	 */
+	template <class Fn>
+	void ParallelFor(size_t count, Fn fn)
+	{
+		this->ParallelFor(count, count, fn);
+	}
+
+	/**
+	 * @brief	This method processes the leading elements of an array in parallel
+	 * 			Pinned pools split the capacity into one contiguous part per thread,
+	 * 			the threads only process their part below the count (and skip an
+	 * 			inactive tail entirely). Other pools split the count.
+	 * @tparam	Fn is a callable with the signature void(size_t begin, size_t end, uint threadIndex)
+	 * @param	count is the number of elements in use
+	 * @param	capacity is the number of elements of the array
+	 * @param	fn is called once per thread with its part of the range
+	 */
+	template <class Fn>
+	void ParallelFor(size_t count, size_t capacity, Fn fn)
+	{
+		this->Dispatch([&](uint threadIndex) {
+			size_t begin, end;
+			this->GetDispatchRange(count, capacity, threadIndex, begin, end);
+
+			if (begin < end)
+				fn(begin, end, threadIndex);
+
+			this->threadStats[threadIndex].numElements += end - begin;
+		});
+	}
+
+	/**
+	 * @brief	This method reduces a range in parallel
+	 * 			Every thread reduces its own part, the partial results
+	 * 			are combined in thread order afterwards.
+	 * @tparam	T is the type of the result
+	 * @tparam	Fn is a callable with the signature T(size_t begin, size_t end)
+	 * @tparam	Combine is a callable with the signature T(const T&, const T&)
+	 * @param	count is the number of elements in the range
+	 * @param	identity is the result of an empty range
+	 * @param	fn reduces a part of the range
+	 * @param	combine combines two partial results
+	 * @return	T is the combined result
+	 */
+	template <class T, class Fn, class Combine>
+	T ParallelReduce(size_t count, const T& identity, Fn fn, Combine combine)
+	{
+		return this->ParallelReduce(count, count, identity, fn, combine);
+	}
+
+	/**
+	 * @brief	This method reduces the leading elements of an array in parallel
+	 * 			The parts are split like the ones of ParallelFor with a capacity.
+	 * @param	count is the number of elements in use
+	 * @param	capacity is the number of elements of the array
+	 * @param	identity is the result of an empty range
+	 * @param	fn reduces a part of the range
+	 * @param	combine combines two partial results
+	 * @return	T is the combined result
+	 */
+	template <class T, class Fn, class Combine>
+	T ParallelReduce(size_t count, size_t capacity, const T& identity, Fn fn, Combine combine)
+	{
+		std::vector<T> partials(this->GetNumThreads(), identity);
+
+		this->Dispatch([&](uint threadIndex) {
+			size_t begin, end;
+			this->GetDispatchRange(count, capacity, threadIndex, begin, end);
+
+			if (begin < end)
+				partials[threadIndex] = fn(begin, end);
+
+			this->threadStats[threadIndex].numElements += end - begin;
+		});
+
+		T result = identity;
+		for (const T& partial : partials)
+			result = combine(result, partial);
+
+		return result;
+	}
+
+	/**
+	 * @brief	This method calculates the part of a range a thread works on
+	 * @param	count is the number of elements in the range
+	 * @param	numThreads is the number of threads the range is split into
+	 * @param	threadIndex is the index of the thread
+	 * @param	begin is the returned first element of the part
+	 * @param	end is the returned element after the last element of the part
+	 */
+	static void GetRange(size_t count, uint numThreads, uint threadIndex, size_t& begin, size_t& end);
+
+private:
+
+	/**
+	 * @brief	This struct defines the counters of a thread
+	 * 			Every thread only writes its own cache line.
+	 */
+	struct alignas(64) ThreadStats
+	{
+		uint64 busyTime;
+		uint64 numElements;
+	};
+
+	void GetDispatchRange(size_t count, size_t capacity, uint threadIndex, size_t& begin, size_t& end) const;
+	void Work(uint threadIndex, uint processor);
+	void RunTask(const std::function<void(uint)>& task, uint threadIndex);
+
+	std::vector<std::thread> workers;
+	std::vector<ThreadStats> threadStats;
+	std::vector<uint> threadNodes;
+	bool areThreadsPinned;
+
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	const std::function<void(uint)>* pTask;
+	uint64 generation;
+	uint numPending;
+	bool isStopping;
+
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "types.h"
+
+/**
+ * @brief	This class picks the timestep of the next simulation step
+ * 			from an error estimate of the current state.
+ * 			Calm phases take large steps and violent phases small ones,
+ * 			always within the configured bounds.
+ */
+class TimestepController
+{
+public:
+
+	/**
+	 * @brief	This struct defines the settings of the controller
+	 */
+	struct Settings
+	{
+		float minTimestep = Time::maxTimeStep / 16.0f;	/**< the smallest allowed timestep in seconds */
+		float maxTimestep = Time::maxTimeStep;			/**< the largest allowed timestep in seconds */
+		float accuracy = 0.1f;							/**< the fraction of the local length scale a step may cover */
+		float softening = 0.05f;						/**< keeps the length scale from vanishing at the gravity source */
+		float maxGrowth = 2.0f;							/**< the largest factor a timestep may grow by per step */
+	};
+
+	/**
+	 * @brief	Construct a new TimestepController object
+	 * @param	settings are the bounds and the accuracy of the controller
+	 */
+	TimestepController(const Settings& settings);
+
+	/**
+	 * @brief	This method picks the timestep of the next step
+	 * @param	estimatedTimestep is the largest timestep that keeps the error estimate in bounds
+	 * @return	float is the timestep to be used for the next step
+	 */
+	float NextTimestep(float estimatedTimestep);
+
+	const Settings& GetSettings(void) const;
+
+private:
+
+	Settings settings;
+	float lastTimestep;
+
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares the adaptive timestep with fixed timesteps
+ */
+namespace TimestepStudy
+{
+	/**
+	 * @brief	This method prints the steps every timestep takes and how far it ends from a reference
+	 * 			All runs simulate the same time from the start grid, the reference takes fixed
+	 * 			steps a quarter of the smallest adaptive timestep. Next to every adaptive accuracy
+	 * 			and the block timesteps the fewest particle updates a fixed timestep needs to end
+	 * 			at least as close are printed.
+	 * @param	numParticles is the number of simulated particles
+	 * @param	duration is the simulated time in seconds
+	 * @return	false if a run doesn't end at finite positions or the default accuracy
+	 * 			takes more updates than the fixed timestep that ends as close
+	 */
+	bool Run(size_t numParticles, float duration);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+namespace Topology
+{
+	/**
+	 * @brief	This struct defines a NUMA node
+	 * 			The memory of a node is local to its processors.
+	 */
+	struct NumaNode
+	{
+		uint index;						/**< the index of the node assigned by the operating system */
+		std::vector<uint> processors;	/**< the logical processors of the node the process may run on */
+	};
+
+	/**
+	 * @brief	This method detects the NUMA nodes of the machine
+	 * 			Machines without NUMA information are reported as a
+	 * 			single node containing all hardware threads.
+	 * @return	std::vector<NumaNode> are the nodes with at least one usable processor
+	 */
+	std::vector<NumaNode> GetNumaNodes(void);
+
+	/**
+	 * @brief	This method binds the calling thread to a single logical processor
+	 * @param	processor is the logical processor (as listed by GetNumaNodes)
+	 * @return	false if the thread could not be bound
+	 */
+	bool PinCurrentThread(uint processor);
+}
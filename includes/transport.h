@@ -0,0 +1,41 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <vector>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This class defines the interface of the message transport between ranks
+ * 			A rank is one process of a distributed simulation. Messages between two
+ * 			ranks arrive in the order they were exchanged.
+ */
+class Transport
+{
+public:
+
+	virtual ~Transport() { }
+
+	/**
+	 * @brief	Retrieves the rank of this process
+	 * @return	uint is the rank (0 to GetNumRanks() - 1)
+	 */
+	virtual uint GetRank(void) const = 0;
+	/**
+	 * @brief	Retrieves the number of ranks
+	 * @return	uint is the number of processes of the simulation
+	 */
+	virtual uint GetNumRanks(void) const = 0;
+
+	/**
+	 * @brief	This method sends a message to another rank and receives one from it
+	 * 			Both ranks have to call it with each other's rank. Sending and
+	 * 			receiving overlap, so neither side waits for the other to read first.
+	 * @param	rank is the other rank
+	 * @param	sendData is the message for the other rank
+	 * @param	receiveData is the returned message of the other rank
+	 * @return	false if the other rank is gone
+	 */
+	virtual bool Exchange(uint rank, const std::vector<byte>& sendData, std::vector<byte>& receiveData) = 0;
+
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <atomic>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This class defines a lock-free triple buffer
+ * 			One thread writes into the back buffer and publishes it,
+ * 			another thread acquires the newest published buffer.
+ * 			Neither side ever waits for the other one: the writer
+ * 			overwrites states that were never acquired and the reader
+ * 			keeps its current state until a newer one was published.
+ * @tparam	T is the type of the buffered state
+ */
+template <class T>
+class TripleBuffer
+{
+public:
+
+	/**
+	 * @brief	Construct a new TripleBuffer object
+	 */
+	TripleBuffer() :
+		middle(1),
+		back(0),
+		front(2)
+	{ }
+
+	/**
+	 * @brief	Retrieves the buffer the writer may fill
+	 * @return	T& is the current back buffer
+	 */
+	T& GetBackBuffer(void)
+	{
+		return this->buffers[this->back];
+	}
+	/**
+	 * @brief	This method publishes the back buffer as the newest state
+	 * 			The writer continues with the former middle buffer.
+	 */
+	void Publish(void)
+	{
+		uint8 previous = this->middle.exchange(this->back | dirtyBit, std::memory_order_acq_rel);
+		this->back = previous & indexMask;
+	}
+
+	/**
+	 * @brief	This method makes the newest published state the front buffer
+	 * @return	false if nothing was published since the last call
+	 */
+	bool Acquire(void)
+	{
+		if (!(this->middle.load(std::memory_order_relaxed) & dirtyBit))
+			return false;
+
+		uint8 previous = this->middle.exchange(this->front, std::memory_order_acq_rel);
+		this->front = previous & indexMask;
+
+		return true;
+	}
+	/**
+	 * @brief	Retrieves the buffer the reader may read
+	 * @return	const T& is the current front buffer
+	 */
+	const T& GetFrontBuffer(void) const
+	{
+		return this->buffers[this->front];
+	}
+
+private:
+
+	static constexpr uint8 indexMask = 0x3;
+	static constexpr uint8 dirtyBit = 0x4;
+
+	T buffers[3];
+
+	// index of the middle buffer and whether it holds an unread state
+	alignas(64) std::atomic<uint8> middle;
+	// only touched by the writer
+	alignas(64) uint8 back;
+	// only touched by the reader
+	alignas(64) uint8 front;
+
+};
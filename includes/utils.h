@@ -1,22 +1,35 @@
 #pragma once
 
 // EXTERNAL INCLUDES
+#if defined(_WIN32)
 #include <comdef.h>
+#endif
 #include <cstdio>
 // INTERNAL INCLUDES
+#include "logger.h"
 #include "math/vec2.h"
 
 #define SAFE_DELETE(x) if (x) { delete x; x = nullptr; }
 #define SAFE_DELETE_ARRAY(x) if (x) { delete[] x; x = nullptr; }
 #define SAFE_RELEASE(x) if (x) { x->Release(); x = nullptr; }
 
-#if defined(_DEBUG)
-#define LOG(x, ...) { char string[128]; snprintf(string, 128, x, __VA_ARGS__); printf("[INFO]: [%s]\n", string); }
+// the messages are formatted and printed asynchronously (see Logger)
+#if LOG_MIN_LEVEL <= 0
+#define LOG(x, ...) Logger::Write(Logger::Info, __FILE__, __LINE__, x, ##__VA_ARGS__)
 #else
 #define LOG(x, ...)
 #endif
+#if LOG_MIN_LEVEL <= 1
+#define WARN(x, ...) Logger::Write(Logger::Warning, __FILE__, __LINE__, x, ##__VA_ARGS__)
+#else
+#define WARN(x, ...)
+#endif
+#if LOG_MIN_LEVEL <= 2
+#define ERR(x, ...) Logger::Write(Logger::Error, __FILE__, __LINE__, x, ##__VA_ARGS__)
+#else
+#define ERR(x, ...)
+#endif
 
-#define WARN(x, ...) { char string[128]; snprintf(string, 128, x, __VA_ARGS__); printf("[WARNING]: [%s] (%s #%i)\n", string, __FILE__, __LINE__); }
-#define ERR(x, ...) { char string[128]; snprintf(string, 128, x, __VA_ARGS__); printf("[ERROR]: [%s] (%s #%i)\n", string, __FILE__, __LINE__); }
-
-#define V_RETURN(x) hr = x; if (hr != S_OK) { _com_error err(hr); LPCTSTR errMsg = err.ErrorMessage(); ERR("%s", errMsg); throw; }
+#if defined(_WIN32)
+#define V_RETURN(x) hr = x; if (hr != S_OK) { _com_error err(hr); LPCTSTR errMsg = err.ErrorMessage(); ERR("%s", errMsg); Logger::Flush(); throw; }
+#endif
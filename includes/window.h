@@ -2,6 +2,7 @@
 
 // EXTERNAL INCLUDES
 // INTERNAL INCLUDES
+#include "inputevent.h"
 #include "math/vec2.h"
 #include "types.h"
 #include "window.h"
@@ -37,11 +38,24 @@ public:
 	 * @return	uint64 is the current window handle 
 	 */
 	uint64 GetHandle(void) const;
+	/**
+	 * @brief	Retrieves the queue the window pushes its input events into
+	 * 			The events are meant to be drained by the simulation.
+	 * @return	InputEventQueue& is the input event queue of this window
+	 */
+	InputEventQueue& GetInputEvents(void);
+	/**
+	 * @brief	Retrieves the resolution of the window's client area
+	 * @return	Math::Vec2 is the resolution in pixels
+	 */
+	Math::Vec2 GetResolution(void) const;
 
 	bool isClosed; /**< is the current desired state of the window */
 
 private:
 
 	uint64 handle;
+	Math::Vec2 resolution;
+	InputEventQueue inputEvents;
 
 };
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+// EXTERNAL INCLUDES
+#include <stddef.h>
+// INTERNAL INCLUDES
+#include "types.h"
+
+/**
+ * @brief	This namespace compares stepping the systems of a ParticleWorld in one pass with stepping them one by one
+ */
+namespace WorldStudy
+{
+	/**
+	 * @brief	This method steps the same systems batched in one world and one world per system
+	 * 			The particles are split unevenly over 1 up to numSystems systems with their own
+	 * 			constants. Both ways have to end at the same positions.
+	 * @param	numSystems is the largest number of systems
+	 * @param	numParticles is the number of particles of all systems together
+	 * @param	numSteps is the number of measured steps of every run
+	 * @return	true if both ways end at the same positions
+	 */
+	bool Run(size_t numSystems, size_t numParticles, uint numSteps);
+}
@@ -1,35 +1,186 @@
 // EXTERNAL INCLUDES
+#include <cinttypes>
+#include <cstdio>
+#if defined(_WIN32)
 #include <windows.h>
+#endif
 // INTERNAL INCLUDES
 #include "application.h"
+#include "deltatime.h"
+#include "framegovernor.h"
+#include "metrics.h"
+#include "metricsserver.h"
+#include "nullpresenter.h"
+#include "particlesimulation.h"
+#include "sharedstatewriter.h"
+#include "simulationthread.h"
+#include "streamserver.h"
+#include "threadpool.h"
+#include "topology.h"
+#include "triplebuffer.h"
 #include "utils.h"
+#if defined(_WIN32)
+#include "particlerenderer.h"
 #include "window.h"
-#include "deltaTime.h"
+#endif
+
+constexpr size_t numMaxParticles = 50000; /**< the number of simulated particles */
+
+Application::Application() :
+	title(nullptr),
+	processID(0),
+	window(nullptr),
+	appstate(Stopped),
+	renderer(nullptr),
+	presenter(nullptr),
+	maxRunTime(0.0f),
+	adaptiveTimestep(false),
+	threadPool(nullptr),
+	simulation(nullptr),
+	simulationThread(nullptr),
+	snapshots(nullptr),
+	governor(nullptr),
+	metricsPort(0),
+	metrics(nullptr),
+	metricsServer(nullptr),
+	sharedState(nullptr),
+	streamServer(nullptr)
+{
+
+}
 
 Application::~Application()
 {
-	SAFE_DELETE(this->renderer);
+	// the threads have to stop before the data they work on is removed
+	SAFE_DELETE(this->metricsServer);
+	SAFE_DELETE(this->simulationThread);
+	SAFE_DELETE(this->streamServer);
+	SAFE_DELETE(this->sharedState);
+	SAFE_DELETE(this->snapshots);
+	SAFE_DELETE(this->governor);
+	SAFE_DELETE(this->simulation);
+	SAFE_DELETE(this->threadPool);
+	SAFE_DELETE(this->metrics);
+	SAFE_DELETE(this->presenter);
+#if defined(_WIN32)
 	SAFE_DELETE(this->window);
+#endif
 }
 
-void Application::Init(const char* title, Math::Vec2 resolution)
+void Application::Init(const char* title, Math::Vec2 resolution, float maxRunTime, uint16 metricsPort, const char* pSharedStateName, uint16 streamPort, bool adaptiveTimestep)
 {
 	LOG("Starting application");
 
 	this->title = title;
+	this->maxRunTime = maxRunTime;
+	this->adaptiveTimestep = adaptiveTimestep;
+	this->metricsPort = metricsPort;
 
+#if defined(_WIN32)
 	// set up the window and the renderer
 	this->window = new Window(title, resolution);
 	this->renderer = new ParticleRenderer();
 	this->renderer->Initialize(this->window->GetHandle(), resolution);
+	this->presenter = this->renderer;
+#else
+	// there is nothing to show so we only wait for vsync
+	this->presenter = new NullPresenter();
+#endif
+
+	// set up the simulation and its threads
+	// (threads are only pinned if their memory can be remote)
+	this->threadPool = new ThreadPool(0, Topology::GetNumaNodes().size() > 1);
+	this->simulation = new ParticleSimulation(numMaxParticles, this->threadPool);
+	this->snapshots = new TripleBuffer<SimulationSnapshot>();
+	this->metrics = new MetricsRegistry();
+
+	// the quality drops before the frames miss the refresh
+	FrameGovernor::Settings governorSettings;
+	governorSettings.numParticles = numMaxParticles;
+	this->governor = new FrameGovernor(governorSettings);
+
+	// other processes read the states right out of the shared memory
+	if (pSharedStateName)
+	{
+		this->sharedState = new SharedStateWriter();
+		if (!this->sharedState->Create(pSharedStateName, 4, numMaxParticles))
+			SAFE_DELETE(this->sharedState);
+	}
+	// remote viewers get compressed states
+	if (streamPort != 0)
+	{
+		this->streamServer = new StreamServer();
+		if (!this->streamServer->Start(streamPort, StreamServer::Settings()))
+			SAFE_DELETE(this->streamServer);
+	}
+#if defined(_WIN32)
+	this->simulationThread = new SimulationThread(this->simulation, &this->window->GetInputEvents(), this->snapshots);
+#else
+	this->simulationThread = new SimulationThread(this->simulation, nullptr, this->snapshots);
+#endif
 }
 void Application::Update(void)
 {
 	LOG("Gameloop starting");
 
+	this->appstate = Running;
+
+	// place the particles on their start grid
+	if (!this->simulation->SetupParticles())
+	{
+		ERR("The particles couldn't be set up, the game loop doesn't start");
+		this->appstate = Stopped;
+		return;
+	}
+	// particles close to the gravity source take up to 16 substeps per step
+	this->simulation->SetTimeBins(this->governor->GetQuality().numTimeBins);
+	// energy, bounds and speeds are watched for instabilities
+	this->simulation->SetDiagnostics(true);
+	// settled particles aren't integrated until the input changes the gravity
+	this->simulation->SetSleeping(true);
+
+#if defined(_WIN32)
 	// create the buffers and fill the particle data in
-	this->renderer->SetupParticles();
+	this->renderer->SetupParticles(*this->simulation);
+#endif
+
+	// the metrics are recorded either way, serving them is optional
+	const std::vector<double> timeBounds = MetricsRegistry::ExponentialBounds(0.0001, 2.0, 12);
+	const ParticleSimulation* pSimulation = this->simulation;
+
+	this->metrics->AddGauge("particle_simulation_particles", "Number of simulated particles.", "",
+		[pSimulation] { return static_cast<double>(pSimulation->GetNumParticles()); });
+	this->metrics->AddGauge("particle_simulation_memory_bytes", "Bytes of the particle memory arena in use.", "",
+		[pSimulation] { return static_cast<double>(pSimulation->GetMemoryArena()->GetUsedSize()); });
+	this->metrics->AddProcessMetrics();
+
+	MetricsRegistry::Gauge* pKineticEnergy = this->metrics->AddGauge("particle_simulation_energy", "Energy of all particles (unit mass).", "kind=\"kinetic\"");
+	MetricsRegistry::Gauge* pPotentialEnergy = this->metrics->AddGauge("particle_simulation_energy", "Energy of all particles (unit mass).", "kind=\"potential\"");
+	MetricsRegistry::Gauge* pMaxSpeed = this->metrics->AddGauge("particle_simulation_max_speed", "Speed of the fastest particle.");
+
+	SimulationThread::Settings simulationSettings;
+	simulationSettings.pStepCounter = this->metrics->AddCounter("particle_simulation_steps_total", "Number of completed simulation steps.");
+	simulationSettings.pStepTimes = this->metrics->AddHistogram("particle_simulation_step_seconds", "Wall clock time of a simulation step.", "", timeBounds);
+	simulationSettings.pSharedState = this->sharedState;
+	simulationSettings.pStreamServer = this->streamServer;
+	simulationSettings.adaptiveTimestep = this->adaptiveTimestep;
+
+	MetricsRegistry::Histogram* pPumpTimes = this->metrics->AddHistogram("particle_frame_stage_seconds", "Wall clock time of a stage of the frame loop.", "stage=\"pump\"", timeBounds);
+	MetricsRegistry::Histogram* pAcquireTimes = this->metrics->AddHistogram("particle_frame_stage_seconds", "Wall clock time of a stage of the frame loop.", "stage=\"acquire\"", timeBounds);
+	MetricsRegistry::Histogram* pPresentTimes = this->metrics->AddHistogram("particle_frame_stage_seconds", "Wall clock time of a stage of the frame loop.", "stage=\"present\"", timeBounds);
 
+	// the governor belongs to the frame loop, the loop sets its level instead of the metrics thread reading it
+	MetricsRegistry::Gauge* pQualityLevel = this->metrics->AddGauge("particle_frame_quality_level", "Quality level of the frame governor (0 is the best quality).");
+	pQualityLevel->Set(static_cast<double>(this->governor->GetLevel()));
+
+	if (this->metricsPort != 0)
+	{
+		this->metricsServer = new MetricsServer(this->metrics);
+		if (!this->metricsServer->Start(this->metricsPort))
+			SAFE_DELETE(this->metricsServer);
+	}
+
+#if defined(GPU_SIMULATION)
 	// create a time object for the delta time
 	Time::Time time = { 0 };
 
@@ -41,10 +192,14 @@ void Application::Update(void)
 		// update of the current delta time
 		Time::GetDetlaTime(time);
 
+		// apply the input of this step
+		this->simulation->ApplyInputEvents(this->window->GetInputEvents(), Time::Now());
+		this->simulation->AdvanceTimestep(time.deltaTime);
+
 		// clear the frame
 		this->renderer->ClearFrame();
 		// update the particles
-		this->renderer->UpdateParticles(time.deltaTime);
+		this->renderer->UpdateParticles(this->simulation->GetConstants());
 		// render the particles
 		this->renderer->RenderParticles(time.deltaTime);
 		// show them on screen
@@ -59,6 +214,166 @@ void Application::Update(void)
 		}
 
 	} while (true);
+#else
+	// the simulation runs on its own thread from now on
+	this->simulationThread->Start(simulationSettings);
+
+	uint64 startTime = Time::Now();
+	uint64 numFrames = 0;
+
+	do
+	{
+		uint64 stageStartTime = Time::Now();
+		uint64 stageEndTime;
+
+#if defined(_WIN32)
+		// window message loop
+		this->window->PumpMessages();
+#endif
+		stageEndTime = Time::Now();
+		pPumpTimes->Observe((stageEndTime - stageStartTime) / 1000000.0);
+		this->governor->AddStageTime(FrameGovernor::Pump, stageEndTime - stageStartTime);
+		stageStartTime = stageEndTime;
+
+		// show the newest completed state (blocks on vsync)
+		this->snapshots->Acquire();
+		stageEndTime = Time::Now();
+		pAcquireTimes->Observe((stageEndTime - stageStartTime) / 1000000.0);
+		this->governor->AddStageTime(FrameGovernor::Acquire, stageEndTime - stageStartTime);
+		this->governor->AddStageTime(FrameGovernor::Simulate, this->simulationThread->GetLastStepTime());
+		stageStartTime = stageEndTime;
+
+		const ParticleSimulation::Diagnostics& diagnostics = this->snapshots->GetFrontBuffer().diagnostics;
+		if (diagnostics.step > 0)
+		{
+			pKineticEnergy->Set(diagnostics.kineticEnergy);
+			pPotentialEnergy->Set(diagnostics.potentialEnergy);
+			pMaxSpeed->Set(diagnostics.maxSpeed);
+		}
+
+		this->presenter->PresentSnapshot(this->snapshots->GetFrontBuffer());
+		stageEndTime = Time::Now();
+		pPresentTimes->Observe((stageEndTime - stageStartTime) / 1000000.0);
+		numFrames++;
+
+		// the waiting for vsync isn't work, the present stage doesn't count against the budget
+		uint governorLevel = this->governor->GetLevel();
+		const FrameGovernor::Quality& quality = this->governor->EndFrame();
+		if (this->governor->GetLevel() != governorLevel)
+		{
+			this->simulationThread->SetQuality(quality);
+			pQualityLevel->Set(static_cast<double>(this->governor->GetLevel()));
+		}
+
+#if defined(_WIN32)
+		// in case the desired window state
+		// is "closed" we stop the game loop
+		if (this->window->isClosed)
+		{
+			LOG("Gameloop stopped");
+			break;
+		}
+#endif
+
+		// headless runs stop after their run time
+		if (this->maxRunTime > 0.0f && (Time::Now() - startTime) >= static_cast<uint64>(this->maxRunTime * 1000000.0f))
+		{
+			LOG("Gameloop stopped");
+			break;
+		}
+
+	} while (true);
+
+	this->simulationThread->Stop();
+	if (this->metricsServer)
+		this->metricsServer->Stop();
+	if (this->streamServer)
+		this->streamServer->Stop();
+
+	// the log of the run goes before its summary
+	Logger::Flush();
+
+	// simulation and presentation rates are independent of each other
+	double seconds = static_cast<double>(Time::Now() - startTime) / 1000000.0;
+	uint64 numSteps = this->simulationThread->GetNumSteps();
+	double meanTimestep = (numSteps > 0) ? static_cast<double>(this->simulationThread->GetSimulatedTime()) / numSteps / 1000.0 : 0.0;
+	printf("Simulated %" PRIu64 " steps (%.1f steps/s, mean timestep %.3f ms), presented %" PRIu64 " frames (%.1f frames/s) in %.2f s\n",
+		numSteps, numSteps / seconds, meanTimestep, numFrames, numFrames / seconds, seconds);
+
+	// block timesteps skip the particles that aren't due in a substep
+	uint64 numUpdates = this->simulation->GetNumParticleUpdates();
+	uint64 numSavedUpdates = this->simulation->GetNumSavedParticleUpdates();
+	printf("Integrated %" PRIu64 " particle updates (%.1f M/s), block timesteps saved %" PRIu64 " (%.1f M/s)\n",
+		numUpdates, numUpdates / seconds / 1000000.0, numSavedUpdates, numSavedUpdates / seconds / 1000000.0);
+
+	// sleeping particles are skipped until the next input
+	uint64 numSkippedUpdates = this->simulation->GetNumSkippedParticleUpdates();
+	printf("Sleeping: %zu of %zu particles asleep at the end, skipped %" PRIu64 " particle updates (%.1f M/s)\n",
+		this->simulation->GetNumParticles() - this->simulation->GetNumAwakeParticles(), this->simulation->GetNumParticles(),
+		numSkippedUpdates, numSkippedUpdates / seconds / 1000000.0);
+
+	// the particle budget of the governor defers the awake particles behind it to a later step
+	uint64 numDeferredUpdates = this->simulation->GetNumDeferredParticleUpdates();
+	printf("Particle budget: deferred %" PRIu64 " particle updates (%.1f M/s)\n", numDeferredUpdates, numDeferredUpdates / seconds / 1000000.0);
+
+	// a sudden jump of the energy or the bounds means the integration went unstable
+	const ParticleSimulation::Diagnostics& diagnostics = this->simulation->GetDiagnostics();
+	printf("Diagnostics: kinetic energy %.3f, potential energy %.3f, bounds (%.3f, %.3f)-(%.3f, %.3f), centroid (%.3f, %.3f), max speed %.3f\n",
+		diagnostics.kineticEnergy, diagnostics.potentialEnergy, diagnostics.boundsMin.x, diagnostics.boundsMin.y, diagnostics.boundsMax.x, diagnostics.boundsMax.y,
+		diagnostics.centroid.x, diagnostics.centroid.y, diagnostics.maxSpeed);
+
+	// the frames within the budget are the ones that don't stutter
+	const FrameGovernor::Quality& quality = this->governor->GetQuality();
+	uint64 numGovernedFrames = this->governor->GetNumFrames();
+	printf("Frame governor: %" PRIu64 " of %" PRIu64 " frames within the %.1f ms budget (%.1f%%), %" PRIu64 " quality changes, level %u of %u at the end (%u time bins, %zu particles, every %u. state presented)\n",
+		this->governor->GetNumFramesWithinBudget(), numGovernedFrames, this->governor->GetSettings().targetFrameTime * 1000.0f,
+		(numGovernedFrames > 0) ? 100.0 * this->governor->GetNumFramesWithinBudget() / numGovernedFrames : 0.0, this->governor->GetNumLevelChanges(),
+		this->governor->GetLevel(), this->governor->GetNumLevels() - 1, quality.numTimeBins, quality.particleBudget, quality.renderDecimation);
+
+	// a position costs 8 bytes uncompressed
+	if (this->streamServer)
+	{
+		uint64 numStreamFrames = this->streamServer->GetNumFrames();
+		uint64 numFrameBytes = this->streamServer->GetNumFrameBytes();
+		uint64 numFrameParticles = this->streamServer->GetNumFrameParticles();
+		printf("Streaming: %" PRIu64 " frames (%.0f bytes/frame, %.2f bits/particle, %.1f%% of the raw positions), encoded in %.3f ms/frame, %" PRIu64 " frames dropped\n",
+			numStreamFrames, (numStreamFrames > 0) ? static_cast<double>(numFrameBytes) / numStreamFrames : 0.0,
+			(numFrameParticles > 0) ? 8.0 * numFrameBytes / numFrameParticles : 0.0, (numFrameParticles > 0) ? 100.0 * numFrameBytes / (8.0 * numFrameParticles) : 0.0,
+			(numStreamFrames > 0) ? this->streamServer->GetEncodeTime() / 1000.0 / numStreamFrames : 0.0, this->streamServer->GetNumDroppedFrames());
+	}
+
+	// the cost of the particle memory grows with the particle count
+	const MemoryArena* pArena = this->simulation->GetMemoryArena();
+	const char* pageSizeNames[] = { "small pages", "transparent huge pages", "explicit huge pages" };
+	printf("Particle memory: %.1f MiB on %s, reserved in %.3f ms, first touched in %.3f ms\n",
+		pArena->GetUsedSize() / (1024.0 * 1024.0), pageSizeNames[pArena->GetPageSize()],
+		pArena->GetReserveTime() / 1000.0, this->simulation->GetFirstTouchTime() / 1000.0);
+
+	// every pinned thread keeps its range of particles in the memory of its node
+	for (const Topology::NumaNode& node : Topology::GetNumaNodes())
+	{
+		uint numThreads = 0;
+		uint64 busyTime = 0;
+		uint64 numElements = 0;
+
+		for (uint thread = 0; thread < this->threadPool->GetNumThreads(); thread++)
+		{
+			if (this->threadPool->GetThreadNode(thread) != node.index)
+				continue;
+
+			numThreads++;
+			busyTime += this->threadPool->GetBusyTime(thread);
+			numElements += this->threadPool->GetNumProcessedElements(thread);
+		}
+
+		if (numThreads > 0)
+			printf("NUMA node %u: %u %s threads processed %" PRIu64 " elements (%.1f M/s while busy, %.0f%% busy)\n",
+				node.index, numThreads, (this->threadPool->AreThreadsPinned()) ? "pinned" : "unpinned", numElements,
+				(busyTime > 0) ? numElements / static_cast<double>(busyTime) : 0.0, 100.0 * busyTime / (numThreads * seconds * 1000000.0));
+	}
+#endif
+
+	this->appstate = Stopped;
 }
 void Application::Close(void)
 {
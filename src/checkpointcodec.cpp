@@ -0,0 +1,492 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+// INTERNAL INCLUDES
+#include "checkpointcodec.h"
+#include "threadpool.h"
+
+constexpr size_t minMatch = 4;				/**< the shortest match the LZ coder emits */
+constexpr size_t maxOffset = 65535;			/**< the farthest match the LZ coder emits */
+constexpr uint hashBits = 12;				/**< the size of the match finder table */
+
+/**
+ * @brief	This helper processes the chunks on a thread pool
+ * 			or on the calling thread if there is no pool
+ */
+template <class Fn>
+static void ForEachChunk(ThreadPool* pThreadPool, size_t count, Fn fn)
+{
+	if (pThreadPool)
+		pThreadPool->ParallelFor(count, fn);
+	else
+		fn(0, count, 0);
+}
+
+static inline uint32 Load32(const byte* pData)
+{
+	uint32 value;
+	memcpy(&value, pData, sizeof(value));
+	return value;
+}
+static inline uint64 Load64(const byte* pData)
+{
+	uint64 value;
+	memcpy(&value, pData, sizeof(value));
+	return value;
+}
+
+/**
+ * @brief	This helper gathers one byte of eight consecutive elements
+ */
+static inline uint64 Gather8(const byte* pElements, size_t elementSize)
+{
+	uint64 value = 0;
+	for (size_t k = 0; k < 8; k++)
+		value |= static_cast<uint64>(pElements[k * elementSize]) << (8 * k);
+	return value;
+}
+
+/**
+ * @brief	This helper XORs the elements of a chunk with their reference and shuffles them into byte planes
+ * 			Plane b holds byte b of every element, the bytes behind the last whole
+ * 			element follow the planes unshuffled (but XORed). Blocks of eight elements
+ * 			are transposed at a time, so every plane gets eight bytes per write.
+ */
+static void Shuffle(const byte* pData, const byte* pReference, size_t size, size_t elementSize, byte* pPlanes)
+{
+	const size_t numElements = size / elementSize;
+	size_t i = 0;
+
+	for (; i + 8 <= numElements; i += 8)
+	{
+		const byte* pBlock = pData + i * elementSize;
+		const byte* pBlockReference = (pReference) ? pReference + i * elementSize : nullptr;
+
+		for (size_t b = 0; b < elementSize; b++)
+		{
+			uint64 value = Gather8(pBlock + b, elementSize);
+			if (pBlockReference)
+				value ^= Gather8(pBlockReference + b, elementSize);
+
+			memcpy(pPlanes + b * numElements + i, &value, sizeof(value));
+		}
+	}
+
+	for (; i < numElements; i++)
+	{
+		for (size_t b = 0; b < elementSize; b++)
+		{
+			size_t index = i * elementSize + b;
+			pPlanes[b * numElements + i] = (pReference) ? pData[index] ^ pReference[index] : pData[index];
+		}
+	}
+
+	for (size_t index = numElements * elementSize; index < size; index++)
+		pPlanes[index] = (pReference) ? pData[index] ^ pReference[index] : pData[index];
+}
+
+/**
+ * @brief	This helper reverses Shuffle
+ */
+static void Unshuffle(const byte* pPlanes, const byte* pReference, size_t size, size_t elementSize, byte* pData)
+{
+	const size_t numElements = size / elementSize;
+	size_t i = 0;
+
+	for (; i + 8 <= numElements; i += 8)
+	{
+		byte* pBlock = pData + i * elementSize;
+
+		for (size_t b = 0; b < elementSize; b++)
+		{
+			uint64 value = Load64(pPlanes + b * numElements + i);
+			for (size_t k = 0; k < 8; k++)
+				pBlock[k * elementSize + b] = static_cast<byte>(value >> (8 * k));
+		}
+	}
+
+	for (; i < numElements; i++)
+	{
+		for (size_t b = 0; b < elementSize; b++)
+			pData[i * elementSize + b] = pPlanes[b * numElements + i];
+	}
+
+	for (size_t index = numElements * elementSize; index < size; index++)
+		pData[index] = pPlanes[index];
+
+	// the reference is applied in one sequential pass
+	if (pReference)
+	{
+		for (size_t index = 0; index < size; index++)
+			pData[index] ^= pReference[index];
+	}
+}
+
+/**
+ * @brief	This helper writes a length that didn't fit into its nibble
+ * @return	false if the output is full
+ */
+static inline bool WriteLength(size_t length, byte*& pOut, const byte* pOutEnd)
+{
+	for (; length >= 255; length -= 255)
+	{
+		if (pOut == pOutEnd)
+			return false;
+		*pOut++ = 255;
+	}
+
+	if (pOut == pOutEnd)
+		return false;
+	*pOut++ = static_cast<byte>(length);
+
+	return true;
+}
+
+/**
+ * @brief	This helper writes a sequence of literals followed by a match
+ * 			A sequence is a token (the literal length and the match length
+ * 			in four bits each), the rest of the literal length, the literals,
+ * 			the match offset (two bytes) and the rest of the match length.
+ * 			The last sequence has no match.
+ * @return	false if the output is full
+ */
+static bool WriteSequence(const byte* pLiterals, size_t numLiterals, size_t offset, size_t matchLength, byte*& pOut, const byte* pOutEnd)
+{
+	if (pOut == pOutEnd)
+		return false;
+
+	const size_t matchCode = (matchLength > 0) ? matchLength - minMatch : 0;
+	byte* pToken = pOut++;
+	*pToken = static_cast<byte>((std::min<size_t>(numLiterals, 15) << 4) | std::min<size_t>(matchCode, 15));
+
+	if (numLiterals >= 15 && !WriteLength(numLiterals - 15, pOut, pOutEnd))
+		return false;
+
+	if (static_cast<size_t>(pOutEnd - pOut) < numLiterals)
+		return false;
+	memcpy(pOut, pLiterals, numLiterals);
+	pOut += numLiterals;
+
+	if (matchLength == 0)
+		return true;
+
+	if (pOutEnd - pOut < 2)
+		return false;
+	*pOut++ = static_cast<byte>(offset);
+	*pOut++ = static_cast<byte>(offset >> 8);
+
+	return matchCode < 15 || WriteLength(matchCode - 15, pOut, pOutEnd);
+}
+
+/**
+ * @brief	This helper compresses a buffer with a greedy LZ77 coder
+ * 			The matches are found with a hash table of the last position of every
+ * 			four byte sequence. Stale entries of an earlier buffer are harmless,
+ * 			every candidate is compared before it is used.
+ * @return	size_t is the compressed size (0 if it isn't smaller than maxOutSize)
+ */
+static size_t CompressLZ(const byte* pIn, size_t size, byte* pOut, size_t maxOutSize, uint32* pHashTable)
+{
+	byte* pOutBegin = pOut;
+	const byte* pOutEnd = pOut + maxOutSize;
+	size_t position = 0;
+	size_t anchor = 0;
+
+	while (position + minMatch <= size)
+	{
+		uint32 sequence = Load32(pIn + position);
+		uint32 hash = (sequence * 2654435761u) >> (32 - hashBits);
+		size_t candidate = pHashTable[hash];
+		pHashTable[hash] = static_cast<uint32>(position);
+
+		if (candidate >= position || position - candidate > maxOffset || Load32(pIn + candidate) != sequence)
+		{
+			// skip faster through data that doesn't match
+			position += 1 + ((position - anchor) >> 6);
+			continue;
+		}
+
+		// extend the match eight bytes at a time
+		size_t length = minMatch;
+		while (position + length + sizeof(uint64) <= size && Load64(pIn + candidate + length) == Load64(pIn + position + length))
+			length += sizeof(uint64);
+		while (position + length < size && pIn[candidate + length] == pIn[position + length])
+			length++;
+
+		if (!WriteSequence(pIn + anchor, position - anchor, position - candidate, length, pOut, pOutEnd))
+			return 0;
+
+		position += length;
+		anchor = position;
+	}
+
+	if (!WriteSequence(pIn + anchor, size - anchor, 0, 0, pOut, pOutEnd))
+		return 0;
+
+	return static_cast<size_t>(pOut - pOutBegin);
+}
+
+/**
+ * @brief	This helper reads a length that didn't fit into its nibble
+ * @return	false if the input ended
+ */
+static inline bool ReadLength(size_t& length, const byte*& pIn, const byte* pInEnd)
+{
+	byte value;
+	do
+	{
+		if (pIn == pInEnd)
+			return false;
+
+		value = *pIn++;
+		length += value;
+	} while (value == 255);
+
+	return true;
+}
+
+/**
+ * @brief	This helper reverses CompressLZ
+ * @return	false if the compressed data is broken
+ */
+static bool DecompressLZ(const byte* pIn, size_t compressedSize, byte* pOut, size_t size)
+{
+	const byte* pInEnd = pIn + compressedSize;
+	byte* pOutBegin = pOut;
+	byte* pOutEnd = pOut + size;
+
+	while (pIn < pInEnd)
+	{
+		const byte token = *pIn++;
+
+		size_t numLiterals = token >> 4;
+		if (numLiterals == 15 && !ReadLength(numLiterals, pIn, pInEnd))
+			return false;
+
+		if (static_cast<size_t>(pInEnd - pIn) < numLiterals || static_cast<size_t>(pOutEnd - pOut) < numLiterals)
+			return false;
+		memcpy(pOut, pIn, numLiterals);
+		pIn += numLiterals;
+		pOut += numLiterals;
+
+		// the last sequence has no match
+		if (pIn == pInEnd)
+			break;
+
+		if (pInEnd - pIn < 2)
+			return false;
+		size_t offset = pIn[0] | (pIn[1] << 8);
+		pIn += 2;
+
+		size_t length = token & 15;
+		if (length == 15 && !ReadLength(length, pIn, pInEnd))
+			return false;
+		length += minMatch;
+
+		if (offset == 0 || offset > static_cast<size_t>(pOut - pOutBegin) || static_cast<size_t>(pOutEnd - pOut) < length)
+			return false;
+
+		// matches may overlap the bytes they produce
+		const byte* pMatch = pOut - offset;
+		if (offset == 1)
+			memset(pOut, *pMatch, length);
+		else if (offset >= length)
+			memcpy(pOut, pMatch, length);
+		else
+		{
+			for (size_t i = 0; i < length; i++)
+				pOut[i] = pMatch[i];
+		}
+		pOut += length;
+	}
+
+	return pOut == pOutEnd;
+}
+
+CheckpointEncoder::CheckpointEncoder(ThreadPool* pThreadPool) :
+	pThreadPool(pThreadPool)
+{
+	this->scratch.resize((pThreadPool) ? pThreadPool->GetNumThreads() : 1);
+}
+
+void CheckpointEncoder::Encode(const void* pData, size_t size, uint elementSize, bool relative, std::vector<byte>& checkpoint)
+{
+	// the chunks hold whole elements
+	elementSize = std::max(elementSize, 1u);
+	const size_t chunkBytes = std::max<size_t>(CheckpointCodec::chunkSize / elementSize, 1) * elementSize;
+	const size_t numChunks = (size + chunkBytes - 1) / chunkBytes;
+	relative = relative && this->reference.size() == size;
+
+	this->reference.resize(size);
+	this->chunks.resize(numChunks);
+
+	const byte* pBytes = static_cast<const byte*>(pData);
+	byte* pReference = this->reference.data();
+	std::vector<byte>* pChunks = this->chunks.data();
+	Scratch* pScratch = this->scratch.data();
+
+	ForEachChunk(this->pThreadPool, numChunks, [=](size_t begin, size_t end, uint threadIndex) {
+		Scratch& threadScratch = pScratch[threadIndex];
+		threadScratch.planes.resize(chunkBytes);
+		threadScratch.hashTable.resize(1u << hashBits, 0);
+
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			const size_t offset = chunk * chunkBytes;
+			const size_t chunkSize = std::min(chunkBytes, size - offset);
+			std::vector<byte>& compressed = pChunks[chunk];
+
+			Shuffle(pBytes + offset, (relative) ? pReference + offset : nullptr, chunkSize, elementSize, threadScratch.planes.data());
+
+			// the size of the chunk comes first, chunks that don't shrink are stored
+			compressed.resize(sizeof(uint32) + chunkSize);
+			size_t compressedSize = CompressLZ(threadScratch.planes.data(), chunkSize, compressed.data() + sizeof(uint32), chunkSize - 1, threadScratch.hashTable.data());
+
+			uint32 sizeCode = static_cast<uint32>(compressedSize);
+			if (compressedSize == 0)
+			{
+				memcpy(compressed.data() + sizeof(uint32), threadScratch.planes.data(), chunkSize);
+				compressedSize = chunkSize;
+				sizeCode = static_cast<uint32>(chunkSize) | CheckpointCodec::storedChunk;
+			}
+
+			memcpy(compressed.data(), &sizeCode, sizeof(sizeCode));
+			compressed.resize(sizeof(uint32) + compressedSize);
+
+			// the data is the reference of the next checkpoint
+			memcpy(pReference + offset, pBytes + offset, chunkSize);
+		}
+	});
+
+	// the sizes of all chunks come before the chunks
+	CheckpointCodec::Header header = {};
+	header.magic = CheckpointCodec::magic;
+	header.version = CheckpointCodec::version;
+	header.isRelative = (relative) ? 1 : 0;
+	header.elementSize = elementSize;
+	header.chunkSize = static_cast<uint32>(chunkBytes);
+	header.numChunks = static_cast<uint32>(numChunks);
+	header.size = size;
+
+	std::vector<size_t> offsets(numChunks);
+	size_t checkpointSize = sizeof(header) + numChunks * sizeof(uint32);
+	for (size_t chunk = 0; chunk < numChunks; chunk++)
+	{
+		offsets[chunk] = checkpointSize;
+		checkpointSize += pChunks[chunk].size() - sizeof(uint32);
+	}
+
+	checkpoint.resize(checkpointSize);
+	memcpy(checkpoint.data(), &header, sizeof(header));
+
+	byte* pCheckpoint = checkpoint.data();
+	const size_t* pOffsets = offsets.data();
+
+	ForEachChunk(this->pThreadPool, numChunks, [=](size_t begin, size_t end, uint) {
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			memcpy(pCheckpoint + sizeof(header) + chunk * sizeof(uint32), pChunks[chunk].data(), sizeof(uint32));
+			memcpy(pCheckpoint + pOffsets[chunk], pChunks[chunk].data() + sizeof(uint32), pChunks[chunk].size() - sizeof(uint32));
+		}
+	});
+}
+
+void CheckpointEncoder::Reset(void)
+{
+	this->reference.clear();
+}
+
+CheckpointDecoder::CheckpointDecoder(ThreadPool* pThreadPool) :
+	pThreadPool(pThreadPool)
+{
+	this->planes.resize((pThreadPool) ? pThreadPool->GetNumThreads() : 1);
+}
+
+bool CheckpointDecoder::Decode(const byte* pCheckpoint, size_t size, std::vector<byte>& data)
+{
+	CheckpointCodec::Header header;
+	if (size < sizeof(header))
+		return false;
+
+	memcpy(&header, pCheckpoint, sizeof(header));
+	if (header.magic != CheckpointCodec::magic || header.version != CheckpointCodec::version || header.elementSize == 0 || header.chunkSize == 0 || header.chunkSize % header.elementSize != 0
+		|| header.numChunks != (header.size + header.chunkSize - 1) / header.chunkSize || size < sizeof(header) + header.numChunks * sizeof(uint32))
+		return false;
+
+	const bool relative = header.isRelative != 0;
+	if (relative && this->reference.size() != header.size)
+		return false;
+
+	// find every chunk before they are decompressed in parallel
+	const size_t numChunks = header.numChunks;
+	std::vector<size_t> offsets(numChunks + 1);
+	offsets[0] = sizeof(header) + numChunks * sizeof(uint32);
+
+	for (size_t chunk = 0; chunk < numChunks; chunk++)
+	{
+		uint32 sizeCode;
+		memcpy(&sizeCode, pCheckpoint + sizeof(header) + chunk * sizeof(uint32), sizeof(sizeCode));
+		offsets[chunk + 1] = offsets[chunk] + (sizeCode & ~CheckpointCodec::storedChunk);
+	}
+
+	if (offsets[numChunks] != size)
+		return false;
+
+	data.resize(header.size);
+	this->reference.resize(header.size);
+
+	const uint32 chunkSize = header.chunkSize;
+	const size_t elementSize = header.elementSize;
+	const size_t dataSize = header.size;
+	const size_t* pOffsets = offsets.data();
+	byte* pData = data.data();
+	byte* pReference = this->reference.data();
+	std::vector<byte>* pPlanes = this->planes.data();
+	std::atomic<bool> isValid(true);
+
+	ForEachChunk(this->pThreadPool, numChunks, [&, pCheckpoint](size_t begin, size_t end, uint threadIndex) {
+		std::vector<byte>& threadPlanes = pPlanes[threadIndex];
+		threadPlanes.resize(chunkSize);
+
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			const size_t offset = chunk * chunkSize;
+			const size_t size = std::min<size_t>(chunkSize, dataSize - offset);
+			const byte* pCompressed = pCheckpoint + pOffsets[chunk];
+			const size_t compressedSize = pOffsets[chunk + 1] - pOffsets[chunk];
+
+			uint32 sizeCode;
+			memcpy(&sizeCode, pCheckpoint + sizeof(header) + chunk * sizeof(uint32), sizeof(sizeCode));
+
+			if (sizeCode & CheckpointCodec::storedChunk)
+			{
+				if (compressedSize != size)
+				{
+					isValid.store(false, std::memory_order_relaxed);
+					return;
+				}
+				memcpy(threadPlanes.data(), pCompressed, size);
+			}
+			else if (!DecompressLZ(pCompressed, compressedSize, threadPlanes.data(), size))
+			{
+				isValid.store(false, std::memory_order_relaxed);
+				return;
+			}
+
+			Unshuffle(threadPlanes.data(), (relative) ? pReference + offset : nullptr, size, elementSize, pData + offset);
+
+			// the data is the reference of the next checkpoint
+			memcpy(pReference + offset, pData + offset, size);
+		}
+	});
+
+	// a broken chunk breaks the chain of relative checkpoints too
+	if (!isValid.load(std::memory_order_relaxed))
+	{
+		this->reference.clear();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,140 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+// INTERNAL INCLUDES
+#include "checkpointcodec.h"
+#include "checkpointstudy.h"
+#include "deltatime.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "utils.h"
+
+/**
+ * @brief	This struct defines what was measured for one kind of checkpoint
+ */
+struct CodecResult
+{
+	uint64 numCheckpoints;
+	uint64 rawSize;
+	uint64 compressedSize;
+	uint64 compressTime;
+	uint64 decompressTime;
+	uint64 writeTime;
+};
+
+/**
+ * @brief	This helper writes a buffer to a temporary file and measures how long it took
+ * 			The file is flushed to the operating system, not synchronized to the disk.
+ * @return	uint64 is the write time in microseconds
+ */
+static uint64 MeasureWrite(const byte* pData, size_t size)
+{
+	FILE* pFile = tmpfile();
+	if (!pFile)
+		return 0;
+
+	uint64 startTime = Time::Now();
+	fwrite(pData, 1, size, pFile);
+	fflush(pFile);
+	uint64 writeTime = Time::Now() - startTime;
+
+	fclose(pFile);
+	return writeTime;
+}
+
+bool CheckpointStudy::Run(size_t numParticles, uint numSteps, uint interval)
+{
+	ThreadPool threadPool;
+	ParticleSimulation simulation(numParticles, &threadPool);
+	if (!simulation.SetupParticles())
+		return false;
+	simulation.SetTimeBins(4);
+	simulation.SetSleeping(true);
+
+	CheckpointEncoder independentEncoder(&threadPool), relativeEncoder(&threadPool);
+	CheckpointDecoder independentDecoder(&threadPool), relativeDecoder(&threadPool);
+	std::vector<ParticleSimulation::Particle> state(numParticles);
+	std::vector<byte> checkpoint, decoded;
+	CodecResult results[3] = {};
+	bool succeeded = true;
+
+	interval = std::max(interval, 1u);
+	for (uint step = 1; step <= numSteps; step++)
+	{
+		simulation.Step(Time::maxTimeStep);
+		if (step % interval != 0)
+			continue;
+
+		// the checkpoints are in id order, so a particle is compared with itself
+		const ParticleSimulation::Particle* pParticles = simulation.GetParticles();
+		const uint32* pParticleIDs = simulation.GetParticleIDs();
+		for (size_t i = 0; i < numParticles; i++)
+			state[pParticleIDs[i]] = pParticles[i];
+
+		const byte* pState = reinterpret_cast<const byte*>(state.data());
+		const size_t stateSize = sizeof(ParticleSimulation::Particle) * numParticles;
+
+		results[0].numCheckpoints++;
+		results[0].rawSize += stateSize;
+		results[0].compressedSize += stateSize;
+		results[0].writeTime += MeasureWrite(pState, stateSize);
+
+		for (uint relative = 0; relative < 2; relative++)
+		{
+			CheckpointEncoder& encoder = (relative) ? relativeEncoder : independentEncoder;
+			CheckpointDecoder& decoder = (relative) ? relativeDecoder : independentDecoder;
+			CodecResult& result = results[1 + relative];
+
+			uint64 startTime = Time::Now();
+			encoder.Encode(pState, stateSize, sizeof(ParticleSimulation::Particle), relative != 0, checkpoint);
+			uint64 compressTime = Time::Now() - startTime;
+
+			startTime = Time::Now();
+			bool isDecoded = decoder.Decode(checkpoint.data(), checkpoint.size(), decoded);
+			uint64 decompressTime = Time::Now() - startTime;
+
+			// the codec must be lossless
+			if (!isDecoded || decoded.size() != stateSize || memcmp(decoded.data(), pState, stateSize) != 0)
+			{
+				ERR("The checkpoint of step %u didn't decompress to its state", step);
+				succeeded = false;
+			}
+
+			result.numCheckpoints++;
+			result.rawSize += stateSize;
+			result.compressedSize += checkpoint.size();
+			result.compressTime += compressTime;
+			result.decompressTime += decompressTime;
+			result.writeTime += MeasureWrite(checkpoint.data(), checkpoint.size());
+		}
+	}
+
+	printf("Checkpoints of %zu particles (%.1f MiB) every %u steps, %" PRIu64 " checkpoints, %u threads\n",
+		numParticles, sizeof(ParticleSimulation::Particle) * numParticles / (1024.0 * 1024.0), interval, results[0].numCheckpoints, threadPool.GetNumThreads());
+	printf("%-12s %8s %14s %16s %10s %15s\n", "codec", "ratio", "compress GB/s", "decompress GB/s", "write ms", "checkpoint ms");
+
+	const char* pNames[] = { "raw", "independent", "relative" };
+	for (uint codec = 0; codec < 3; codec++)
+	{
+		const CodecResult& result = results[codec];
+		if (result.numCheckpoints == 0)
+			continue;
+
+		// a checkpoint costs its compression and writing the compressed bytes
+		double ratio = (result.compressedSize > 0) ? static_cast<double>(result.rawSize) / result.compressedSize : 0.0;
+		double compressRate = (result.compressTime > 0) ? result.rawSize / (result.compressTime * 1000.0) : 0.0;
+		double decompressRate = (result.decompressTime > 0) ? result.rawSize / (result.decompressTime * 1000.0) : 0.0;
+		double writeTime = result.writeTime / 1000.0 / result.numCheckpoints;
+		double checkpointTime = (result.compressTime + result.writeTime) / 1000.0 / result.numCheckpoints;
+
+		if (codec == 0)
+			printf("%-12s %8.2f %14s %16s %10.3f %15.3f\n", pNames[codec], ratio, "-", "-", writeTime, checkpointTime);
+		else
+			printf("%-12s %8.2f %14.2f %16.2f %10.3f %15.3f\n", pNames[codec], ratio, compressRate, decompressRate, writeTime, checkpointTime);
+	}
+
+	return succeeded;
+}
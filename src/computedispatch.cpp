@@ -0,0 +1,36 @@
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "computedispatch.h"
+#include "utils.h"
+
+Compute::Dispatcher::Dispatcher(ThreadPool* pThreadPool) :
+	pThreadPool(pThreadPool),
+	numGroups(0),
+	numThreads(0)
+{
+
+}
+
+uint64 Compute::Dispatcher::GetNumGroups(void) const
+{
+	return this->numGroups;
+}
+uint64 Compute::Dispatcher::GetNumThreads(void) const
+{
+	return this->numThreads;
+}
+
+bool Compute::Dispatcher::ValidateDispatch(uint numGroupsX, uint numGroupsY, uint numGroupsZ)
+{
+	// a zero count is a valid dispatch that does nothing
+	if (numGroupsX == 0 || numGroupsY == 0 || numGroupsZ == 0)
+		return true;
+
+	if (numGroupsX > maxGroupsPerDimension || numGroupsY > maxGroupsPerDimension || numGroupsZ > maxGroupsPerDimension)
+	{
+		ERR("Dispatch(%u, %u, %u) exceeds the limit of %u groups per dimension", numGroupsX, numGroupsY, numGroupsZ, maxGroupsPerDimension);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,282 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cfloat>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+// INTERNAL INCLUDES
+#include "computedispatch.h"
+#include "computekernels.h"
+#include "computestudy.h"
+#include "deltatime.h"
+#include "integrators.h"
+#include "threadpool.h"
+#include "utils.h"
+
+typedef ParticleSimulation::Particle Particle;
+
+constexpr uint numRounds = 3;	/**< a measurement is repeated this many times, the fastest run counts */
+
+/**
+ * @brief	This is IntegrateCS before the check of the particle id
+ */
+struct UncheckedIntegrate : ComputeKernels::Integrate
+{
+	void operator()(uint /*phase*/, const Compute::ThreadContext& context, GroupShared& /*shared*/, ThreadPrivate& /*local*/) const
+	{
+		this->IntegrateParticle(context.dispatchThreadID.x);
+	}
+};
+
+/**
+ * @brief	This struct defines the bounding box of positions
+ */
+struct Bounds
+{
+	Math::Vec2 min;
+	Math::Vec2 max;
+};
+
+/**
+ * @brief	This kernel reduces the positions of every group to their bounds in groupshared memory
+ * 			Phase 0 loads the positions, every following phase halves the active threads
+ * 			(one barrier each) and the first thread appends the bounds of the group.
+ */
+struct GroupBounds : Compute::Kernel<64>
+{
+	static constexpr uint numPhases = 7;
+
+	struct GroupShared
+	{
+		Bounds bounds[64];
+	};
+
+	Compute::StructuredBuffer<Particle>* pParticles;
+	Compute::AppendConsumeBuffer<Bounds>* pGroupBounds;
+	uint numParticles;
+
+	void operator()(uint phase, const Compute::ThreadContext& context, GroupShared& shared, ThreadPrivate& /*local*/) const
+	{
+		const uint index = context.groupIndex;
+
+		if (phase == 0)
+		{
+			// the surplus threads of the last group load an empty box
+			if (context.dispatchThreadID.x < this->numParticles)
+			{
+				Math::Vec2 position = (*this->pParticles)[context.dispatchThreadID.x].position;
+				shared.bounds[index] = { position, position };
+			}
+			else
+				shared.bounds[index] = { { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX } };
+
+			return;
+		}
+
+		const uint stride = 64u >> phase;
+		if (index >= stride)
+			return;
+
+		Bounds& bounds = shared.bounds[index];
+		const Bounds& other = shared.bounds[index + stride];
+		bounds.min = { std::min(bounds.min.x, other.min.x), std::min(bounds.min.y, other.min.y) };
+		bounds.max = { std::max(bounds.max.x, other.max.x), std::max(bounds.max.y, other.max.y) };
+
+		if (stride == 1)
+			this->pGroupBounds->Append(bounds);
+	}
+};
+
+/**
+ * @brief	This helper places the particles on the start grid of the simulation and takes one step
+ * 			so that they move.
+ */
+static void SetupParticles(std::vector<Particle>& particles)
+{
+	for (size_t i = 0; i < particles.size(); i++)
+	{
+		float column = float(i % 1000);
+		float row = float(i / 50);
+
+		particles[i].position = { (column * 0.0009f) - 0.5f, (row * 0.0009f) - 0.5f };
+		particles[i].prevPosition = particles[i].position;
+		particles[i].nextPosition = particles[i].position;
+	}
+}
+
+/**
+ * @brief	This helper calculates the largest distance between the positions of two particle arrays
+ */
+static float MaxDifference(const std::vector<Particle>& lhs, const std::vector<Particle>& rhs)
+{
+	float maxDifference = 0.0f;
+	for (size_t i = 0; i < lhs.size(); i++)
+	{
+		maxDifference = std::max(maxDifference, fabsf(lhs[i].nextPosition.x - rhs[i].nextPosition.x));
+		maxDifference = std::max(maxDifference, fabsf(lhs[i].nextPosition.y - rhs[i].nextPosition.y));
+	}
+
+	return maxDifference;
+}
+
+bool ComputeStudy::Run(size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	Compute::Dispatcher dispatcher(&threadPool);
+	numSteps = std::max(numSteps, 1u);
+	bool succeeded = true;
+
+	ParticleSimulation::SimulationConstants constants = {};
+	constants.numParticles = static_cast<uint>(numParticles);
+	constants.gravitySource = Math::Vec2::zero;
+	constants.gravityStrength = 9.81f;
+	constants.lastTimestep = Time::maxTimeStep;
+	constants.timestep = Time::maxTimeStep;
+	constants.damping = 0.9948f;
+
+	Integrators::StepConstants stepConstants;
+	stepConstants.gravitySource = constants.gravitySource;
+	stepConstants.gravityStrength = constants.gravityStrength;
+	stepConstants.lastTimestep = constants.lastTimestep;
+	stepConstants.timestep = constants.timestep;
+	stepConstants.damping = constants.damping;
+
+	// the CPU integration is the reference of one step
+	std::vector<Particle> reference(numParticles), particles(numParticles);
+	std::vector<Math::Vec2> velocities(numParticles, Math::Vec2::zero);
+	SetupParticles(reference);
+	Integrators::IntegrateRange<Integrators::FloatPositionVerlet>(reference.data(), velocities.data(), 0, numParticles, stepConstants);
+
+	Compute::StructuredBuffer<Particle> particleBuffer(particles.data(), numParticles);
+	ComputeKernels::Integrate integrate;
+	integrate.pCurrentSimulationState = &particleBuffer;
+	integrate.constants = constants;
+	UncheckedIntegrate uncheckedIntegrate;
+	uncheckedIntegrate.pCurrentSimulationState = &particleBuffer;
+	uncheckedIntegrate.constants = constants;
+
+	const uint numThreads = ComputeKernels::Integrate::numThreads.x;
+	const uint numGroups = Compute::NumGroups(numParticles, numThreads);
+
+	printf("IntegrateCS of %zu particles, %u threads per group, %u pool threads\n", numParticles, numThreads, threadPool.GetNumThreads());
+	printf("%-34s %10s %12s %14s %12s\n", "dispatch", "groups", "threads", "out of bounds", "max error");
+
+	// the dispatch of UpdateParticles before, the surplus threads exceed the buffer (D3D11 drops the writes)
+	for (uint sizing = 0; sizing < 3; sizing++)
+	{
+		SetupParticles(particles);
+		particleBuffer.ResetNumOutOfBounds();
+
+		const uint groups = (sizing == 0) ? static_cast<uint>(std::min<size_t>(numParticles, UINT32_MAX)) : numGroups;
+		const bool dispatched = (sizing == 2) ? dispatcher.Dispatch(integrate, groups) : dispatcher.Dispatch(uncheckedIntegrate, groups);
+		const char* pNames[] = { "Dispatch(n), no id check", "Dispatch(ceil(n / 64)), no id check", "Dispatch(ceil(n / 64))" };
+
+		if (!dispatched)
+		{
+			printf("%-34s %10u %12s %14s %12s\n", pNames[sizing], groups, "rejected", "-", "-");
+			continue;
+		}
+
+		printf("%-34s %10u %12" PRIu64 " %14" PRIu64 " %12.3e\n", pNames[sizing], groups, static_cast<uint64>(groups) * numThreads,
+			particleBuffer.GetNumOutOfBounds(), MaxDifference(particles, reference));
+
+		if (sizing == 2 && (particleBuffer.GetNumOutOfBounds() > 0 || MaxDifference(particles, reference) > 1e-6f))
+		{
+			ERR("IntegrateCS touched memory outside its buffer or differs from the CPU integration");
+			succeeded = false;
+		}
+	}
+
+	// the throughput of the dispatched kernel next to the native loop
+	double kernelTime = 0.0, nativeTime = 0.0;
+	for (uint round = 0; round < numRounds; round++)
+	{
+		SetupParticles(particles);
+		uint64 startTime = Time::Now();
+		for (uint step = 0; step < numSteps; step++)
+			dispatcher.Dispatch(integrate, numGroups);
+		double time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+		kernelTime = (round == 0) ? time : std::min(kernelTime, time);
+
+		SetupParticles(particles);
+		Particle* pParticles = particles.data();
+		Math::Vec2* pVelocities = velocities.data();
+		startTime = Time::Now();
+		for (uint step = 0; step < numSteps; step++)
+		{
+			threadPool.ParallelFor(numParticles, [=, &stepConstants](size_t begin, size_t end, uint) {
+				Integrators::IntegrateRange<Integrators::FloatPositionVerlet>(pParticles, pVelocities, begin, end, stepConstants);
+			});
+		}
+		time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+		nativeTime = (round == 0) ? time : std::min(nativeTime, time);
+	}
+
+	// a reduction with six barriers per group, the groups append their bounds
+	SetupParticles(particles);
+	std::vector<Bounds> groupBounds(numGroups);
+	Compute::AppendConsumeBuffer<Bounds> groupBoundsBuffer(groupBounds.data(), groupBounds.size());
+	GroupBounds bounds;
+	bounds.pParticles = &particleBuffer;
+	bounds.pGroupBounds = &groupBoundsBuffer;
+	bounds.numParticles = static_cast<uint>(numParticles);
+
+	double boundsTime = 0.0;
+	Bounds total = {};
+	for (uint round = 0; round < numRounds; round++)
+	{
+		groupBoundsBuffer.SetCount(0);
+		uint64 startTime = Time::Now();
+		dispatcher.Dispatch(bounds, numGroups);
+
+		total = { { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX } };
+		for (uint count = groupBoundsBuffer.GetCount(); count > 0; count--)
+		{
+			Bounds group = groupBoundsBuffer.Consume();
+			total.min = { std::min(total.min.x, group.min.x), std::min(total.min.y, group.min.y) };
+			total.max = { std::max(total.max.x, group.max.x), std::max(total.max.y, group.max.y) };
+		}
+
+		double time = (Time::Now() - startTime) * 1000.0 / static_cast<double>(numParticles);
+		boundsTime = (round == 0) ? time : std::min(boundsTime, time);
+	}
+
+	Bounds expected = { { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX } };
+	for (const Particle& particle : particles)
+	{
+		expected.min = { std::min(expected.min.x, particle.position.x), std::min(expected.min.y, particle.position.y) };
+		expected.max = { std::max(expected.max.x, particle.position.x), std::max(expected.max.y, particle.position.y) };
+	}
+
+	if (numParticles > 0 && (total.min.x != expected.min.x || total.min.y != expected.min.y || total.max.x != expected.max.x || total.max.y != expected.max.y))
+	{
+		ERR("The groupshared reduction doesn't match the bounds of the particles");
+		succeeded = false;
+	}
+
+	// CreateParticleCS fills the buffer, the groups beyond its capacity overflow it
+	std::vector<Particle> created(numParticles);
+	Compute::AppendConsumeBuffer<Particle> createdBuffer(created.data(), created.size());
+	ComputeKernels::CreateParticle createParticle;
+	createParticle.pCurrentSimulationState = &createdBuffer;
+	createParticle.emitterLocation = { 0.25f, -0.25f };
+
+	const uint numCreateGroups = Compute::NumGroups(numParticles, ComputeKernels::CreateParticle::numThreads.x) + 1;
+	dispatcher.Dispatch(createParticle, numCreateGroups);
+
+	const uint64 numCreated = static_cast<uint64>(numCreateGroups) * ComputeKernels::CreateParticle::numThreads.x;
+	if (createdBuffer.GetCount() != numParticles || createdBuffer.GetNumOutOfBounds() != numCreated - numParticles)
+	{
+		ERR("CreateParticleCS appended %u particles (%" PRIu64 " overflowed) instead of %zu", createdBuffer.GetCount(), createdBuffer.GetNumOutOfBounds(), numParticles);
+		succeeded = false;
+	}
+
+	printf("%-34s %14s %16s\n", "kernel", "ns/particle", "M particles/s");
+	printf("%-34s %14.3f %16.1f\n", "native position Verlet", nativeTime, 1000.0 / nativeTime);
+	printf("%-34s %14.3f %16.1f\n", "IntegrateCS", kernelTime, 1000.0 / kernelTime);
+	printf("%-34s %14.3f %16.1f\n", "groupshared bounds (7 phases)", boundsTime, 1000.0 / boundsTime);
+	printf("CreateParticleCS appended %u of %" PRIu64 " particles, %" PRIu64 " overflowed the buffer\n", createdBuffer.GetCount(), numCreated, createdBuffer.GetNumOutOfBounds());
+
+	return succeeded;
+}
@@ -0,0 +1,236 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+// INTERNAL INCLUDES
+#include "constraintstudy.h"
+#include "deltatime.h"
+#include "distanceconstraints.h"
+#include "particleworld.h"
+#include "threadpool.h"
+#include "utils.h"
+
+typedef DistanceConstraints::Particle Particle;
+
+constexpr uint numRounds = 3;				/**< a measurement is repeated this many times, the fastest run counts */
+constexpr uint numConvergenceIterations = 32;	/**< the iterations of the convergence table */
+constexpr double clothMargin = 2.0;			/**< how many times closer to its rest lengths the constrained cloth in the world has to stay */
+
+/**
+ * @brief	This struct defines a solver of the study
+ */
+struct Solver
+{
+	const char* pName;
+	DistanceConstraints::SolverMethod method;
+	float relaxation;
+};
+
+static const Solver solvers[] = {
+	{ "Gauss-Seidel", DistanceConstraints::GaussSeidel, 1.0f },
+	{ "Jacobi", DistanceConstraints::Jacobi, 1.0f },
+	{ "Jacobi (relaxation 1.5)", DistanceConstraints::Jacobi, 1.5f }
+};
+
+/**
+ * @brief	This helper ties every particle of a square grid to its horizontal, vertical and diagonal neighbours
+ * 			The particles are numbered row by row like the start grid of a ParticleWorld.
+ */
+static void AddCloth(DistanceConstraints& constraints, uint side, float spacing)
+{
+	const float diagonal = spacing * sqrtf(2.0f);
+
+	for (uint row = 0; row < side; row++)
+	{
+		for (uint column = 0; column < side; column++)
+		{
+			const uint32 particle = row * side + column;
+
+			if (column + 1 < side)
+				constraints.Add(particle, particle + 1, spacing);
+			if (row + 1 < side)
+				constraints.Add(particle, particle + side, spacing);
+			if (column + 1 < side && row + 1 < side)
+				constraints.Add(particle, particle + side + 1, diagonal);
+			if (column > 0 && row + 1 < side)
+				constraints.Add(particle, particle + side - 1, diagonal);
+		}
+	}
+}
+
+/**
+ * @brief	This helper places the particles on the grid and moves every one by a random offset
+ * 			The offsets are at most a quarter of the spacing and the same on every call.
+ */
+static void SetupJitteredCloth(std::vector<Particle>& particles, uint side, float spacing)
+{
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> jitter(-0.25f * spacing, 0.25f * spacing);
+
+	for (size_t i = 0; i < particles.size(); i++)
+	{
+		Math::Vec2 position = { static_cast<float>(i % side) * spacing - 0.5f, static_cast<float>(i / side) * spacing - 0.5f };
+		particles[i].position = position;
+		particles[i].prevPosition = position;
+		particles[i].nextPosition = { position.x + jitter(generator), position.y + jitter(generator) };
+	}
+}
+
+/**
+ * @brief	This helper steps a cloth in a world
+ * @return	double is the time per particle and step in nanoseconds
+ */
+static double StepWorld(ThreadPool& threadPool, size_t numParticles, DistanceConstraints* pConstraints, uint numIterations, uint numSteps, double& error)
+{
+	ParticleWorld world(numParticles, &threadPool);
+
+	// the attractor is half an edge below the cloth, the cloth falls onto it and the pulls
+	// converge on it, so the free particles bunch up and the constraints have to hold them apart
+	ParticleWorld::SystemSettings settings;
+	settings.numParticles = numParticles;
+	settings.origin = Math::Vec2::zero;
+	settings.size = 1.0f;
+	settings.gravitySource = { 0.0f, -1.0f };
+	settings.gravityStrength = 9.81f;
+	settings.damping = 0.9948f;
+	if (world.AddSystem(settings) == ParticleWorld::invalidSystem)
+		return NAN;
+	world.SetConstraints(pConstraints, numIterations);
+
+	uint64 startTime = Time::Now();
+	for (uint step = 0; step < numSteps; step++)
+		world.Step(Time::maxTimeStep);
+	double time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+
+	// the error of the cloth even without the constraints solved
+	DistanceConstraints measure(&threadPool);
+	const uint side = static_cast<uint>(sqrt(static_cast<double>(numParticles)));
+	AddCloth(measure, side, 1.0f / side);
+	error = measure.MeasureError(world.GetParticles());
+
+	return time;
+}
+
+bool ConstraintStudy::Run(size_t numParticles, uint numIterations, uint numSteps)
+{
+	ThreadPool threadPool;
+	numIterations = std::max(numIterations, 1u);
+	numSteps = std::max(numSteps, 1u);
+	bool succeeded = true;
+
+	// the cloth is a square grid with one unit edge length
+	const uint side = std::max(2u, static_cast<uint>(sqrt(static_cast<double>(numParticles))));
+	const float spacing = 1.0f / side;
+	numParticles = static_cast<size_t>(side) * side;
+
+	DistanceConstraints constraints(&threadPool);
+	AddCloth(constraints, side, spacing);
+
+	std::vector<Particle> start(numParticles), particles(numParticles);
+	SetupJitteredCloth(start, side, spacing);
+
+	// the first solve colours the constraints
+	particles = start;
+	constraints.Solve(particles.data(), numParticles, 1);
+
+	printf("Cloth of %zu particles (%u x %u), %zu constraints, %u threads\n", numParticles, side, side, constraints.GetNumConstraints(), threadPool.GetNumThreads());
+	printf("%zu blocks, %u colours between them (%zu constraints solved on one thread), colouring took %.1f ms\n", constraints.GetNumBlocks(), constraints.GetNumColours(),
+		constraints.GetNumSerialConstraints(), constraints.GetColouringTime() / 1000.0);
+
+	// the constraints of a colour never share a particle, so any split among threads gives the same positions
+	{
+		ThreadPool fourThreads(4);
+		DistanceConstraints serialConstraints(nullptr), parallelConstraints(&fourThreads);
+		AddCloth(serialConstraints, side, spacing);
+		AddCloth(parallelConstraints, side, spacing);
+
+		std::vector<Particle> serial = start, parallel = start;
+		serialConstraints.Solve(serial.data(), numParticles, 4);
+		parallelConstraints.Solve(parallel.data(), numParticles, 4);
+
+		if (memcmp(serial.data(), parallel.data(), sizeof(Particle) * numParticles) != 0)
+		{
+			ERR("Gauss-Seidel solved on 4 threads differs from the calling thread");
+			succeeded = false;
+		}
+	}
+
+	// the relative error after every iteration, starting from the jittered cloth
+	std::vector<double> errors[sizeof(solvers) / sizeof(Solver)];
+	for (size_t solver = 0; solver < sizeof(solvers) / sizeof(Solver); solver++)
+	{
+		constraints.SetSolverMethod(solvers[solver].method, solvers[solver].relaxation);
+		particles = start;
+		errors[solver].push_back(constraints.MeasureError(particles.data()));
+
+		for (uint iteration = 0; iteration < numConvergenceIterations; iteration++)
+		{
+			constraints.Solve(particles.data(), numParticles, 1);
+			errors[solver].push_back(constraints.MeasureError(particles.data()));
+		}
+	}
+
+	printf("%-24s", "rms relative error after");
+	for (uint iteration = 0; iteration <= numConvergenceIterations; iteration = (iteration == 0) ? 1 : iteration * 2)
+		printf(" %9u", iteration);
+	printf(" %10s\n", "per iter.");
+
+	for (size_t solver = 0; solver < sizeof(solvers) / sizeof(Solver); solver++)
+	{
+		printf("%-24s", solvers[solver].pName);
+		for (uint iteration = 0; iteration <= numConvergenceIterations; iteration = (iteration == 0) ? 1 : iteration * 2)
+			printf(" %9.2e", errors[solver][iteration]);
+
+		// the mean factor an iteration reduces the error by
+		printf(" %10.3f\n", pow(errors[solver][numConvergenceIterations] / errors[solver][0], 1.0 / numConvergenceIterations));
+	}
+
+	if (errors[0][numConvergenceIterations] >= errors[0][0])
+	{
+		ERR("Gauss-Seidel didn't reduce the error of the cloth");
+		succeeded = false;
+	}
+
+	// the throughput of every solver
+	printf("%-24s %14s %16s\n", "solver", "ns/constraint", "M constraints/s");
+	for (size_t solver = 0; solver < sizeof(solvers) / sizeof(Solver); solver++)
+	{
+		constraints.SetSolverMethod(solvers[solver].method, solvers[solver].relaxation);
+		double bestTime = 0.0;
+
+		for (uint round = 0; round < numRounds; round++)
+		{
+			particles = start;
+			uint64 startTime = Time::Now();
+			constraints.Solve(particles.data(), numParticles, numIterations);
+
+			double time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(constraints.GetNumConstraints()) * numIterations);
+			bestTime = (round == 0) ? time : std::min(bestTime, time);
+		}
+
+		printf("%-24s %14.3f %16.1f\n", solvers[solver].pName, bestTime, 1000.0 / bestTime);
+	}
+
+	// the cloth falling in a world, with and without the constraints
+	double freeError = 0.0, clothError = 0.0;
+	constraints.SetSolverMethod(DistanceConstraints::GaussSeidel);
+	double freeTime = StepWorld(threadPool, numParticles, nullptr, numIterations, numSteps, freeError);
+	double clothTime = StepWorld(threadPool, numParticles, &constraints, numIterations, numSteps, clothError);
+
+	printf("%u steps in a ParticleWorld %17s %16s\n", numSteps, "ns/particle", "rms rel. error");
+	printf("%-36s %12.3f %16.2e\n", "without constraints", freeTime, freeError);
+	printf("%-36s %12.3f %16.2e\n", (std::string("Gauss-Seidel, ") + std::to_string(numIterations) + " iterations per step").c_str(), clothTime, clothError);
+
+	// the cloth contracts towards the attractor, the constraints have to hold it clearly closer to its rest lengths than no solve at all
+	if (!(clothError * clothMargin < freeError))
+	{
+		ERR("The constrained cloth isn't %.0f times closer to its rest lengths than the free one (%.2e vs %.2e)", clothMargin, clothError, freeError);
+		succeeded = false;
+	}
+
+	return succeeded;
+}
@@ -0,0 +1,44 @@
+// EXTERNAL INCLUDES
+#include <cstdio>
+#include <d3dcompiler.h>
+// INTERNAL INCLUDES
+#include "d3dshadercompiler.h"
+#include "utils.h"
+
+D3DShaderCompiler::D3DShaderCompiler()
+{
+	snprintf(this->version, sizeof(this->version), "d3dcompiler_%d", D3D_COMPILER_VERSION);
+}
+
+const char* D3DShaderCompiler::GetVersion(void) const
+{
+	return this->version;
+}
+
+bool D3DShaderCompiler::Compile(const std::string& source, const char* pFileName, const char* pEntryPoint, const char* pShaderModel, uint32 flags, std::vector<byte>& bytecode)
+{
+	LOG("Compiling shader (%s -> %s)", pFileName, pEntryPoint);
+
+	ID3DBlob* pBlob = nullptr;
+	ID3DBlob* pErrorBlob = nullptr;
+
+	// the file name lets the standard include handler resolve relative includes
+	HRESULT hr = D3DCompile(source.data(), source.size(), pFileName, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		pEntryPoint, pShaderModel, flags, 0, &pBlob, &pErrorBlob);
+
+	if (pErrorBlob)
+		LOG("%s", (char*)pErrorBlob->GetBufferPointer());
+	SAFE_RELEASE(pErrorBlob);
+
+	if (FAILED(hr))
+	{
+		SAFE_RELEASE(pBlob);
+		return false;
+	}
+
+	const byte* pBytecode = static_cast<const byte*>(pBlob->GetBufferPointer());
+	bytecode.assign(pBytecode, pBytecode + pBlob->GetBufferSize());
+	SAFE_RELEASE(pBlob);
+
+	return true;
+}
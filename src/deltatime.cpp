@@ -23,4 +23,10 @@ void Time::GetDetlaTime(Time& time)
 		time.deltaTime = 0.00001f;
 
 	time.oldTime = time.newTime;
+}
+uint64 Time::Now(void)
+{
+	// the steady clock never jumps so timestamps stay ordered
+	auto duration = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<uint64>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "diagnosticsstudy.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "utils.h"
+
+constexpr uint numRounds = 3;		/**< a run is measured this many times, the fastest counts */
+constexpr uint numWarmupSteps = 10;	/**< the steps before the measurement, the particles leave their start grid */
+
+/**
+ * @brief	This helper steps the simulation with or without the diagnostics
+ * @param	diagnostics are the returned diagnostics of the last step
+ * @return	double is the time per particle update in nanoseconds
+ */
+static double MeasureSteps(ThreadPool& threadPool, size_t numParticles, uint numSteps, ParticleSimulation::IntegrationMethod method, bool areDiagnosticsEnabled,
+	ParticleSimulation::Diagnostics& diagnostics)
+{
+	double bestTime = NAN;
+
+	for (uint round = 0; round < numRounds; round++)
+	{
+		ParticleSimulation simulation(numParticles, &threadPool);
+		if (!simulation.SetupParticles())
+			return NAN;
+		simulation.SetIntegrationMethod(method);
+		simulation.SetDiagnostics(areDiagnosticsEnabled);
+
+		for (uint step = 0; step < numWarmupSteps; step++)
+			simulation.Step(Time::maxTimeStep);
+
+		uint64 numUpdates = simulation.GetNumParticleUpdates();
+		uint64 startTime = Time::Now();
+		for (uint step = 0; step < numSteps; step++)
+			simulation.Step(Time::maxTimeStep);
+		double time = static_cast<double>(Time::Now() - startTime) * 1000.0 / std::max<uint64>(simulation.GetNumParticleUpdates() - numUpdates, 1);
+
+		bestTime = (round == 0) ? time : std::min(bestTime, time);
+		diagnostics = simulation.GetDiagnostics();
+	}
+
+	return bestTime;
+}
+
+bool DiagnosticsStudy::Run(size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	numSteps = std::max(numSteps, 1u);
+	bool succeeded = true;
+
+	const ParticleSimulation::IntegrationMethod methods[] = { ParticleSimulation::PositionVerlet, ParticleSimulation::VelocityVerlet };
+	const char* pNames[] = { "position Verlet (derived velocities)", "velocity Verlet (kept velocities)" };
+
+	printf("Diagnostics of %zu particles over %u steps, %u threads\n", numParticles, numSteps, threadPool.GetNumThreads());
+	printf("%-38s %13s %15s %10s %16s %10s\n", "integrator", "ns/particle", "diagnosed ns", "overhead", "kinetic energy", "max speed");
+
+	for (uint i = 0; i < 2; i++)
+	{
+		ParticleSimulation::Diagnostics diagnostics;
+		double plainTime = MeasureSteps(threadPool, numParticles, numSteps, methods[i], false, diagnostics);
+		double diagnosedTime = MeasureSteps(threadPool, numParticles, numSteps, methods[i], true, diagnostics);
+
+		printf("%-38s %13.2f %15.2f %9.1f%% %16.3f %10.3f\n", pNames[i], plainTime, diagnosedTime, 100.0 * (diagnosedTime - plainTime) / plainTime,
+			diagnostics.kineticEnergy, diagnostics.maxSpeed);
+
+		uint64 numBinnedParticles = 0;
+		for (uint bin = 0; bin < ParticleSimulation::Diagnostics::numSpeedBins; bin++)
+			numBinnedParticles += diagnostics.speedHistogram[bin];
+
+		if (!std::isfinite(diagnostics.kineticEnergy) || !std::isfinite(diagnostics.potentialEnergy) || !std::isfinite(diagnostics.maxSpeed))
+		{
+			ERR("The diagnostics of %s aren't finite", pNames[i]);
+			succeeded = false;
+		}
+		if (numBinnedParticles != numParticles)
+		{
+			ERR("The speed histogram of %s holds %" PRIu64 " of %zu particles", pNames[i], numBinnedParticles, numParticles);
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
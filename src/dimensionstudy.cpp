@@ -0,0 +1,63 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "dimensionstudy.h"
+#include "particleworld.h"
+#include "threadpool.h"
+
+constexpr uint numRounds = 3;	/**< a world is measured this many times, the fastest run counts */
+
+/**
+ * @brief	This helper steps a world with one system of particles
+ * @return	double is the time per particle and step in nanoseconds
+ */
+template <class Vector>
+static double MeasureWorld(ThreadPool& threadPool, size_t numParticles, uint numSteps)
+{
+	double bestTime = 0.0;
+
+	for (uint round = 0; round < numRounds; round++)
+	{
+		BasicParticleWorld<Vector> world(numParticles, &threadPool);
+
+		typename BasicParticleWorld<Vector>::SystemSettings settings;
+		settings.numParticles = numParticles;
+		settings.origin = Vector::zero;
+		settings.size = 1.0f;
+		settings.gravitySource = Vector::zero;
+		settings.gravityStrength = 9.81f;
+		settings.damping = 0.9948f;
+		if (world.AddSystem(settings) == BasicParticleWorld<Vector>::invalidSystem)
+			return NAN;
+
+		uint64 startTime = Time::Now();
+		for (uint step = 0; step < numSteps; step++)
+			world.Step(Time::maxTimeStep);
+
+		double time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+		bestTime = (round == 0) ? time : std::min(bestTime, time);
+	}
+
+	return bestTime;
+}
+
+void DimensionStudy::Run(size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	numSteps = std::max(numSteps, 1u);
+
+	const double stepTimes[] = { MeasureWorld<Math::Vec2>(threadPool, numParticles, numSteps), MeasureWorld<Math::Vec3>(threadPool, numParticles, numSteps) };
+	const size_t particleSizes[] = { sizeof(ParticleWorld::Particle) + sizeof(Math::Vec2), sizeof(ParticleWorld3D::Particle) + sizeof(Math::Vec3) };
+
+	printf("Position Verlet of %zu particles for %u steps, %u threads\n", numParticles, numSteps, threadPool.GetNumThreads());
+	printf("%-10s %14s %12s %16s %8s\n", "dimension", "bytes/particle", "ns/particle", "M particles/s", "cost");
+
+	for (uint dimension = 0; dimension < 2; dimension++)
+	{
+		printf("%-10s %14zu %12.3f %16.1f %7.2fx\n", (dimension == 0) ? "2D" : "3D", particleSizes[dimension], stepTimes[dimension],
+			1000.0 / stepTimes[dimension], stepTimes[dimension] / stepTimes[0]);
+	}
+}
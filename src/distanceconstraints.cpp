@@ -0,0 +1,412 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "distanceconstraints.h"
+#include "threadpool.h"
+#include "utils.h"
+
+/**
+ * @brief	This helper processes a range on the pool or on the calling thread
+ * @param	fn is called with the parts of the range (void(size_t begin, size_t end, uint threadIndex))
+ */
+template <class Fn>
+static void ForRange(ThreadPool* pThreadPool, size_t count, Fn fn)
+{
+	if (pThreadPool)
+		pThreadPool->ParallelFor(count, fn);
+	else if (count > 0)
+		fn(0, count, 0);
+}
+
+/**
+ * @brief	This helper calculates how a constraint moves its first particle
+ * 			Both particles have the same mass, so each one covers half of the error.
+ * @return	Vector is the correction of particleA (particleB moves by its negation)
+ */
+template <class Vector>
+static inline Vector Correction(const Vector& positionA, const Vector& positionB, float restLength, float stiffness)
+{
+	constexpr uint numDims = numDimensions<Vector>;
+	Vector delta;
+	float length2 = 0.0f;
+
+	for (uint d = 0; d < numDims; d++)
+	{
+		Component(delta, d) = Component(positionB, d) - Component(positionA, d);
+		length2 += Component(delta, d) * Component(delta, d);
+	}
+
+	// coincident particles have no direction to be pushed apart in
+	if (length2 < 1e-12f)
+		return Vector::zero;
+
+	float length = sqrtf(length2);
+	float scale = 0.5f * stiffness * (length - restLength) / length;
+
+	for (uint d = 0; d < numDims; d++)
+		Component(delta, d) *= scale;
+
+	return delta;
+}
+
+/**
+ * @brief	This helper solves a range of constraints one after another
+ */
+template <class Vector>
+static void ProjectRange(BasicParticle<Vector>* pParticles, const typename BasicDistanceConstraints<Vector>::Constraint* pConstraints, size_t begin, size_t end)
+{
+	constexpr uint numDims = numDimensions<Vector>;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		Vector& positionA = pParticles[pConstraints[i].particleA].nextPosition;
+		Vector& positionB = pParticles[pConstraints[i].particleB].nextPosition;
+		Vector correction = Correction(positionA, positionB, pConstraints[i].restLength, pConstraints[i].stiffness);
+
+		for (uint d = 0; d < numDims; d++)
+		{
+			Component(positionA, d) += Component(correction, d);
+			Component(positionB, d) -= Component(correction, d);
+		}
+	}
+}
+
+template <class Vector>
+BasicDistanceConstraints<Vector>::BasicDistanceConstraints(ThreadPool* pThreadPool) :
+	pThreadPool(pThreadPool),
+	method(GaussSeidel),
+	relaxation(1.0f),
+	numSolvedConstraints(0),
+	numReferencedParticles(0),
+	isColoured(false),
+	colouringTime(0),
+	areIncidencesBuilt(false)
+{
+
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::Add(uint32 particleA, uint32 particleB, float restLength, float stiffness)
+{
+	if (particleA == particleB)
+	{
+		WARN("A particle can't be constrained to itself (particle %u)", particleA);
+		return;
+	}
+
+	Constraint constraint;
+	constraint.particleA = particleA;
+	constraint.particleB = particleB;
+	constraint.restLength = restLength;
+	constraint.stiffness = std::min(std::max(stiffness, 0.0f), 1.0f);
+
+	this->constraints.push_back(constraint);
+	this->numReferencedParticles = std::max<size_t>(this->numReferencedParticles, std::max(particleA, particleB) + size_t(1));
+	this->isColoured = false;
+	this->areIncidencesBuilt = false;
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::Clear(void)
+{
+	this->constraints.clear();
+	this->colouredConstraints.clear();
+	this->blockEnds.clear();
+	this->colourEnds.clear();
+	this->incidenceStarts.clear();
+	this->incidences.clear();
+	this->corrections.clear();
+	this->numReferencedParticles = 0;
+	this->isColoured = false;
+	this->areIncidencesBuilt = false;
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::SetSolverMethod(SolverMethod method, float relaxation)
+{
+	this->method = method;
+	this->relaxation = relaxation;
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::Solve(Particle* pParticles, size_t numParticles, uint numIterations)
+{
+	if (this->constraints.empty() || numIterations == 0)
+		return;
+
+	if (this->numReferencedParticles > numParticles)
+	{
+		ERR("The constraints refer to particle %zu but there are only %zu particles", this->numReferencedParticles - 1, numParticles);
+		return;
+	}
+
+	if (this->method == GaussSeidel)
+		this->SolveGaussSeidel(pParticles, numIterations);
+	else
+		this->SolveJacobi(pParticles, numIterations);
+
+	this->numSolvedConstraints += static_cast<uint64>(this->constraints.size()) * numIterations;
+}
+
+template <class Vector>
+double BasicDistanceConstraints<Vector>::MeasureError(const Particle* pParticles) const
+{
+	if (this->constraints.empty())
+		return 0.0;
+
+	const Constraint* pConstraints = this->constraints.data();
+
+	auto measure = [=](size_t begin, size_t end) {
+		double sum = 0.0;
+		for (size_t i = begin; i < end; i++)
+		{
+			double length = sqrt(static_cast<double>(Math::SquareLength(pParticles[pConstraints[i].particleB].nextPosition - pParticles[pConstraints[i].particleA].nextPosition)));
+			double error = (length - pConstraints[i].restLength) / pConstraints[i].restLength;
+			sum += error * error;
+		}
+		return sum;
+	};
+
+	double sum = (this->pThreadPool) ? this->pThreadPool->ParallelReduce(this->constraints.size(), 0.0, measure, [](double lhs, double rhs) { return lhs + rhs; })
+		: measure(0, this->constraints.size());
+
+	return sqrt(sum / static_cast<double>(this->constraints.size()));
+}
+
+template <class Vector>
+size_t BasicDistanceConstraints<Vector>::GetNumConstraints(void) const
+{
+	return this->constraints.size();
+}
+template <class Vector>
+typename BasicDistanceConstraints<Vector>::SolverMethod BasicDistanceConstraints<Vector>::GetSolverMethod(void) const
+{
+	return this->method;
+}
+template <class Vector>
+size_t BasicDistanceConstraints<Vector>::GetNumBlocks(void) const
+{
+	return this->blockEnds.size();
+}
+template <class Vector>
+uint BasicDistanceConstraints<Vector>::GetNumColours(void) const
+{
+	return static_cast<uint>(this->colourEnds.size());
+}
+template <class Vector>
+size_t BasicDistanceConstraints<Vector>::GetNumSerialConstraints(void) const
+{
+	const size_t coloursBegin = this->blockEnds.empty() ? 0 : this->blockEnds.back();
+	return this->colouredConstraints.size() - (this->colourEnds.empty() ? coloursBegin : this->colourEnds.back());
+}
+template <class Vector>
+uint64 BasicDistanceConstraints<Vector>::GetColouringTime(void) const
+{
+	return this->colouringTime;
+}
+template <class Vector>
+uint64 BasicDistanceConstraints<Vector>::GetNumSolvedConstraints(void) const
+{
+	return this->numSolvedConstraints;
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::Colour(void)
+{
+	uint64 startTime = Time::Now();
+
+	// the constraints within a block of particles keep their order, only the others are coloured
+	const size_t numConstraints = this->constraints.size();
+	const size_t numBlocks = (this->numReferencedParticles + numBlockParticles - 1) / numBlockParticles;
+	const uint inBlock = maxColours + 1;
+	std::vector<size_t> blockCounts(numBlocks, 0);
+
+	// greedy: every constraint takes the first colour neither of its particles has yet
+	std::vector<uint64> particleColours(this->numReferencedParticles, 0);
+	std::vector<uint8> colours(numConstraints);
+	size_t colourCounts[maxColours + 1] = {};
+
+	for (size_t i = 0; i < numConstraints; i++)
+	{
+		const Constraint& constraint = this->constraints[i];
+		if (constraint.particleA / numBlockParticles == constraint.particleB / numBlockParticles)
+		{
+			colours[i] = static_cast<uint8>(inBlock);
+			blockCounts[constraint.particleA / numBlockParticles]++;
+			continue;
+		}
+
+		uint64 usedColours = particleColours[constraint.particleA] | particleColours[constraint.particleB];
+
+		uint colour = 0;
+		while (colour < maxColours && (usedColours & (uint64(1) << colour)))
+			colour++;
+
+		if (colour < maxColours)
+		{
+			particleColours[constraint.particleA] |= uint64(1) << colour;
+			particleColours[constraint.particleB] |= uint64(1) << colour;
+		}
+
+		colours[i] = static_cast<uint8>(colour);
+		colourCounts[colour]++;
+	}
+
+	// the colours are used from the first one on, so the used ones are a prefix
+	uint numColours = 0;
+	while (numColours < maxColours && colourCounts[numColours] > 0)
+		numColours++;
+
+	// sort the constraints by block and then by colour, they keep their order within a block and a colour
+	std::vector<size_t> blockStarts(numBlocks);
+	size_t start = 0;
+	this->blockEnds.resize(numBlocks);
+	for (size_t block = 0; block < numBlocks; block++)
+	{
+		blockStarts[block] = start;
+		start += blockCounts[block];
+		this->blockEnds[block] = start;
+	}
+
+	size_t colourStarts[maxColours + 1];
+	this->colourEnds.resize(numColours);
+	for (uint colour = 0; colour <= maxColours; colour++)
+	{
+		colourStarts[colour] = start;
+		start += colourCounts[colour];
+
+		if (colour < numColours)
+			this->colourEnds[colour] = start;
+	}
+
+	this->colouredConstraints.resize(numConstraints);
+	for (size_t i = 0; i < numConstraints; i++)
+	{
+		if (colours[i] == inBlock)
+			this->colouredConstraints[blockStarts[this->constraints[i].particleA / numBlockParticles]++] = this->constraints[i];
+		else
+			this->colouredConstraints[colourStarts[colours[i]]++] = this->constraints[i];
+	}
+
+	if (colourCounts[maxColours] > 0)
+		WARN("%zu constraints don't fit into %u colours, they are solved on one thread", colourCounts[maxColours], maxColours);
+
+	this->isColoured = true;
+	this->colouringTime = Time::Now() - startTime;
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::BuildIncidences(void)
+{
+	const size_t numConstraints = this->constraints.size();
+
+	// count the constraints of every particle, then place them behind each other
+	this->incidenceStarts.assign(this->numReferencedParticles + 1, 0);
+	for (const Constraint& constraint : this->constraints)
+	{
+		this->incidenceStarts[constraint.particleA + 1]++;
+		this->incidenceStarts[constraint.particleB + 1]++;
+	}
+	for (size_t i = 0; i < this->numReferencedParticles; i++)
+		this->incidenceStarts[i + 1] += this->incidenceStarts[i];
+
+	std::vector<uint32> fill(this->incidenceStarts.begin(), this->incidenceStarts.end() - 1);
+	this->incidences.resize(numConstraints * 2);
+	for (size_t i = 0; i < numConstraints; i++)
+	{
+		this->incidences[fill[this->constraints[i].particleA]++] = static_cast<uint32>(i << 1);
+		this->incidences[fill[this->constraints[i].particleB]++] = static_cast<uint32>((i << 1) | 1);
+	}
+
+	this->corrections.resize(numConstraints);
+	this->areIncidencesBuilt = true;
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::SolveGaussSeidel(Particle* pParticles, uint numIterations)
+{
+	if (!this->isColoured)
+		this->Colour();
+
+	const Constraint* pConstraints = this->colouredConstraints.data();
+	const size_t* pBlockEnds = this->blockEnds.data();
+	const size_t coloursBegin = this->blockEnds.empty() ? 0 : this->blockEnds.back();
+	const size_t serialBegin = this->colourEnds.empty() ? coloursBegin : this->colourEnds.back();
+
+	for (uint iteration = 0; iteration < numIterations; iteration++)
+	{
+		// the blocks share no particle, every block passes its corrections on in the order of its constraints
+		ForRange(this->pThreadPool, this->blockEnds.size(), [=](size_t begin, size_t end, uint) {
+			for (size_t block = begin; block < end; block++)
+				ProjectRange(pParticles, pConstraints, (block == 0) ? 0 : pBlockEnds[block - 1], pBlockEnds[block]);
+		});
+
+		// no two constraints of a colour share a particle, their threads never write the same particle
+		for (size_t colour = 0; colour < this->colourEnds.size(); colour++)
+		{
+			const size_t colourBegin = (colour == 0) ? coloursBegin : this->colourEnds[colour - 1];
+
+			ForRange(this->pThreadPool, this->colourEnds[colour] - colourBegin, [=](size_t begin, size_t end, uint) {
+				ProjectRange(pParticles, pConstraints, colourBegin + begin, colourBegin + end);
+			});
+		}
+
+		ProjectRange(pParticles, pConstraints, serialBegin, this->colouredConstraints.size());
+	}
+}
+
+template <class Vector>
+void BasicDistanceConstraints<Vector>::SolveJacobi(Particle* pParticles, uint numIterations)
+{
+	if (!this->areIncidencesBuilt)
+		this->BuildIncidences();
+
+	constexpr uint numDims = numDimensions<Vector>;
+	const Constraint* pConstraints = this->constraints.data();
+	const uint32* pIncidenceStarts = this->incidenceStarts.data();
+	const uint32* pIncidences = this->incidences.data();
+	Vector* pCorrections = this->corrections.data();
+	const float relaxation = this->relaxation;
+
+	for (uint iteration = 0; iteration < numIterations; iteration++)
+	{
+		// every constraint is solved from the positions of the last iteration
+		ForRange(this->pThreadPool, this->constraints.size(), [=](size_t begin, size_t end, uint) {
+			for (size_t i = begin; i < end; i++)
+			{
+				pCorrections[i] = Correction(pParticles[pConstraints[i].particleA].nextPosition, pParticles[pConstraints[i].particleB].nextPosition,
+					pConstraints[i].restLength, pConstraints[i].stiffness);
+			}
+		});
+
+		// every particle gathers the corrections of its own constraints
+		ForRange(this->pThreadPool, this->numReferencedParticles, [=](size_t begin, size_t end, uint) {
+			for (size_t i = begin; i < end; i++)
+			{
+				const uint32 first = pIncidenceStarts[i];
+				const uint32 last = pIncidenceStarts[i + 1];
+				if (first == last)
+					continue;
+
+				Vector sum = Vector::zero;
+				for (uint32 incidence = first; incidence < last; incidence++)
+				{
+					const Vector& correction = pCorrections[pIncidences[incidence] >> 1];
+					const float sign = (pIncidences[incidence] & 1) ? -1.0f : 1.0f;
+
+					for (uint d = 0; d < numDims; d++)
+						Component(sum, d) += sign * Component(correction, d);
+				}
+
+				const float scale = relaxation / static_cast<float>(last - first);
+				for (uint d = 0; d < numDims; d++)
+					Component(pParticles[i].nextPosition, d) += Component(sum, d) * scale;
+			}
+		});
+	}
+}
+
+template class BasicDistanceConstraints<Math::Vec2>;
+template class BasicDistanceConstraints<Math::Vec3>;
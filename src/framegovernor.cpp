@@ -0,0 +1,133 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+// INTERNAL INCLUDES
+#include "framegovernor.h"
+
+FrameGovernor::FrameGovernor(const Settings& settings) :
+	settings(settings),
+	level(0),
+	stageTimes(),
+	smoothedFrameTime(0.0f),
+	numFramesAtLevel(0),
+	numFramesOverBudget(0),
+	numFramesUnderThreshold(0),
+	numRecoverFrames(settings.numRecoverFrames),
+	isTrialLevel(false),
+	numFrames(0),
+	numFramesWithinBudget(0),
+	numLevelChanges(0)
+{
+	// the substeps are the cheapest to lose, then the presented states, then the particles
+	Quality quality = { settings.maxTimeBins, settings.numParticles, 1 };
+	this->levels.push_back(quality);
+
+	// fewer time bins still sort the particles and cost as much as all of them, only one step for all saves time
+	if (quality.numTimeBins > 0)
+	{
+		quality.numTimeBins = 0;
+		this->levels.push_back(quality);
+	}
+	while (quality.renderDecimation * 2 <= settings.maxRenderDecimation)
+	{
+		quality.renderDecimation *= 2;
+		this->levels.push_back(quality);
+	}
+	for (uint halving = 0; halving < settings.numParticleHalvings && quality.particleBudget > 1; halving++)
+	{
+		quality.particleBudget /= 2;
+		this->levels.push_back(quality);
+	}
+}
+
+void FrameGovernor::AddStageTime(Stage stage, uint64 time)
+{
+	this->stageTimes[stage] += time;
+}
+
+const FrameGovernor::Quality& FrameGovernor::EndFrame(void)
+{
+	// the simulation runs next to the stages of the main thread
+	uint64 mainThreadTime = this->stageTimes[Pump] + this->stageTimes[Acquire];
+	float frameTime = static_cast<float>(std::max(mainThreadTime, this->stageTimes[Simulate])) / 1000000.0f;
+	std::fill(this->stageTimes, this->stageTimes + numStages, 0);
+
+	const float targetFrameTime = this->settings.targetFrameTime;
+
+	// the smoothed frame time starts over with every level, the former level's frames don't count
+	this->smoothedFrameTime = (this->numFramesAtLevel == 0) ? frameTime : this->smoothedFrameTime + (frameTime - this->smoothedFrameTime) * this->settings.smoothing;
+	this->numFramesWithinBudget += (frameTime <= targetFrameTime) ? 1 : 0;
+	this->numFramesAtLevel++;
+	this->numFrames++;
+
+	// frames between the recover threshold and the budget reset both runs
+	this->numFramesOverBudget = (this->smoothedFrameTime > targetFrameTime) ? this->numFramesOverBudget + 1 : 0;
+	this->numFramesUnderThreshold = (this->smoothedFrameTime < targetFrameTime * this->settings.recoverThreshold) ? this->numFramesUnderThreshold + 1 : 0;
+
+	// a raised quality that held for a whole recovery is settled
+	if (this->isTrialLevel && this->numFramesAtLevel >= this->numRecoverFrames)
+	{
+		this->isTrialLevel = false;
+		this->numRecoverFrames = this->settings.numRecoverFrames;
+	}
+
+	uint nextLevel = this->level;
+	if (this->numFramesOverBudget >= this->settings.numDegradeFrames && this->level + 1 < this->levels.size())
+	{
+		// a raised quality that failed waits twice as long for the next try
+		if (this->isTrialLevel)
+			this->numRecoverFrames = std::min(this->numRecoverFrames * 2, std::max(this->settings.maxRecoverFrames, this->settings.numRecoverFrames));
+
+		nextLevel = this->level + 1;
+		this->isTrialLevel = false;
+	}
+	else if (this->numFramesUnderThreshold >= this->numRecoverFrames && this->level > 0)
+	{
+		nextLevel = this->level - 1;
+		this->isTrialLevel = true;
+	}
+
+	// the next change has to be earned by the frames of the new level
+	if (nextLevel != this->level)
+	{
+		this->level = nextLevel;
+		this->numFramesOverBudget = 0;
+		this->numFramesUnderThreshold = 0;
+		this->numFramesAtLevel = 0;
+		this->numLevelChanges++;
+	}
+
+	return this->levels[this->level];
+}
+
+const FrameGovernor::Quality& FrameGovernor::GetQuality(void) const
+{
+	return this->levels[this->level];
+}
+uint FrameGovernor::GetLevel(void) const
+{
+	return this->level;
+}
+uint FrameGovernor::GetNumLevels(void) const
+{
+	return static_cast<uint>(this->levels.size());
+}
+uint64 FrameGovernor::GetNumFrames(void) const
+{
+	return this->numFrames;
+}
+uint64 FrameGovernor::GetNumFramesWithinBudget(void) const
+{
+	return this->numFramesWithinBudget;
+}
+uint64 FrameGovernor::GetNumLevelChanges(void) const
+{
+	return this->numLevelChanges;
+}
+float FrameGovernor::GetSmoothedFrameTime(void) const
+{
+	return this->smoothedFrameTime;
+}
+const FrameGovernor::Settings& FrameGovernor::GetSettings(void) const
+{
+	return this->settings;
+}
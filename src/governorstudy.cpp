@@ -0,0 +1,231 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "framegovernor.h"
+#include "governorstudy.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "utils.h"
+
+constexpr uint numWarmupSteps = 30;		/**< the steps before a level is measured, the particles leave their start grid */
+constexpr uint numMeasuredSteps = 30;	/**< the steps the cost of a level is averaged over */
+constexpr uint numRounds = 3;			/**< the steps of a level are measured this many times, the fastest run counts */
+constexpr float calmLoad = 0.6f;		/**< the share of the budget the best quality takes at the calmest load */
+constexpr double minBestShare = 0.75;	/**< the share of the ideal frames at the best quality the governor has to keep */
+
+/**
+ * @brief	This struct defines a result of a run over the trace
+ */
+struct TraceResult
+{
+	uint64 numFramesWithinBudget;
+	uint64 numLevelChanges;
+	uint64 numBestFrames;		/**< the frames at the best quality */
+	double meanLevel;
+};
+
+/**
+ * @brief	This helper measures the cost of a quality level on the simulation
+ * @return	double is the time of a step and its published state in microseconds (the fastest of the rounds)
+ */
+static double MeasureLevel(ThreadPool& threadPool, size_t numParticles, const FrameGovernor::Quality& quality)
+{
+	ParticleSimulation simulation(numParticles, &threadPool);
+	if (!simulation.SetupParticles())
+		return NAN;
+	simulation.SetDiagnostics(true);
+	simulation.SetTimeBins(quality.numTimeBins);
+	simulation.SetParticleBudget(quality.particleBudget);
+
+	SimulationSnapshot snapshot;
+	for (uint step = 0; step < numWarmupSteps; step++)
+		simulation.Step(Time::maxTimeStep);
+
+	// like the simulation thread, only every n-th state is published
+	double bestTime = 0.0;
+	for (uint round = 0; round < numRounds; round++)
+	{
+		uint64 startTime = Time::Now();
+		for (uint step = 0; step < numMeasuredSteps; step++)
+		{
+			simulation.Step(Time::maxTimeStep);
+			if (step % quality.renderDecimation == 0)
+				simulation.WriteSnapshot(snapshot);
+		}
+
+		double time = static_cast<double>(Time::Now() - startTime) / numMeasuredSteps;
+		bestTime = (round == 0) ? time : std::min(bestTime, time);
+	}
+
+	return bestTime;
+}
+
+/**
+ * @brief	This helper creates the load of every frame of the trace
+ * 			The phases are calm, heavy, overloaded, calm again and a noisy swell,
+ * 			every frame gets a little noise and every few seconds a short spike.
+ */
+static std::vector<float> CreateLoadTrace(uint numFrames, std::mt19937& generator)
+{
+	std::normal_distribution<float> noise(1.0f, 0.08f);
+	std::vector<float> loads(numFrames);
+
+	for (uint frame = 0; frame < numFrames; frame++)
+	{
+		float phase = static_cast<float>(frame) / numFrames;
+		float load = 1.0f;
+
+		if (phase >= 0.2f && phase < 0.4f)
+			load = 1.5f;
+		else if (phase >= 0.4f && phase < 0.55f)
+			load = 2.5f;
+		else if (phase >= 0.75f)
+			load = 1.25f + 0.35f * sinf(static_cast<float>(frame) * 0.05f);
+
+		if (frame % 240 < 4)
+			load *= 3.0f;
+
+		loads[frame] = load * std::max(noise(generator), 0.5f);
+	}
+
+	return loads;
+}
+
+/**
+ * @brief	This helper runs a governor over the trace on a virtual clock
+ * @param	costs are the costs of the levels relative to the best quality
+ */
+static TraceResult RunTrace(const FrameGovernor::Settings& settings, const std::vector<float>& loads, const std::vector<double>& costs)
+{
+	FrameGovernor governor(settings);
+	TraceResult result = { 0, 0, 0, 0.0 };
+	const double budget = settings.targetFrameTime * 1000000.0;
+
+	for (float load : loads)
+	{
+		result.numBestFrames += (governor.GetLevel() == 0) ? 1 : 0;
+		result.meanLevel += governor.GetLevel();
+
+		governor.AddStageTime(FrameGovernor::Simulate, static_cast<uint64>(budget * calmLoad * load * costs[governor.GetLevel()]));
+		governor.EndFrame();
+	}
+
+	result.numFramesWithinBudget = governor.GetNumFramesWithinBudget();
+	result.numLevelChanges = governor.GetNumLevelChanges();
+	result.meanLevel /= static_cast<double>(loads.size());
+
+	return result;
+}
+
+/**
+ * @brief	This helper picks the best level that keeps every frame of the trace within the budget on its own
+ * 			It knows the load of a frame in advance, so it needs no hysteresis and never lags behind.
+ * @param	costs are the costs of the levels relative to the best quality
+ */
+static TraceResult RunIdeal(const std::vector<float>& loads, const std::vector<double>& costs)
+{
+	TraceResult result = { 0, 0, 0, 0.0 };
+	uint lastLevel = 0;
+
+	for (float load : loads)
+	{
+		uint level = 0;
+		while (level + 1 < costs.size() && calmLoad * load * costs[level] > 1.0)
+			level++;
+
+		result.numFramesWithinBudget += (calmLoad * load * costs[level] <= 1.0) ? 1 : 0;
+		result.numLevelChanges += (level != lastLevel) ? 1 : 0;
+		result.numBestFrames += (level == 0) ? 1 : 0;
+		result.meanLevel += level;
+		lastLevel = level;
+	}
+
+	result.meanLevel /= static_cast<double>(loads.size());
+
+	return result;
+}
+
+bool GovernorStudy::Run(size_t numParticles, uint numFrames)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	numFrames = std::max(numFrames, 1u);
+	bool succeeded = true;
+
+	FrameGovernor::Settings settings;
+	settings.numParticles = numParticles;
+	FrameGovernor levels(settings);
+
+	// the cost of every level on the simulation
+	printf("Quality levels of %zu particles, %u threads\n", numParticles, threadPool.GetNumThreads());
+	printf("%6s %10s %10s %11s %10s %9s\n", "level", "time bins", "particles", "decimation", "step us", "relative");
+
+	std::vector<double> costs;
+	double bestCost = 0.0;
+	for (uint level = 0; level < levels.GetNumLevels(); level++)
+	{
+		// the governor walks down the ladder while it stays over the budget
+		while (levels.GetLevel() < level)
+		{
+			levels.AddStageTime(FrameGovernor::Simulate, static_cast<uint64>(2.0 * settings.targetFrameTime * 1000000.0));
+			levels.EndFrame();
+		}
+
+		const FrameGovernor::Quality& quality = levels.GetQuality();
+		double cost = MeasureLevel(threadPool, numParticles, quality);
+		bestCost = (level == 0) ? cost : bestCost;
+		costs.push_back(cost / bestCost);
+
+		printf("%6u %10u %10zu %11u %10.1f %9.2f\n", level, quality.numTimeBins, quality.particleBudget, quality.renderDecimation, cost, cost / bestCost);
+	}
+
+	std::mt19937 generator(42);
+	const std::vector<float> loads = CreateLoadTrace(numFrames, generator);
+
+	// a fixed quality never changes, the governor without hysteresis reacts to every frame
+	FrameGovernor::Settings fixedSettings = settings;
+	fixedSettings.numDegradeFrames = ~0u;
+	fixedSettings.numRecoverFrames = ~0u;
+	FrameGovernor::Settings eagerSettings = settings;
+	eagerSettings.recoverThreshold = 1.0f;
+	eagerSettings.numDegradeFrames = 1;
+	eagerSettings.numRecoverFrames = 1;
+	eagerSettings.maxRecoverFrames = 1;
+	eagerSettings.smoothing = 1.0f;
+
+	TraceResult fixed = RunTrace(fixedSettings, loads, costs);
+	TraceResult eager = RunTrace(eagerSettings, loads, costs);
+	TraceResult governed = RunTrace(settings, loads, costs);
+	TraceResult ideal = RunIdeal(loads, costs);
+
+	printf("%u frames with a %.1f ms budget %15s %16s %12s %14s\n", numFrames, settings.targetFrameTime * 1000.0f, "within budget", "quality changes", "mean level", "best quality");
+	const char* pNames[] = { "fixed quality", "governor without hysteresis", "governor with hysteresis", "best level of every frame (ideal)" };
+	const TraceResult* pResults[] = { &fixed, &eager, &governed, &ideal };
+	for (uint i = 0; i < 4; i++)
+		printf("%-40s %14.1f%% %16" PRIu64 " %12.2f %13.1f%%\n", pNames[i], 100.0 * pResults[i]->numFramesWithinBudget / numFrames, pResults[i]->numLevelChanges,
+			pResults[i]->meanLevel, 100.0 * pResults[i]->numBestFrames / numFrames);
+
+	if (governed.numFramesWithinBudget <= fixed.numFramesWithinBudget)
+	{
+		ERR("The governor met the budget in %" PRIu64 " frames, the fixed quality in %" PRIu64, governed.numFramesWithinBudget, fixed.numFramesWithinBudget);
+		succeeded = false;
+	}
+	if (governed.numLevelChanges >= eager.numLevelChanges)
+	{
+		ERR("The governor changed the quality %" PRIu64 " times, without hysteresis %" PRIu64 " times", governed.numLevelChanges, eager.numLevelChanges);
+		succeeded = false;
+	}
+	if (governed.numBestFrames < minBestShare * ideal.numBestFrames)
+	{
+		ERR("The governor kept %" PRIu64 " frames at the best quality, the ideal levels %" PRIu64, governed.numBestFrames, ideal.numBestFrames);
+		succeeded = false;
+	}
+
+	return succeeded;
+}
@@ -0,0 +1,73 @@
+// EXTERNAL INCLUDES
+// INTERNAL INCLUDES
+#include "inputevent.h"
+
+static_assert((InputEventQueue::capacity & (InputEventQueue::capacity - 1)) == 0, "capacity must be a power of two");
+
+InputEventQueue::InputEventQueue() :
+	enqueuePos(0),
+	dequeuePos(0),
+	numPendingEvents(0)
+{
+	// every cell starts out free for the producer
+	// that reaches its position first
+	for (size_t i = 0; i < capacity; i++)
+		this->cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool InputEventQueue::Push(const InputEvent& event)
+{
+	size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+	Cell* pCell;
+
+	// claim a cell by moving the enqueue position forward
+	// (a failed exchange reloads the current position)
+	do
+	{
+		pCell = &this->cells[pos & (capacity - 1)];
+		size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+		// the consumer did not free this cell yet
+		if (diff < 0)
+			return false;
+
+		// another producer claimed this cell already
+		if (diff > 0)
+		{
+			pos = this->enqueuePos.load(std::memory_order_relaxed);
+			continue;
+		}
+
+		if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			break;
+
+	} while (true);
+
+	// write the event and hand the cell to the consumer
+	pCell->event = event;
+	pCell->sequence.store(pos + 1, std::memory_order_release);
+
+	return true;
+}
+
+bool InputEventQueue::Pop(uint64 until, InputEvent& event)
+{
+	Cell* pCell = &this->cells[this->dequeuePos & (capacity - 1)];
+
+	// the cell is either empty or still being written
+	if (pCell->sequence.load(std::memory_order_acquire) != this->dequeuePos + 1)
+		return false;
+
+	// events of later steps stay inside the queue
+	if (pCell->event.timestamp > until)
+		return false;
+
+	event = pCell->event;
+
+	// hand the cell back to the producers (one lap later)
+	pCell->sequence.store(this->dequeuePos + capacity, std::memory_order_release);
+	this->dequeuePos++;
+
+	return true;
+}
@@ -0,0 +1,233 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <type_traits>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "integrators.h"
+#include "integratorstudy.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "utils.h"
+
+typedef ParticleSimulation::Particle Particle;
+
+constexpr float orbitRadius = 0.5f;
+constexpr float gravityStrength = 9.81f;	/**< the pull of the simulation */
+constexpr float eccentricSpeed = 0.5f;		/**< the start speed of the eccentric orbit relative to the circular one */
+constexpr uint numTimesteps = 2;			/**< the timestep of the simulation and a quarter of it */
+constexpr uint numRotations = 3;			/**< the rotated copies of the circular orbit that measure the rounding */
+constexpr double floorMargin = 4.0;			/**< how far an orbit error has to be above the rounding to fit the order on it */
+
+/**
+ * @brief	This struct defines what was measured for one integrator
+ */
+struct IntegratorResult
+{
+	const char* pName;
+	double stepTime;						/**< nanoseconds per particle and step of the simulation */
+	double orbitErrors[numTimesteps];		/**< the distance to the analytic circular orbit relative to its radius */
+	double roundingErrors[numTimesteps];	/**< how far the rotated copies of the circular orbit end up from it relative to its radius */
+	double energyErrors[numTimesteps];		/**< the largest relative energy error of the eccentric orbit */
+};
+
+/**
+ * @brief	This helper places a particle at a position with a velocity in the state the integrator expects
+ * 			The position Verlet takes the former position instead of the velocity, the leapfrog
+ * 			the velocity half a step before the position.
+ */
+template <class Integrator>
+static void StartOrbit(Particle& particle, Math::Vec2& velocity, const Math::Vec2& position, const Math::Vec2& startVelocity, const Integrators::StepConstants& constants)
+{
+	const float timestep = constants.timestep;
+	const Math::Vec2 acceleration = Integrators::Acceleration(position, constants);
+
+	particle.nextPosition = position;
+	particle.position = position;
+	particle.prevPosition = Math::Vec2::zero;
+	velocity = startVelocity;
+
+	if constexpr (std::is_same<Integrator, Integrators::PositionVerlet>::value)
+	{
+		particle.position = position - startVelocity * timestep + acceleration * (timestep * timestep * 0.5f);
+		Integrator::Reset(particle, velocity);
+	}
+	else if constexpr (std::is_same<Integrator, Integrators::Leapfrog>::value)
+	{
+		velocity = startVelocity - acceleration * (timestep * 0.5f);
+	}
+}
+
+/**
+ * @brief	This helper retrieves the velocity at the current position of a particle
+ */
+template <class Integrator>
+static Math::Vec2 CurrentVelocity(const Particle& particle, const Math::Vec2& velocity, const Integrators::StepConstants& constants)
+{
+	const float timestep = constants.timestep;
+
+	if constexpr (std::is_same<Integrator, Integrators::PositionVerlet>::value)
+		return (particle.nextPosition - particle.position) / timestep + Integrators::Acceleration(particle.nextPosition, constants) * (timestep * 0.5f);
+	else if constexpr (std::is_same<Integrator, Integrators::Leapfrog>::value)
+		return velocity + Integrators::Acceleration(particle.nextPosition, constants) * (timestep * 0.5f);
+	else
+		return velocity;
+}
+
+/**
+ * @brief	This helper integrates the circular orbit from a start angle
+ * @return	Math::Vec2 is the end position rotated back by the start angle
+ */
+template <class Integrator>
+static Math::Vec2 IntegrateCircularOrbit(const Integrators::StepConstants& constants, uint numSteps, double startAngle)
+{
+	const double angularSpeed = sqrt(static_cast<double>(gravityStrength) / orbitRadius);
+	const double circularSpeed = angularSpeed * orbitRadius;
+	const double c = cos(startAngle), s = sin(startAngle);
+
+	Particle particle;
+	Math::Vec2 velocity;
+	StartOrbit<Integrator>(particle, velocity, { static_cast<float>(orbitRadius * c), static_cast<float>(orbitRadius * s) },
+		{ static_cast<float>(-circularSpeed * s), static_cast<float>(circularSpeed * c) }, constants);
+	for (uint step = 0; step < numSteps; step++)
+		Integrator::Integrate(particle, velocity, constants);
+
+	const double x = particle.nextPosition.x, y = particle.nextPosition.y;
+	return { static_cast<float>(x * c + y * s), static_cast<float>(y * c - x * s) };
+}
+
+/**
+ * @brief	This helper integrates the circular and the eccentric orbit with an integrator
+ * 			The pull is rotationally symmetric, so rotated copies of the circular orbit have the
+ * 			same integration error and only differ by the rounding of the float positions.
+ * @param	orbitError is the returned distance to the analytic circular orbit relative to its radius
+ * @param	roundingError is the returned largest distance of a rotated copy to the circular orbit relative to its radius
+ * @param	energyError is the returned largest relative energy error of the eccentric orbit
+ */
+template <class Integrator>
+static void MeasureOrbits(float timestep, uint numOrbits, double& orbitError, double& roundingError, double& energyError)
+{
+	Integrators::StepConstants constants;
+	constants.gravitySource = Math::Vec2::zero;
+	constants.gravityStrength = gravityStrength;
+	constants.lastTimestep = timestep;
+	constants.timestep = timestep;
+	constants.damping = 1.0f;
+
+	// the pull has a constant magnitude, a circle holds at v^2 / r = g
+	const double angularSpeed = sqrt(static_cast<double>(gravityStrength) / orbitRadius);
+	const uint numSteps = static_cast<uint>(round(numOrbits * 2.0 * M_PI / angularSpeed / timestep));
+	const float circularSpeed = static_cast<float>(angularSpeed * orbitRadius);
+
+	const Math::Vec2 endPosition = IntegrateCircularOrbit<Integrator>(constants, numSteps, 0.0);
+	const double angle = angularSpeed * timestep * numSteps;
+	const double dx = endPosition.x - orbitRadius * cos(angle);
+	const double dy = endPosition.y - orbitRadius * sin(angle);
+	orbitError = sqrt(dx * dx + dy * dy) / orbitRadius;
+
+	// start angles of whole radians, a copy rotated by quarter turns would round the same
+	roundingError = 0.0;
+	for (uint i = 1; i <= numRotations; i++)
+	{
+		const Math::Vec2 rotatedPosition = IntegrateCircularOrbit<Integrator>(constants, numSteps, static_cast<double>(i));
+		const double rx = static_cast<double>(rotatedPosition.x) - endPosition.x;
+		const double ry = static_cast<double>(rotatedPosition.y) - endPosition.y;
+		roundingError = std::max(roundingError, sqrt(rx * rx + ry * ry) / orbitRadius);
+	}
+
+	// the energy per unit mass is v^2 / 2 + g * r
+	Particle particle;
+	Math::Vec2 velocity;
+	auto energy = [&]() {
+		Math::Vec2 currentVelocity = CurrentVelocity<Integrator>(particle, velocity, constants);
+		return 0.5 * Math::SquareLength(currentVelocity) + static_cast<double>(gravityStrength) * Math::Length(particle.nextPosition);
+	};
+
+	StartOrbit<Integrator>(particle, velocity, { orbitRadius, 0.0f }, { 0.0f, circularSpeed * eccentricSpeed }, constants);
+	const double startEnergy = energy();
+	energyError = 0.0;
+	for (uint step = 0; step < numSteps; step++)
+	{
+		Integrator::Integrate(particle, velocity, constants);
+		energyError = std::max(energyError, fabs(energy() - startEnergy) / startEnergy);
+	}
+}
+
+/**
+ * @brief	This helper measures the simulation with an integrator selected
+ * @return	double is the time per particle and step in nanoseconds
+ */
+static double MeasureSimulation(ThreadPool& threadPool, size_t numParticles, uint numSteps, ParticleSimulation::IntegrationMethod method)
+{
+	ParticleSimulation simulation(numParticles, &threadPool);
+	if (!simulation.SetupParticles())
+		return NAN;
+	simulation.SetIntegrationMethod(method);
+
+	uint64 startTime = Time::Now();
+	for (uint step = 0; step < numSteps; step++)
+		simulation.Step(Time::maxTimeStep);
+
+	return (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+}
+
+/**
+ * @brief	This helper measures an integrator at both timesteps
+ */
+template <class Integrator>
+static IntegratorResult MeasureIntegrator(const char* pName, ThreadPool& threadPool, size_t numParticles, uint numSteps, uint numOrbits,
+	ParticleSimulation::IntegrationMethod method)
+{
+	IntegratorResult result = { pName, MeasureSimulation(threadPool, numParticles, numSteps, method), {}, {}, {} };
+
+	for (uint i = 0; i < numTimesteps; i++)
+		MeasureOrbits<Integrator>(Time::maxTimeStep / static_cast<float>(1u << (2 * i)), numOrbits, result.orbitErrors[i], result.roundingErrors[i], result.energyErrors[i]);
+
+	return result;
+}
+
+bool IntegratorStudy::Run(size_t numParticles, uint numSteps, uint numOrbits)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	numSteps = std::max(numSteps, 1u);
+	numOrbits = std::max(numOrbits, 1u);
+	bool succeeded = true;
+
+	const IntegratorResult results[] = {
+		MeasureIntegrator<Integrators::PositionVerlet>("position Verlet", threadPool, numParticles, numSteps, numOrbits, ParticleSimulation::PositionVerlet),
+		MeasureIntegrator<Integrators::VelocityVerlet>("velocity Verlet", threadPool, numParticles, numSteps, numOrbits, ParticleSimulation::VelocityVerlet),
+		MeasureIntegrator<Integrators::Leapfrog>("leapfrog", threadPool, numParticles, numSteps, numOrbits, ParticleSimulation::Leapfrog),
+		MeasureIntegrator<Integrators::SemiImplicitEuler>("semi-implicit Euler", threadPool, numParticles, numSteps, numOrbits, ParticleSimulation::SemiImplicitEuler),
+		MeasureIntegrator<Integrators::RungeKutta4>("Runge-Kutta 4", threadPool, numParticles, numSteps, numOrbits, ParticleSimulation::RungeKutta4),
+	};
+
+	printf("Simulation of %zu particles for %u steps, %u threads, %u revolutions of an orbit of radius %.2f at 1/60 s and 1/240 s\n",
+		numParticles, numSteps, threadPool.GetNumThreads(), numOrbits, orbitRadius);
+	printf("%-20s %12s %7s %12s %12s %6s %13s %13s\n", "integrator", "ns/particle", "cost", "orbit 1/60", "orbit 1/240", "order", "energy 1/60", "energy 1/240");
+
+	for (const IntegratorResult& result : results)
+	{
+		// the error of an integrator of order p shrinks by 4^p with a quarter of the timestep,
+		// but only as long as it isn't buried in the rounding of the float positions
+		bool aboveRounding = true;
+		for (uint i = 0; i < numTimesteps; i++)
+			aboveRounding &= result.orbitErrors[i] > result.roundingErrors[i] * floorMargin;
+
+		char order[16] = "float";
+		if (aboveRounding)
+			snprintf(order, sizeof(order), "%.2f", log(result.orbitErrors[0] / result.orbitErrors[1]) / log(4.0));
+
+		printf("%-20s %12.3f %6.2fx %12.3e %12.3e %6s %13.3e %13.3e\n", result.pName, result.stepTime, result.stepTime / results[0].stepTime,
+			result.orbitErrors[0], result.orbitErrors[1], order, result.energyErrors[0], result.energyErrors[1]);
+
+		if ((aboveRounding && !(result.orbitErrors[1] < result.orbitErrors[0])) || !std::isfinite(result.orbitErrors[1]) || !std::isfinite(result.energyErrors[1]))
+		{
+			ERR("The %s integration doesn't get closer to the orbit with a quarter of the timestep", result.pName);
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
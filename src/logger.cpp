@@ -0,0 +1,241 @@
+// EXTERNAL INCLUDES
+#include <chrono>
+#include <cinttypes>
+// INTERNAL INCLUDES
+#include "logger.h"
+
+constexpr size_t maxMessageSize = 1024;		/**< formatted messages are cut after this size */
+constexpr auto idleInterval = std::chrono::milliseconds(1);	/**< how long the logger thread sleeps when every ring is empty */
+
+/**
+ * @brief	This struct owns the ring of a thread and releases it when the thread exits
+ */
+struct ThreadRing
+{
+	void* pRing = nullptr;
+	std::atomic<bool>* pIsAbandoned = nullptr;
+
+	~ThreadRing()
+	{
+		if (this->pIsAbandoned)
+			this->pIsAbandoned->store(true, std::memory_order_release);
+	}
+};
+static thread_local ThreadRing threadRing;
+
+Logger::Logger() :
+	level(Info),
+	isRunning(true)
+{
+	this->thread = std::thread(&Logger::Run, this);
+}
+
+Logger::~Logger()
+{
+	this->isRunning.store(false, std::memory_order_relaxed);
+	this->thread.join();
+
+	// everything recorded until now
+	this->Drain();
+
+	// rings of threads that are still running stay alive for them
+	for (Ring* pRing : this->rings)
+	{
+		if (pRing->isAbandoned.load(std::memory_order_acquire))
+			delete pRing;
+	}
+}
+
+Logger& Logger::Get(void)
+{
+	static Logger logger;
+	return logger;
+}
+
+void Logger::SetLevel(Level level)
+{
+	Get().level.store(level, std::memory_order_relaxed);
+}
+Logger::Level Logger::GetLevel(void)
+{
+	return static_cast<Level>(Get().level.load(std::memory_order_relaxed));
+}
+
+void Logger::Flush(void)
+{
+	Logger& logger = Get();
+
+	while (true)
+	{
+		bool isEmpty = true;
+		{
+			std::lock_guard<std::mutex> lock(logger.ringsMutex);
+
+			for (Ring* pRing : logger.rings)
+			{
+				if (pRing->tail.load(std::memory_order_acquire) != pRing->head.load(std::memory_order_acquire))
+					isEmpty = false;
+			}
+		}
+
+		if (isEmpty)
+			return;
+
+		std::this_thread::sleep_for(idleInterval);
+	}
+}
+
+Logger::Ring* Logger::GetThreadRing(void)
+{
+	if (threadRing.pRing)
+		return static_cast<Ring*>(threadRing.pRing);
+
+	// the first message of a thread registers its ring
+	Ring* pRing = new Ring();
+	pRing->head.store(0, std::memory_order_relaxed);
+	pRing->tail.store(0, std::memory_order_relaxed);
+	pRing->numDropped.store(0, std::memory_order_relaxed);
+	pRing->isAbandoned.store(false, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(this->ringsMutex);
+		this->rings.push_back(pRing);
+	}
+
+	threadRing.pRing = pRing;
+	threadRing.pIsAbandoned = &pRing->isAbandoned;
+
+	return pRing;
+}
+
+byte* Logger::Reserve(uint32 size)
+{
+	Ring* pRing = this->GetThreadRing();
+
+	if (size > ringCapacity / 4)
+	{
+		pRing->numDropped.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	size_t head = pRing->head.load(std::memory_order_relaxed);
+	size_t tail = pRing->tail.load(std::memory_order_acquire);
+	size_t offset = head & (ringCapacity - 1);
+	size_t padding = (ringCapacity - offset < size) ? ringCapacity - offset : 0;
+
+	// the logger thread is behind, the message is lost
+	if (head + padding + size - tail > ringCapacity)
+	{
+		pRing->numDropped.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	// a record never wraps around, the rest of the ring is skipped
+	// (a rest too small for a header is skipped without one)
+	if (padding > 0)
+	{
+		if (padding >= sizeof(Record))
+		{
+			Record paddingRecord = {};
+			paddingRecord.size = static_cast<uint32>(padding);
+			memcpy(pRing->buffer + offset, &paddingRecord, sizeof(paddingRecord));
+		}
+
+		pRing->head.store(head + padding, std::memory_order_release);
+		offset = 0;
+	}
+
+	return pRing->buffer + offset;
+}
+
+void Logger::Commit(uint32 size)
+{
+	Ring* pRing = static_cast<Ring*>(threadRing.pRing);
+
+	// hand the record (and a padding before it) to the logger thread
+	pRing->head.store(pRing->head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+void Logger::Run(void)
+{
+	while (this->isRunning.load(std::memory_order_relaxed))
+	{
+		if (!this->Drain())
+			std::this_thread::sleep_for(idleInterval);
+	}
+}
+
+bool Logger::Drain(void)
+{
+	bool hasPrinted = false;
+	std::lock_guard<std::mutex> lock(this->ringsMutex);
+
+	for (size_t i = 0; i < this->rings.size(); i++)
+	{
+		Ring* pRing = this->rings[i];
+
+		// the abandoned flag is read first, afterwards the thread can't write anymore
+		bool isAbandoned = pRing->isAbandoned.load(std::memory_order_acquire);
+		size_t tail = pRing->tail.load(std::memory_order_relaxed);
+		size_t head = pRing->head.load(std::memory_order_acquire);
+
+		while (tail != head)
+		{
+			size_t offset = tail & (ringCapacity - 1);
+
+			if (ringCapacity - offset < sizeof(Record))
+			{
+				tail += ringCapacity - offset;
+				continue;
+			}
+
+			const byte* pRecord = pRing->buffer + offset;
+			Record record;
+			memcpy(&record, pRecord, sizeof(record));
+
+			if (record.pFormatFn)
+				this->Print(record, pRecord + sizeof(Record));
+
+			tail += record.size;
+			pRing->tail.store(tail, std::memory_order_release);
+			hasPrinted = true;
+		}
+
+		uint64 numDropped = pRing->numDropped.exchange(0, std::memory_order_relaxed);
+		if (numDropped > 0)
+		{
+			printf("[WARNING]: [%" PRIu64 " log messages were dropped] (%s #%i)\n", numDropped, __FILE__, __LINE__);
+			hasPrinted = true;
+		}
+
+		if (isAbandoned)
+		{
+			delete pRing;
+			this->rings.erase(this->rings.begin() + i--);
+		}
+	}
+
+	if (hasPrinted)
+		fflush(stdout);
+
+	return hasPrinted;
+}
+
+void Logger::Print(const Record& record, const byte* pArgs)
+{
+	char message[maxMessageSize];
+	record.pFormatFn(message, sizeof(message), record.pFormat, pArgs);
+
+	switch (record.level)
+	{
+	case Info:
+		printf("[INFO]: [%s]\n", message);
+		break;
+	case Warning:
+		printf("[WARNING]: [%s] (%s #%i)\n", message, record.pFile, record.line);
+		break;
+	case Error:
+		printf("[ERROR]: [%s] (%s #%i)\n", message, record.pFile, record.line);
+		break;
+	}
+}
@@ -0,0 +1,98 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cstdio>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "logger.h"
+#include "loggerstudy.h"
+#include "utils.h"
+
+constexpr uint batchSize = 256;		/**< the calls between two flushes, they fit into a ring */
+
+// the WARN macro before the Logger existed
+#define SYNC_WARN(x, ...) { char string[128]; snprintf(string, 128, x, ##__VA_ARGS__); printf("[WARNING]: [%s] (%s #%i)\n", string, __FILE__, __LINE__); }
+
+/**
+ * @brief	This helper calls a kind of log call in batches
+ * 			Only the calls are timed, not the flush after every batch.
+ * @return	double is the time of a call in nanoseconds
+ */
+template <class LogFn>
+static double MeasureCalls(uint numCalls, LogFn log)
+{
+	uint64 time = 0;
+
+	for (uint call = 0; call < numCalls; call += batchSize)
+	{
+		uint numBatchCalls = std::min(batchSize, numCalls - call);
+
+		uint64 startTime = Time::Now();
+		for (uint i = 0; i < numBatchCalls; i++)
+			log(call + i);
+		time += Time::Now() - startTime;
+
+		Logger::Flush();
+		fflush(stdout);
+	}
+
+	return 1000.0 * time / numCalls;
+}
+
+bool LoggerStudy::Run(uint numCalls)
+{
+	numCalls = std::max(numCalls, 1u);
+	const char* pName = "particles";
+	double values[3];
+
+	// the messages are printed into a temporary file, not the console
+	fflush(stdout);
+	FILE* pSink = tmpfile();
+#if defined(_WIN32)
+	int stdoutFile = _dup(_fileno(stdout));
+	bool isRedirected = pSink && _dup2(_fileno(pSink), _fileno(stdout)) == 0;
+#else
+	int stdoutFile = dup(fileno(stdout));
+	bool isRedirected = pSink && dup2(fileno(pSink), fileno(stdout)) >= 0;
+#endif
+
+	values[0] = MeasureCalls(numCalls, [pName](uint call) { SYNC_WARN("%u %s at %f", call, pName, call * 0.5); });
+	values[1] = MeasureCalls(numCalls, [pName](uint call) { WARN("%u %s at %f", call, pName, call * 0.5); });
+
+	// below the runtime level only the level is read
+	Logger::Level level = Logger::GetLevel();
+	Logger::SetLevel(Logger::Error);
+	values[2] = MeasureCalls(numCalls, [pName](uint call) { WARN("%u %s at %f", call, pName, call * 0.5); });
+	Logger::SetLevel(level);
+
+	fflush(stdout);
+#if defined(_WIN32)
+	if (isRedirected)
+		_dup2(stdoutFile, _fileno(stdout));
+	_close(stdoutFile);
+#else
+	if (isRedirected)
+		dup2(stdoutFile, fileno(stdout));
+	close(stdoutFile);
+#endif
+	if (pSink)
+		fclose(pSink);
+
+	printf("Cost of a log call with an int, a string and a double on the calling thread, %u calls%s\n", numCalls, (isRedirected) ? "" : " (printed to the console)");
+	printf("%-36s %10s\n", "call", "ns/call");
+	const char* pNames[] = { "former synchronous macro", "Logger (recorded)", "Logger (filtered at runtime)" };
+	for (uint i = 0; i < 3; i++)
+		printf("%-36s %10.1f\n", pNames[i], values[i]);
+
+	if (values[1] >= values[0])
+	{
+		ERR("A recorded call took %.1f ns, a call of the former macros %.1f ns", values[1], values[0]);
+		return false;
+	}
+
+	return true;
+}
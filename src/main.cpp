@@ -1,23 +1,52 @@
 // EXTERNAL INCLUDES
+#include <cstdlib>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#endif
 // INTERNAL INCLUDES
 #include "application.h"
+#include "studies.h"
 
 /**
  * @brief	Entry point :)
+ * 			Without Windows the application runs headless,
+ * 			the first start argument is the run time in seconds then
+ * 			the optional second one the port the metrics are served on (0 doesn't serve them)
+ * 			the optional third one the name of the shared memory ring the states are published to ("-" doesn't publish them)
+ * 			the optional fourth one the port the states are streamed to remote viewers on (0 doesn't stream them)
+ * 			and the optional fifth one "adaptive" picks the timestep of every step from an error estimate.
+ * 			"--<study> [arguments]" runs one of the studies instead, "--help" lists them (see studies.cpp).
  * 
  * @param	argc contains the number of start arguments
  * @param	argv contains the start arguments as a list of strings
- * @return	uint32 is the error code after execution (unused here)
+ * @return	int is the error code after execution (unused here)
  */
-#ifdef _DEBUG
-uint32 main(uint32 argc, char** argv)
+#if defined(_DEBUG) || !defined(_WIN32)
+int main(int argc, char** argv)
 #else
 int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 #endif
 {
+#if defined(_WIN32) && !defined(_DEBUG)
+	int argc = __argc;
+	char** argv = __argv;
+#endif
+
+	// the studies run before any thread exists
+	int exitCode = 0;
+	if (Studies::Run(argc, argv, exitCode))
+		return exitCode;
+
 	Application app;
 
+#if defined(_WIN32)
 	app.Init("[Patrick Kurras] GPU Particle Simulation", { 1366, 768 });
+#else
+	app.Init("[Patrick Kurras] GPU Particle Simulation", { 1366, 768 }, (argc > 1) ? static_cast<float>(atof(argv[1])) : 10.0f,
+		(argc > 2) ? static_cast<uint16>(atoi(argv[2])) : 0, (argc > 3 && strcmp(argv[3], "-") != 0) ? argv[3] : nullptr,
+		(argc > 4) ? static_cast<uint16>(atoi(argv[4])) : 0, argc > 5 && strcmp(argv[5], "adaptive") == 0);
+#endif
 	app.Update();
 	app.Close();
 
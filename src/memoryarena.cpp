@@ -0,0 +1,206 @@
+// EXTERNAL INCLUDES
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cstdio>
+#include <sys/mman.h>
+#endif
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "memoryarena.h"
+#include "utils.h"
+
+constexpr size_t hugePageSize = 2 * 1024 * 1024; /**< the size of a huge page on x86-64 */
+
+/**
+ * @brief	This helper rounds a size up to a multiple of a power of two
+ */
+static size_t RoundUp(size_t size, size_t multiple)
+{
+	return (size + multiple - 1) & ~(multiple - 1);
+}
+
+MemoryArena::MemoryArena(size_t capacity, PageSize pageSize) :
+	pMemory(nullptr),
+	capacity(RoundUp(capacity, hugePageSize)),
+	usedSize(0),
+	pageSize(pageSize),
+	reserveTime(0)
+{
+	uint64 startTime = Time::Now();
+
+#if defined(_WIN32)
+	// large pages need the "lock pages in memory" privilege
+	if (this->pageSize == ExplicitHugePages)
+	{
+		size_t largePageSize = GetLargePageMinimum();
+
+		if (largePageSize > 0)
+		{
+			this->capacity = RoundUp(this->capacity, largePageSize);
+			this->pMemory = static_cast<byte*>(VirtualAlloc(NULL, this->capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+		}
+
+		if (!this->pMemory)
+			WARN("Large pages are not available, falling back to small pages");
+	}
+
+	// there are no transparent huge pages on windows
+	if (!this->pMemory)
+	{
+		this->pageSize = SmallPages;
+		this->pMemory = static_cast<byte*>(VirtualAlloc(NULL, this->capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+	}
+#else
+	if (this->pageSize == ExplicitHugePages)
+	{
+		void* pMapping = mmap(NULL, this->capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+		if (pMapping != MAP_FAILED)
+			this->pMemory = static_cast<byte*>(pMapping);
+		else
+		{
+			WARN("Explicit huge pages are not available, falling back to transparent huge pages");
+			this->pageSize = TransparentHugePages;
+		}
+	}
+
+	if (!this->pMemory)
+	{
+		// over-reserve so the arena can start on a huge page boundary
+		size_t mappingSize = this->capacity + hugePageSize;
+		void* pMapping = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (pMapping != MAP_FAILED)
+		{
+			byte* pBegin = static_cast<byte*>(pMapping);
+			byte* pAligned = reinterpret_cast<byte*>(RoundUp(reinterpret_cast<size_t>(pBegin), hugePageSize));
+
+			// give the unaligned head and tail back
+			if (pAligned > pBegin)
+				munmap(pBegin, pAligned - pBegin);
+			if (pBegin + mappingSize > pAligned + this->capacity)
+				munmap(pAligned + this->capacity, (pBegin + mappingSize) - (pAligned + this->capacity));
+
+			this->pMemory = pAligned;
+
+			if (this->pageSize == TransparentHugePages && madvise(this->pMemory, this->capacity, MADV_HUGEPAGE) != 0)
+			{
+				WARN("Transparent huge pages are not available, falling back to small pages");
+				this->pageSize = SmallPages;
+			}
+
+			// with the system wide setting "always" the kernel would merge small pages as well
+			if (this->pageSize == SmallPages && madvise(this->pMemory, this->capacity, MADV_NOHUGEPAGE) != 0)
+				WARN("Could not exclude the memory arena from transparent huge pages");
+		}
+	}
+#endif
+
+	if (!this->pMemory)
+	{
+		ERR("Could not reserve %zu bytes for the memory arena", this->capacity);
+		this->capacity = 0;
+	}
+
+	this->reserveTime = Time::Now() - startTime;
+}
+
+MemoryArena::~MemoryArena()
+{
+	if (!this->pMemory)
+		return;
+
+#if defined(_WIN32)
+	VirtualFree(this->pMemory, 0, MEM_RELEASE);
+#else
+	munmap(this->pMemory, this->capacity);
+#endif
+}
+
+void* MemoryArena::Allocate(size_t size)
+{
+	size_t alignedSize = AlignedSize(size);
+
+	if (this->usedSize + alignedSize > this->capacity)
+	{
+		ERR("Memory arena exhausted (%zu of %zu bytes used)", this->usedSize, this->capacity);
+		return nullptr;
+	}
+
+	void* pAllocation = this->pMemory + this->usedSize;
+	this->usedSize += alignedSize;
+
+	return pAllocation;
+}
+
+size_t MemoryArena::AlignedSize(size_t size)
+{
+	return RoundUp(size, alignment);
+}
+
+bool MemoryArena::GetResidentSize(size_t& residentSize, size_t& hugePageSize) const
+{
+	residentSize = 0;
+	hugePageSize = 0;
+
+	if (!this->pMemory)
+		return false;
+
+#if defined(_WIN32)
+	// large pages are committed and locked when they are reserved
+	residentSize = this->usedSize;
+	hugePageSize = (this->pageSize == ExplicitHugePages) ? this->usedSize : 0;
+	return true;
+#else
+	FILE* pFile = fopen("/proc/self/smaps", "r");
+	if (!pFile)
+		return false;
+
+	// the kernel may split the mapping of the arena, every part that overlaps it counts
+	const size_t arenaBegin = reinterpret_cast<size_t>(this->pMemory);
+	const size_t arenaEnd = arenaBegin + this->capacity;
+	bool inArena = false;
+	char line[512];
+
+	while (fgets(line, sizeof(line), pFile))
+	{
+		size_t begin, end, size;
+
+		if (sscanf(line, "%zx-%zx ", &begin, &end) == 2)
+			inArena = (begin < arenaEnd && end > arenaBegin);
+		else if (!inArena)
+			continue;
+		else if (sscanf(line, "Rss: %zu kB", &size) == 1)
+			residentSize += size * 1024;
+		else if (sscanf(line, "AnonHugePages: %zu kB", &size) == 1)
+			hugePageSize += size * 1024;
+		else if (sscanf(line, "Private_Hugetlb: %zu kB", &size) == 1)
+		{
+			// the explicit huge pages aren't part of the resident set
+			residentSize += size * 1024;
+			hugePageSize += size * 1024;
+		}
+	}
+
+	fclose(pFile);
+	return true;
+#endif
+}
+
+size_t MemoryArena::GetCapacity(void) const
+{
+	return this->capacity;
+}
+size_t MemoryArena::GetUsedSize(void) const
+{
+	return this->usedSize;
+}
+MemoryArena::PageSize MemoryArena::GetPageSize(void) const
+{
+	return this->pageSize;
+}
+uint64 MemoryArena::GetReserveTime(void) const
+{
+	return this->reserveTime;
+}
@@ -0,0 +1,241 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "metrics.h"
+#include "utils.h"
+
+/**
+ * @brief	This helper appends one sample line
+ */
+static void AppendSample(std::string& text, const std::string& name, const char* pSuffix, const std::string& labels, const char* pExtraLabel, double value)
+{
+	char line[512];
+	std::string allLabels = labels;
+
+	if (pExtraLabel)
+		allLabels += (allLabels.empty() ? "" : ",") + std::string(pExtraLabel);
+
+	if (allLabels.empty())
+		snprintf(line, sizeof(line), "%s%s %.15g\n", name.c_str(), pSuffix, value);
+	else
+		snprintf(line, sizeof(line), "%s%s{%s} %.15g\n", name.c_str(), pSuffix, allLabels.c_str(), value);
+
+	text += line;
+}
+
+MetricsRegistry::Metric::Metric(const char* pName, const char* pHelp, const char* pLabels, const char* pType) :
+	name(pName),
+	help(pHelp),
+	labels(pLabels),
+	pType(pType)
+{
+
+}
+
+MetricsRegistry::Counter::Counter(const char* pName, const char* pHelp, const char* pLabels) :
+	Metric(pName, pHelp, pLabels, "counter")
+{
+	for (Slot& slot : this->slots)
+		slot.value.store(0, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::Counter::Add(uint64 value)
+{
+	this->slots[GetThreadSlot()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64 MetricsRegistry::Counter::GetValue(void) const
+{
+	uint64 value = 0;
+	for (const Slot& slot : this->slots)
+		value += slot.value.load(std::memory_order_relaxed);
+
+	return value;
+}
+
+void MetricsRegistry::Counter::FormatSamples(std::string& text) const
+{
+	AppendSample(text, this->name, "", this->labels, nullptr, static_cast<double>(this->GetValue()));
+}
+
+MetricsRegistry::Gauge::Gauge(const char* pName, const char* pHelp, const char* pLabels, std::function<double(void)> callback) :
+	Metric(pName, pHelp, pLabels, "gauge"),
+	value(0.0),
+	callback(callback)
+{
+
+}
+
+void MetricsRegistry::Gauge::Set(double value)
+{
+	this->value.store(value, std::memory_order_relaxed);
+}
+
+double MetricsRegistry::Gauge::GetValue(void) const
+{
+	return (this->callback) ? this->callback() : this->value.load(std::memory_order_relaxed);
+}
+
+void MetricsRegistry::Gauge::FormatSamples(std::string& text) const
+{
+	AppendSample(text, this->name, "", this->labels, nullptr, this->GetValue());
+}
+
+MetricsRegistry::Histogram::Histogram(const char* pName, const char* pHelp, const char* pLabels, const std::vector<double>& bounds) :
+	Metric(pName, pHelp, pLabels, "histogram"),
+	numBounds(std::min(static_cast<uint>(bounds.size()), maxBuckets))
+{
+	if (bounds.size() > maxBuckets)
+		WARN("Histogram %s keeps %u of %zu buckets", pName, maxBuckets, bounds.size());
+
+	std::copy(bounds.begin(), bounds.begin() + this->numBounds, this->bounds);
+
+	for (Slot& slot : this->slots)
+	{
+		for (std::atomic<uint64>& count : slot.counts)
+			count.store(0, std::memory_order_relaxed);
+		slot.sum.store(0.0, std::memory_order_relaxed);
+	}
+}
+
+void MetricsRegistry::Histogram::Observe(double value)
+{
+	Slot& slot = this->slots[GetThreadSlot()];
+
+	// the first bucket the value fits in (the last one is +Inf)
+	uint bucket = static_cast<uint>(std::lower_bound(this->bounds, this->bounds + this->numBounds, value) - this->bounds);
+	slot.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+
+	// only threads sharing a slot ever retry
+	double sum = slot.sum.load(std::memory_order_relaxed);
+	while (!slot.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+		;
+}
+
+void MetricsRegistry::Histogram::FormatSamples(std::string& text) const
+{
+	uint64 counts[maxBuckets + 1] = {};
+	double sum = 0.0;
+
+	for (const Slot& slot : this->slots)
+	{
+		for (uint bucket = 0; bucket <= this->numBounds; bucket++)
+			counts[bucket] += slot.counts[bucket].load(std::memory_order_relaxed);
+		sum += slot.sum.load(std::memory_order_relaxed);
+	}
+
+	// buckets are cumulative in the exposition format
+	uint64 count = 0;
+	char bound[64];
+	for (uint bucket = 0; bucket < this->numBounds; bucket++)
+	{
+		count += counts[bucket];
+		snprintf(bound, sizeof(bound), "le=\"%g\"", this->bounds[bucket]);
+		AppendSample(text, this->name, "_bucket", this->labels, bound, static_cast<double>(count));
+	}
+	count += counts[this->numBounds];
+
+	AppendSample(text, this->name, "_bucket", this->labels, "le=\"+Inf\"", static_cast<double>(count));
+	AppendSample(text, this->name, "_sum", this->labels, nullptr, sum);
+	AppendSample(text, this->name, "_count", this->labels, nullptr, static_cast<double>(count));
+}
+
+MetricsRegistry::Counter* MetricsRegistry::AddCounter(const char* pName, const char* pHelp, const char* pLabels)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->metrics.emplace_back(new Counter(pName, pHelp, pLabels));
+	return static_cast<Counter*>(this->metrics.back().get());
+}
+
+MetricsRegistry::Gauge* MetricsRegistry::AddGauge(const char* pName, const char* pHelp, const char* pLabels, std::function<double(void)> callback)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->metrics.emplace_back(new Gauge(pName, pHelp, pLabels, callback));
+	return static_cast<Gauge*>(this->metrics.back().get());
+}
+
+MetricsRegistry::Histogram* MetricsRegistry::AddHistogram(const char* pName, const char* pHelp, const char* pLabels, const std::vector<double>& bounds)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->metrics.emplace_back(new Histogram(pName, pHelp, pLabels, bounds));
+	return static_cast<Histogram*>(this->metrics.back().get());
+}
+
+void MetricsRegistry::AddProcessMetrics(void)
+{
+	this->AddGauge("process_resident_memory_bytes", "Resident memory size in bytes.", "", [] {
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0.0;
+
+		return static_cast<double>(counters.WorkingSetSize);
+#else
+		unsigned long size, resident;
+		FILE* pFile = fopen("/proc/self/statm", "r");
+		if (!pFile)
+			return 0.0;
+
+		int numRead = fscanf(pFile, "%lu %lu", &size, &resident);
+		fclose(pFile);
+
+		return (numRead == 2) ? static_cast<double>(resident) * sysconf(_SC_PAGESIZE) : 0.0;
+#endif
+	});
+}
+
+std::string MetricsRegistry::Format(void) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	std::string text;
+	std::set<std::string> formattedNames;
+
+	// metrics that only differ by their labels are one family,
+	// it is described once and its samples have to be adjacent
+	for (const std::unique_ptr<Metric>& pFamily : this->metrics)
+	{
+		if (!formattedNames.insert(pFamily->name).second)
+			continue;
+
+		text += "# HELP " + pFamily->name + " " + pFamily->help + "\n# TYPE " + pFamily->name + " " + pFamily->pType + "\n";
+
+		for (const std::unique_ptr<Metric>& pMetric : this->metrics)
+		{
+			if (pMetric->name == pFamily->name)
+				pMetric->FormatSamples(text);
+		}
+	}
+
+	return text;
+}
+
+std::vector<double> MetricsRegistry::ExponentialBounds(double start, double factor, uint count)
+{
+	std::vector<double> bounds(count);
+
+	for (uint i = 0; i < count; i++)
+		bounds[i] = start * pow(factor, static_cast<double>(i));
+
+	return bounds;
+}
+
+uint MetricsRegistry::GetThreadSlot(void)
+{
+	static std::atomic<uint> nextSlot(0);
+	thread_local uint slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % numThreadSlots;
+
+	return slot;
+}
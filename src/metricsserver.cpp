@@ -0,0 +1,193 @@
+// EXTERNAL INCLUDES
+#include <cstdio>
+#include <cstring>
+#include <string>
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "metrics.h"
+#include "metricsserver.h"
+#include "utils.h"
+
+#if defined(_WIN32)
+typedef SOCKET SocketHandle;
+#define CLOSE_SOCKET closesocket
+#define POLL_SOCKETS WSAPoll
+#define SEND_FLAGS 0
+#else
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define CLOSE_SOCKET close
+#define POLL_SOCKETS poll
+#define SEND_FLAGS MSG_NOSIGNAL	/**< a scraper that hangs up must not kill the process */
+#endif
+
+constexpr int pollTimeout = 100;			/**< how often the listener checks whether it should stop (milliseconds) */
+constexpr size_t maxRequestSize = 4096;		/**< requests are only read up to this size */
+
+MetricsServer::MetricsServer(const MetricsRegistry* pRegistry) :
+	pRegistry(pRegistry),
+	listenSocket(static_cast<uint64>(INVALID_SOCKET)),
+	isRunning(false),
+	numScrapes(0)
+{
+
+}
+
+MetricsServer::~MetricsServer()
+{
+	this->Stop();
+}
+
+bool MetricsServer::Start(uint16 port)
+{
+#if defined(_WIN32)
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+		return false;
+#endif
+
+	SocketHandle listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSocket == INVALID_SOCKET)
+	{
+		ERR("Could not create the metrics socket");
+#if defined(_WIN32)
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	int reuse = 1;
+	setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+	// scraping is only allowed from the same machine
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenSocket, 8) != 0)
+	{
+		ERR("Could not listen for metrics on port %u", port);
+		CLOSE_SOCKET(listenSocket);
+#if defined(_WIN32)
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	LOG("Serving metrics on http://127.0.0.1:%u/metrics", port);
+
+	this->listenSocket = static_cast<uint64>(listenSocket);
+	this->isRunning.store(true, std::memory_order_relaxed);
+	this->thread = std::thread(&MetricsServer::Run, this);
+
+	return true;
+}
+
+void MetricsServer::Stop(void)
+{
+	if (!this->thread.joinable())
+		return;
+
+	this->isRunning.store(false, std::memory_order_relaxed);
+	this->thread.join();
+
+	CLOSE_SOCKET(static_cast<SocketHandle>(this->listenSocket));
+	this->listenSocket = static_cast<uint64>(INVALID_SOCKET);
+
+#if defined(_WIN32)
+	WSACleanup();
+#endif
+}
+
+uint64 MetricsServer::GetNumScrapes(void) const
+{
+	return this->numScrapes.load(std::memory_order_relaxed);
+}
+
+void MetricsServer::Run(void)
+{
+	pollfd listenPoll = {};
+	listenPoll.fd = static_cast<SocketHandle>(this->listenSocket);
+	listenPoll.events = POLLIN;
+
+	while (this->isRunning.load(std::memory_order_relaxed))
+	{
+		// wake up regularly to notice Stop
+		if (POLL_SOCKETS(&listenPoll, 1, pollTimeout) <= 0)
+			continue;
+
+		SocketHandle clientSocket = accept(listenPoll.fd, nullptr, nullptr);
+		if (clientSocket == INVALID_SOCKET)
+			continue;
+
+		this->Serve(static_cast<uint64>(clientSocket));
+		CLOSE_SOCKET(clientSocket);
+	}
+}
+
+void MetricsServer::Serve(uint64 clientSocket)
+{
+	SocketHandle client = static_cast<SocketHandle>(clientSocket);
+
+	// read until the end of the request header
+	std::string request;
+	char buffer[1024];
+	while (request.size() < maxRequestSize && request.find("\r\n\r\n") == std::string::npos)
+	{
+		pollfd clientPoll = {};
+		clientPoll.fd = client;
+		clientPoll.events = POLLIN;
+
+		if (POLL_SOCKETS(&clientPoll, 1, pollTimeout * 10) <= 0)
+			return;
+
+		int numReceived = recv(client, buffer, sizeof(buffer), 0);
+		if (numReceived <= 0)
+			return;
+
+		request.append(buffer, numReceived);
+	}
+
+	std::string body;
+	const char* pStatus;
+
+	if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0)
+	{
+		pStatus = "200 OK";
+		body = this->pRegistry->Format();
+		this->numScrapes.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		pStatus = "404 Not Found";
+		body = "Only /metrics is served\n";
+	}
+
+	char header[256];
+	int headerSize = snprintf(header, sizeof(header),
+		"HTTP/1.1 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+		pStatus, body.size());
+
+	std::string response(header, headerSize);
+	response += body;
+
+	size_t numSent = 0;
+	while (numSent < response.size())
+	{
+		int result = send(client, response.data() + numSent, static_cast<int>(response.size() - numSent), SEND_FLAGS);
+		if (result <= 0)
+			return;
+
+		numSent += result;
+	}
+}
@@ -0,0 +1,453 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#if !defined(_WIN32)
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "npyexport.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "utils.h"
+
+constexpr uint32 crcPolynomial = 0xEDB88320;		/**< the reflected CRC-32 polynomial of zip */
+constexpr uint32 zip64Limit = 0xFFFFFFFF;			/**< sizes and offsets from here on need zip64 */
+constexpr size_t minParallelCrcSize = 1 << 20;		/**< smaller entries are checksummed on the calling thread */
+
+/**
+ * @brief	This struct defines a buffer of a vectored write
+ */
+struct WriteBuffer
+{
+	const void* pData;
+	size_t size;
+};
+
+/**
+ * @brief	This helper writes buffers to a file without copying them
+ * @return	false if the file couldn't be written
+ */
+static bool WriteBuffers(const char* pPath, const std::vector<WriteBuffer>& buffers)
+{
+#if defined(_WIN32)
+	FILE* pFile = fopen(pPath, "wb");
+	if (!pFile)
+	{
+		ERR("Could not create %s", pPath);
+		return false;
+	}
+
+	// the buffers go straight to the file
+	setvbuf(pFile, nullptr, _IONBF, 0);
+
+	bool succeeded = true;
+	for (const WriteBuffer& buffer : buffers)
+		succeeded = succeeded && fwrite(buffer.pData, 1, buffer.size, pFile) == buffer.size;
+
+	succeeded = (fclose(pFile) == 0) && succeeded;
+#else
+	int file = open(pPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (file < 0)
+	{
+		ERR("Could not create %s", pPath);
+		return false;
+	}
+
+	std::vector<iovec> vectors;
+	for (const WriteBuffer& buffer : buffers)
+	{
+		if (buffer.size > 0)
+			vectors.push_back({ const_cast<void*>(buffer.pData), buffer.size });
+	}
+
+	// a call writes at most IOV_MAX buffers and may stop anywhere in them
+	bool succeeded = true;
+	size_t first = 0;
+	while (succeeded && first < vectors.size())
+	{
+		ssize_t numWritten = writev(file, vectors.data() + first, static_cast<int>(std::min<size_t>(vectors.size() - first, IOV_MAX)));
+		succeeded = numWritten > 0;
+
+		for (size_t remaining = (succeeded) ? static_cast<size_t>(numWritten) : 0; remaining > 0;)
+		{
+			iovec& vector = vectors[first];
+			size_t count = std::min(remaining, vector.iov_len);
+			vector.iov_base = static_cast<byte*>(vector.iov_base) + count;
+			vector.iov_len -= count;
+			remaining -= count;
+
+			if (vector.iov_len == 0)
+				first++;
+		}
+	}
+
+	succeeded = (close(file) == 0) && succeeded;
+#endif
+
+	if (!succeeded)
+		ERR("Could not write %s", pPath);
+
+	return succeeded;
+}
+
+/**
+ * @brief	This struct defines the tables of the slicing-by-8 CRC-32
+ */
+struct CrcTables
+{
+	uint32 values[8][256];
+};
+
+/**
+ * @brief	This helper builds the tables of the slicing-by-8 CRC-32
+ */
+static CrcTables BuildCrcTables(void)
+{
+	CrcTables tables;
+
+	for (uint32 i = 0; i < 256; i++)
+	{
+		uint32 crc = i;
+		for (uint bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ crcPolynomial : crc >> 1;
+		tables.values[0][i] = crc;
+	}
+
+	for (uint32 i = 0; i < 256; i++)
+	{
+		for (uint slice = 1; slice < 8; slice++)
+			tables.values[slice][i] = (tables.values[slice - 1][i] >> 8) ^ tables.values[0][tables.values[slice - 1][i] & 0xFF];
+	}
+
+	return tables;
+}
+
+/**
+ * @brief	This helper continues a CRC-32 over a buffer
+ * @param	crc is the CRC-32 of the data before (0 for none)
+ * @return	uint32 is the CRC-32 including the buffer
+ */
+static uint32 UpdateCrc(uint32 crc, const byte* pData, size_t size)
+{
+	static const CrcTables crcTables = BuildCrcTables();
+	const uint32 (&tables)[8][256] = crcTables.values;
+	crc = ~crc;
+
+	// eight bytes per table lookup round
+	for (; size >= 8; size -= 8, pData += 8)
+	{
+		uint32 low, high;
+		memcpy(&low, pData, sizeof(low));
+		memcpy(&high, pData + 4, sizeof(high));
+		low ^= crc;
+
+		crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24]
+			^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+	}
+
+	for (; size > 0; size--, pData++)
+		crc = (crc >> 8) ^ tables[0][(crc ^ *pData) & 0xFF];
+
+	return ~crc;
+}
+
+/**
+ * @brief	This helper multiplies two polynomials modulo the CRC-32 polynomial
+ */
+static uint32 MultiplyModP(uint32 a, uint32 b)
+{
+	uint32 product = 0;
+	for (uint32 mask = 1u << 31; mask != 0; mask >>= 1)
+	{
+		if (a & mask)
+			product ^= b;
+		b = (b & 1) ? (b >> 1) ^ crcPolynomial : b >> 1;
+	}
+	return product;
+}
+
+/**
+ * @brief	This helper combines the CRC-32 of two consecutive buffers
+ * 			The first CRC is shifted over the length of the second buffer
+ * 			by multiplying it with x^(8 * size) (square and multiply).
+ * @return	uint32 is the CRC-32 of both buffers
+ */
+static uint32 CombineCrc(uint32 crc, uint32 nextCrc, size_t nextSize)
+{
+	uint32 power = 1u << 31;	/**< x^0 */
+	uint32 square = 1u << 23;	/**< x^8 */
+
+	for (size_t exponent = nextSize; exponent > 0; exponent >>= 1)
+	{
+		if (exponent & 1)
+			power = MultiplyModP(power, square);
+		square = MultiplyModP(square, square);
+	}
+
+	return MultiplyModP(power, crc) ^ nextCrc;
+}
+
+/**
+ * @brief	This helper calculates the CRC-32 of a buffer with one range per thread
+ */
+static uint32 CalculateCrc(uint32 crc, const byte* pData, size_t size, ThreadPool* pThreadPool)
+{
+	if (!pThreadPool || size < minParallelCrcSize)
+		return UpdateCrc(crc, pData, size);
+
+	const uint numThreads = pThreadPool->GetNumThreads();
+	std::vector<uint32> crcs(numThreads, 0);
+
+	pThreadPool->ParallelFor(size, [&](size_t begin, size_t end, uint threadIndex) {
+		crcs[threadIndex] = UpdateCrc(0, pData + begin, end - begin);
+	});
+
+	// the ranges follow each other in thread order
+	for (uint thread = 0; thread < numThreads; thread++)
+	{
+		size_t begin, end;
+		ThreadPool::GetRange(size, numThreads, thread, begin, end);
+		if (begin < end)
+			crc = CombineCrc(crc, crcs[thread], end - begin);
+	}
+
+	return crc;
+}
+
+/**
+ * @brief	This helper appends little endian values to a zip header
+ */
+template <class T>
+static void Append(std::string& header, T value)
+{
+	for (size_t i = 0; i < sizeof(T); i++)
+		header.push_back(static_cast<char>((static_cast<uint64>(value) >> (8 * i)) & 0xFF));
+}
+
+std::vector<NpyExport::Array> NpyExport::GetParticleArrays(const ParticleSimulation& simulation, std::vector<Math::Vec2>& velocities)
+{
+	static_assert(sizeof(ParticleSimulation::Particle) == 6 * sizeof(float), "the particle dtype has to match ParticleSimulation::Particle");
+
+	const size_t numParticles = simulation.GetNumParticles();
+	std::vector<Array> arrays;
+
+	velocities.resize(numParticles);
+	simulation.CalculateVelocities(velocities.data());
+
+	arrays.push_back({ "particles", "[('position', '<f4', (2,)), ('prevPosition', '<f4', (2,)), ('nextPosition', '<f4', (2,))]", { numParticles },
+		simulation.GetParticles(), sizeof(ParticleSimulation::Particle) * numParticles });
+	arrays.push_back({ "velocities", "'<f4'", { numParticles, 2 }, velocities.data(), sizeof(Math::Vec2) * numParticles });
+	arrays.push_back({ "ids", "'<u4'", { numParticles }, simulation.GetParticleIDs(), sizeof(uint32) * numParticles });
+
+	return arrays;
+}
+
+std::string NpyExport::FormatHeader(const Array& array)
+{
+	std::string shape = "(";
+	for (size_t extent : array.shape)
+		shape += std::to_string(extent) + ",";
+	if (array.shape.size() > 1)
+		shape.pop_back();
+	shape += ")";
+
+	std::string dictionary = "{'descr': " + array.descr + ", 'fortran_order': False, 'shape': " + shape + ", }";
+
+	// magic, version and header length come first, the data starts 64 byte aligned
+	const size_t prefixSize = 10;
+	size_t headerSize = (prefixSize + dictionary.size() + 1 + 63) / 64 * 64;
+	dictionary.append(headerSize - prefixSize - dictionary.size() - 1, ' ');
+	dictionary.push_back('\n');
+
+	std::string header("\x93NUMPY\x01\x00", 8);
+	Append(header, static_cast<uint16>(dictionary.size()));
+
+	return header + dictionary;
+}
+
+bool NpyExport::WriteNpy(const char* pPath, const Array& array)
+{
+	std::string header = FormatHeader(array);
+
+	return WriteBuffers(pPath, { { header.data(), header.size() }, { array.pData, array.size } });
+}
+
+bool NpyExport::WriteNpz(const char* pPath, const std::vector<Array>& arrays, ThreadPool* pThreadPool)
+{
+	std::vector<std::string> localHeaders(arrays.size());
+	std::vector<std::string> npyHeaders(arrays.size());
+	std::vector<WriteBuffer> buffers;
+	std::string centralDirectory;
+	uint64 offset = 0;
+
+	// every entry is a local header, the .npy header and the data, the central directory follows all of them
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		const Array& array = arrays[i];
+		const std::string name = array.name + ".npy";
+		npyHeaders[i] = FormatHeader(array);
+
+		uint32 crc = UpdateCrc(0, reinterpret_cast<const byte*>(npyHeaders[i].data()), npyHeaders[i].size());
+		crc = CalculateCrc(crc, static_cast<const byte*>(array.pData), array.size, pThreadPool);
+
+		const uint64 entrySize = npyHeaders[i].size() + array.size;
+		const bool isLarge = entrySize >= zip64Limit;
+		const bool isFar = offset >= zip64Limit;
+		const uint16 version = (isLarge || isFar) ? 45 : 20;
+
+		// local file header (stored, no data descriptor)
+		std::string& local = localHeaders[i];
+		Append(local, static_cast<uint32>(0x04034B50));
+		Append(local, version);
+		Append(local, static_cast<uint16>(0));					// flags
+		Append(local, static_cast<uint16>(0));					// stored
+		Append(local, static_cast<uint16>(0));					// time
+		Append(local, static_cast<uint16>(0x21));				// date (1980-01-01)
+		Append(local, crc);
+		Append(local, static_cast<uint32>((isLarge) ? zip64Limit : entrySize));
+		Append(local, static_cast<uint32>((isLarge) ? zip64Limit : entrySize));
+		Append(local, static_cast<uint16>(name.size()));
+		Append(local, static_cast<uint16>((isLarge) ? 20 : 0));
+		local += name;
+		if (isLarge)
+		{
+			Append(local, static_cast<uint16>(0x0001));
+			Append(local, static_cast<uint16>(16));
+			Append(local, entrySize);
+			Append(local, entrySize);
+		}
+
+		// central directory header
+		const uint16 extraSize = static_cast<uint16>(((isLarge) ? 16 : 0) + ((isFar) ? 8 : 0));
+		Append(centralDirectory, static_cast<uint32>(0x02014B50));
+		Append(centralDirectory, static_cast<uint16>(45));		// made by
+		Append(centralDirectory, version);
+		Append(centralDirectory, static_cast<uint16>(0));
+		Append(centralDirectory, static_cast<uint16>(0));
+		Append(centralDirectory, static_cast<uint16>(0));
+		Append(centralDirectory, static_cast<uint16>(0x21));
+		Append(centralDirectory, crc);
+		Append(centralDirectory, static_cast<uint32>((isLarge) ? zip64Limit : entrySize));
+		Append(centralDirectory, static_cast<uint32>((isLarge) ? zip64Limit : entrySize));
+		Append(centralDirectory, static_cast<uint16>(name.size()));
+		Append(centralDirectory, static_cast<uint16>((extraSize > 0) ? extraSize + 4 : 0));
+		Append(centralDirectory, static_cast<uint16>(0));		// comment
+		Append(centralDirectory, static_cast<uint16>(0));		// disk
+		Append(centralDirectory, static_cast<uint16>(0));		// internal attributes
+		Append(centralDirectory, static_cast<uint32>(0));		// external attributes
+		Append(centralDirectory, static_cast<uint32>((isFar) ? zip64Limit : offset));
+		centralDirectory += name;
+		if (extraSize > 0)
+		{
+			Append(centralDirectory, static_cast<uint16>(0x0001));
+			Append(centralDirectory, extraSize);
+			if (isLarge)
+			{
+				Append(centralDirectory, entrySize);
+				Append(centralDirectory, entrySize);
+			}
+			if (isFar)
+				Append(centralDirectory, offset);
+		}
+
+		offset += localHeaders[i].size() + entrySize;
+	}
+
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		buffers.push_back({ localHeaders[i].data(), localHeaders[i].size() });
+		buffers.push_back({ npyHeaders[i].data(), npyHeaders[i].size() });
+		buffers.push_back({ arrays[i].pData, arrays[i].size });
+	}
+
+	// the end of the central directory, with the zip64 records in front if anything didn't fit
+	const uint64 directoryOffset = offset;
+	const uint64 directorySize = centralDirectory.size();
+	const uint64 numEntries = arrays.size();
+	const bool needsZip64 = directoryOffset >= zip64Limit || numEntries >= 0xFFFF;
+	std::string end;
+
+	if (needsZip64)
+	{
+		Append(end, static_cast<uint32>(0x06064B50));
+		Append(end, static_cast<uint64>(44));					// size of the rest of the record
+		Append(end, static_cast<uint16>(45));
+		Append(end, static_cast<uint16>(45));
+		Append(end, static_cast<uint32>(0));
+		Append(end, static_cast<uint32>(0));
+		Append(end, numEntries);
+		Append(end, numEntries);
+		Append(end, directorySize);
+		Append(end, directoryOffset);
+
+		Append(end, static_cast<uint32>(0x07064B50));
+		Append(end, static_cast<uint32>(0));
+		Append(end, directoryOffset + directorySize);
+		Append(end, static_cast<uint32>(1));
+	}
+
+	Append(end, static_cast<uint32>(0x06054B50));
+	Append(end, static_cast<uint16>(0));
+	Append(end, static_cast<uint16>(0));
+	Append(end, static_cast<uint16>(std::min<uint64>(numEntries, 0xFFFF)));
+	Append(end, static_cast<uint16>(std::min<uint64>(numEntries, 0xFFFF)));
+	Append(end, static_cast<uint32>(std::min<uint64>(directorySize, zip64Limit)));
+	Append(end, static_cast<uint32>(std::min<uint64>(directoryOffset, zip64Limit)));
+	Append(end, static_cast<uint16>(0));
+
+	buffers.push_back({ centralDirectory.data(), centralDirectory.size() });
+	buffers.push_back({ end.data(), end.size() });
+
+	return WriteBuffers(pPath, buffers);
+}
+
+bool NpyExport::Run(const char* pPath, size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	ParticleSimulation simulation(numParticles, &threadPool);
+	if (!simulation.SetupParticles())
+		return false;
+	simulation.SetTimeBins(4);
+	simulation.SetSleeping(true);
+
+	for (uint step = 0; step < numSteps; step++)
+		simulation.Step(Time::maxTimeStep);
+
+	std::vector<Math::Vec2> velocities;
+	const std::vector<Array> arrays = GetParticleArrays(simulation, velocities);
+	const std::filesystem::path path(pPath);
+	const bool isBundle = path.extension() == ".npz";
+
+	size_t size = 0;
+	for (const Array& array : arrays)
+		size += array.size;
+
+	uint64 startTime = Time::Now();
+	bool succeeded = true;
+
+	if (isBundle)
+		succeeded = WriteNpz(pPath, arrays, &threadPool);
+	else
+	{
+		std::error_code error;
+		std::filesystem::create_directories(path, error);
+
+		for (const Array& array : arrays)
+			succeeded = succeeded && WriteNpy((path / (array.name + ".npy")).string().c_str(), array);
+	}
+
+	double seconds = (Time::Now() - startTime) / 1000000.0;
+	if (succeeded)
+	{
+		printf("Exported %zu particles after %u steps to %s (%.1f MiB in %.3f s, %.2f GB/s)\n",
+			numParticles, numSteps, pPath, size / (1024.0 * 1024.0), seconds, (seconds > 0.0) ? size / seconds / 1e9 : 0.0);
+	}
+
+	return succeeded;
+}
@@ -0,0 +1,26 @@
+// EXTERNAL INCLUDES
+#include <chrono>
+#include <thread>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "nullpresenter.h"
+
+NullPresenter::NullPresenter(float refreshRate) :
+	interval(static_cast<uint64>(1000000.0f / refreshRate)),
+	nextVerticalBlank(0)
+{
+
+}
+
+void NullPresenter::PresentSnapshot(const SimulationSnapshot& /*snapshot*/)
+{
+	uint64 now = Time::Now();
+
+	// a missed vertical blank waits for the next one
+	// just like Present(1, 0) does
+	if (this->nextVerticalBlank <= now)
+		this->nextVerticalBlank = now + this->interval - ((now - this->nextVerticalBlank) % this->interval);
+
+	std::this_thread::sleep_for(std::chrono::microseconds(this->nextVerticalBlank - now));
+	this->nextVerticalBlank += this->interval;
+}
@@ -0,0 +1,90 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "numastudy.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "topology.h"
+#include "utils.h"
+
+constexpr uint numWarmupSteps = 10;	/**< the steps before the measurement, the particles leave their start grid */
+
+/**
+ * @brief	This helper prints the throughput of every node over the measured steps of a budget
+ * @param	busyTimes are the busy times of the threads before the steps
+ * @param	numElements are the processed elements of the threads before the steps
+ */
+static void PrintNodes(const ThreadPool& threadPool, const char* pPoolName, size_t particleBudget, double stepTime,
+	const std::vector<uint64>& busyTimes, const std::vector<uint64>& numElements)
+{
+	for (const Topology::NumaNode& node : Topology::GetNumaNodes())
+	{
+		uint numThreads = 0;
+		uint64 busyTime = 0;
+		uint64 numNodeElements = 0;
+
+		for (uint thread = 0; thread < threadPool.GetNumThreads(); thread++)
+		{
+			if (threadPool.GetThreadNode(thread) != node.index)
+				continue;
+
+			numThreads++;
+			busyTime += threadPool.GetBusyTime(thread) - busyTimes[thread];
+			numNodeElements += threadPool.GetNumProcessedElements(thread) - numElements[thread];
+		}
+
+		if (numThreads > 0)
+			printf("%-9s %10zu %8.2f %5u %8u %14" PRIu64 " %12.1f\n", pPoolName, particleBudget, stepTime, node.index, numThreads, numNodeElements,
+				(busyTime > 0) ? numNodeElements / static_cast<double>(busyTime) : 0.0);
+	}
+}
+
+bool NumaStudy::Run(size_t numParticles, uint numSteps)
+{
+	numParticles = std::max<size_t>(numParticles, 1);
+	numSteps = std::max(numSteps, 1u);
+
+	printf("Particle throughput of %zu particles on %zu NUMA nodes, %u steps per budget\n", numParticles, Topology::GetNumaNodes().size(), numSteps);
+	printf("%-9s %10s %8s %5s %8s %14s %12s\n", "threads", "budget", "step ms", "node", "threads", "elements", "M/s busy");
+
+	for (bool pinThreads : { false, true })
+	{
+		ThreadPool threadPool(0, pinThreads);
+		const char* pPoolName = (pinThreads) ? "pinned" : "unpinned";
+
+		ParticleSimulation simulation(numParticles, &threadPool);
+		if (!simulation.SetupParticles())
+		{
+			ERR("Could not reserve the memory of %zu particles", numParticles);
+			return false;
+		}
+
+		for (uint step = 0; step < numWarmupSteps; step++)
+			simulation.Step(Time::maxTimeStep);
+
+		for (size_t particleBudget : { numParticles, numParticles / 2 })
+		{
+			simulation.SetParticleBudget(particleBudget);
+
+			std::vector<uint64> busyTimes, numElements;
+			for (uint thread = 0; thread < threadPool.GetNumThreads(); thread++)
+			{
+				busyTimes.push_back(threadPool.GetBusyTime(thread));
+				numElements.push_back(threadPool.GetNumProcessedElements(thread));
+			}
+
+			uint64 startTime = Time::Now();
+			for (uint step = 0; step < numSteps; step++)
+				simulation.Step(Time::maxTimeStep);
+			double stepTime = (Time::Now() - startTime) / 1000.0 / numSteps;
+
+			PrintNodes(threadPool, pPoolName, particleBudget, stepTime, busyTimes, numElements);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,277 @@
+// EXTERNAL INCLUDES
+#include <cfloat>
+#include <cmath>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "obstaclefield.h"
+#include "threadpool.h"
+#include "utils.h"
+
+/**
+ * @brief	This helper calculates the exact signed distance to a shape
+ * @param	gradient is the returned direction away from the shape (normalized)
+ * @return	float is the distance (negative inside)
+ */
+static inline float ShapeDistance(const ObstacleField::Shape& shape, const Math::Vec2& position, Math::Vec2& gradient)
+{
+	switch (shape.type)
+	{
+	case ObstacleField::Circle:
+	{
+		Math::Vec2 offset = position - shape.a;
+		float length = sqrtf(offset.x * offset.x + offset.y * offset.y);
+
+		gradient = (length > 0.0f) ? offset / length : Math::Vec2::unit_y;
+		return length - shape.radius;
+	}
+	case ObstacleField::Box:
+	{
+		// the box without its rounding, mirrored into the first quadrant
+		Math::Vec2 offset = position - shape.a;
+		float qx = fabsf(offset.x) - (shape.b.x - shape.radius);
+		float qy = fabsf(offset.y) - (shape.b.y - shape.radius);
+		float outsideX = std::max(qx, 0.0f), outsideY = std::max(qy, 0.0f);
+		float outside = sqrtf(outsideX * outsideX + outsideY * outsideY);
+
+		if (outside > 0.0f)
+			gradient = { copysignf(outsideX / outside, offset.x), copysignf(outsideY / outside, offset.y) };
+		else if (qx > qy)
+			gradient = { copysignf(1.0f, offset.x), 0.0f };
+		else
+			gradient = { 0.0f, copysignf(1.0f, offset.y) };
+
+		return outside + std::min(std::max(qx, qy), 0.0f) - shape.radius;
+	}
+	case ObstacleField::Capsule:
+	{
+		// the closest point of the segment
+		Math::Vec2 segment = shape.b - shape.a;
+		Math::Vec2 offset = position - shape.a;
+		float segmentLength2 = segment.x * segment.x + segment.y * segment.y;
+		float t = (segmentLength2 > 0.0f) ? std::min(std::max((offset.x * segment.x + offset.y * segment.y) / segmentLength2, 0.0f), 1.0f) : 0.0f;
+
+		offset = offset - segment * t;
+		float length = sqrtf(offset.x * offset.x + offset.y * offset.y);
+
+		gradient = (length > 0.0f) ? offset / length : Math::Vec2::unit_y;
+		return length - shape.radius;
+	}
+	}
+
+	gradient = Math::Vec2::zero;
+	return FLT_MAX;
+}
+
+/**
+ * @brief	This helper calculates the bounding box of a shape
+ */
+static void ShapeBounds(const ObstacleField::Shape& shape, Math::Vec2& boundsMin, Math::Vec2& boundsMax)
+{
+	switch (shape.type)
+	{
+	case ObstacleField::Circle:
+		boundsMin = shape.a - shape.radius;
+		boundsMax = shape.a + shape.radius;
+		return;
+	case ObstacleField::Box:
+		boundsMin = shape.a - shape.b;
+		boundsMax = shape.a + shape.b;
+		return;
+	case ObstacleField::Capsule:
+		boundsMin = Math::Vec2{ std::min(shape.a.x, shape.b.x), std::min(shape.a.y, shape.b.y) } - shape.radius;
+		boundsMax = Math::Vec2{ std::max(shape.a.x, shape.b.x), std::max(shape.a.y, shape.b.y) } + shape.radius;
+		return;
+	}
+
+	// ShapeDistance doesn't reach any node from an unknown shape
+	boundsMin = shape.a;
+	boundsMax = shape.a;
+}
+
+ObstacleField::ObstacleField(Math::Vec2 boundsMin, Math::Vec2 boundsMax, float cellSize, float maxDistance) :
+	boundsMin(boundsMin),
+	cellSize(cellSize),
+	invCellSize(1.0f / cellSize),
+	maxDistance(maxDistance),
+	numColumns(std::max(2u, static_cast<uint>(ceilf((boundsMax.x - boundsMin.x) / cellSize)) + 1)),
+	numRows(std::max(2u, static_cast<uint>(ceilf((boundsMax.y - boundsMin.y) / cellSize)) + 1)),
+	maxCoordinate(),
+	bakeTime(0)
+{
+	// a sample at the last node still has a node to its right and above
+	this->maxCoordinate = { nextafterf(static_cast<float>(this->numColumns - 1), 0.0f), nextafterf(static_cast<float>(this->numRows - 1), 0.0f) };
+	this->distances.assign(static_cast<size_t>(this->numColumns) * this->numRows, maxDistance);
+}
+
+void ObstacleField::AddCircle(Math::Vec2 center, float radius)
+{
+	this->shapes.push_back({ Circle, center, Math::Vec2::zero, radius });
+}
+
+void ObstacleField::AddBox(Math::Vec2 center, Math::Vec2 halfExtents, float rounding)
+{
+	this->shapes.push_back({ Box, center, halfExtents, std::min(rounding, std::min(halfExtents.x, halfExtents.y)) });
+}
+
+void ObstacleField::AddCapsule(Math::Vec2 a, Math::Vec2 b, float radius)
+{
+	this->shapes.push_back({ Capsule, a, b, radius });
+}
+
+void ObstacleField::Clear(void)
+{
+	this->shapes.clear();
+}
+
+void ObstacleField::Bake(ThreadPool* pThreadPool)
+{
+	uint64 startTime = Time::Now();
+
+	const Shape* pShapes = this->shapes.data();
+	const size_t numShapes = this->shapes.size();
+	const Math::Vec2 boundsMin = this->boundsMin;
+	const float cellSize = this->cellSize;
+	const float invCellSize = this->invCellSize;
+	const float maxDistance = this->maxDistance;
+	const uint numColumns = this->numColumns;
+	float* pDistances = this->distances.data();
+
+	auto bake = [=](size_t rowBegin, size_t rowEnd, uint) {
+		std::fill(pDistances + rowBegin * numColumns, pDistances + rowEnd * numColumns, maxDistance);
+
+		// every shape only reaches the nodes of its grown bounding box
+		for (size_t i = 0; i < numShapes; i++)
+		{
+			Math::Vec2 shapeMin, shapeMax;
+			ShapeBounds(pShapes[i], shapeMin, shapeMax);
+
+			float firstRow = ceilf((shapeMin.y - maxDistance - boundsMin.y) * invCellSize);
+			float lastRow = floorf((shapeMax.y + maxDistance - boundsMin.y) * invCellSize);
+			float firstColumn = ceilf((shapeMin.x - maxDistance - boundsMin.x) * invCellSize);
+			float lastColumn = floorf((shapeMax.x + maxDistance - boundsMin.x) * invCellSize);
+
+			size_t begin = static_cast<size_t>(std::max(firstRow, static_cast<float>(rowBegin)));
+			size_t end = static_cast<size_t>(std::max(std::min(lastRow + 1.0f, static_cast<float>(rowEnd)), 0.0f));
+			size_t columnBegin = static_cast<size_t>(std::max(firstColumn, 0.0f));
+			size_t columnEnd = static_cast<size_t>(std::max(std::min(lastColumn + 1.0f, static_cast<float>(numColumns)), 0.0f));
+
+			for (size_t row = begin; row < end; row++)
+			{
+				float* pRow = pDistances + row * numColumns;
+				Math::Vec2 position = { 0.0f, boundsMin.y + static_cast<float>(row) * cellSize };
+
+				for (size_t column = columnBegin; column < columnEnd; column++)
+				{
+					Math::Vec2 gradient;
+					position.x = boundsMin.x + static_cast<float>(column) * cellSize;
+					pRow[column] = std::min(pRow[column], ShapeDistance(pShapes[i], position, gradient));
+				}
+			}
+		}
+	};
+
+	if (pThreadPool)
+		pThreadPool->ParallelFor(this->numRows, bake);
+	else
+		bake(0, this->numRows, 0);
+
+	this->bakeTime = Time::Now() - startTime;
+}
+
+float ObstacleField::Evaluate(const Math::Vec2& position, Math::Vec2& gradient) const
+{
+	float distance = FLT_MAX;
+	gradient = Math::Vec2::zero;
+
+	for (const Shape& shape : this->shapes)
+	{
+		Math::Vec2 shapeGradient;
+		float shapeDistance = ShapeDistance(shape, position, shapeGradient);
+
+		if (shapeDistance < distance)
+		{
+			distance = shapeDistance;
+			gradient = shapeGradient;
+		}
+	}
+
+	return distance;
+}
+
+size_t ObstacleField::Collide(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float radius, float restitution) const
+{
+	return this->CollideRange<true>(pParticles, pVelocities, begin, end, radius, restitution);
+}
+
+size_t ObstacleField::CollideAnalytic(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float radius, float restitution) const
+{
+	return this->CollideRange<false>(pParticles, pVelocities, begin, end, radius, restitution);
+}
+
+size_t ObstacleField::GetNumShapes(void) const
+{
+	return this->shapes.size();
+}
+size_t ObstacleField::GetNumNodes(void) const
+{
+	return this->distances.size();
+}
+float ObstacleField::GetCellSize(void) const
+{
+	return this->cellSize;
+}
+float ObstacleField::GetMaxDistance(void) const
+{
+	return this->maxDistance;
+}
+uint64 ObstacleField::GetBakeTime(void) const
+{
+	return this->bakeTime;
+}
+
+template <bool isBaked>
+size_t ObstacleField::CollideRange(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float radius, float restitution) const
+{
+	const float bounce = 1.0f + restitution;
+	size_t numCollisions = 0;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		Particle& particle = pParticles[i];
+		Math::Vec2 gradient;
+		float distance = (isBaked) ? this->Sample(particle.nextPosition, gradient) : this->Evaluate(particle.nextPosition, gradient);
+
+		if (distance >= radius)
+			continue;
+
+		// the gradient vanishes where the field is flat (e.g. between two equally close nodes)
+		float gradientLength2 = gradient.x * gradient.x + gradient.y * gradient.y;
+		if (gradientLength2 < 1e-12f)
+			continue;
+
+		Math::Vec2 normal = gradient / sqrtf(gradientLength2);
+		Math::Vec2 displacement = particle.nextPosition - particle.position;
+		particle.nextPosition += normal * (radius - distance);
+
+		// only a velocity towards the obstacle bounces off it
+		if (pVelocities)
+		{
+			float normalVelocity = pVelocities[i].x * normal.x + pVelocities[i].y * normal.y;
+			if (normalVelocity < 0.0f)
+				pVelocities[i] -= normal * (normalVelocity * bounce);
+		}
+		else
+		{
+			float normalDisplacement = displacement.x * normal.x + displacement.y * normal.y;
+			if (normalDisplacement < 0.0f)
+				displacement -= normal * (normalDisplacement * bounce);
+
+			// the push itself isn't a velocity
+			particle.position = particle.nextPosition - displacement;
+		}
+
+		numCollisions++;
+	}
+
+	return numCollisions;
+}
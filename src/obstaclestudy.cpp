@@ -0,0 +1,224 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "obstaclefield.h"
+#include "obstaclestudy.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "utils.h"
+
+typedef ObstacleField::Particle Particle;
+
+constexpr uint numRounds = 3;					/**< a measurement is repeated this many times, the fastest run counts */
+constexpr float particleRadius = 0.002f;		/**< the radius of a particle */
+constexpr float restitution = 0.5f;				/**< the fraction of the normal velocity a particle bounces off with */
+constexpr uint64 maxAnalyticEvaluations = 200000000;	/**< the analytic collisions are measured on as many particles as this many shape evaluations allow */
+
+/**
+ * @brief	This helper scatters shapes over the unit square around the origin
+ * 			The shapes shrink with their number, so they cover about the same area.
+ */
+static void AddRandomShapes(ObstacleField& obstacles, uint numShapes, std::mt19937& generator)
+{
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> unit(0.5f, 1.0f);
+	const float size = 0.25f / sqrtf(static_cast<float>(numShapes));
+
+	for (uint i = 0; i < numShapes; i++)
+	{
+		Math::Vec2 center = { coordinate(generator), coordinate(generator) };
+
+		switch (i % 3)
+		{
+		case 0:
+			obstacles.AddCircle(center, size * unit(generator));
+			break;
+		case 1:
+			obstacles.AddBox(center, { size * unit(generator), size * unit(generator) }, 0.25f * size);
+			break;
+		case 2:
+			obstacles.AddCapsule(center, center + Math::Vec2{ size * coordinate(generator), size * coordinate(generator) } * 2.0f, 0.5f * size * unit(generator));
+			break;
+		}
+	}
+}
+
+/**
+ * @brief	This helper scatters particles over the unit square, every one moves by a small random displacement
+ */
+static void ScatterParticles(std::vector<Particle>& particles, std::mt19937& generator)
+{
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> displacement(-0.005f, 0.005f);
+
+	for (Particle& particle : particles)
+	{
+		particle.nextPosition = { coordinate(generator), coordinate(generator) };
+		particle.position = particle.nextPosition - Math::Vec2{ displacement(generator), displacement(generator) };
+		particle.prevPosition = Math::Vec2::zero;
+	}
+}
+
+/**
+ * @brief	This helper sorts particles by the grid cell they are in, row by row
+ * 			Neighbouring particles then sample neighbouring nodes, like the coherent particles of a simulation.
+ */
+static void SortByCell(std::vector<Particle>& particles, Math::Vec2 boundsMin, float cellSize)
+{
+	auto cell = [=](const Particle& particle) {
+		uint64 row = static_cast<uint64>((particle.nextPosition.y - boundsMin.y) / cellSize);
+		uint64 column = static_cast<uint64>((particle.nextPosition.x - boundsMin.x) / cellSize);
+		return (row << 32) | column;
+	};
+
+	std::sort(particles.begin(), particles.end(), [&](const Particle& lhs, const Particle& rhs) { return cell(lhs) < cell(rhs); });
+}
+
+/**
+ * @brief	This helper collides particles with the obstacles on the pool
+ * @return	double is the time per particle in nanoseconds
+ */
+static double MeasureCollide(ThreadPool& threadPool, const ObstacleField& obstacles, const std::vector<Particle>& start, std::vector<Particle>& particles, size_t numParticles, bool isBaked, uint64& numCollisions)
+{
+	double bestTime = 0.0;
+
+	for (uint round = 0; round < numRounds; round++)
+	{
+		std::copy(start.begin(), start.begin() + numParticles, particles.begin());
+		std::vector<size_t> collisions(threadPool.GetNumThreads(), 0);
+		Particle* pParticles = particles.data();
+
+		uint64 startTime = Time::Now();
+		threadPool.ParallelFor(numParticles, [&](size_t begin, size_t end, uint threadIndex) {
+			collisions[threadIndex] += (isBaked) ? obstacles.Collide(pParticles, nullptr, begin, end, particleRadius, restitution)
+				: obstacles.CollideAnalytic(pParticles, nullptr, begin, end, particleRadius, restitution);
+		});
+		double time = (Time::Now() - startTime) * 1000.0 / static_cast<double>(numParticles);
+		bestTime = (round == 0) ? time : std::min(bestTime, time);
+
+		numCollisions = 0;
+		for (size_t count : collisions)
+			numCollisions += count;
+	}
+
+	return bestTime;
+}
+
+/**
+ * @brief	This helper steps the simulation with or without obstacles
+ * @param	numInside is the returned number of particles whose center ended up inside an obstacle
+ * @return	double is the time per particle and step in nanoseconds
+ */
+static double StepSimulation(ThreadPool& threadPool, const ObstacleField& obstacles, size_t numParticles, uint numSteps, bool collide, size_t& numInside, uint64& numCollisions)
+{
+	ParticleSimulation simulation(numParticles, &threadPool);
+	if (!simulation.SetupParticles())
+		return NAN;
+	if (collide)
+		simulation.SetObstacles(&obstacles, particleRadius, restitution);
+
+	uint64 startTime = Time::Now();
+	for (uint step = 0; step < numSteps; step++)
+		simulation.Step(Time::maxTimeStep);
+	double time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+
+	const Particle* pParticles = simulation.GetParticles();
+	numInside = threadPool.ParallelReduce(numParticles, size_t(0), [&](size_t begin, size_t end) {
+		size_t count = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			Math::Vec2 gradient;
+			count += (obstacles.Evaluate(pParticles[i].nextPosition, gradient) < 0.0f) ? 1 : 0;
+		}
+		return count;
+	}, [](size_t lhs, size_t rhs) { return lhs + rhs; });
+	numCollisions = simulation.GetNumCollisions();
+
+	return time;
+}
+
+bool ObstacleStudy::Run(size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	numSteps = std::max(numSteps, 1u);
+	bool succeeded = true;
+
+	// the grid covers the square the shapes and particles are in
+	const float cellSize = 1.0f / 512.0f;
+	const float maxDistance = 4.0f * cellSize;
+	const Math::Vec2 boundsMin = { -1.25f, -1.25f }, boundsMax = { 1.25f, 1.25f };
+
+	std::mt19937 generator(42);
+	std::vector<Particle> start(numParticles), particles(numParticles);
+	ScatterParticles(start, generator);
+	std::vector<Particle> sorted = start;
+	SortByCell(sorted, boundsMin, cellSize);
+
+	printf("Collisions of %zu particles (radius %.3f), %u threads, %u x %u nodes\n", numParticles, particleRadius, threadPool.GetNumThreads(),
+		static_cast<uint>((boundsMax.x - boundsMin.x) / cellSize) + 1, static_cast<uint>((boundsMax.y - boundsMin.y) / cellSize) + 1);
+	printf("%7s %8s %12s %14s %11s %9s %15s %10s\n", "shapes", "bake ms", "analytic ns", "scattered ns", "sorted ns", "speedup", "collisions", "max error");
+
+	const uint shapeCounts[] = { 1, 16, 256, 4096 };
+	for (uint numShapes : shapeCounts)
+	{
+		ObstacleField obstacles(boundsMin, boundsMax, cellSize, maxDistance);
+		AddRandomShapes(obstacles, numShapes, generator);
+		obstacles.Bake(&threadPool);
+
+		// the analytic test evaluates every shape, it only gets a part of the particles
+		const size_t numAnalyticParticles = static_cast<size_t>(std::min<uint64>(numParticles, std::max<uint64>(maxAnalyticEvaluations / numShapes, 1000)));
+		uint64 numBakedCollisions = 0, numSortedCollisions = 0, numAnalyticCollisions = 0;
+		double bakedTime = MeasureCollide(threadPool, obstacles, start, particles, numParticles, true, numBakedCollisions);
+		double sortedTime = MeasureCollide(threadPool, obstacles, sorted, particles, numParticles, true, numSortedCollisions);
+		double analyticTime = MeasureCollide(threadPool, obstacles, start, particles, numAnalyticParticles, false, numAnalyticCollisions);
+
+		// the baked distance next to the exact one, within the band that is baked
+		float maxError = threadPool.ParallelReduce(numAnalyticParticles, 0.0f, [&](size_t begin, size_t end) {
+			float error = 0.0f;
+			for (size_t i = begin; i < end; i++)
+			{
+				Math::Vec2 gradient;
+				float exact = obstacles.Evaluate(start[i].nextPosition, gradient);
+				if (fabsf(exact) < maxDistance - cellSize)
+					error = std::max(error, fabsf(obstacles.Sample(start[i].nextPosition, gradient) - exact));
+			}
+			return error;
+		}, [](float lhs, float rhs) { return std::max(lhs, rhs); });
+
+		if (maxError > cellSize)
+		{
+			ERR("The baked distances of %u shapes deviate by %f from the shapes", numShapes, maxError);
+			succeeded = false;
+		}
+
+		// the share of the particles that collided, baked and analytic
+		printf("%7u %8.1f %12.3f %14.3f %11.3f %8.1fx %6.2f%%/%6.2f%% %10.2e\n", numShapes, obstacles.GetBakeTime() / 1000.0, analyticTime, bakedTime, sortedTime,
+			analyticTime / bakedTime, 100.0 * numBakedCollisions / numParticles, 100.0 * numAnalyticCollisions / numAnalyticParticles, maxError);
+	}
+
+	// the simulation falls onto a disc around its attractor, a floor and some bars
+	ObstacleField obstacles(boundsMin, boundsMax, cellSize, maxDistance);
+	obstacles.AddCircle(Math::Vec2::zero, 0.1f);
+	obstacles.AddBox({ 0.0f, -0.6f }, { 0.8f, 0.05f }, 0.02f);
+	obstacles.AddCapsule({ -0.6f, 0.3f }, { -0.2f, 0.5f }, 0.02f);
+	obstacles.AddCapsule({ 0.2f, 0.5f }, { 0.6f, 0.3f }, 0.02f);
+	obstacles.Bake(&threadPool);
+
+	size_t freeInside = 0, collidingInside = 0;
+	uint64 freeCollisions = 0, numCollisions = 0;
+	double freeTime = StepSimulation(threadPool, obstacles, numParticles, numSteps, false, freeInside, freeCollisions);
+	double collidingTime = StepSimulation(threadPool, obstacles, numParticles, numSteps, true, collidingInside, numCollisions);
+
+	printf("%u steps of the simulation %13s %16s %14s\n", numSteps, "ns/particle", "inside obstacles", "collisions");
+	printf("%-36s %12.3f %16zu %14s\n", "without obstacles", freeTime, freeInside, "-");
+	printf("%-36s %12.3f %16zu %14" PRIu64 "\n", "with the baked obstacles", collidingTime, collidingInside, numCollisions);
+
+	return succeeded;
+}
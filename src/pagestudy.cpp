@@ -0,0 +1,67 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cstdio>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "memoryarena.h"
+#include "pagestudy.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "utils.h"
+
+constexpr uint numWarmupSteps = 10;	/**< the steps before the measurement, the particles leave their start grid */
+
+bool PageStudy::Run(size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	numSteps = std::max(numSteps, 1u);
+	uint numReserved = 0;
+
+	const MemoryArena::PageSize pageSizes[] = { MemoryArena::SmallPages, MemoryArena::TransparentHugePages, MemoryArena::ExplicitHugePages };
+	const char* pageSizeNames[] = { "small pages", "transparent huge pages", "explicit huge pages" };
+
+	printf("Particle memory of %zu particles, %u steps with block timesteps, %u threads\n", numParticles, numSteps, threadPool.GetNumThreads());
+	printf("%-24s %-24s %9s %9s %12s %15s %14s\n", "requested", "granted", "MiB", "huge %", "reserve ms", "first touch ms", "ns/particle");
+
+	for (MemoryArena::PageSize pageSize : pageSizes)
+	{
+		ParticleSimulation simulation(numParticles, &threadPool);
+		if (!simulation.SetupParticles(pageSize))
+		{
+			printf("%-24s %-24s\n", pageSizeNames[pageSize], "-");
+			continue;
+		}
+		simulation.SetTimeBins(4);
+		numReserved++;
+
+		for (uint step = 0; step < numWarmupSteps; step++)
+			simulation.Step(Time::maxTimeStep);
+
+		uint64 numUpdates = simulation.GetNumParticleUpdates();
+		uint64 startTime = Time::Now();
+		for (uint step = 0; step < numSteps; step++)
+			simulation.Step(Time::maxTimeStep);
+		double time = static_cast<double>(Time::Now() - startTime);
+		numUpdates = simulation.GetNumParticleUpdates() - numUpdates;
+
+		// what the kernel actually backs the touched arena with, the granted page size is only the request after its fallbacks
+		const MemoryArena* pArena = simulation.GetMemoryArena();
+		size_t residentSize, hugePageSize;
+		char hugePageShare[16] = "-";
+		if (pArena->GetResidentSize(residentSize, hugePageSize) && residentSize > 0)
+			snprintf(hugePageShare, sizeof(hugePageShare), "%.1f", 100.0 * hugePageSize / residentSize);
+
+		printf("%-24s %-24s %9.1f %9s %12.3f %15.3f %14.2f\n", pageSizeNames[pageSize], pageSizeNames[pArena->GetPageSize()],
+			pArena->GetUsedSize() / (1024.0 * 1024.0), hugePageShare, pArena->GetReserveTime() / 1000.0, simulation.GetFirstTouchTime() / 1000.0,
+			(numUpdates > 0) ? 1000.0 * time / numUpdates : 0.0);
+	}
+
+	if (numReserved == 0)
+	{
+		ERR("No page size could reserve the memory of %zu particles", numParticles);
+		return false;
+	}
+
+	return true;
+}
@@ -1,8 +1,9 @@
 // EXTERNAL INCLUDES
 #include <cmath>
 // INTERNAL INCLUDES
-#include "inputevent.h"
+#include "computedispatch.h"
 #include "particlerenderer.h"
+#include "shadercache.h"
 #include "utils.h"
 
 #define THREAD_NUM_X 64
@@ -12,34 +13,6 @@ ID3D11UnorderedAccessView* gNullUAV = nullptr;
 ID3D11Buffer* gNullBuffer = nullptr;
 uint32 gNullUINT = 0;
 
-ParticleRenderer::SimulationConstants simulationData = { 0 };
-
-// Input Callbacks
-MouseClickedScreenSpaceCallback OnMouseClickedScreenSpace = [](Math::Vec2 position)
-{
-	simulationData.gravitySource = position;
-};
-UpArrowPressedCallback OnUpArrowPressed = []()
-{
-	simulationData.gravityStrength += 0.1f;
-	LOG("Gravity strength: %f", simulationData.gravityStrength);
-};
-DownArrowPressedCallback OnDownArrowPressed = []()
-{
-	simulationData.gravityStrength -= 0.1f;
-	LOG("Gravity strength: %f", simulationData.gravityStrength);
-};
-RightArrowPressedCallback OnRightArrowPressed = []()
-{
-	simulationData.damping += 0.001f;
-	LOG("Damping strength: %f", 1.0f - simulationData.damping);
-};
-LeftArrowPressedCallback OnLeftArrowPressed = []()
-{
-	simulationData.damping -= 0.001f;
-	LOG("Damping strength: %f", 1.0f - simulationData.damping);
-};
-
 ParticleRenderer::ParticleRenderer() :
 	pParticleVS(nullptr),
 	pParticlePS(nullptr),
@@ -50,12 +23,11 @@ ParticleRenderer::ParticleRenderer() :
 	pCurrentSimulationState(nullptr),
 	pCurrentSimulationStateSRV(nullptr),
 	pCurrentSimulationStateUAV(nullptr),
-	pCurrentSimulationData(nullptr),
 	pNextSimulationState(nullptr),
 	pNextSimulationStateSRV(nullptr),
 	pNextSimulationStateUAV(nullptr),
-	pNextSimulationData(nullptr),
-	numMaxParticles(50000)
+	numMaxParticles(0),
+	uploadedStep(~0ull)
 {
 
 }
@@ -63,9 +35,6 @@ ParticleRenderer::ParticleRenderer() :
 ParticleRenderer::~ParticleRenderer()
 {
 	// Clean everything up
-	SAFE_DELETE(this->pCurrentSimulationData);
-	SAFE_DELETE(this->pNextSimulationData);
-
 	SAFE_RELEASE(this->pParticlePS);
 	SAFE_RELEASE(this->pParticleVS);
 	SAFE_RELEASE(this->pParticleSimulationCS);
@@ -83,31 +52,11 @@ ParticleRenderer::~ParticleRenderer()
 	SAFE_RELEASE(this->pNextSimulationStateUAV);
 }
 
-HRESULT ParticleRenderer::SetupParticles()
+HRESULT ParticleRenderer::SetupParticles(const ParticleSimulation& simulation)
 {
 	HRESULT hr = S_OK;
 
-	// Make space for the particles on heap
-	this->pCurrentSimulationData = new Particle[this->numMaxParticles];
-	// this->pNextSimulationData = new Particle[this->numMaxParticles];
-
-	// Set the memory to 0
-	ZeroMemory(this->pCurrentSimulationData, sizeof(Particle) * this->numMaxParticles);
-	// ZeroMemory(this->pNextSimulationData, sizeof(Particle) * this->numMaxParticles);
-
-	float row = 0;
-	// Iterate over all particles and set their positions
-	for (size_t i = 0; i < numMaxParticles; i++)
-	{
-		float column = float(i % 1000);
-
-		this->pCurrentSimulationData[i].position = { (column * 0.0009f) - 0.5f, (row * 0.0009f) - 0.5f };
-		this->pCurrentSimulationData[i].prevPosition = this->pCurrentSimulationData[i].position;
-		this->pCurrentSimulationData[i].nextPosition = this->pCurrentSimulationData[i].position;
-
-		if (i % 50 == 49)
-			row++;
-	}
+	this->numMaxParticles = simulation.GetNumParticles();
 
 	// Compile the shaders
 	V_RETURN(this->CompileShaders());
@@ -118,7 +67,7 @@ HRESULT ParticleRenderer::SetupParticles()
 		&this->pCurrentSimulationState,
 		&this->pCurrentSimulationStateSRV,
 		&this->pCurrentSimulationStateUAV,
-		this->pCurrentSimulationData)
+		simulation.GetParticles())
 	);
 	/*V_RETURN(this->GenerateAppendStructuredBuffer<Particle>(
 		static_cast<uint>(this->numMaxParticles),
@@ -132,27 +81,15 @@ HRESULT ParticleRenderer::SetupParticles()
 	UINT bufferInit[4] = { (uint)this->numMaxParticles, 1, 0, 0 };
 	V_RETURN(this->GenerateIndirectDrawIndirectBuffer<uint>(&pIndirectDrawBuffer, bufferInit));
 
-	// Update simulation constants
-	simulationData.numParticles = static_cast<uint>(this->numMaxParticles / THREAD_NUM_X);
-	simulationData.lastTimestep = 1.0f;
-	simulationData.timestep = 1.0f;
-	simulationData.gravitySource = Math::Vec2{ 0.0f, 0.0f };
-	simulationData.gravityStrength = 9.81f;
-	simulationData.damping = 0.9948f;
-
 	return hr;
 }
 
-void ParticleRenderer::UpdateParticles(float deltaTime)
+void ParticleRenderer::UpdateParticles(const SimulationConstants& constants)
 {
 	UINT UAVInitialCounts = 0;
 
 	// Update simulation constants
-	simulationData.lastTimestep = simulationData.timestep;
-	/* simulationData.gravitySource = Math::Vec2{ (sin(accumulatedTime) * 0.1f), (cos(accumulatedTime) * 0.1f) }; */
-	simulationData.timestep = deltaTime;
-
-	this->pContext->UpdateSubresource(this->pSimulationBuffer, 0, NULL, &simulationData, 0, 0);
+	this->pContext->UpdateSubresource(this->pSimulationBuffer, 0, NULL, &constants, 0, 0);
 
 	// Setup of the compute shader
 	this->pContext->CSSetShader(this->pParticleSimulationCS, NULL, 0);
@@ -161,8 +98,8 @@ void ParticleRenderer::UpdateParticles(float deltaTime)
 	this->pContext->CSSetUnorderedAccessViews(0, 1, &this->pCurrentSimulationStateUAV, &UAVInitialCounts);
 	// this->context->CSSetUnorderedAccessViews(0, 1, &this->pNextSimulationStateUAV, &UAVInitialCounts);
 
-	// dispatch the compute command
-	this->pContext->Dispatch(static_cast<uint>(this->numMaxParticles), 1, 1);
+	// dispatch one thread per particle (the groups have THREAD_NUM_X threads)
+	this->pContext->Dispatch(Compute::NumGroups(this->numMaxParticles, THREAD_NUM_X), 1, 1);
 	// this->context->Dispatch(1, 1, 1);
 
 	// Unset the views
@@ -190,6 +127,24 @@ void ParticleRenderer::RenderParticles(float deltaTime)
 	this->pContext->PSSetShader(nullptr, NULL, 0);
 }
 
+void ParticleRenderer::PresentSnapshot(const SimulationSnapshot& snapshot)
+{
+	// clear the frame
+	this->ClearFrame();
+
+	// upload the particles (nothing was published before the first step, the same state is only uploaded once)
+	if (snapshot.particles.size() == this->numMaxParticles && snapshot.step != this->uploadedStep)
+	{
+		this->pContext->UpdateSubresource(this->pCurrentSimulationState, 0, NULL, snapshot.particles.data(), 0, 0);
+		this->uploadedStep = snapshot.step;
+	}
+
+	// render the particles
+	this->RenderParticles(0.0f);
+	// show them on screen
+	this->PresentFrame();
+}
+
 HRESULT ParticleRenderer::CompileShaders()
 {
 	HRESULT hr = S_OK;
@@ -212,5 +167,9 @@ HRESULT ParticleRenderer::CompileShaders()
 	V_RETURN(this->device->CreateComputeShader(pBlob->GetBufferPointer(), pBlob->GetBufferSize(), NULL, &this->pParticleCreation));
 	SAFE_RELEASE(pBlob);*/
 
+	// a warm start reads every shader from the cache
+	LOG("Loaded shaders in %.3f ms (%u cached, %u compiled)", this->pShaderCache->GetLoadTime() / 1000.0,
+		this->pShaderCache->GetNumHits(), this->pShaderCache->GetNumMisses());
+
 	return hr;
 }
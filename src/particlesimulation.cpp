@@ -0,0 +1,1387 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "integrators.h"
+#include "obstaclefield.h"
+#include "particlesimulation.h"
+#include "segmentbvh.h"
+#include "threadpool.h"
+#include "utils.h"
+
+// the diagnostics reduce four particles at a time where SSE2 is available
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DIAGNOSTICS_SSE2
+#endif
+
+/**
+ * @brief	This helper processes the leading particles on a thread pool
+ * 			or on the calling thread if there is no pool
+ * 			The parts of the threads are split over all particles on pinned pools
+ * 			(see ThreadPool::ParallelFor), so every thread keeps the particles it placed.
+ */
+template <class Fn>
+static void ForEachRange(ThreadPool* pThreadPool, size_t count, size_t numMaxParticles, Fn fn)
+{
+	if (pThreadPool)
+		pThreadPool->ParallelFor(count, numMaxParticles, fn);
+	else
+		fn(0, count, 0);
+}
+
+/**
+ * @brief	This helper calculates the squared largest timestep a particle allows
+ * 			No particle may cover more than a fraction of its distance to the
+ * 			gravity source, neither by its velocity nor by falling from rest.
+ * @return	float is the squared timestep (FLT_MAX if the particle allows any timestep)
+ */
+static inline float ParticleTimestep2(const ParticleSimulation::Particle& particle, const Math::Vec2& gravitySource, float gravityStrength, float invLastTimestep2, float accuracy, float softening)
+{
+	float timestep2 = FLT_MAX;
+
+	float distance = Math::Distance(gravitySource, particle.nextPosition) + softening;
+	float speed2 = Math::SquareDistance(particle.nextPosition, particle.position) * invLastTimestep2;
+
+	// falling from rest covers 0.5 * g * dt^2
+	if (gravityStrength > 0.0f)
+		timestep2 = std::min(timestep2, (2.0f * accuracy * distance) / gravityStrength);
+	// moving covers v * dt
+	if (speed2 > 0.0f)
+		timestep2 = std::min(timestep2, (accuracy * accuracy * distance * distance) / speed2);
+
+	return timestep2;
+}
+
+/**
+ * @brief	This helper expresses the last displacement of a particle in another timestep
+ * 			The velocity at the current position is d / h + a * h / 2 (d being the last
+ * 			displacement), the former position is moved so that the new timestep
+ * 			continues with the same velocity. It is only as exact as a float (the
+ * 			compensated position Verlet keeps the stale error of the former position).
+ */
+static inline void RescaleLastDisplacement(ParticleSimulation::Particle& particle, const Math::Vec2& acceleration, float lastTimestep, float timestep)
+{
+	Math::Vec2 displacement = particle.nextPosition - particle.position;
+	displacement = displacement * (timestep / lastTimestep) + acceleration * (timestep * (lastTimestep - timestep) * 0.5f);
+	particle.position = particle.nextPosition - displacement;
+}
+
+/**
+ * @brief	This helper builds the constants of an integration step
+ * 			The damping is defined per Time::maxTimeStep and scaled to the timestep.
+ */
+static Integrators::StepConstants MakeStepConstants(const ParticleSimulation::SimulationConstants& constants, float lastTimestep, float timestep)
+{
+	Integrators::StepConstants stepConstants;
+	stepConstants.gravitySource = constants.gravitySource;
+	stepConstants.gravityStrength = constants.gravityStrength;
+	stepConstants.lastTimestep = lastTimestep;
+	stepConstants.timestep = timestep;
+	stepConstants.damping = powf(constants.damping, timestep / Time::maxTimeStep);
+
+	return stepConstants;
+}
+
+constexpr size_t diagnosticsBlockSize = 1024;	/**< particles that are integrated before they are diagnosed (they stay in the L1 cache) */
+constexpr size_t diagnosticsSumSize = 256;		/**< particles that are summed up in single precision before the sum goes into a double */
+constexpr uint diagnosticsLanes = 4;			/**< particles that are diagnosed side by side (the floats of an SSE register) */
+
+/**
+ * @brief	This struct defines the diagnostics of a part of the particles
+ * 			Every thread accumulates into its own cache lines.
+ */
+struct alignas(64) DiagnosticsPartial
+{
+	double kineticEnergy;
+	double potentialEnergy;
+	double sumX;
+	double sumY;
+	Math::Vec2 boundsMin;
+	Math::Vec2 boundsMax;
+	float maxSpeed;
+	uint64 speedHistogram[ParticleSimulation::Diagnostics::numSpeedBins];
+	uint64 numParticles;
+};
+
+/**
+ * @brief	This struct defines what the diagnostics of a step need to know
+ */
+struct DiagnosticsConstants
+{
+	Math::Vec2 gravitySource;
+	float gravityStrength;
+	float timestep;				/**< the timestep the particles were integrated with last */
+	bool hasVelocities;			/**< the integrator keeps the velocities, otherwise they are derived from the positions */
+	float invSpeedBinWidth;
+};
+
+/**
+ * @brief	This helper builds the constants of the diagnostics of a step
+ */
+static DiagnosticsConstants MakeDiagnosticsConstants(const ParticleSimulation::SimulationConstants& constants, float timestep, bool hasVelocities, float maxHistogramSpeed)
+{
+	DiagnosticsConstants diagnosticsConstants;
+	diagnosticsConstants.gravitySource = constants.gravitySource;
+	diagnosticsConstants.gravityStrength = constants.gravityStrength;
+	diagnosticsConstants.timestep = timestep;
+	diagnosticsConstants.hasVelocities = hasVelocities;
+	diagnosticsConstants.invSpeedBinWidth = ParticleSimulation::Diagnostics::numSpeedBins / maxHistogramSpeed;
+
+	return diagnosticsConstants;
+}
+
+/**
+ * @brief	This helper creates diagnostics of no particles
+ */
+static DiagnosticsPartial EmptyDiagnostics(void)
+{
+	DiagnosticsPartial partial = {};
+	partial.boundsMin = { FLT_MAX, FLT_MAX };
+	partial.boundsMax = { -FLT_MAX, -FLT_MAX };
+
+	return partial;
+}
+
+/**
+ * @brief	This helper adds a range of particles to the diagnostics of a thread
+ * 			The particles are diagnosed four at a time with SSE2, every lane keeps
+ * 			its own sums, bounds and histogram, the rest of the range is diagnosed
+ * 			one by one. The lanes sum short runs in single precision and then add
+ * 			them to the double sums. The maximum speed is found by its square, so
+ * 			the lanes take roots only of their distances to the gravity source and
+ * 			of their speeds for the bins (one instruction for four particles).
+ * @tparam	hasVelocities reads the kept velocities, otherwise they are derived from the positions
+ */
+template <bool hasVelocities>
+static void AccumulateDiagnosticsRange(DiagnosticsPartial& partial, const ParticleSimulation::Particle* pParticles, const Math::Vec2* pVelocities, size_t begin, size_t end, const DiagnosticsConstants& constants)
+{
+	constexpr uint numSpeedBins = ParticleSimulation::Diagnostics::numSpeedBins;
+	const Math::Vec2 gravitySource = constants.gravitySource;
+	const float gravityStrength = constants.gravityStrength;
+	const float invTimestep = 1.0f / constants.timestep;
+	const float halfStepPull = constants.gravityStrength * constants.timestep * 0.5f;
+	const float invSpeedBinWidth2 = constants.invSpeedBinWidth * constants.invSpeedBinWidth;
+
+	Math::Vec2 boundsMin = partial.boundsMin;
+	Math::Vec2 boundsMax = partial.boundsMax;
+	float maxSpeed2 = 0.0f;
+	uint32 laneHistograms[diagnosticsLanes][numSpeedBins] = {};
+	size_t i = begin;
+
+#if defined(DIAGNOSTICS_SSE2)
+	const __m128 gravitySourceX = _mm_set1_ps(gravitySource.x);
+	const __m128 gravitySourceY = _mm_set1_ps(gravitySource.y);
+	const __m128 gravityStrengths = _mm_set1_ps(gravityStrength);
+	const __m128 invTimesteps = _mm_set1_ps(invTimestep);
+	const __m128 halfStepPulls = _mm_set1_ps(halfStepPull);
+	const __m128 minDistances = _mm_set1_ps(0.001f);
+	const __m128 halves = _mm_set1_ps(0.5f);
+	const __m128 invSpeedBinWidths2 = _mm_set1_ps(invSpeedBinWidth2);
+	const __m128 lastSpeedBins = _mm_set1_ps(static_cast<float>(numSpeedBins - 1));
+
+	__m128 minX = _mm_set1_ps(boundsMin.x), minY = _mm_set1_ps(boundsMin.y);
+	__m128 maxX = _mm_set1_ps(boundsMax.x), maxY = _mm_set1_ps(boundsMax.y);
+	__m128 maxSpeeds2 = _mm_setzero_ps();
+
+	// the vectors of four particles are loaded in pairs and split into their x and y
+	auto loadLanes = [](const Math::Vec2& a, const Math::Vec2& b, const Math::Vec2& c, const Math::Vec2& d, __m128& x, __m128& y)
+	{
+		const __m128 ab = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&a))), reinterpret_cast<const __m64*>(&b));
+		const __m128 cd = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&c))), reinterpret_cast<const __m64*>(&d));
+		x = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(2, 0, 2, 0));
+		y = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(3, 1, 3, 1));
+	};
+
+	while (end - i >= diagnosticsLanes)
+	{
+		const size_t sumEnd = i + std::min<size_t>(diagnosticsSumSize, (end - i) & ~static_cast<size_t>(diagnosticsLanes - 1));
+		__m128 kineticEnergy = _mm_setzero_ps(), potentialEnergy = _mm_setzero_ps();
+		__m128 sumX = _mm_setzero_ps(), sumY = _mm_setzero_ps();
+
+		for (; i < sumEnd; i += diagnosticsLanes)
+		{
+			const ParticleSimulation::Particle* pLanes = pParticles + i;
+			__m128 x, y, velocityX, velocityY;
+			loadLanes(pLanes[0].nextPosition, pLanes[1].nextPosition, pLanes[2].nextPosition, pLanes[3].nextPosition, x, y);
+
+			const __m128 distX = _mm_sub_ps(gravitySourceX, x);
+			const __m128 distY = _mm_sub_ps(gravitySourceY, y);
+			const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(distX, distX), _mm_mul_ps(distY, distY)));
+
+			if constexpr (hasVelocities)
+			{
+				loadLanes(pVelocities[i], pVelocities[i + 1], pVelocities[i + 2], pVelocities[i + 3], velocityX, velocityY);
+			}
+			else
+			{
+				// the velocity at the current position is d / h + a * h / 2 (the pull fades out within 0.001 of the source)
+				__m128 positionX, positionY;
+				loadLanes(pLanes[0].position, pLanes[1].position, pLanes[2].position, pLanes[3].position, positionX, positionY);
+				const __m128 pull = _mm_div_ps(halfStepPulls, _mm_max_ps(distance, minDistances));
+				velocityX = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(x, positionX), invTimesteps), _mm_mul_ps(distX, pull));
+				velocityY = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(y, positionY), invTimesteps), _mm_mul_ps(distY, pull));
+			}
+
+			const __m128 speed2 = _mm_add_ps(_mm_mul_ps(velocityX, velocityX), _mm_mul_ps(velocityY, velocityY));
+			kineticEnergy = _mm_add_ps(kineticEnergy, _mm_mul_ps(halves, speed2));
+			potentialEnergy = _mm_add_ps(potentialEnergy, _mm_mul_ps(gravityStrengths, distance));
+			sumX = _mm_add_ps(sumX, x);
+			sumY = _mm_add_ps(sumY, y);
+
+			minX = _mm_min_ps(minX, x);
+			minY = _mm_min_ps(minY, y);
+			maxX = _mm_max_ps(maxX, x);
+			maxY = _mm_max_ps(maxY, y);
+			maxSpeeds2 = _mm_max_ps(maxSpeeds2, speed2);
+
+			// every lane counts into its own histogram (a speed that isn't a number goes into the last bin)
+			const __m128 bin = _mm_min_ps(_mm_sqrt_ps(_mm_mul_ps(speed2, invSpeedBinWidths2)), lastSpeedBins);
+
+			// the bins are moved out of the register, four loads of a stored register would wait for the store
+			const __m128i binIndices = _mm_cvttps_epi32(bin);
+			laneHistograms[0][_mm_cvtsi128_si32(binIndices)]++;
+			laneHistograms[1][_mm_cvtsi128_si32(_mm_shuffle_epi32(binIndices, _MM_SHUFFLE(1, 1, 1, 1)))]++;
+			laneHistograms[2][_mm_cvtsi128_si32(_mm_shuffle_epi32(binIndices, _MM_SHUFFLE(2, 2, 2, 2)))]++;
+			laneHistograms[3][_mm_cvtsi128_si32(_mm_shuffle_epi32(binIndices, _MM_SHUFFLE(3, 3, 3, 3)))]++;
+		}
+
+		alignas(16) float laneSums[4][diagnosticsLanes];
+		_mm_store_ps(laneSums[0], kineticEnergy);
+		_mm_store_ps(laneSums[1], potentialEnergy);
+		_mm_store_ps(laneSums[2], sumX);
+		_mm_store_ps(laneSums[3], sumY);
+		for (uint lane = 0; lane < diagnosticsLanes; lane++)
+		{
+			partial.kineticEnergy += laneSums[0][lane];
+			partial.potentialEnergy += laneSums[1][lane];
+			partial.sumX += laneSums[2][lane];
+			partial.sumY += laneSums[3][lane];
+		}
+	}
+
+	alignas(16) float laneBounds[5][diagnosticsLanes];
+	_mm_store_ps(laneBounds[0], minX);
+	_mm_store_ps(laneBounds[1], minY);
+	_mm_store_ps(laneBounds[2], maxX);
+	_mm_store_ps(laneBounds[3], maxY);
+	_mm_store_ps(laneBounds[4], maxSpeeds2);
+	for (uint lane = 0; lane < diagnosticsLanes; lane++)
+	{
+		boundsMin = { std::min(boundsMin.x, laneBounds[0][lane]), std::min(boundsMin.y, laneBounds[1][lane]) };
+		boundsMax = { std::max(boundsMax.x, laneBounds[2][lane]), std::max(boundsMax.y, laneBounds[3][lane]) };
+		maxSpeed2 = std::max(maxSpeed2, laneBounds[4][lane]);
+	}
+#endif
+
+	// the particles that don't fill the lanes (all of them without SSE2)
+	double kineticEnergy = 0.0, potentialEnergy = 0.0, sumX = 0.0, sumY = 0.0;
+	for (; i < end; i++)
+	{
+		const ParticleSimulation::Particle& particle = pParticles[i];
+		const float x = particle.nextPosition.x;
+		const float y = particle.nextPosition.y;
+		const float distX = gravitySource.x - x;
+		const float distY = gravitySource.y - y;
+		const float distance = sqrtf(distX * distX + distY * distY);
+
+		float velocityX, velocityY;
+		if constexpr (hasVelocities)
+		{
+			velocityX = pVelocities[i].x;
+			velocityY = pVelocities[i].y;
+		}
+		else
+		{
+			const float pull = halfStepPull / std::max(distance, 0.001f);
+			velocityX = (x - particle.position.x) * invTimestep + distX * pull;
+			velocityY = (y - particle.position.y) * invTimestep + distY * pull;
+		}
+
+		const float speed2 = velocityX * velocityX + velocityY * velocityY;
+		kineticEnergy += 0.5f * speed2;
+		potentialEnergy += gravityStrength * distance;
+		sumX += x;
+		sumY += y;
+
+		boundsMin = { std::min(boundsMin.x, x), std::min(boundsMin.y, y) };
+		boundsMax = { std::max(boundsMax.x, x), std::max(boundsMax.y, y) };
+		maxSpeed2 = std::max(maxSpeed2, speed2);
+		laneHistograms[0][static_cast<uint>(std::min(static_cast<float>(numSpeedBins - 1), sqrtf(speed2 * invSpeedBinWidth2)))]++;
+	}
+
+	partial.kineticEnergy += kineticEnergy;
+	partial.potentialEnergy += potentialEnergy;
+	partial.sumX += sumX;
+	partial.sumY += sumY;
+	partial.boundsMin = boundsMin;
+	partial.boundsMax = boundsMax;
+	partial.maxSpeed = std::max(partial.maxSpeed, sqrtf(maxSpeed2));
+	for (uint lane = 0; lane < diagnosticsLanes; lane++)
+	{
+		for (uint bin = 0; bin < numSpeedBins; bin++)
+			partial.speedHistogram[bin] += laneHistograms[lane][bin];
+	}
+	partial.numParticles += end - begin;
+}
+
+/**
+ * @brief	This helper adds a range of particles to the diagnostics of a thread
+ */
+static void AccumulateDiagnostics(DiagnosticsPartial& partial, const ParticleSimulation::Particle* pParticles, const Math::Vec2* pVelocities, size_t begin, size_t end, const DiagnosticsConstants& constants)
+{
+	if (constants.hasVelocities)
+		AccumulateDiagnosticsRange<true>(partial, pParticles, pVelocities, begin, end, constants);
+	else
+		AccumulateDiagnosticsRange<false>(partial, pParticles, pVelocities, begin, end, constants);
+}
+
+/**
+ * @brief	This helper combines the diagnostics of all threads pairwise (as a tree)
+ */
+static ParticleSimulation::Diagnostics ReduceDiagnostics(std::vector<DiagnosticsPartial>& partials, float speedBinWidth, uint64 step)
+{
+	const size_t numPartials = partials.size();
+
+	for (size_t stride = 1; stride < numPartials; stride *= 2)
+	{
+		for (size_t i = 0; i + stride < numPartials; i += 2 * stride)
+		{
+			DiagnosticsPartial& lhs = partials[i];
+			const DiagnosticsPartial& rhs = partials[i + stride];
+
+			lhs.kineticEnergy += rhs.kineticEnergy;
+			lhs.potentialEnergy += rhs.potentialEnergy;
+			lhs.sumX += rhs.sumX;
+			lhs.sumY += rhs.sumY;
+			lhs.boundsMin = { std::min(lhs.boundsMin.x, rhs.boundsMin.x), std::min(lhs.boundsMin.y, rhs.boundsMin.y) };
+			lhs.boundsMax = { std::max(lhs.boundsMax.x, rhs.boundsMax.x), std::max(lhs.boundsMax.y, rhs.boundsMax.y) };
+			lhs.maxSpeed = std::max(lhs.maxSpeed, rhs.maxSpeed);
+			for (uint bin = 0; bin < ParticleSimulation::Diagnostics::numSpeedBins; bin++)
+				lhs.speedHistogram[bin] += rhs.speedHistogram[bin];
+			lhs.numParticles += rhs.numParticles;
+		}
+	}
+
+	const DiagnosticsPartial& total = partials.front();
+	ParticleSimulation::Diagnostics diagnostics;
+
+	diagnostics.kineticEnergy = total.kineticEnergy;
+	diagnostics.potentialEnergy = total.potentialEnergy;
+	diagnostics.boundsMin = total.boundsMin;
+	diagnostics.boundsMax = total.boundsMax;
+	diagnostics.centroid = (total.numParticles > 0) ?
+		Math::Vec2{ static_cast<float>(total.sumX / total.numParticles), static_cast<float>(total.sumY / total.numParticles) } : Math::Vec2::zero;
+	diagnostics.maxSpeed = total.maxSpeed;
+	diagnostics.speedBinWidth = speedBinWidth;
+	memcpy(diagnostics.speedHistogram, total.speedHistogram, sizeof(diagnostics.speedHistogram));
+	diagnostics.step = step;
+
+	return diagnostics;
+}
+
+/**
+ * @brief	This struct defines how the particles of a step collide with the obstacles
+ */
+struct CollisionConstants
+{
+	const ObstacleField* pObstacles;	/**< the obstacles (nullptr if there are none) */
+	float radius;
+	float restitution;
+	const SegmentBVH* pWalls;			/**< the walls (nullptr if there are none) */
+	float wallDamping;
+	bool hasVelocities;					/**< the integrator keeps the velocities, otherwise the last displacement is the velocity */
+};
+
+/**
+ * @brief	This struct defines what the timestep estimate of a step needs to know
+ */
+struct TimestepConstants
+{
+	Math::Vec2 gravitySource;
+	float gravityStrength;			/**< the magnitude of the pull */
+	float invLastTimestep2;			/**< the inverse squared timestep of the last displacement */
+	float accuracy;
+	float softening;
+};
+
+/**
+ * @brief	This helper reduces the smallest squared timestep of a range of particles (see ParticleTimestep2)
+ * 			The lanes take four roots and divisions at once, the rest of the range
+ * 			is estimated one by one.
+ * @return	float is the smallest squared timestep (FLT_MAX if the particles allow any timestep)
+ */
+static float MinTimestep2Range(const ParticleSimulation::Particle* pParticles, size_t begin, size_t end, const TimestepConstants& constants)
+{
+	float minTimestep2 = FLT_MAX;
+	size_t i = begin;
+
+#if defined(DIAGNOSTICS_SSE2)
+	const __m128 gravitySourceX = _mm_set1_ps(constants.gravitySource.x);
+	const __m128 gravitySourceY = _mm_set1_ps(constants.gravitySource.y);
+	const __m128 softenings = _mm_set1_ps(constants.softening);
+	const __m128 fallFactors = _mm_set1_ps((constants.gravityStrength > 0.0f) ? 2.0f * constants.accuracy / constants.gravityStrength : 0.0f);
+	const __m128 moveFactors = _mm_set1_ps(constants.accuracy * constants.accuracy);
+	const __m128 invLastTimesteps2 = _mm_set1_ps(constants.invLastTimestep2);
+	const __m128 zeros = _mm_setzero_ps();
+	const bool isFalling = constants.gravityStrength > 0.0f;
+	__m128 minTimesteps2 = _mm_set1_ps(FLT_MAX);
+
+	// the vectors of four particles are loaded in pairs and split into their x and y
+	auto loadLanes = [](const Math::Vec2& a, const Math::Vec2& b, const Math::Vec2& c, const Math::Vec2& d, __m128& x, __m128& y)
+	{
+		const __m128 ab = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&a))), reinterpret_cast<const __m64*>(&b));
+		const __m128 cd = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&c))), reinterpret_cast<const __m64*>(&d));
+		x = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(2, 0, 2, 0));
+		y = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(3, 1, 3, 1));
+	};
+
+	for (; end - i >= diagnosticsLanes; i += diagnosticsLanes)
+	{
+		const ParticleSimulation::Particle* pLanes = pParticles + i;
+		__m128 x, y, positionX, positionY;
+		loadLanes(pLanes[0].nextPosition, pLanes[1].nextPosition, pLanes[2].nextPosition, pLanes[3].nextPosition, x, y);
+		loadLanes(pLanes[0].position, pLanes[1].position, pLanes[2].position, pLanes[3].position, positionX, positionY);
+
+		const __m128 distX = _mm_sub_ps(gravitySourceX, x);
+		const __m128 distY = _mm_sub_ps(gravitySourceY, y);
+		const __m128 distance = _mm_add_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(distX, distX), _mm_mul_ps(distY, distY))), softenings);
+		const __m128 moveX = _mm_sub_ps(x, positionX);
+		const __m128 moveY = _mm_sub_ps(y, positionY);
+		const __m128 speed2 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(moveX, moveX), _mm_mul_ps(moveY, moveY)), invLastTimesteps2);
+
+		// a resting lane keeps its minimum
+		if (isFalling)
+			minTimesteps2 = _mm_min_ps(_mm_mul_ps(fallFactors, distance), minTimesteps2);
+		const __m128 moving = _mm_cmpgt_ps(speed2, zeros);
+		const __m128 moveTimestep2 = _mm_div_ps(_mm_mul_ps(moveFactors, _mm_mul_ps(distance, distance)), speed2);
+		minTimesteps2 = _mm_min_ps(_mm_or_ps(_mm_and_ps(moving, moveTimestep2), _mm_andnot_ps(moving, minTimesteps2)), minTimesteps2);
+	}
+
+	alignas(16) float laneMins[diagnosticsLanes];
+	_mm_store_ps(laneMins, minTimesteps2);
+	for (uint lane = 0; lane < diagnosticsLanes; lane++)
+		minTimestep2 = std::min(minTimestep2, laneMins[lane]);
+#endif
+
+	// the particles that don't fill the lanes (all of them without SSE2)
+	for (; i < end; i++)
+		minTimestep2 = std::min(minTimestep2, ParticleTimestep2(pParticles[i], constants.gravitySource, constants.gravityStrength, constants.invLastTimestep2, constants.accuracy, constants.softening));
+
+	return minTimestep2;
+}
+
+/**
+ * @brief	This helper integrates a range of particles, collides it and optionally diagnoses it
+ * 			Every block is collided, diagnosed and estimated while it is still in the cache.
+ * @param	pPartial are the diagnostics of the calling thread (nullptr doesn't diagnose)
+ * @param	pMinTimestep2 is the smallest squared timestep of the calling thread (nullptr doesn't estimate it)
+ * @return	size_t is the number of particles that collided with an obstacle or a wall
+ */
+template <class Integrator>
+static size_t IntegrateAndDiagnose(ParticleSimulation::Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, const Integrators::StepConstants& stepConstants,
+	DiagnosticsPartial* pPartial, const DiagnosticsConstants& diagnosticsConstants, const CollisionConstants& collisionConstants,
+	float* pMinTimestep2, const TimestepConstants& timestepConstants)
+{
+	const ObstacleField* pObstacles = collisionConstants.pObstacles;
+	const SegmentBVH* pWalls = collisionConstants.pWalls;
+	Math::Vec2* pCollisionVelocities = (collisionConstants.hasVelocities) ? pVelocities : nullptr;
+	size_t numCollisions = 0;
+
+	if (!pPartial && !pObstacles && !pWalls && !pMinTimestep2)
+	{
+		Integrators::IntegrateRange<Integrator>(pParticles, pVelocities, begin, end, stepConstants);
+		return 0;
+	}
+
+	for (size_t blockBegin = begin; blockBegin < end; blockBegin += diagnosticsBlockSize)
+	{
+		size_t blockEnd = std::min(end, blockBegin + diagnosticsBlockSize);
+		Integrators::IntegrateRange<Integrator>(pParticles, pVelocities, blockBegin, blockEnd, stepConstants);
+
+		// the walls see the whole step, the obstacles the position it ends at
+		if (pWalls)
+			numCollisions += pWalls->Collide(pParticles, pCollisionVelocities, blockBegin, blockEnd, collisionConstants.wallDamping);
+		if (pObstacles)
+			numCollisions += pObstacles->Collide(pParticles, pCollisionVelocities, blockBegin, blockEnd, collisionConstants.radius, collisionConstants.restitution);
+
+		if (pPartial)
+			AccumulateDiagnostics(*pPartial, pParticles, pVelocities, blockBegin, blockEnd, diagnosticsConstants);
+		if (pMinTimestep2)
+			*pMinTimestep2 = std::min(*pMinTimestep2, MinTimestep2Range(pParticles, blockBegin, blockEnd, timestepConstants));
+	}
+
+	return numCollisions;
+}
+
+/**
+ * @brief	This helper counts the steps in a row every particle of a range stayed quiet
+ * @param	threshold2 is the squared displacement of the last update a particle has to stay below
+ * @return	size_t is the number of particles that stayed quiet long enough to fall asleep
+ */
+static size_t UpdateQuietSteps(const ParticleSimulation::Particle* pParticles, uint8* pQuietSteps, size_t begin, size_t end, float threshold2, uint numQuietSteps)
+{
+	size_t numQuietParticles = 0;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		const ParticleSimulation::Particle& particle = pParticles[i];
+		uint quietSteps = pQuietSteps[i];
+
+		if (Math::SquareDistance(particle.nextPosition, particle.position) > threshold2)
+			quietSteps = 0;
+		else if (quietSteps < numQuietSteps)
+			quietSteps++;
+
+		pQuietSteps[i] = static_cast<uint8>(quietSteps);
+		numQuietParticles += (quietSteps >= numQuietSteps) ? 1 : 0;
+	}
+
+	return numQuietParticles;
+}
+
+ParticleSimulation::ParticleSimulation(size_t numMaxParticles, ThreadPool* pThreadPool) :
+	pThreadPool(pThreadPool),
+	numMaxParticles(numMaxParticles),
+	pArena(nullptr),
+	firstTouchTime(0),
+	pParticles(nullptr),
+	pVelocities(nullptr),
+	integrationMethod(PositionVerlet),
+	constants(),
+	numSteps(0),
+	numParticleUpdates(0),
+	numSavedParticleUpdates(0),
+	stepTime(0),
+	areDiagnosticsEnabled(false),
+	maxHistogramSpeed(0.0f),
+	diagnostics(),
+	isSleepingEnabled(false),
+	sleepThreshold(0.0f),
+	numQuietSteps(0),
+	numAwakeParticles(numMaxParticles),
+	numQuietParticles(0),
+	particleBudget(numMaxParticles),
+	numSkippedParticleUpdates(0),
+	numDeferredParticleUpdates(0),
+	pQuietSteps(nullptr),
+	pSleepingDiagnostics(new DiagnosticsPartial(EmptyDiagnostics())),
+	pObstacles(nullptr),
+	particleRadius(0.0f),
+	restitution(0.0f),
+	pWalls(nullptr),
+	wallDamping(0.0f),
+	numCollisions(0),
+	numTimeBins(0),
+	timeBinAccuracy(0.0f),
+	timeBinSoftening(0.0f),
+	lastBlockTimestep(0.0f),
+	isBlockStepping(false),
+	pTimeBins(nullptr),
+	numSortedParticles(0),
+	pSortedParticles(nullptr),
+	pSortedVelocities(nullptr),
+	pSortedTimeBins(nullptr),
+	pParticleIDs(nullptr),
+	pSortedParticleIDs(nullptr),
+	estimateAccuracy(0.0f),
+	estimateSoftening(0.0f),
+	hasTimestepEstimate(false),
+	estimatedTimestep2(FLT_MAX)
+{
+
+}
+
+ParticleSimulation::~ParticleSimulation()
+{
+	// the arena releases all particle arrays at once
+	SAFE_DELETE(this->pArena);
+	SAFE_DELETE(this->pSleepingDiagnostics);
+}
+
+bool ParticleSimulation::SetupParticles(MemoryArena::PageSize pageSize)
+{
+	const size_t numParticles = this->numMaxParticles;
+
+	// Make space for the particles and their sorted copies in one arena
+	size_t particlesSize = MemoryArena::AlignedSize(sizeof(Particle) * numParticles);
+	size_t velocitiesSize = MemoryArena::AlignedSize(sizeof(Math::Vec2) * numParticles);
+	size_t timeBinsSize = MemoryArena::AlignedSize(sizeof(uint8) * numParticles);
+	size_t quietStepsSize = MemoryArena::AlignedSize(sizeof(uint8) * numParticles);
+	size_t particleIDsSize = MemoryArena::AlignedSize(sizeof(uint32) * numParticles);
+
+	SAFE_DELETE(this->pArena);
+	this->pArena = new MemoryArena(2 * (particlesSize + velocitiesSize + timeBinsSize + particleIDsSize) + quietStepsSize, pageSize);
+
+	this->pParticles = this->pArena->Allocate<Particle>(numParticles);
+	this->pVelocities = this->pArena->Allocate<Math::Vec2>(numParticles);
+	this->pTimeBins = this->pArena->Allocate<uint8>(numParticles);
+	this->pSortedParticles = this->pArena->Allocate<Particle>(numParticles);
+	this->pSortedVelocities = this->pArena->Allocate<Math::Vec2>(numParticles);
+	this->pSortedTimeBins = this->pArena->Allocate<uint8>(numParticles);
+	this->pQuietSteps = this->pArena->Allocate<uint8>(numParticles);
+	this->pParticleIDs = this->pArena->Allocate<uint32>(numParticles);
+	this->pSortedParticleIDs = this->pArena->Allocate<uint32>(numParticles);
+
+	// the reservation itself may have failed, which leaves the arena empty
+	if (!this->pParticles || !this->pVelocities || !this->pTimeBins || !this->pSortedParticles || !this->pSortedVelocities || !this->pSortedTimeBins ||
+		!this->pQuietSteps || !this->pParticleIDs || !this->pSortedParticleIDs)
+	{
+		ERR("The arrays of %zu particles don't fit into their memory arena", numParticles);
+		SAFE_DELETE(this->pArena);
+
+		this->pParticles = this->pSortedParticles = nullptr;
+		this->pVelocities = this->pSortedVelocities = nullptr;
+		this->pTimeBins = this->pSortedTimeBins = this->pQuietSteps = nullptr;
+		this->pParticleIDs = this->pSortedParticleIDs = nullptr;
+
+		return false;
+	}
+
+	this->isBlockStepping = false;
+	this->numSortedParticles = 0;
+	this->hasTimestepEstimate = false;
+	this->numAwakeParticles = numParticles;
+	*this->pSleepingDiagnostics = EmptyDiagnostics();
+
+	Particle* pParticles = this->pParticles;
+	Math::Vec2* pVelocities = this->pVelocities;
+	uint8* pTimeBins = this->pTimeBins;
+	Particle* pSortedParticles = this->pSortedParticles;
+	Math::Vec2* pSortedVelocities = this->pSortedVelocities;
+	uint8* pSortedTimeBins = this->pSortedTimeBins;
+	uint8* pQuietSteps = this->pQuietSteps;
+	uint32* pParticleIDs = this->pParticleIDs;
+	uint32* pSortedParticleIDs = this->pSortedParticleIDs;
+
+	// Every thread places the particles of its own range (the pages
+	// are committed by the first write, not by the reservation)
+	uint64 startTime = Time::Now();
+
+	ForEachRange(this->pThreadPool, numParticles, this->numMaxParticles, [=](size_t begin, size_t end, uint) {
+		for (size_t i = begin; i < end; i++)
+		{
+			float column = float(i % 1000);
+			float row = float(i / 50);
+
+			pParticles[i].position = { (column * 0.0009f) - 0.5f, (row * 0.0009f) - 0.5f };
+			pParticles[i].prevPosition = pParticles[i].position;
+			pParticles[i].nextPosition = pParticles[i].position;
+			pVelocities[i] = Math::Vec2::zero;
+			Integrators::PositionVerlet::Reset(pParticles[i], pVelocities[i]);
+			pTimeBins[i] = 0;
+			pQuietSteps[i] = 0;
+			pParticleIDs[i] = static_cast<uint32>(i);
+		}
+
+		memset(pSortedParticles + begin, 0, sizeof(Particle) * (end - begin));
+		memset(pSortedVelocities + begin, 0, sizeof(Math::Vec2) * (end - begin));
+		memset(pSortedTimeBins + begin, 0, sizeof(uint8) * (end - begin));
+		memset(pSortedParticleIDs + begin, 0, sizeof(uint32) * (end - begin));
+	});
+
+	this->firstTouchTime = Time::Now() - startTime;
+
+	// Initial simulation constants
+	this->constants.numParticles = static_cast<uint>(this->numMaxParticles);
+	this->constants.lastTimestep = 1.0f;
+	this->constants.timestep = 1.0f;
+	this->constants.gravitySource = Math::Vec2{ 0.0f, 0.0f };
+	this->constants.gravityStrength = 9.81f;
+	this->constants.damping = 0.9948f;
+
+	return true;
+}
+
+void ParticleSimulation::SetIntegrationMethod(IntegrationMethod method)
+{
+	// the velocity is only kept up to date by the velocity based integrators
+	if (this->pParticles && this->integrationMethod == PositionVerlet && method != PositionVerlet)
+	{
+		// every particle continues with the velocity of its own time bin (in place, every velocity is read before it is written)
+		this->CalculateVelocities(this->pVelocities);
+	}
+	// and the position Verlet may keep its own state there
+	else if (this->pParticles && this->integrationMethod != PositionVerlet && method == PositionVerlet)
+	{
+		Particle* pParticles = this->pParticles;
+		Math::Vec2* pVelocities = this->pVelocities;
+		ForEachRange(this->pThreadPool, this->numMaxParticles, this->numMaxParticles, [=](size_t begin, size_t end, uint) {
+			for (size_t i = begin; i < end; i++)
+				Integrators::PositionVerlet::Reset(pParticles[i], pVelocities[i]);
+		});
+	}
+
+	this->integrationMethod = method;
+	this->hasTimestepEstimate = false;
+}
+
+void ParticleSimulation::SetTimeBins(uint numTimeBins, float accuracy, float softening)
+{
+	numTimeBins = std::min(numTimeBins, maxTimeBins);
+
+	// back to one timestep for all particles
+	if (numTimeBins == 0 && this->isBlockStepping)
+	{
+		if (this->integrationMethod == PositionVerlet)
+		{
+			const Integrators::StepConstants stepConstants = MakeStepConstants(this->constants, this->lastBlockTimestep, this->lastBlockTimestep);
+
+			// (the sleeping particles rest in any timestep)
+			for (size_t i = 0; i < this->numAwakeParticles; i++)
+			{
+				Particle& particle = this->pParticles[i];
+				float binTimestep = this->lastBlockTimestep / static_cast<float>(1u << this->pTimeBins[i]);
+				RescaleLastDisplacement(particle, Integrators::Acceleration(particle.nextPosition, stepConstants), binTimestep, this->lastBlockTimestep);
+			}
+		}
+
+		this->isBlockStepping = false;
+	}
+
+	this->numTimeBins = numTimeBins;
+	this->timeBinAccuracy = accuracy;
+	this->timeBinSoftening = softening;
+	this->hasTimestepEstimate = false;
+}
+
+void ParticleSimulation::SetTimestepEstimate(float accuracy, float softening)
+{
+	this->estimateAccuracy = std::max(accuracy, 0.0f);
+	this->estimateSoftening = softening;
+	this->hasTimestepEstimate = false;
+}
+
+void ParticleSimulation::SetDiagnostics(bool enabled, float maxHistogramSpeed)
+{
+	this->areDiagnosticsEnabled = enabled;
+	this->maxHistogramSpeed = maxHistogramSpeed;
+
+	if (!enabled)
+		this->diagnostics = Diagnostics();
+}
+
+void ParticleSimulation::SetSleeping(bool enabled, float threshold, uint numQuietSteps)
+{
+	if (!enabled)
+		this->WakeParticles();
+
+	this->isSleepingEnabled = enabled;
+	this->sleepThreshold = threshold;
+	this->numQuietSteps = std::min(std::max(numQuietSteps, 1u), 255u);
+}
+
+void ParticleSimulation::WakeParticles(void)
+{
+	// the sleeping particles rest, so they simply continue from there
+	this->numAwakeParticles = this->numMaxParticles;
+	this->hasTimestepEstimate = false;
+	*this->pSleepingDiagnostics = EmptyDiagnostics();
+
+	if (this->pQuietSteps)
+		memset(this->pQuietSteps, 0, this->numMaxParticles);
+}
+
+void ParticleSimulation::SetObstacles(const ObstacleField* pObstacles, float radius, float restitution)
+{
+	this->pObstacles = pObstacles;
+	this->particleRadius = radius;
+	this->restitution = std::min(std::max(restitution, 0.0f), 1.0f);
+
+	this->WakeParticles();
+}
+
+void ParticleSimulation::SetWalls(const SegmentBVH* pWalls, float damping)
+{
+	this->pWalls = pWalls;
+	this->wallDamping = std::min(std::max(damping, 0.0f), 1.0f);
+
+	this->WakeParticles();
+}
+
+void ParticleSimulation::SetParticleBudget(size_t particleBudget)
+{
+	this->particleBudget = particleBudget;
+}
+
+uint32 ParticleSimulation::ApplyInputEvents(InputEventQueue& inputEvents, uint64 until)
+{
+	this->hasTimestepEstimate = false;
+	return inputEvents.Drain(until, [this](const InputEvent& event) { this->ApplyInputEvent(event); });
+}
+
+void ParticleSimulation::AdvanceTimestep(float timestep)
+{
+	this->constants.lastTimestep = this->constants.timestep;
+	this->constants.timestep = timestep;
+	this->numSteps++;
+}
+
+void ParticleSimulation::Step(float timestep, InputEventQueue* pInputEvents, uint64 stepEnd)
+{
+	uint64 startTime = Time::Now();
+
+	this->AdvanceTimestep(timestep);
+	this->hasTimestepEstimate = false;
+
+	// without substeps all input of the step applies before it
+	if (pInputEvents && this->numTimeBins == 0)
+		this->ApplyInputEvents(*pInputEvents, stepEnd);
+
+	this->numSkippedParticleUpdates += this->numMaxParticles - this->numAwakeParticles;
+	this->numDeferredParticleUpdates += this->numAwakeParticles - std::min(this->numAwakeParticles, this->particleBudget);
+	this->numQuietParticles = 0;
+
+	// choose the kernel once per step, never per particle
+	switch (this->integrationMethod)
+	{
+	case PositionVerlet:
+		this->Integrate<Integrators::PositionVerlet>(pInputEvents, stepEnd);
+		break;
+	case VelocityVerlet:
+		this->Integrate<Integrators::VelocityVerlet>(pInputEvents, stepEnd);
+		break;
+	case Leapfrog:
+		this->Integrate<Integrators::Leapfrog>(pInputEvents, stepEnd);
+		break;
+	case SemiImplicitEuler:
+		this->Integrate<Integrators::SemiImplicitEuler>(pInputEvents, stepEnd);
+		break;
+	case RungeKutta4:
+		this->Integrate<Integrators::RungeKutta4>(pInputEvents, stepEnd);
+		break;
+	}
+
+	if (this->numQuietParticles > 0)
+		this->PutQuietParticlesToSleep();
+
+	this->stepTime += Time::Now() - startTime;
+}
+
+template <class Integrator>
+void ParticleSimulation::Integrate(InputEventQueue* pInputEvents, uint64 stepEnd)
+{
+	if (this->numTimeBins > 0)
+	{
+		this->IntegrateTimeBins<Integrator>(pInputEvents, stepEnd);
+		return;
+	}
+
+	const Integrators::StepConstants stepConstants = MakeStepConstants(this->constants, this->constants.lastTimestep, this->constants.timestep);
+	const size_t numActiveParticles = std::min(this->numAwakeParticles, this->particleBudget);
+	Particle* pParticles = this->pParticles;
+	Math::Vec2* pVelocities = this->pVelocities;
+	const uint numThreads = (this->pThreadPool) ? this->pThreadPool->GetNumThreads() : 1;
+
+	const DiagnosticsConstants diagnosticsConstants = MakeDiagnosticsConstants(this->constants, this->constants.timestep, this->integrationMethod != PositionVerlet, this->maxHistogramSpeed);
+	std::vector<DiagnosticsPartial> partials((this->areDiagnosticsEnabled) ? numThreads : 0, EmptyDiagnostics());
+	DiagnosticsPartial* pPartials = partials.data();
+
+	// the quiet steps are counted while the particles are still cached
+	uint8* pQuietSteps = (this->isSleepingEnabled) ? this->pQuietSteps : nullptr;
+	const float sleepThreshold2 = this->sleepThreshold * this->sleepThreshold;
+	const uint numQuietSteps = this->numQuietSteps;
+	std::vector<size_t> numQuietParticles(numThreads, 0);
+	size_t* pNumQuietParticles = numQuietParticles.data();
+
+	const CollisionConstants collisionConstants = { this->pObstacles, this->particleRadius, this->restitution, this->pWalls, this->wallDamping, this->integrationMethod != PositionVerlet };
+	std::vector<size_t> numCollisions(numThreads, 0);
+	size_t* pNumCollisions = numCollisions.data();
+
+	// the timestep of the next step is estimated on the positions this step ends at, which only covers all awake particles within the budget
+	const bool isEstimating = this->estimateAccuracy > 0.0f && numActiveParticles == this->numAwakeParticles;
+	const TimestepConstants timestepConstants = { this->constants.gravitySource, fabsf(this->constants.gravityStrength),
+		1.0f / (this->constants.timestep * this->constants.timestep), this->estimateAccuracy, this->estimateSoftening };
+	std::vector<float> minTimesteps2((isEstimating) ? numThreads : 0, FLT_MAX);
+	float* pMinTimesteps2 = minTimesteps2.data();
+
+	ForEachRange(this->pThreadPool, numActiveParticles, this->numMaxParticles, [=, &stepConstants, &diagnosticsConstants, &collisionConstants, &timestepConstants](size_t begin, size_t end, uint threadIndex) {
+		pNumCollisions[threadIndex] += IntegrateAndDiagnose<Integrator>(pParticles, pVelocities, begin, end, stepConstants, (pPartials) ? &pPartials[threadIndex] : nullptr,
+			diagnosticsConstants, collisionConstants, (pMinTimesteps2) ? &pMinTimesteps2[threadIndex] : nullptr, timestepConstants);
+
+		if (pQuietSteps)
+			pNumQuietParticles[threadIndex] += UpdateQuietSteps(pParticles, pQuietSteps, begin, end, sleepThreshold2, numQuietSteps);
+	});
+
+	if (this->areDiagnosticsEnabled)
+	{
+		// the sleeping particles were diagnosed when they fell asleep
+		partials.push_back(*this->pSleepingDiagnostics);
+		this->diagnostics = ReduceDiagnostics(partials, this->maxHistogramSpeed / Diagnostics::numSpeedBins, this->numSteps);
+	}
+
+	if (isEstimating)
+	{
+		this->estimatedTimestep2 = FLT_MAX;
+		for (float minTimestep2 : minTimesteps2)
+			this->estimatedTimestep2 = std::min(this->estimatedTimestep2, minTimestep2);
+		this->hasTimestepEstimate = true;
+	}
+
+	for (size_t count : numQuietParticles)
+		this->numQuietParticles += count;
+	for (size_t count : numCollisions)
+		this->numCollisions += count;
+	this->numParticleUpdates += numActiveParticles;
+}
+
+template <class Integrator>
+void ParticleSimulation::IntegrateTimeBins(InputEventQueue* pInputEvents, uint64 stepEnd)
+{
+	const float timestep = this->constants.timestep;
+
+	// the first block continues with the timestep all particles had so far
+	if (!this->isBlockStepping)
+	{
+		memset(this->pTimeBins, 0, this->numMaxParticles);
+		this->lastBlockTimestep = this->constants.lastTimestep;
+		this->numSortedParticles = 0;
+		this->isBlockStepping = true;
+	}
+
+	// binEnds[bin] is the number of particles in this and all finer bins
+	size_t binEnds[maxTimeBins + 2];
+	const uint finestBin = this->SortIntoTimeBins(timestep, binEnds);
+
+	// every bin is diagnosed after its last substep, an input event between the substeps changes both
+	Integrators::StepConstants binConstants[maxTimeBins + 1];
+	DiagnosticsConstants diagnosticsConstants[maxTimeBins + 1];
+	auto makeBinConstants = [&]() {
+		for (uint bin = 0; bin <= finestBin; bin++)
+		{
+			float binTimestep = timestep / static_cast<float>(1u << bin);
+			binConstants[bin] = MakeStepConstants(this->constants, binTimestep, binTimestep);
+			diagnosticsConstants[bin] = MakeDiagnosticsConstants(this->constants, binTimestep, this->integrationMethod != PositionVerlet, this->maxHistogramSpeed);
+		}
+	};
+	makeBinConstants();
+
+	Particle* pParticles = this->pParticles;
+	Math::Vec2* pVelocities = this->pVelocities;
+	uint64 numUpdates = 0;
+
+	const uint numThreads = (this->pThreadPool) ? this->pThreadPool->GetNumThreads() : 1;
+	std::vector<DiagnosticsPartial> partials((this->areDiagnosticsEnabled) ? numThreads : 0, EmptyDiagnostics());
+	DiagnosticsPartial* pPartials = partials.data();
+
+	// the threshold is a displacement per step, a bin moves 1 / 2^bin of it per substep
+	float sleepThresholds2[maxTimeBins + 1];
+	for (uint bin = 0; bin <= finestBin; bin++)
+	{
+		float binThreshold = this->sleepThreshold / static_cast<float>(1u << bin);
+		sleepThresholds2[bin] = binThreshold * binThreshold;
+	}
+
+	uint8* pQuietSteps = (this->isSleepingEnabled) ? this->pQuietSteps : nullptr;
+	std::vector<size_t> numQuietParticles(numThreads, 0);
+
+	// the particles collide after every substep they are integrated in
+	const CollisionConstants collisionConstants = { this->pObstacles, this->particleRadius, this->restitution, this->pWalls, this->wallDamping, this->integrationMethod != PositionVerlet };
+	std::vector<size_t> numCollisions(numThreads, 0);
+
+	// particles an input event wakes join with the next step, they still rest in the sleeping diagnostics
+	const DiagnosticsPartial sleepingDiagnostics = *this->pSleepingDiagnostics;
+
+	const uint numSubsteps = 1u << finestBin;
+	const double stepDuration = static_cast<double>(timestep) * 1000000.0;
+	for (uint substep = 0; substep < numSubsteps; substep++)
+	{
+		// the input that was received until the end of a substep applies before it
+		uint64 substepEnd = stepEnd - static_cast<uint64>(stepDuration * (numSubsteps - substep - 1) / numSubsteps);
+		if (pInputEvents && this->ApplyInputEvents(*pInputEvents, substepEnd) > 0)
+			makeBinConstants();
+
+		// a bin is due whenever its period divides the substep
+		uint numTrailingZeros = 0;
+		while (substep != 0 && !((substep >> numTrailingZeros) & 1))
+			numTrailingZeros++;
+		const uint coarsestBin = (substep == 0) ? 0 : finestBin - numTrailingZeros;
+
+		// the due particles are a prefix of the sorted particles
+		ForEachRange(this->pThreadPool, binEnds[coarsestBin], this->numMaxParticles, [&](size_t begin, size_t end, uint threadIndex) {
+			for (uint bin = coarsestBin; bin <= finestBin; bin++)
+			{
+				size_t binBegin = std::max(begin, binEnds[bin + 1]);
+				size_t binEnd = std::min(end, binEnds[bin]);
+				bool isLastSubstep = (substep + (1u << (finestBin - bin)) == numSubsteps);
+
+				if (binBegin >= binEnd)
+					continue;
+
+				numCollisions[threadIndex] += IntegrateAndDiagnose<Integrator>(pParticles, pVelocities, binBegin, binEnd, binConstants[bin],
+					(pPartials && isLastSubstep) ? &pPartials[threadIndex] : nullptr, diagnosticsConstants[bin], collisionConstants, nullptr, TimestepConstants());
+
+				if (pQuietSteps && isLastSubstep)
+					numQuietParticles[threadIndex] += UpdateQuietSteps(pParticles, pQuietSteps, binBegin, binEnd, sleepThresholds2[bin], this->numQuietSteps);
+			}
+		});
+
+		numUpdates += binEnds[coarsestBin];
+	}
+
+	this->numParticleUpdates += numUpdates;
+	this->numSavedParticleUpdates += binEnds[0] * numSubsteps - numUpdates;
+	this->lastBlockTimestep = timestep;
+
+	if (this->areDiagnosticsEnabled)
+	{
+		// the sleeping particles were diagnosed when they fell asleep
+		partials.push_back(sleepingDiagnostics);
+		this->diagnostics = ReduceDiagnostics(partials, this->maxHistogramSpeed / Diagnostics::numSpeedBins, this->numSteps);
+	}
+
+	for (size_t count : numQuietParticles)
+		this->numQuietParticles += count;
+	for (size_t count : numCollisions)
+		this->numCollisions += count;
+}
+
+uint ParticleSimulation::SortIntoTimeBins(float timestep, size_t* pBinEnds)
+{
+	const uint numBins = this->numTimeBins + 1;
+	const uint numThreads = (this->pThreadPool) ? this->pThreadPool->GetNumThreads() : 1;
+	const bool rescale = (this->integrationMethod == PositionVerlet);
+	const float lastBlockTimestep = this->lastBlockTimestep;
+	const Math::Vec2 gravitySource = this->constants.gravitySource;
+	const float gravityStrength = fabsf(this->constants.gravityStrength);
+	const Integrators::StepConstants stepConstants = MakeStepConstants(this->constants, timestep, timestep);
+	const float accuracy = this->timeBinAccuracy;
+	const float softening = this->timeBinSoftening;
+	const uint numTimeBins = this->numTimeBins;
+	const size_t numActiveParticles = std::min(this->numAwakeParticles, this->particleBudget);
+
+	Particle* pParticles = this->pParticles;
+	uint8* pTimeBins = this->pTimeBins;
+
+	// every thread counts the bins of its own range and how many particles changed theirs
+	std::vector<size_t> offsets(numThreads * numBins, 0);
+	std::vector<size_t> numChanged(numThreads, 0);
+
+	// the last and the new timestep of every bin
+	float lastTimesteps[maxTimeBins + 1], invLastTimesteps2[maxTimeBins + 1], binTimesteps[maxTimeBins + 1], binTimesteps2[maxTimeBins + 1];
+	for (uint bin = 0; bin < numBins; bin++)
+	{
+		lastTimesteps[bin] = lastBlockTimestep / static_cast<float>(1u << bin);
+		invLastTimesteps2[bin] = 1.0f / (lastTimesteps[bin] * lastTimesteps[bin]);
+		binTimesteps[bin] = timestep / static_cast<float>(1u << bin);
+		binTimesteps2[bin] = binTimesteps[bin] * binTimesteps[bin];
+	}
+
+	ForEachRange(this->pThreadPool, numActiveParticles, this->numMaxParticles, [&](size_t begin, size_t end, uint threadIndex) {
+		size_t* pCounts = &offsets[threadIndex * numBins];
+		size_t numChangedBins = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			Particle& particle = pParticles[i];
+			const uint lastBin = pTimeBins[i];
+			float timestep2 = ParticleTimestep2(particle, gravitySource, gravityStrength, invLastTimesteps2[lastBin], accuracy, softening);
+
+			// the coarsest bin whose timestep is small enough
+			uint bin = 0;
+			while (bin < numTimeBins && binTimesteps2[bin] > timestep2)
+				bin++;
+
+			// express the last displacement in the timestep of the new bin
+			if (rescale && binTimesteps[bin] != lastTimesteps[lastBin])
+				RescaleLastDisplacement(particle, Integrators::Acceleration(particle.nextPosition, stepConstants), lastTimesteps[lastBin], binTimesteps[bin]);
+
+			numChangedBins += (bin != lastBin) ? 1 : 0;
+			pTimeBins[i] = static_cast<uint8>(bin);
+			pCounts[bin]++;
+		}
+
+		numChanged[threadIndex] += numChangedBins;
+	});
+
+	// turn the counts into scatter offsets, finest bins first
+	size_t offset = 0;
+	uint finestBin = 0;
+	pBinEnds[numBins] = 0;
+	for (uint bin = numBins; bin-- > 0;)
+	{
+		for (uint thread = 0; thread < numThreads; thread++)
+		{
+			size_t count = offsets[thread * numBins + bin];
+			offsets[thread * numBins + bin] = offset;
+			offset += count;
+		}
+
+		if (offset > 0 && finestBin == 0)
+			finestBin = bin;
+
+		pBinEnds[bin] = offset;
+	}
+
+	// the particles are still in order if the same ones kept their bins
+	size_t numChangedBins = 0;
+	for (size_t count : numChanged)
+		numChangedBins += count;
+	if (numChangedBins == 0 && this->numSortedParticles == numActiveParticles)
+		return finestBin;
+
+	// every thread scatters its own range again
+	Particle* pSortedParticles = this->pSortedParticles;
+	Math::Vec2* pVelocities = this->pVelocities;
+	Math::Vec2* pSortedVelocities = this->pSortedVelocities;
+	uint8* pSortedTimeBins = this->pSortedTimeBins;
+	uint32* pParticleIDs = this->pParticleIDs;
+	uint32* pSortedParticleIDs = this->pSortedParticleIDs;
+
+	ForEachRange(this->pThreadPool, numActiveParticles, this->numMaxParticles, [&](size_t begin, size_t end, uint threadIndex) {
+		size_t* pOffsets = &offsets[threadIndex * numBins];
+
+		for (size_t i = begin; i < end; i++)
+		{
+			size_t index = pOffsets[pTimeBins[i]]++;
+			pSortedParticles[index] = pParticles[i];
+			pSortedVelocities[index] = pVelocities[i];
+			pSortedTimeBins[index] = pTimeBins[i];
+			pSortedParticleIDs[index] = pParticleIDs[i];
+		}
+	});
+
+	// the awake particles behind the budget stay where they are
+	const size_t numWaiting = this->numAwakeParticles - numActiveParticles;
+	memcpy(pSortedParticles + numActiveParticles, pParticles + numActiveParticles, sizeof(Particle) * numWaiting);
+	memcpy(pSortedVelocities + numActiveParticles, pVelocities + numActiveParticles, sizeof(Math::Vec2) * numWaiting);
+	memcpy(pSortedTimeBins + numActiveParticles, pTimeBins + numActiveParticles, sizeof(uint8) * numWaiting);
+	memcpy(pSortedParticleIDs + numActiveParticles, pParticleIDs + numActiveParticles, sizeof(uint32) * numWaiting);
+
+	std::swap(this->pParticles, this->pSortedParticles);
+	std::swap(this->pVelocities, this->pSortedVelocities);
+	std::swap(this->pTimeBins, this->pSortedTimeBins);
+	std::swap(this->pParticleIDs, this->pSortedParticleIDs);
+	this->numSortedParticles = numActiveParticles;
+
+	return finestBin;
+}
+
+void ParticleSimulation::PutQuietParticlesToSleep(void)
+{
+	const size_t numWereAwake = this->numAwakeParticles;
+	const uint numQuietSteps = this->numQuietSteps;
+	size_t numAwake = numWereAwake;
+
+	// move the quiet particles behind the awake ones
+	for (size_t i = 0; i < numAwake;)
+	{
+		if (this->pQuietSteps[i] < numQuietSteps)
+		{
+			i++;
+			continue;
+		}
+
+		numAwake--;
+		std::swap(this->pParticles[i], this->pParticles[numAwake]);
+		std::swap(this->pVelocities[i], this->pVelocities[numAwake]);
+		std::swap(this->pTimeBins[i], this->pTimeBins[numAwake]);
+		std::swap(this->pQuietSteps[i], this->pQuietSteps[numAwake]);
+		std::swap(this->pParticleIDs[i], this->pParticleIDs[numAwake]);
+	}
+
+	// the sleeping particles come to rest where they are
+	for (size_t i = numAwake; i < numWereAwake; i++)
+	{
+		this->pParticles[i].position = this->pParticles[i].nextPosition;
+		this->pVelocities[i] = Math::Vec2::zero;
+		Integrators::PositionVerlet::Reset(this->pParticles[i], this->pVelocities[i]);
+	}
+
+	// block timesteps swap the arrays with their sorted copies, which only get the awake particles
+	const size_t numFellAsleep = numWereAwake - numAwake;
+	memcpy(this->pSortedParticles + numAwake, this->pParticles + numAwake, sizeof(Particle) * numFellAsleep);
+	memcpy(this->pSortedVelocities + numAwake, this->pVelocities + numAwake, sizeof(Math::Vec2) * numFellAsleep);
+	memcpy(this->pSortedTimeBins + numAwake, this->pTimeBins + numAwake, sizeof(uint8) * numFellAsleep);
+	memcpy(this->pSortedParticleIDs + numAwake, this->pParticleIDs + numAwake, sizeof(uint32) * numFellAsleep);
+
+	// resting particles don't change their diagnostics until they wake up
+	const DiagnosticsConstants diagnosticsConstants = MakeDiagnosticsConstants(this->constants, this->constants.timestep, true, this->maxHistogramSpeed);
+	AccumulateDiagnostics(*this->pSleepingDiagnostics, this->pParticles, this->pVelocities, numAwake, numWereAwake, diagnosticsConstants);
+
+	// the awake particles that moved into the gaps aren't in the order of their bins anymore
+	if (numAwake < numWereAwake)
+		this->numSortedParticles = 0;
+
+	this->numAwakeParticles = numAwake;
+}
+
+float ParticleSimulation::EstimateTimestep(float accuracy, float softening) const
+{
+	const Math::Vec2 gravitySource = this->constants.gravitySource;
+	const float gravityStrength = fabsf(this->constants.gravityStrength);
+	const float lastTimestep = (this->isBlockStepping) ? this->lastBlockTimestep : this->constants.timestep;
+	const Particle* pParticles = this->pParticles;
+	const uint8* pTimeBins = (this->isBlockStepping) ? this->pTimeBins : nullptr;
+
+	// the last step already estimated the particles as they are
+	if (this->hasTimestepEstimate && accuracy == this->estimateAccuracy && softening == this->estimateSoftening)
+		return (this->estimatedTimestep2 == FLT_MAX) ? FLT_MAX : sqrtf(this->estimatedTimestep2);
+
+	// the smallest squared timestep of a part of the particles
+	const TimestepConstants timestepConstants = { gravitySource, gravityStrength, 1.0f / (lastTimestep * lastTimestep), accuracy, softening };
+	auto reduce = [=, &timestepConstants](size_t begin, size_t end) {
+		if (!pTimeBins)
+			return MinTimestep2Range(pParticles, begin, end, timestepConstants);
+
+		float minTimestep2 = FLT_MAX;
+		for (size_t i = begin; i < end; i++)
+		{
+			float particleTimestep = lastTimestep / static_cast<float>(1u << pTimeBins[i]);
+			minTimestep2 = std::min(minTimestep2, ParticleTimestep2(pParticles[i], gravitySource, gravityStrength, 1.0f / (particleTimestep * particleTimestep), accuracy, softening));
+		}
+
+		return minTimestep2;
+	};
+	auto combine = [](float lhs, float rhs) { return std::min(lhs, rhs); };
+
+	float minTimestep2 = (this->pThreadPool) ?
+		this->pThreadPool->ParallelReduce(this->numAwakeParticles, this->numMaxParticles, FLT_MAX, reduce, combine) :
+		reduce(0, this->numAwakeParticles);
+
+	// the particles that demand the shortest timestep take the finest substeps
+	return (minTimestep2 == FLT_MAX) ? FLT_MAX : sqrtf(minTimestep2) * static_cast<float>(1u << this->numTimeBins);
+}
+
+void ParticleSimulation::CalculateVelocities(Math::Vec2* pVelocities) const
+{
+	if (this->integrationMethod != PositionVerlet)
+	{
+		memcpy(pVelocities, this->pVelocities, sizeof(Math::Vec2) * this->numMaxParticles);
+		return;
+	}
+
+	const Integrators::StepConstants stepConstants = MakeStepConstants(this->constants, this->constants.timestep, this->constants.timestep);
+	const float timestep = (this->isBlockStepping) ? this->lastBlockTimestep : this->constants.timestep;
+	const Particle* pParticles = this->pParticles;
+	const Math::Vec2* pKeptVelocities = this->pVelocities;
+	const uint8* pTimeBins = (this->isBlockStepping) ? this->pTimeBins : nullptr;
+
+	// before the first step the particles rest on their start grid
+	const bool hasMoved = this->numSteps > 0;
+
+	// the same velocity as the diagnostics, d / h + a * h / 2
+	ForEachRange(this->pThreadPool, this->numAwakeParticles, this->numMaxParticles, [=](size_t begin, size_t end, uint) {
+		for (size_t i = begin; i < end; i++)
+		{
+			const Particle& particle = pParticles[i];
+			const float particleTimestep = (pTimeBins) ? timestep / static_cast<float>(1u << pTimeBins[i]) : timestep;
+			const Math::Vec2 displacement = Integrators::PositionVerlet::Displacement(particle, pKeptVelocities[i]);
+			const Math::Vec2 acceleration = Integrators::Acceleration(particle.nextPosition, stepConstants);
+
+			pVelocities[i] = (hasMoved) ? displacement / particleTimestep + acceleration * (particleTimestep * 0.5f) : Math::Vec2::zero;
+		}
+	});
+
+	for (size_t i = this->numAwakeParticles; i < this->numMaxParticles; i++)
+		pVelocities[i] = Math::Vec2::zero;
+}
+
+void ParticleSimulation::WriteSnapshot(SimulationSnapshot& snapshot) const
+{
+	snapshot.particles.resize(this->numMaxParticles);
+	memcpy(snapshot.particles.data(), this->pParticles, sizeof(Particle) * this->numMaxParticles);
+	snapshot.diagnostics = this->diagnostics;
+	snapshot.step = this->numSteps;
+}
+
+size_t ParticleSimulation::GetNumParticles(void) const
+{
+	return this->numMaxParticles;
+}
+const ParticleSimulation::Particle* ParticleSimulation::GetParticles(void) const
+{
+	return this->pParticles;
+}
+const Math::Vec2* ParticleSimulation::GetVelocities(void) const
+{
+	return this->pVelocities;
+}
+const uint32* ParticleSimulation::GetParticleIDs(void) const
+{
+	return this->pParticleIDs;
+}
+ParticleSimulation::IntegrationMethod ParticleSimulation::GetIntegrationMethod(void) const
+{
+	return this->integrationMethod;
+}
+const ParticleSimulation::SimulationConstants& ParticleSimulation::GetConstants(void) const
+{
+	return this->constants;
+}
+uint64 ParticleSimulation::GetNumSteps(void) const
+{
+	return this->numSteps;
+}
+uint64 ParticleSimulation::GetNumParticleUpdates(void) const
+{
+	return this->numParticleUpdates;
+}
+uint64 ParticleSimulation::GetNumSavedParticleUpdates(void) const
+{
+	return this->numSavedParticleUpdates;
+}
+size_t ParticleSimulation::GetNumAwakeParticles(void) const
+{
+	return this->numAwakeParticles;
+}
+uint64 ParticleSimulation::GetNumSkippedParticleUpdates(void) const
+{
+	return this->numSkippedParticleUpdates;
+}
+uint64 ParticleSimulation::GetNumDeferredParticleUpdates(void) const
+{
+	return this->numDeferredParticleUpdates;
+}
+uint64 ParticleSimulation::GetNumCollisions(void) const
+{
+	return this->numCollisions;
+}
+const ParticleSimulation::Diagnostics& ParticleSimulation::GetDiagnostics(void) const
+{
+	return this->diagnostics;
+}
+uint64 ParticleSimulation::GetStepTime(void) const
+{
+	return this->stepTime;
+}
+const MemoryArena* ParticleSimulation::GetMemoryArena(void) const
+{
+	return this->pArena;
+}
+uint64 ParticleSimulation::GetFirstTouchTime(void) const
+{
+	return this->firstTouchTime;
+}
+
+void ParticleSimulation::ApplyInputEvent(const InputEvent& event)
+{
+	switch (event.type)
+	{
+	case InputEvent::MouseClickedScreenSpace:
+		this->constants.gravitySource = event.position;
+		this->WakeParticles();
+		break;
+	case InputEvent::UpArrowPressed:
+		this->constants.gravityStrength += 0.1f;
+		this->WakeParticles();
+		LOG("Gravity strength: %f", this->constants.gravityStrength);
+		break;
+	case InputEvent::DownArrowPressed:
+		this->constants.gravityStrength -= 0.1f;
+		this->WakeParticles();
+		LOG("Gravity strength: %f", this->constants.gravityStrength);
+		break;
+	case InputEvent::RightArrowPressed:
+		this->constants.damping += 0.001f;
+		LOG("Damping strength: %f", 1.0f - this->constants.damping);
+		break;
+	case InputEvent::LeftArrowPressed:
+		this->constants.damping -= 0.001f;
+		LOG("Damping strength: %f", 1.0f - this->constants.damping);
+		break;
+	}
+}
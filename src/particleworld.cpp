@@ -0,0 +1,303 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "particlesimulation.h"
+#include "particleworld.h"
+#include "threadpool.h"
+#include "utils.h"
+
+/**
+ * @brief	This helper calculates the number of grid columns along every dimension
+ * @return	size_t is the smallest number of columns whose grid holds all particles
+ */
+static size_t GridColumns(size_t numParticles, uint numDims)
+{
+	size_t numColumns = std::max<size_t>(1, static_cast<size_t>(ceil(pow(static_cast<double>(numParticles), 1.0 / numDims))));
+
+	// pow may miss an exact root by one
+	auto capacity = [numDims](size_t columns) {
+		size_t count = 1;
+		for (uint d = 0; d < numDims; d++)
+			count *= columns;
+		return count;
+	};
+	while (capacity(numColumns) < numParticles)
+		numColumns++;
+	while (numColumns > 1 && capacity(numColumns - 1) >= numParticles)
+		numColumns--;
+
+	return numColumns;
+}
+
+template <class Vector>
+BasicParticleWorld<Vector>::BasicParticleWorld(size_t numMaxParticles, ThreadPool* pThreadPool, MemoryArena::PageSize pageSize) :
+	pThreadPool(pThreadPool),
+	numMaxParticles(numMaxParticles),
+	numParticles(0),
+	pArena(nullptr),
+	pParticles(nullptr),
+	pVelocities(nullptr),
+	numSteps(0),
+	nextSystemID(0),
+	timestep(Time::maxTimeStep),
+	pConstraints(nullptr),
+	numConstraintIterations(0)
+{
+	// all systems share one set of arrays
+	size_t particlesSize = MemoryArena::AlignedSize(sizeof(Particle) * numMaxParticles);
+	size_t velocitiesSize = MemoryArena::AlignedSize(sizeof(Vector) * numMaxParticles);
+
+	this->pArena = new MemoryArena(particlesSize + velocitiesSize, pageSize);
+	this->pParticles = this->pArena->Allocate<Particle>(numMaxParticles);
+	this->pVelocities = this->pArena->Allocate<Vector>(numMaxParticles);
+
+	// the reservation itself may have failed, which leaves the arena empty
+	if (!this->pParticles || !this->pVelocities)
+	{
+		ERR("The arrays of %zu particles don't fit into their memory arena", numMaxParticles);
+		SAFE_DELETE(this->pArena);
+
+		this->pParticles = nullptr;
+		this->pVelocities = nullptr;
+		this->numMaxParticles = 0;
+	}
+}
+
+template <class Vector>
+BasicParticleWorld<Vector>::~BasicParticleWorld()
+{
+	SAFE_DELETE(this->pArena);
+}
+
+template <class Vector>
+typename BasicParticleWorld<Vector>::SystemID BasicParticleWorld<Vector>::AddSystem(const SystemSettings& settings)
+{
+	if (!this->pParticles)
+	{
+		WARN("The world has no memory for a system of %zu particles", settings.numParticles);
+		return invalidSystem;
+	}
+
+	if (settings.numParticles > this->numMaxParticles - this->numParticles)
+	{
+		WARN("A system of %zu particles doesn't fit into the world (%zu of %zu particles in use)", settings.numParticles, this->numParticles, this->numMaxParticles);
+		return invalidSystem;
+	}
+
+	System system;
+	system.id = this->nextSystemID++;
+	system.begin = this->numParticles;
+	system.constants.numParticles = static_cast<uint>(settings.numParticles);
+	system.constants.gravitySource = settings.gravitySource;
+	system.constants.gravityStrength = settings.gravityStrength;
+	system.constants.lastTimestep = this->timestep;
+	system.constants.timestep = this->timestep;
+	system.constants.damping = settings.damping;
+
+	// the particles start at rest on a square (or cubic) grid
+	const size_t numColumns = GridColumns(settings.numParticles, numDimensions<Vector>);
+	const float spacing = settings.size / static_cast<float>(numColumns);
+	Vector corner = settings.origin;
+	for (uint d = 0; d < numDimensions<Vector>; d++)
+		Component(corner, d) -= 0.5f * settings.size;
+
+	for (size_t i = 0; i < settings.numParticles; i++)
+	{
+		Particle& particle = this->pParticles[system.begin + i];
+		size_t index = i;
+		for (uint d = 0; d < numDimensions<Vector>; d++, index /= numColumns)
+			Component(particle.position, d) = Component(corner, d) + spacing * static_cast<float>(index % numColumns);
+
+		particle.prevPosition = particle.position;
+		particle.nextPosition = particle.position;
+		this->pVelocities[system.begin + i] = Vector::zero;
+		Integrators::PositionVerlet::Reset(particle, this->pVelocities[system.begin + i]);
+	}
+
+	this->numParticles += settings.numParticles;
+	this->systems.push_back(system);
+	this->systemEnds.push_back(this->numParticles);
+	this->stepConstants.emplace_back();
+
+	return system.id;
+}
+
+template <class Vector>
+bool BasicParticleWorld<Vector>::RemoveSystem(SystemID system)
+{
+	size_t index = this->FindSystem(system);
+	if (index == this->systems.size())
+		return false;
+
+	// close the gap with the particles of the following systems
+	const size_t begin = this->systems[index].begin;
+	const size_t end = this->systemEnds[index];
+	const size_t count = end - begin;
+
+	memmove(this->pParticles + begin, this->pParticles + end, sizeof(Particle) * (this->numParticles - end));
+	memmove(this->pVelocities + begin, this->pVelocities + end, sizeof(Vector) * (this->numParticles - end));
+
+	for (size_t i = index + 1; i < this->systems.size(); i++)
+	{
+		this->systems[i].begin -= count;
+		this->systemEnds[i] -= count;
+	}
+
+	this->systems.erase(this->systems.begin() + index);
+	this->systemEnds.erase(this->systemEnds.begin() + index);
+	this->stepConstants.pop_back();
+	this->numParticles -= count;
+
+	return true;
+}
+
+template <class Vector>
+bool BasicParticleWorld<Vector>::SetGravity(SystemID system, Vector gravitySource, float gravityStrength)
+{
+	size_t index = this->FindSystem(system);
+	if (index == this->systems.size())
+		return false;
+
+	this->systems[index].constants.gravitySource = gravitySource;
+	this->systems[index].constants.gravityStrength = gravityStrength;
+
+	return true;
+}
+
+template <class Vector>
+bool BasicParticleWorld<Vector>::SetDamping(SystemID system, float damping)
+{
+	size_t index = this->FindSystem(system);
+	if (index == this->systems.size())
+		return false;
+
+	this->systems[index].constants.damping = damping;
+
+	return true;
+}
+
+template <class Vector>
+void BasicParticleWorld<Vector>::SetConstraints(BasicDistanceConstraints<Vector>* pConstraints, uint numIterations)
+{
+	this->pConstraints = pConstraints;
+	this->numConstraintIterations = numIterations;
+}
+
+template <class Vector>
+void BasicParticleWorld<Vector>::Step(float timestep)
+{
+	this->timestep = timestep;
+	this->numSteps++;
+
+	// the constants of every system are prepared once per step
+	for (size_t i = 0; i < this->systems.size(); i++)
+	{
+		SystemConstants& constants = this->systems[i].constants;
+		constants.lastTimestep = constants.timestep;
+		constants.timestep = timestep;
+
+		Integrators::BasicStepConstants<Vector>& stepConstants = this->stepConstants[i];
+		stepConstants.gravitySource = constants.gravitySource;
+		stepConstants.gravityStrength = constants.gravityStrength;
+		stepConstants.lastTimestep = constants.lastTimestep;
+		stepConstants.timestep = constants.timestep;
+		stepConstants.damping = powf(constants.damping, timestep / Time::maxTimeStep);
+	}
+
+	Particle* pParticles = this->pParticles;
+	Vector* pVelocities = this->pVelocities;
+	const size_t* pSystemEnds = this->systemEnds.data();
+	const size_t numSystems = this->systemEnds.size();
+	const Integrators::BasicStepConstants<Vector>* pStepConstants = this->stepConstants.data();
+
+	// every thread integrates the systems its part of the packed particles overlaps
+	auto integrate = [=](size_t begin, size_t end, uint) {
+		size_t system = std::upper_bound(pSystemEnds, pSystemEnds + numSystems, begin) - pSystemEnds;
+
+		for (; system < numSystems && begin < end; system++)
+		{
+			size_t systemEnd = std::min(end, pSystemEnds[system]);
+			Integrators::IntegrateRange<Integrators::PositionVerlet>(pParticles, pVelocities, begin, systemEnd, pStepConstants[system]);
+			begin = systemEnd;
+		}
+	};
+
+	if (this->pThreadPool)
+		this->pThreadPool->ParallelFor(this->numParticles, integrate);
+	else
+		integrate(0, this->numParticles, 0);
+
+	// the corrected positions become the velocities of the next step
+	if (this->pConstraints)
+		this->pConstraints->Solve(this->pParticles, this->numParticles, this->numConstraintIterations);
+}
+
+template <>
+void BasicParticleWorld<Math::Vec2>::WriteSnapshot(SimulationSnapshot& snapshot) const
+{
+	snapshot.particles.resize(this->numParticles);
+	memcpy(snapshot.particles.data(), this->pParticles, sizeof(Particle) * this->numParticles);
+	snapshot.diagnostics = ParticleSimulation::Diagnostics();
+	snapshot.step = this->numSteps;
+}
+
+template <class Vector>
+size_t BasicParticleWorld<Vector>::GetNumSystems(void) const
+{
+	return this->systems.size();
+}
+template <class Vector>
+size_t BasicParticleWorld<Vector>::GetNumParticles(void) const
+{
+	return this->numParticles;
+}
+template <class Vector>
+size_t BasicParticleWorld<Vector>::GetNumMaxParticles(void) const
+{
+	return this->numMaxParticles;
+}
+template <class Vector>
+uint64 BasicParticleWorld<Vector>::GetNumSteps(void) const
+{
+	return this->numSteps;
+}
+template <class Vector>
+const typename BasicParticleWorld<Vector>::Particle* BasicParticleWorld<Vector>::GetParticles(void) const
+{
+	return this->pParticles;
+}
+template <class Vector>
+const typename BasicParticleWorld<Vector>::Particle* BasicParticleWorld<Vector>::GetParticles(SystemID system, size_t& numParticles) const
+{
+	size_t index = this->FindSystem(system);
+	if (index == this->systems.size())
+	{
+		numParticles = 0;
+		return nullptr;
+	}
+
+	numParticles = this->systemEnds[index] - this->systems[index].begin;
+	return this->pParticles + this->systems[index].begin;
+}
+template <class Vector>
+const typename BasicParticleWorld<Vector>::SystemConstants* BasicParticleWorld<Vector>::GetConstants(SystemID system) const
+{
+	size_t index = this->FindSystem(system);
+
+	return (index < this->systems.size()) ? &this->systems[index].constants : nullptr;
+}
+
+template <class Vector>
+size_t BasicParticleWorld<Vector>::FindSystem(SystemID system) const
+{
+	// the ids grow with every added system, so the systems stay sorted by id
+	auto it = std::lower_bound(this->systems.begin(), this->systems.end(), system, [](const System& lhs, SystemID id) { return lhs.id < id; });
+
+	return (it != this->systems.end() && it->id == system) ? static_cast<size_t>(it - this->systems.begin()) : this->systems.size();
+}
+
+template class BasicParticleWorld<Math::Vec2>;
+template class BasicParticleWorld<Math::Vec3>;
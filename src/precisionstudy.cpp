@@ -0,0 +1,177 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "integrators.h"
+#include "particlesimulation.h"
+#include "precisionstudy.h"
+#include "threadpool.h"
+#include "utils.h"
+
+constexpr uint numRounds = 3;			/**< the throughput is the best of this many rounds */
+constexpr uint numCheckpoints = 3;		/**< the drift is compared after 1%, 10% and all orbit steps */
+constexpr float orbitRadius = 0.5f;
+constexpr float gravityStrength = 9.81f;
+
+/**
+ * @brief	This struct defines what was measured for one precision
+ */
+struct PrecisionResult
+{
+	const char* pName;
+	double stepTime;				/**< nanoseconds per particle and step */
+	double drifts[numCheckpoints];	/**< the distance to the long double orbit */
+};
+
+/**
+ * @brief	This helper measures how fast an integrator steps the particle grid of the simulation
+ * @return	double is the time per particle and step in nanoseconds
+ */
+template <class Integrator>
+static double MeasureThroughput(ThreadPool& threadPool, std::vector<ParticleSimulation::Particle>& particles, std::vector<Math::Vec2>& velocities,
+	uint numSteps, const Integrators::StepConstants& constants)
+{
+	ParticleSimulation::Particle* pParticles = particles.data();
+	Math::Vec2* pVelocities = velocities.data();
+	double bestTime = 0.0;
+
+	for (uint round = 0; round < numRounds; round++)
+	{
+		threadPool.ParallelFor(particles.size(), [=](size_t begin, size_t end, uint) {
+			for (size_t i = begin; i < end; i++)
+			{
+				float column = float(i % 1000);
+				float row = float(i / 50);
+
+				pParticles[i].position = { (column * 0.0009f) - 0.5f, (row * 0.0009f) - 0.5f };
+				pParticles[i].prevPosition = pParticles[i].position;
+				pParticles[i].nextPosition = pParticles[i].position;
+				pVelocities[i] = Math::Vec2::zero;
+				Integrator::Reset(pParticles[i], pVelocities[i]);
+			}
+		});
+
+		uint64 startTime = Time::Now();
+		for (uint step = 0; step < numSteps; step++)
+		{
+			threadPool.ParallelFor(particles.size(), [=, &constants](size_t begin, size_t end, uint) {
+				Integrators::IntegrateRange<Integrator>(pParticles, pVelocities, begin, end, constants);
+			});
+		}
+
+		double time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(particles.size()) * numSteps);
+		bestTime = (round == 0) ? time : std::min(bestTime, time);
+	}
+
+	return bestTime;
+}
+
+/**
+ * @brief	This helper integrates the reference orbit with an integrator
+ * 			The drift is the distance of the stored position to the long double orbit.
+ */
+template <class Integrator>
+static void MeasureDrift(const Integrators::StepConstants& constants, const Math::Vec2& start, const Math::Vec2& second,
+	const uint* pCheckpointSteps, const long double (*pReference)[2], double* pDrifts)
+{
+	ParticleSimulation::Particle particle;
+	particle.position = start;
+	particle.prevPosition = start;
+	particle.nextPosition = second;
+
+	Math::Vec2 velocity = Math::Vec2::zero;
+	Integrator::Reset(particle, velocity);
+
+	uint step = 0;
+	for (uint checkpoint = 0; checkpoint < numCheckpoints; checkpoint++)
+	{
+		for (; step < pCheckpointSteps[checkpoint]; step++)
+			Integrator::Integrate(particle, velocity, constants);
+
+		double dx = static_cast<double>(particle.nextPosition.x - pReference[checkpoint][0]);
+		double dy = static_cast<double>(particle.nextPosition.y - pReference[checkpoint][1]);
+		pDrifts[checkpoint] = sqrt(dx * dx + dy * dy);
+	}
+}
+
+bool PrecisionStudy::Run(size_t numParticles, uint numSteps, uint numOrbitSteps)
+{
+	ThreadPool threadPool;
+	std::vector<ParticleSimulation::Particle> particles(numParticles);
+	std::vector<Math::Vec2> velocities(numParticles);
+
+	// the constants of the simulation
+	Integrators::StepConstants constants;
+	constants.gravitySource = Math::Vec2::zero;
+	constants.gravityStrength = gravityStrength;
+	constants.lastTimestep = Time::maxTimeStep;
+	constants.timestep = Time::maxTimeStep;
+	constants.damping = 0.9948f;
+
+	PrecisionResult results[3] = { { "float", 0.0, {} }, { "compensated", 0.0, {} }, { "double", 0.0, {} } };
+	results[0].stepTime = MeasureThroughput<Integrators::FloatPositionVerlet>(threadPool, particles, velocities, numSteps, constants);
+	results[1].stepTime = MeasureThroughput<Integrators::CompensatedPositionVerlet>(threadPool, particles, velocities, numSteps, constants);
+	results[2].stepTime = MeasureThroughput<Integrators::DoublePositionVerlet>(threadPool, particles, velocities, numSteps, constants);
+
+	// the orbit starts on the circle at the speed that keeps it there, undamped
+	constants.damping = 1.0f;
+	const float timestep = Time::maxTimeStep;
+	const float angularStep = sqrtf(gravityStrength / orbitRadius) * timestep;
+	const Math::Vec2 start = { orbitRadius * cosf(-angularStep), orbitRadius * sinf(-angularStep) };
+	const Math::Vec2 second = { orbitRadius, 0.0f };
+
+	numOrbitSteps = std::max(numOrbitSteps, 100u);
+	const uint checkpointSteps[numCheckpoints] = { numOrbitSteps / 100, numOrbitSteps / 10, numOrbitSteps };
+
+	// the same integration in long doubles starting from the same floats
+	long double reference[numCheckpoints][2];
+	long double prevX = start.x, prevY = start.y, x = second.x, y = second.y;
+	const long double accelerationFactor = static_cast<long double>(timestep) * timestep;
+
+	uint step = 0;
+	for (uint checkpoint = 0; checkpoint < numCheckpoints; checkpoint++)
+	{
+		for (; step < checkpointSteps[checkpoint]; step++)
+		{
+			long double pull = gravityStrength / sqrtl(x * x + y * y);
+			long double nextX = x + (x - prevX) - x * pull * accelerationFactor;
+			long double nextY = y + (y - prevY) - y * pull * accelerationFactor;
+
+			prevX = x;
+			prevY = y;
+			x = nextX;
+			y = nextY;
+		}
+
+		reference[checkpoint][0] = x;
+		reference[checkpoint][1] = y;
+	}
+
+	MeasureDrift<Integrators::FloatPositionVerlet>(constants, start, second, checkpointSteps, reference, results[0].drifts);
+	MeasureDrift<Integrators::CompensatedPositionVerlet>(constants, start, second, checkpointSteps, reference, results[1].drifts);
+	MeasureDrift<Integrators::DoublePositionVerlet>(constants, start, second, checkpointSteps, reference, results[2].drifts);
+
+	const double numRevolutions = numOrbitSteps * angularStep / (2.0 * M_PI);
+	printf("Position Verlet of %zu particles for %u steps, %u threads, orbit of radius %.2f for %u steps (%.0f revolutions)\n",
+		numParticles, numSteps, threadPool.GetNumThreads(), orbitRadius, numOrbitSteps, numRevolutions);
+	printf("%-12s %12s %8s %14s %14s %14s\n", "precision", "ns/particle", "cost", "drift 1%", "drift 10%", "drift 100%");
+
+	for (const PrecisionResult& result : results)
+	{
+		printf("%-12s %12.3f %7.2fx %14.3e %14.3e %14.3e\n", result.pName, result.stepTime, result.stepTime / results[0].stepTime,
+			result.drifts[0], result.drifts[1], result.drifts[2]);
+	}
+
+	// the compensation must not make it worse
+	if (results[1].drifts[numCheckpoints - 1] > results[0].drifts[numCheckpoints - 1])
+	{
+		ERR("The compensated positions drifted further than the plain floats");
+		return false;
+	}
+
+	return true;
+}
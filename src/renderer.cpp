@@ -1,10 +1,13 @@
 // EXTERNAL INCLUDES
 #include <cstdio>
 #include <cwchar>
+#include <vector>
 #include <d3dcompiler.h>
 #include <dxgi1_6.h>
 // INTERNAL INCLUDES
+#include "d3dshadercompiler.h"
 #include "renderer.h"
+#include "shadercache.h"
 #include "types.h"
 
 #pragma warning(push)
@@ -25,8 +28,13 @@ Renderer::Renderer() :
 	pDevice(nullptr),
 	pContext(nullptr),
 	pBackbuffer(nullptr),
-	pDepthBuffer(nullptr)
-{ }
+	pDepthBuffer(nullptr),
+	pShaderCompiler(new D3DShaderCompiler()),
+	pShaderCache(nullptr)
+{
+	// compiled shaders are kept next to the shader files
+	this->pShaderCache = new ShaderCache("ShaderCache", this->pShaderCompiler);
+}
 Renderer::~Renderer()
 {
 	// Clean up all the renderer vars
@@ -38,6 +46,9 @@ Renderer::~Renderer()
 	SAFE_RELEASE(this->pDevice);
 	LOG("Removing D3D11DeviceContext");
 	SAFE_RELEASE(this->pContext);
+	LOG("Removing ShaderCache");
+	SAFE_DELETE(this->pShaderCache);
+	SAFE_DELETE(this->pShaderCompiler);
 	LOG("Removing Buffers");
 	SAFE_RELEASE(this->pBackbuffer);
 	SAFE_RELEASE(this->pDepthBuffer);
@@ -211,34 +222,9 @@ HRESULT Renderer::CreateUnorderedAccessView(ID3D11Buffer** ppBuffer, UINT iNumEl
 
 HRESULT Renderer::CompileShaderFromFile(const char* szFileName, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut)
 {
-	LOG("Compiling shader (%s -> %s)", szFileName, szEntryPoint);
-
 	if (!ppBlobOut)
 		return E_INVALIDARG;
 
-	// Get the current executable path
-	char str[MAX_PATH] = { 0 };
-	HRESULT hr = GetCurrentDirectoryA(sizeof(str), str);
-
-	if (FAILED(hr))
-		return hr;
-
-	// read the string length of the path and the filename
-	size_t pathLen = strlen(str);
-	size_t fileNameLen = strlen(szFileName);
-
-	// check if the path length + filename length + 2 extra symbols
-	// is smaller than the MAX_PATH var
-	if ((pathLen + fileNameLen + 2) < MAX_PATH)
-	{
-		// add backslash to the current path
-		str[pathLen] = '\\';
-		// copy the filename in
-		memcpy(str + pathLen + 1, szFileName, fileNameLen);
-		// set the string terminator at the end
-		str[pathLen + fileNameLen + 1] = '\0';
-	}
-
 	DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
 
 #ifdef _DEBUG
@@ -252,29 +238,17 @@ HRESULT Renderer::CompileShaderFromFile(const char* szFileName, LPCSTR szEntryPo
 	dwShaderFlags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
 
-	ID3DBlob* pErrorBlob = nullptr;
-
-#if D3D_COMPILER_VERSION >= 46
+	// the flags are part of the cache key, debug and release blobs never mix
+	std::vector<byte> bytecode;
+	if (!this->pShaderCache->Load(szFileName, szEntryPoint, szShaderModel, dwShaderFlags, bytecode))
+		return E_FAIL;
 
-	// convert the path to wide chars (because D3DCompileFromFile demands it)
-	WCHAR path[MAX_PATH];
-	mbstowcs(path, str, pathLen + fileNameLen + 2);
+	HRESULT hr = D3DCreateBlob(bytecode.size(), ppBlobOut);
 
-	hr = D3DCompileFromFile(path, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, szEntryPoint, szShaderModel,
-		dwShaderFlags, 0, ppBlobOut, &pErrorBlob);
-#else
-	hr = D3DX11CompileFromFile(str, nullptr, nullptr, szEntryPoint, szShaderModel,
-		dwShaderFlags, 0, nullptr, ppBlobOut, &pErrorBlob, nullptr);
-#endif
 	if (FAILED(hr))
-	{
-		if (pErrorBlob)
-			LOG((char*)pErrorBlob->GetBufferPointer());
-
-		SAFE_RELEASE(pErrorBlob);
 		return hr;
-	}
-	SAFE_RELEASE(pErrorBlob);
+
+	memcpy((*ppBlobOut)->GetBufferPointer(), bytecode.data(), bytecode.size());
 
 	return S_OK;
 }
@@ -0,0 +1,184 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "scalingstudy.h"
+#include "slabsimulation.h"
+#include "sockettransport.h"
+#include "utils.h"
+
+/**
+ * @brief	This struct defines what a rank measured in a run
+ */
+struct RankResult
+{
+	uint64 runTime;
+	uint64 integrationTime;
+	uint64 exchangeTime;
+	uint64 numParticles;
+	uint64 numMigratedParticles;
+};
+
+/**
+ * @brief	This struct defines the result of a run over all ranks
+ */
+struct RunResult
+{
+	double stepTime;			/**< milliseconds per step of the slowest rank */
+	double integrationTime;		/**< milliseconds per step the slowest rank integrated */
+	double exchangeTime;		/**< mean milliseconds per step the ranks spent exchanging */
+	double imbalance;			/**< the largest number of particles of a rank over the mean */
+	double numMigratedParticles;	/**< particles that changed their rank per step */
+};
+
+#if !defined(_WIN32)
+
+/**
+ * @brief	This helper waits until every rank arrived
+ * 			The ranks report to rank 0 first and are released in a second round.
+ */
+static bool Barrier(Transport& transport)
+{
+	std::vector<byte> empty, received;
+	bool succeeded = true;
+
+	for (uint round = 0; round < 2; round++)
+	{
+		if (transport.GetRank() == 0)
+		{
+			for (uint rank = 1; rank < transport.GetNumRanks(); rank++)
+				succeeded &= transport.Exchange(rank, empty, received);
+		}
+		else
+			succeeded &= transport.Exchange(0, empty, received);
+	}
+
+	return succeeded;
+}
+
+/**
+ * @brief	This helper runs the slab simulation on a number of ranks
+ * 			Only rank 0 returns, the other ranks exit when they handed over their results.
+ */
+static bool RunRanks(uint numRanks, size_t numParticles, uint numSteps, RunResult& result)
+{
+	SocketTransport* pTransport = SocketTransport::Spawn(numRanks);
+	if (!pTransport)
+		return false;
+
+	SlabSimulation slab(pTransport, -0.5f, 0.5f);
+	slab.SetupParticles(numParticles);
+
+	// all ranks start measuring together
+	bool succeeded = Barrier(*pTransport);
+
+	uint64 startTime = Time::Now();
+	for (uint step = 0; step < numSteps && succeeded; step++)
+		succeeded &= slab.Step(Time::maxTimeStep);
+
+	RankResult rankResult = { Time::Now() - startTime, slab.GetIntegrationTime(), slab.GetExchangeTime(), slab.GetNumParticles(), slab.GetNumMigratedParticles() };
+
+	// rank 0 collects the results
+	std::vector<RankResult> rankResults(numRanks);
+	std::vector<byte> sendData(sizeof(RankResult)), receiveData;
+	memcpy(sendData.data(), &rankResult, sizeof(RankResult));
+	rankResults[0] = rankResult;
+
+	if (pTransport->GetRank() != 0)
+	{
+		succeeded &= pTransport->Exchange(0, sendData, receiveData);
+		delete pTransport;
+
+		// the forked ranks must not run the destructors of the parent's state
+		_exit(succeeded ? 0 : 1);
+	}
+
+	for (uint rank = 1; rank < numRanks; rank++)
+	{
+		succeeded &= pTransport->Exchange(rank, std::vector<byte>(), receiveData) && receiveData.size() == sizeof(RankResult);
+		if (receiveData.size() == sizeof(RankResult))
+			memcpy(&rankResults[rank], receiveData.data(), sizeof(RankResult));
+	}
+
+	succeeded &= pTransport->WaitForRanks();
+	delete pTransport;
+
+	uint64 maxRunTime = 0, maxIntegrationTime = 0, sumExchangeTime = 0, maxParticles = 0, sumParticles = 0, sumMigratedParticles = 0;
+	for (const RankResult& rank : rankResults)
+	{
+		maxRunTime = std::max(maxRunTime, rank.runTime);
+		maxIntegrationTime = std::max(maxIntegrationTime, rank.integrationTime);
+		sumExchangeTime += rank.exchangeTime;
+		maxParticles = std::max(maxParticles, rank.numParticles);
+		sumParticles += rank.numParticles;
+		sumMigratedParticles += rank.numMigratedParticles;
+	}
+
+	result.stepTime = maxRunTime / 1000.0 / numSteps;
+	result.integrationTime = maxIntegrationTime / 1000.0 / numSteps;
+	result.exchangeTime = sumExchangeTime / 1000.0 / numSteps / numRanks;
+	result.imbalance = (sumParticles > 0) ? static_cast<double>(maxParticles) * numRanks / sumParticles : 1.0;
+	result.numMigratedParticles = static_cast<double>(sumMigratedParticles) / numSteps;
+
+	return succeeded;
+}
+
+bool ScalingStudy::Run(uint maxRanks, size_t numParticles, uint numSteps)
+{
+	std::vector<uint> rankCounts;
+	for (uint numRanks = 1; numRanks < maxRanks; numRanks *= 2)
+		rankCounts.push_back(numRanks);
+	rankCounts.push_back(std::max(maxRanks, 1u));
+
+	const char* pHeader = "%6s %10s %10s %9s %11s %14s %13s %10s %14s\n";
+	const char* pRow = "%6u %10zu %10.3f %9.2f %10.0f%% %14.3f %13.3f %10.2f %14.1f\n";
+	bool succeeded = true;
+
+	for (uint weak = 0; weak < 2; weak++)
+	{
+		printf("%s scaling, %zu particles %s, %u steps\n", (weak) ? "Weak" : "Strong", numParticles, (weak) ? "per rank" : "in total", numSteps);
+		printf(pHeader, "ranks", "particles", "ms/step", "speedup", "efficiency", "integrate ms", "exchange ms", "imbalance", "migrated/step");
+
+		double baseStepTime = 0.0;
+		for (uint numRanks : rankCounts)
+		{
+			RunResult result;
+			size_t numRunParticles = (weak) ? numParticles * numRanks : numParticles;
+
+			if (!RunRanks(numRanks, numRunParticles, numSteps, result))
+			{
+				ERR("The run on %u ranks failed", numRanks);
+				succeeded = false;
+				continue;
+			}
+
+			if (numRanks == 1)
+				baseStepTime = result.stepTime;
+
+			// weak scaling is ideal if the step time stays the same
+			double speedup = (result.stepTime > 0.0) ? baseStepTime / result.stepTime : 0.0;
+			double efficiency = (weak) ? speedup : speedup / numRanks;
+
+			printf(pRow, numRanks, numRunParticles, result.stepTime, speedup, 100.0 * efficiency,
+				result.integrationTime, result.exchangeTime, result.imbalance, result.numMigratedParticles);
+		}
+	}
+
+	return succeeded;
+}
+
+#else
+
+bool ScalingStudy::Run(uint, size_t, uint)
+{
+	ERR("The scaling study needs POSIX processes");
+	return false;
+}
+
+#endif
@@ -0,0 +1,424 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "segmentbvh.h"
+#include "threadpool.h"
+#include "utils.h"
+
+constexpr uint maxStackSize = 64;				/**< the deepest hierarchy a sweep can traverse (median splits stay far below) */
+constexpr size_t minParallelSegments = 4096;	/**< subtrees with fewer segments aren't split any further before the parallel build */
+constexpr float wallOffset = 1e-5f;				/**< the distance a bouncing particle keeps from the wall */
+
+/**
+ * @brief	This struct defines the bounds of segments and of their centers
+ */
+struct SegmentBounds
+{
+	Math::Vec2 boundsMin;
+	Math::Vec2 boundsMax;
+	Math::Vec2 centerMin;
+	Math::Vec2 centerMax;
+};
+
+/**
+ * @brief	This helper creates bounds of no segments
+ */
+static SegmentBounds EmptyBounds(void)
+{
+	return { { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX }, { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX } };
+}
+
+/**
+ * @brief	This helper adds a range of segments to bounds
+ */
+static void GrowBounds(SegmentBounds& bounds, const SegmentBVH::Segment* pSegments, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		const SegmentBVH::Segment& segment = pSegments[i];
+		Math::Vec2 center = (segment.a + segment.b) * 0.5f;
+
+		bounds.boundsMin = { std::min(bounds.boundsMin.x, std::min(segment.a.x, segment.b.x)), std::min(bounds.boundsMin.y, std::min(segment.a.y, segment.b.y)) };
+		bounds.boundsMax = { std::max(bounds.boundsMax.x, std::max(segment.a.x, segment.b.x)), std::max(bounds.boundsMax.y, std::max(segment.a.y, segment.b.y)) };
+		bounds.centerMin = { std::min(bounds.centerMin.x, center.x), std::min(bounds.centerMin.y, center.y) };
+		bounds.centerMax = { std::max(bounds.centerMax.x, center.x), std::max(bounds.centerMax.y, center.y) };
+	}
+}
+
+/**
+ * @brief	This helper combines two bounds
+ */
+static SegmentBounds CombineBounds(const SegmentBounds& lhs, const SegmentBounds& rhs)
+{
+	return { { std::min(lhs.boundsMin.x, rhs.boundsMin.x), std::min(lhs.boundsMin.y, rhs.boundsMin.y) },
+		{ std::max(lhs.boundsMax.x, rhs.boundsMax.x), std::max(lhs.boundsMax.y, rhs.boundsMax.y) },
+		{ std::min(lhs.centerMin.x, rhs.centerMin.x), std::min(lhs.centerMin.y, rhs.centerMin.y) },
+		{ std::max(lhs.centerMax.x, rhs.centerMax.x), std::max(lhs.centerMax.y, rhs.centerMax.y) } };
+}
+
+/**
+ * @brief	This helper calculates where a sweep enters a box
+ * @param	invDirection is the inverse of the sweep (per component)
+ * @param	tMax is the fraction of the sweep that is still of interest
+ * @param	tEntry is the returned fraction the sweep enters the box at
+ * @return	true if the sweep enters the box before tMax
+ */
+static inline bool SweepBox(const Math::Vec2& boundsMin, const Math::Vec2& boundsMax, const Math::Vec2& from, const Math::Vec2& invDirection, float tMax, float& tEntry)
+{
+	float t1x = (boundsMin.x - from.x) * invDirection.x, t2x = (boundsMax.x - from.x) * invDirection.x;
+	float t1y = (boundsMin.y - from.y) * invDirection.y, t2y = (boundsMax.y - from.y) * invDirection.y;
+
+	tEntry = std::max(std::max(std::min(t1x, t2x), std::min(t1y, t2y)), 0.0f);
+	float tExit = std::min(std::min(std::max(t1x, t2x), std::max(t1y, t2y)), tMax);
+
+	return tEntry <= tExit;
+}
+
+/**
+ * @brief	This helper intersects a sweep with a segment
+ * @param	tBest is the fraction of the closest hit so far, it is replaced by a closer hit
+ * @return	true if the segment is hit before tBest
+ */
+static inline bool SweepSegment(const SegmentBVH::Segment& segment, const Math::Vec2& from, const Math::Vec2& direction, float& tBest, Math::Vec2& normal)
+{
+	Math::Vec2 edge = segment.b - segment.a;
+	Math::Vec2 offset = segment.a - from;
+	float denominator = direction.x * edge.y - direction.y * edge.x;
+	float tNumerator = offset.x * edge.y - offset.y * edge.x;
+	float uNumerator = offset.x * direction.y - offset.y * direction.x;
+
+	// the fractions are compared before they are divided (a sweep along the wall never crosses it)
+	if (denominator < 0.0f)
+	{
+		denominator = -denominator;
+		tNumerator = -tNumerator;
+		uNumerator = -uNumerator;
+	}
+	if (!(denominator > 0.0f) || tNumerator < 0.0f || tNumerator >= tBest * denominator || uNumerator < 0.0f || uNumerator > denominator)
+		return false;
+
+	// the normal faces the side the sweep comes from
+	float length = sqrtf(edge.x * edge.x + edge.y * edge.y);
+	normal = { -edge.y / length, edge.x / length };
+	if (normal.x * direction.x + normal.y * direction.y > 0.0f)
+		normal = { -normal.x, -normal.y };
+
+	tBest = std::min(tNumerator / denominator, tBest);
+	return true;
+}
+
+/**
+ * @brief	This helper reflects a vector at a wall
+ */
+static inline Math::Vec2 Reflect(const Math::Vec2& vector, const Math::Vec2& normal)
+{
+	return vector - normal * (2.0f * (vector.x * normal.x + vector.y * normal.y));
+}
+
+SegmentBVH::SegmentBVH() :
+	depth(0),
+	buildTime(0)
+{
+
+}
+
+void SegmentBVH::AddSegment(Math::Vec2 a, Math::Vec2 b)
+{
+	this->segments.push_back({ a, b });
+}
+
+void SegmentBVH::Clear(void)
+{
+	this->segments.clear();
+	this->nodes.clear();
+	this->depth = 0;
+}
+
+void SegmentBVH::Build(ThreadPool* pThreadPool)
+{
+	uint64 startTime = Time::Now();
+
+	const size_t numSegments = this->segments.size();
+	this->nodes.resize((numSegments > 0) ? NumNodes(numSegments) : 0);
+	this->depth = 0;
+
+	if (numSegments == 0)
+	{
+		this->buildTime = Time::Now() - startTime;
+		return;
+	}
+
+	// split the first levels until every thread has a few subtrees to build
+	const uint numThreads = (pThreadPool) ? pThreadPool->GetNumThreads() : 1;
+	const Segment* pSegments = this->segments.data();
+	std::vector<Subtree> subtrees = { { 0, numSegments, 0, 0 } };
+	std::vector<Subtree> pending;
+
+	while (!subtrees.empty() && subtrees.size() + pending.size() < 4 * numThreads)
+	{
+		std::vector<Subtree> children;
+
+		for (const Subtree& subtree : subtrees)
+		{
+			const size_t count = subtree.end - subtree.begin;
+			if (count < minParallelSegments)
+			{
+				pending.push_back(subtree);
+				continue;
+			}
+
+			auto reduce = [=](size_t begin, size_t end) {
+				SegmentBounds bounds = EmptyBounds();
+				GrowBounds(bounds, pSegments, subtree.begin + begin, subtree.begin + end);
+				return bounds;
+			};
+			SegmentBounds bounds = (pThreadPool) ? pThreadPool->ParallelReduce(count, EmptyBounds(), reduce, CombineBounds) : reduce(0, count);
+
+			Subtree left, right;
+			this->SplitSegments(subtree, bounds.centerMin, bounds.centerMax, left, right);
+
+			Node& node = this->nodes[subtree.node];
+			node.boundsMin = bounds.boundsMin;
+			node.boundsMax = bounds.boundsMax;
+			node.offset = static_cast<uint32>(right.node);
+			node.count = 0;
+
+			children.push_back(left);
+			children.push_back(right);
+			this->depth = std::max(this->depth, subtree.depth + 1);
+		}
+
+		subtrees.swap(children);
+	}
+
+	pending.insert(pending.end(), subtrees.begin(), subtrees.end());
+
+	// the subtrees own disjoint segments and nodes
+	std::vector<uint> depths(numThreads, 0);
+	auto build = [&](size_t begin, size_t end, uint threadIndex) {
+		for (size_t i = begin; i < end; i++)
+			depths[threadIndex] = std::max(depths[threadIndex], this->BuildSubtree(pending[i]));
+	};
+
+	if (pThreadPool)
+		pThreadPool->ParallelFor(pending.size(), build);
+	else
+		build(0, pending.size(), 0);
+
+	for (uint subtreeDepth : depths)
+		this->depth = std::max(this->depth, subtreeDepth);
+
+	this->buildTime = Time::Now() - startTime;
+}
+
+bool SegmentBVH::Sweep(const Math::Vec2& from, const Math::Vec2& to, Hit& hit, uint64* pNumVisitedNodes) const
+{
+	if (this->nodes.empty())
+		return false;
+
+	const Math::Vec2 direction = to - from;
+	const Math::Vec2 invDirection = { (direction.x != 0.0f) ? 1.0f / direction.x : FLT_MAX, (direction.y != 0.0f) ? 1.0f / direction.y : FLT_MAX };
+	const Node* pNodes = this->nodes.data();
+	const Segment* pSegments = this->segments.data();
+
+	float tBest = 1.0f;
+	bool isHit = false;
+	uint64 numVisitedNodes = 1;
+
+	float tEntry;
+	uint32 stack[maxStackSize];
+	uint stackSize = 0;
+	if (SweepBox(pNodes[0].boundsMin, pNodes[0].boundsMax, from, invDirection, tBest, tEntry))
+		stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = pNodes[stack[--stackSize]];
+
+		if (node.count > 0)
+		{
+			for (uint32 i = node.offset; i < node.offset + node.count; i++)
+				isHit |= SweepSegment(pSegments[i], from, direction, tBest, hit.normal);
+			continue;
+		}
+
+		// a closer hit may have been found since the node was pushed
+		const uint32 left = static_cast<uint32>(&node - pNodes) + 1;
+		const uint32 right = node.offset;
+		float tLeft, tRight;
+		bool isLeftHit = SweepBox(pNodes[left].boundsMin, pNodes[left].boundsMax, from, invDirection, tBest, tLeft);
+		bool isRightHit = SweepBox(pNodes[right].boundsMin, pNodes[right].boundsMax, from, invDirection, tBest, tRight);
+		numVisitedNodes += 2;
+
+		// the nearer child is traversed first
+		if (isLeftHit && isRightHit)
+		{
+			stack[stackSize++] = (tLeft <= tRight) ? right : left;
+			stack[stackSize++] = (tLeft <= tRight) ? left : right;
+		}
+		else if (isLeftHit)
+			stack[stackSize++] = left;
+		else if (isRightHit)
+			stack[stackSize++] = right;
+	}
+
+	if (pNumVisitedNodes)
+		*pNumVisitedNodes += numVisitedNodes;
+
+	hit.t = tBest;
+	return isHit;
+}
+
+bool SegmentBVH::SweepAll(const Math::Vec2& from, const Math::Vec2& to, Hit& hit) const
+{
+	const Math::Vec2 direction = to - from;
+	float tBest = 1.0f;
+	bool isHit = false;
+
+	for (const Segment& segment : this->segments)
+		isHit |= SweepSegment(segment, from, direction, tBest, hit.normal);
+
+	hit.t = tBest;
+	return isHit;
+}
+
+size_t SegmentBVH::Collide(Particle* pParticles, Math::Vec2* pVelocities, size_t begin, size_t end, float damping) const
+{
+	size_t numCollisions = 0;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		Particle& particle = pParticles[i];
+		Math::Vec2 from = particle.position;
+		Math::Vec2 to = particle.nextPosition;
+		Math::Vec2 displacement = to - from;
+		Hit hit;
+
+		if (!this->Sweep(from, to, hit))
+			continue;
+
+		// every bounce reflects the rest of the step and sweeps it again
+		uint bounce = 0;
+		do
+		{
+			Math::Vec2 contact = from + (to - from) * hit.t + hit.normal * wallOffset;
+			Math::Vec2 rest = Reflect((to - from) * (1.0f - hit.t), hit.normal) * damping;
+
+			displacement = Reflect(displacement, hit.normal) * damping;
+			if (pVelocities)
+				pVelocities[i] = Reflect(pVelocities[i], hit.normal) * damping;
+
+			from = contact;
+			to = contact + rest;
+			bounce++;
+		} while (this->Sweep(from, to, hit) && bounce < maxBounces);
+
+		// a particle that is still trapped between walls comes to rest at the last one
+		if (bounce == maxBounces && this->Sweep(from, to, hit))
+		{
+			to = from;
+			displacement = Math::Vec2::zero;
+			if (pVelocities)
+				pVelocities[i] = Math::Vec2::zero;
+		}
+
+		particle.nextPosition = to;
+		if (!pVelocities)
+			particle.position = to - displacement;
+
+		numCollisions++;
+	}
+
+	return numCollisions;
+}
+
+size_t SegmentBVH::GetNumSegments(void) const
+{
+	return this->segments.size();
+}
+size_t SegmentBVH::GetNumNodes(void) const
+{
+	return this->nodes.size();
+}
+uint SegmentBVH::GetDepth(void) const
+{
+	return this->depth;
+}
+uint64 SegmentBVH::GetBuildTime(void) const
+{
+	return this->buildTime;
+}
+
+size_t SegmentBVH::NumNodes(size_t numSegments)
+{
+	// the leaves of n and n + 1 segments only depend on the leaves of n / 2 and n / 2 + 1 segments
+	size_t leaves = 1, nextLeaves = 1;
+	uint numHalvings = 0;
+	while ((numSegments >> numHalvings) > maxLeafSegments)
+		numHalvings++;
+
+	if ((numSegments >> numHalvings) == maxLeafSegments)
+		nextLeaves = 2;
+
+	for (uint halving = numHalvings; halving-- > 0;)
+	{
+		const size_t count = numSegments >> halving;
+		const size_t halfLeaves = leaves, halfNextLeaves = nextLeaves;
+
+		// an even count splits into two equal halves, an odd one into n / 2 and n / 2 + 1
+		if ((count & 1) == 0)
+		{
+			leaves = 2 * halfLeaves;
+			nextLeaves = halfLeaves + halfNextLeaves;
+		}
+		else
+		{
+			leaves = halfLeaves + halfNextLeaves;
+			nextLeaves = 2 * halfNextLeaves;
+		}
+	}
+
+	return 2 * leaves - 1;
+}
+
+uint SegmentBVH::BuildSubtree(const Subtree& subtree)
+{
+	SegmentBounds bounds = EmptyBounds();
+	GrowBounds(bounds, this->segments.data(), subtree.begin, subtree.end);
+
+	Node& node = this->nodes[subtree.node];
+	node.boundsMin = bounds.boundsMin;
+	node.boundsMax = bounds.boundsMax;
+
+	if (subtree.end - subtree.begin <= maxLeafSegments)
+	{
+		node.offset = static_cast<uint32>(subtree.begin);
+		node.count = static_cast<uint32>(subtree.end - subtree.begin);
+		return subtree.depth;
+	}
+
+	Subtree left, right;
+	this->SplitSegments(subtree, bounds.centerMin, bounds.centerMax, left, right);
+	node.offset = static_cast<uint32>(right.node);
+	node.count = 0;
+
+	return std::max(this->BuildSubtree(left), this->BuildSubtree(right));
+}
+
+void SegmentBVH::SplitSegments(const Subtree& subtree, const Math::Vec2& centerMin, const Math::Vec2& centerMax, Subtree& left, Subtree& right)
+{
+	// the median center along the longer axis of the centers
+	const bool isAxisX = (centerMax.x - centerMin.x) >= (centerMax.y - centerMin.y);
+	const size_t middle = subtree.begin + (subtree.end - subtree.begin) / 2;
+
+	std::nth_element(this->segments.begin() + subtree.begin, this->segments.begin() + middle, this->segments.begin() + subtree.end,
+		[isAxisX](const Segment& lhs, const Segment& rhs) {
+			return (isAxisX) ? (lhs.a.x + lhs.b.x) < (rhs.a.x + rhs.b.x) : (lhs.a.y + lhs.b.y) < (rhs.a.y + rhs.b.y);
+		});
+
+	left = { subtree.begin, middle, subtree.node + 1, subtree.depth + 1 };
+	right = { middle, subtree.end, subtree.node + 1 + NumNodes(middle - subtree.begin), subtree.depth + 1 };
+}
@@ -0,0 +1,224 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "obstaclefield.h"
+#include "particlesimulation.h"
+#include "segmentbvh.h"
+#include "segmentstudy.h"
+#include "threadpool.h"
+#include "utils.h"
+
+typedef SegmentBVH::Particle Particle;
+
+constexpr uint numRounds = 3;					/**< a measurement is repeated this many times, the fastest run counts */
+constexpr uint64 maxReferenceTests = 200000000;	/**< the sweeps against every wall are measured on as many particles as this many wall tests allow */
+constexpr float ringRadius = 0.1f;				/**< the radius of the ring of walls around the attractor */
+constexpr uint numRingSegments = 256;			/**< the walls the ring is made of */
+constexpr float wallDamping = 0.8f;				/**< the fraction of the speed a particle keeps on a bounce */
+constexpr float capsuleRadius = 0.002f;			/**< the thickness of the walls as capsules and the radius of a particle colliding with them */
+
+/**
+ * @brief	This helper scatters short walls over the unit square around the origin
+ * 			The walls shrink with their number, so they add up to the same length and about as many steps hit one.
+ */
+static void AddRandomSegments(SegmentBVH& walls, uint numSegments, std::mt19937& generator)
+{
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	const float length = 100.0f / static_cast<float>(numSegments);
+
+	for (uint i = 0; i < numSegments; i++)
+	{
+		Math::Vec2 a = { coordinate(generator), coordinate(generator) };
+		walls.AddSegment(a, a + Math::Vec2{ coordinate(generator), coordinate(generator) } * length);
+	}
+}
+
+/**
+ * @brief	This helper scatters particles over the unit square, every one moves by a small random displacement
+ */
+static void ScatterParticles(std::vector<Particle>& particles, std::mt19937& generator)
+{
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> displacement(-0.01f, 0.01f);
+
+	for (Particle& particle : particles)
+	{
+		particle.position = { coordinate(generator), coordinate(generator) };
+		particle.nextPosition = particle.position + Math::Vec2{ displacement(generator), displacement(generator) };
+		particle.prevPosition = Math::Vec2::zero;
+	}
+}
+
+/**
+ * @brief	This helper sweeps the steps of particles through the hierarchy or against every wall on the pool
+ * @param	numHits is the returned number of steps that hit a wall
+ * @param	numVisitedNodes is the returned number of nodes the traversals visited (0 against every wall)
+ * @return	double is the time per sweep in nanoseconds
+ */
+static double MeasureSweep(ThreadPool& threadPool, const SegmentBVH& walls, const std::vector<Particle>& particles, size_t numParticles, bool isHierarchy,
+	uint64& numHits, uint64& numVisitedNodes)
+{
+	double bestTime = 0.0;
+
+	for (uint round = 0; round < numRounds; round++)
+	{
+		std::vector<uint64> hits(threadPool.GetNumThreads(), 0), visitedNodes(threadPool.GetNumThreads(), 0);
+		const Particle* pParticles = particles.data();
+
+		uint64 startTime = Time::Now();
+		threadPool.ParallelFor(numParticles, [&](size_t begin, size_t end, uint threadIndex) {
+			uint64 threadHits = 0, threadVisitedNodes = 0;
+			for (size_t i = begin; i < end; i++)
+			{
+				SegmentBVH::Hit hit;
+				bool isHit = (isHierarchy) ? walls.Sweep(pParticles[i].position, pParticles[i].nextPosition, hit, &threadVisitedNodes)
+					: walls.SweepAll(pParticles[i].position, pParticles[i].nextPosition, hit);
+				threadHits += (isHit) ? 1 : 0;
+			}
+			hits[threadIndex] += threadHits;
+			visitedNodes[threadIndex] += threadVisitedNodes;
+		});
+		double time = (Time::Now() - startTime) * 1000.0 / static_cast<double>(numParticles);
+		bestTime = (round == 0) ? time : std::min(bestTime, time);
+
+		numHits = 0;
+		numVisitedNodes = 0;
+		for (uint thread = 0; thread < threadPool.GetNumThreads(); thread++)
+		{
+			numHits += hits[thread];
+			numVisitedNodes += visitedNodes[thread];
+		}
+	}
+
+	return bestTime;
+}
+
+/**
+ * @brief	This helper steps the simulation inside the ring, bouncing off the walls, colliding with the capsules or neither
+ * @param	numTunneled is the returned number of particles that started outside the ring and ended inside
+ * @return	double is the time per particle and step in nanoseconds
+ */
+static double StepSimulation(ThreadPool& threadPool, const SegmentBVH* pWalls, const ObstacleField* pObstacles, size_t numParticles, uint numSteps,
+	size_t& numTunneled, uint64& numCollisions)
+{
+	ParticleSimulation simulation(numParticles, &threadPool);
+	if (!simulation.SetupParticles())
+		return NAN;
+	if (pWalls)
+		simulation.SetWalls(pWalls, wallDamping);
+	if (pObstacles)
+		simulation.SetObstacles(pObstacles, capsuleRadius, wallDamping);
+
+	uint64 startTime = Time::Now();
+	for (uint step = 0; step < numSteps; step++)
+		simulation.Step(Time::maxTimeStep);
+	double time = (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+
+	// the start position follows from the ID (see SetupParticles), inside is within the inner radius of the polygon
+	const float innerRadius = ringRadius * cosf(3.14159265f / numRingSegments);
+	const Particle* pParticles = simulation.GetParticles();
+	const uint32* pParticleIDs = simulation.GetParticleIDs();
+	numTunneled = threadPool.ParallelReduce(numParticles, size_t(0), [&](size_t begin, size_t end) {
+		size_t count = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			uint32 id = pParticleIDs[i];
+			Math::Vec2 start = { float(id % 1000) * 0.0009f - 0.5f, float(id / 50) * 0.0009f - 0.5f };
+			Math::Vec2 position = pParticles[i].nextPosition;
+
+			bool startedOutside = start.x * start.x + start.y * start.y > ringRadius * ringRadius;
+			bool endedInside = position.x * position.x + position.y * position.y < innerRadius * innerRadius;
+			count += (startedOutside && endedInside) ? 1 : 0;
+		}
+		return count;
+	}, [](size_t lhs, size_t rhs) { return lhs + rhs; });
+	numCollisions = simulation.GetNumCollisions();
+
+	return time;
+}
+
+bool SegmentStudy::Run(size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	numSteps = std::max(numSteps, 1u);
+	bool succeeded = true;
+
+	std::mt19937 generator(42);
+	std::vector<Particle> particles(numParticles);
+	ScatterParticles(particles, generator);
+
+	printf("Sweeps of %zu particle steps, %u threads\n", numParticles, threadPool.GetNumThreads());
+	printf("%8s %8s %6s %9s %9s %10s %8s %13s %8s %7s\n", "walls", "nodes", "depth", "build ms", "bvh ns", "M sweeps/s", "visited", "all walls ns", "speedup", "hits");
+
+	const uint segmentCounts[] = { 1000, 10000, 100000, 1000000 };
+	for (uint numSegments : segmentCounts)
+	{
+		SegmentBVH walls;
+		AddRandomSegments(walls, numSegments, generator);
+		walls.Build(&threadPool);
+
+		// testing every wall only gets a part of the particles
+		const size_t numReferenceParticles = static_cast<size_t>(std::min<uint64>(numParticles, std::max<uint64>(maxReferenceTests / numSegments, 1000)));
+		uint64 numHits = 0, numVisitedNodes = 0, numReferenceHits = 0, numReferenceNodes = 0;
+		double hierarchyTime = MeasureSweep(threadPool, walls, particles, numParticles, true, numHits, numVisitedNodes);
+		double referenceTime = MeasureSweep(threadPool, walls, particles, numReferenceParticles, false, numReferenceHits, numReferenceNodes);
+
+		// the first hit through the hierarchy next to the first hit of all walls
+		size_t numMismatches = threadPool.ParallelReduce(numReferenceParticles, size_t(0), [&](size_t begin, size_t end) {
+			size_t count = 0;
+			for (size_t i = begin; i < end; i++)
+			{
+				SegmentBVH::Hit hit, referenceHit;
+				bool isHit = walls.Sweep(particles[i].position, particles[i].nextPosition, hit);
+				bool isReferenceHit = walls.SweepAll(particles[i].position, particles[i].nextPosition, referenceHit);
+				count += (isHit != isReferenceHit || hit.t != referenceHit.t) ? 1 : 0;
+			}
+			return count;
+		}, [](size_t lhs, size_t rhs) { return lhs + rhs; });
+
+		if (numMismatches > 0)
+		{
+			ERR("%zu of %zu sweeps through the hierarchy of %u walls find another hit than testing every wall", numMismatches, numReferenceParticles, numSegments);
+			succeeded = false;
+		}
+
+		printf("%8u %8zu %6u %9.1f %9.1f %10.2f %8.1f %13.1f %7.0fx %6.2f%%\n", numSegments, walls.GetNumNodes(), walls.GetDepth(), walls.GetBuildTime() / 1000.0,
+			hierarchyTime, 1000.0 / hierarchyTime, static_cast<double>(numVisitedNodes) / numParticles, referenceTime, referenceTime / hierarchyTime,
+			100.0 * numHits / numParticles);
+	}
+
+	// the simulation falls onto a ring of thin walls around its attractor, the capsules are the same walls with a thickness
+	const float cellSize = 1.0f / 512.0f;
+	ObstacleField capsules({ -1.25f, -1.25f }, { 1.25f, 1.25f }, cellSize, 4.0f * cellSize);
+	SegmentBVH ring;
+	for (uint i = 0; i < numRingSegments; i++)
+	{
+		float angleA = 2.0f * 3.14159265f * i / numRingSegments, angleB = 2.0f * 3.14159265f * (i + 1) / numRingSegments;
+		Math::Vec2 a = Math::Vec2{ cosf(angleA), sinf(angleA) } * ringRadius, b = Math::Vec2{ cosf(angleB), sinf(angleB) } * ringRadius;
+
+		ring.AddSegment(a, b);
+		capsules.AddCapsule(a, b, capsuleRadius);
+	}
+	ring.Build(&threadPool);
+	capsules.Bake(&threadPool);
+
+	size_t freeTunneled = 0, wallTunneled = 0, capsuleTunneled = 0;
+	uint64 freeCollisions = 0, wallCollisions = 0, capsuleCollisions = 0;
+	double freeTime = StepSimulation(threadPool, nullptr, nullptr, numParticles, numSteps, freeTunneled, freeCollisions);
+	double wallTime = StepSimulation(threadPool, &ring, nullptr, numParticles, numSteps, wallTunneled, wallCollisions);
+	double capsuleTime = StepSimulation(threadPool, nullptr, &capsules, numParticles, numSteps, capsuleTunneled, capsuleCollisions);
+
+	printf("%u steps of the simulation %13s %16s %14s\n", numSteps, "ns/particle", "tunneled inside", "collisions");
+	printf("%-36s %12.3f %16zu %14s\n", "without the ring", freeTime, freeTunneled, "-");
+	printf("%-36s %12.3f %16zu %14" PRIu64 "\n", "with the swept walls", wallTime, wallTunneled, wallCollisions);
+	printf("%-36s %12.3f %16zu %14" PRIu64 "\n", "with the baked capsules", capsuleTime, capsuleTunneled, capsuleCollisions);
+
+	return succeeded;
+}
@@ -0,0 +1,246 @@
+// EXTERNAL INCLUDES
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "shadercache.h"
+#include "shadercompiler.h"
+#include "utils.h"
+
+constexpr uint32 blobMagic = 0x48434353;	/**< "SCCH" */
+constexpr uint32 blobFormatVersion = 1;		/**< bump when the blob layout changes */
+
+/**
+ * @brief	This helper continues a 64 bit FNV-1a hash
+ */
+static uint64 Hash(uint64 hash, const void* pData, size_t size)
+{
+	const byte* pBytes = static_cast<const byte*>(pData);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+/**
+ * @brief	This helper hashes a length prefixed string
+ * 			(so "ab" + "c" and "a" + "bc" differ)
+ */
+static uint64 HashString(uint64 hash, const std::string& string)
+{
+	uint64 size = string.size();
+	hash = Hash(hash, &size, sizeof(size));
+
+	return Hash(hash, string.data(), string.size());
+}
+
+/**
+ * @brief	This helper reads a whole file
+ */
+static bool ReadFile(const std::string& path, std::string& text)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+/**
+ * @brief	This helper hashes all files a source includes (recursively)
+ * 			Includes are resolved relative to the including file like
+ * 			the standard include handler of the D3D compiler does.
+ */
+static uint64 HashIncludes(uint64 hash, const std::filesystem::path& fileName, const std::string& source, std::set<std::string>& visited)
+{
+	std::istringstream lines(source);
+	std::string line;
+
+	while (std::getline(lines, line))
+	{
+		size_t pos = line.find_first_not_of(" \t");
+		if (pos == std::string::npos || line[pos] != '#')
+			continue;
+
+		pos = line.find_first_not_of(" \t", pos + 1);
+		if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+			continue;
+
+		size_t begin = line.find_first_of("\"<", pos + 7);
+		size_t end = (begin == std::string::npos) ? begin : line.find_first_of("\">", begin + 1);
+		if (end == std::string::npos)
+			continue;
+
+		std::string includeName = line.substr(begin + 1, end - begin - 1);
+		std::filesystem::path includePath = fileName.parent_path() / includeName;
+
+		// every file only counts once (include guards)
+		if (!visited.insert(includePath.lexically_normal().string()).second)
+			continue;
+
+		std::string includeSource;
+		hash = HashString(hash, includeName);
+
+		// a missing include fails in the compiler
+		if (ReadFile(includePath.string(), includeSource))
+		{
+			hash = HashString(hash, includeSource);
+			hash = HashIncludes(hash, includePath, includeSource, visited);
+		}
+	}
+
+	return hash;
+}
+
+ShaderCache::ShaderCache(const char* pDirectory, ShaderCompiler* pCompiler) :
+	directory(pDirectory),
+	pCompiler(pCompiler),
+	numHits(0),
+	numMisses(0),
+	loadTime(0)
+{
+
+}
+
+bool ShaderCache::Load(const char* pFileName, const char* pEntryPoint, const char* pShaderModel, uint32 flags, std::vector<byte>& bytecode)
+{
+	uint64 startTime = Time::Now();
+
+	std::string source;
+	if (!ReadFile(pFileName, source))
+	{
+		ERR("Could not read shader %s", pFileName);
+		return false;
+	}
+
+	uint64 key = this->HashSource(pFileName, source, pEntryPoint, pShaderModel, flags);
+
+	char blobName[32];
+	snprintf(blobName, sizeof(blobName), "%016" PRIx64 ".cso", key);
+	std::string path = (std::filesystem::path(this->directory) / blobName).string();
+
+	bool isHit = this->ReadBlob(path, key, bytecode);
+
+	if (isHit)
+		this->numHits++;
+	else
+	{
+		this->numMisses++;
+
+		if (!this->pCompiler->Compile(source, pFileName, pEntryPoint, pShaderModel, flags, bytecode))
+		{
+			ERR("Could not compile shader %s (%s)", pFileName, pEntryPoint);
+			return false;
+		}
+
+		// a cache that can't be written only costs the next start time
+		if (!this->WriteBlob(path, key, bytecode))
+			WARN("Could not write shader cache %s", path.c_str());
+	}
+
+	uint64 time = Time::Now() - startTime;
+	this->loadTime += time;
+
+	LOG("Loaded shader %s (%s) %s in %.3f ms", pFileName, pEntryPoint, (isHit) ? "from the cache" : "by compiling", time / 1000.0);
+
+	return true;
+}
+
+uint ShaderCache::GetNumHits(void) const
+{
+	return this->numHits;
+}
+uint ShaderCache::GetNumMisses(void) const
+{
+	return this->numMisses;
+}
+uint64 ShaderCache::GetLoadTime(void) const
+{
+	return this->loadTime;
+}
+
+uint64 ShaderCache::HashSource(const std::string& fileName, const std::string& source, const char* pEntryPoint, const char* pShaderModel, uint32 flags) const
+{
+	uint64 hash = 0xcbf29ce484222325ull;
+
+	hash = HashString(hash, this->pCompiler->GetVersion());
+	hash = HashString(hash, pEntryPoint);
+	hash = HashString(hash, pShaderModel);
+	hash = Hash(hash, &flags, sizeof(flags));
+	hash = HashString(hash, source);
+
+	std::set<std::string> visited;
+	return HashIncludes(hash, fileName, source, visited);
+}
+
+bool ShaderCache::ReadBlob(const std::string& path, uint64 key, std::vector<byte>& bytecode) const
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	BlobHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+
+	// blobs of another format, another key (hash collision) or a truncated write are ignored
+	if (header.magic != blobMagic || header.formatVersion != blobFormatVersion || header.key != key)
+		return false;
+
+	bytecode.resize(static_cast<size_t>(header.size));
+	if (!file.read(reinterpret_cast<char*>(bytecode.data()), bytecode.size()))
+		return false;
+
+	if (Hash(0xcbf29ce484222325ull, bytecode.data(), bytecode.size()) != header.checksum)
+	{
+		WARN("Ignoring corrupt shader cache %s", path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool ShaderCache::WriteBlob(const std::string& path, uint64 key, const std::vector<byte>& bytecode) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(this->directory, error);
+
+	BlobHeader header;
+	header.magic = blobMagic;
+	header.formatVersion = blobFormatVersion;
+	header.key = key;
+	header.size = bytecode.size();
+	header.checksum = Hash(0xcbf29ce484222325ull, bytecode.data(), bytecode.size());
+
+	// write next to the blob and move it in place, so readers never see half a blob
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(bytecode.data()), bytecode.size());
+
+		if (!file)
+			return false;
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
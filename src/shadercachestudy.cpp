@@ -0,0 +1,177 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "shadercache.h"
+#include "shadercachestudy.h"
+#include "stubshadercompiler.h"
+#include "utils.h"
+
+/**
+ * @brief	This struct defines a shader the renderer loads
+ */
+struct ShaderProgram
+{
+	const char* pFileName;
+	const char* pEntryPoint;
+	const char* pShaderModel;
+};
+
+/**
+ * @brief	This struct defines what was measured for one pass over the shaders
+ */
+struct CachePass
+{
+	uint numHits;
+	uint numMisses;
+	uint numCompiles;
+	uint64 time;		/**< the load time of all shaders in microseconds */
+};
+
+constexpr uint32 debugFlags = 1;	/**< the flags of the last pass (D3DCOMPILE_DEBUG) */
+
+// the shaders ParticleRenderer::CompileShaders loads
+static const ShaderProgram programs[] = {
+	{ "ParticleRendering.hlsl", "ParticleVS", "vs_4_0" },
+	{ "ParticleRendering.hlsl", "ParticlePS", "ps_4_0" },
+	{ "ParticleSimulation.hlsl", "IntegrateCS", "cs_4_0" },
+};
+
+/**
+ * @brief	This helper loads every shader once through the cache
+ * @param	flags are the compile flags of every shader
+ * @param	bytecodes are the returned bytecodes, one per shader
+ * @return	false if a shader couldn't be loaded
+ */
+static bool LoadPrograms(ShaderCache& cache, const StubShaderCompiler& compiler, const std::filesystem::path& sourceDirectory, uint32 flags,
+	std::vector<std::vector<byte>>& bytecodes, CachePass& pass)
+{
+	uint numHits = cache.GetNumHits();
+	uint numMisses = cache.GetNumMisses();
+	uint numCompiles = compiler.GetNumCompiles();
+	uint64 loadTime = cache.GetLoadTime();
+
+	bytecodes.resize(std::size(programs));
+	for (size_t i = 0; i < std::size(programs); i++)
+	{
+		std::string fileName = (sourceDirectory / programs[i].pFileName).string();
+		if (!cache.Load(fileName.c_str(), programs[i].pEntryPoint, programs[i].pShaderModel, flags, bytecodes[i]))
+			return false;
+	}
+
+	pass.numHits += cache.GetNumHits() - numHits;
+	pass.numMisses += cache.GetNumMisses() - numMisses;
+	pass.numCompiles += compiler.GetNumCompiles() - numCompiles;
+	pass.time += cache.GetLoadTime() - loadTime;
+
+	return true;
+}
+
+bool ShaderCacheStudy::Run(const char* pShaderDirectory, uint numRounds)
+{
+	numRounds = std::max(numRounds, 1u);
+	const uint numPrograms = static_cast<uint>(std::size(programs));
+	std::error_code error;
+
+	// the sources are copied, the edit must not touch the real ones
+	std::filesystem::path studyDirectory = std::filesystem::temp_directory_path(error) / "GPUParticleSimulationShaderCache";
+	std::filesystem::path sourceDirectory = studyDirectory / "Shaders";
+	std::filesystem::path cacheDirectory = studyDirectory / "ShaderCache";
+	std::filesystem::remove_all(studyDirectory, error);
+	std::filesystem::create_directories(sourceDirectory, error);
+
+	for (const ShaderProgram& program : programs)
+	{
+		std::filesystem::copy_file(std::filesystem::path(pShaderDirectory) / program.pFileName, sourceDirectory / program.pFileName,
+			std::filesystem::copy_options::overwrite_existing, error);
+		if (error)
+		{
+			ERR("Could not copy shader %s from %s", program.pFileName, pShaderDirectory);
+			std::filesystem::remove_all(studyDirectory, error);
+			return false;
+		}
+	}
+
+	StubShaderCompiler compiler;
+	ShaderCache cache(cacheDirectory.string().c_str(), &compiler);
+	std::vector<std::vector<byte>> coldBytecodes, bytecodes;
+	CachePass cold = {}, warm = {}, edited = {}, flagged = {};
+	bool succeeded = true;
+
+	succeeded = LoadPrograms(cache, compiler, sourceDirectory, 0, coldBytecodes, cold);
+	for (uint round = 0; round < numRounds && succeeded; round++)
+	{
+		succeeded = LoadPrograms(cache, compiler, sourceDirectory, 0, bytecodes, warm);
+		if (succeeded && bytecodes != coldBytecodes)
+		{
+			ERR("A cached blob differs from the compiled bytecode");
+			succeeded = false;
+		}
+	}
+
+	// an edit of a source invalidates only the shaders of that file
+	uint numEditedPrograms = 0;
+	if (succeeded)
+	{
+		std::ofstream file(sourceDirectory / programs[0].pFileName, std::ios::binary | std::ios::app);
+		file << "\n// edited\n";
+		file.close();
+
+		for (const ShaderProgram& program : programs)
+			numEditedPrograms += (strcmp(program.pFileName, programs[0].pFileName) == 0) ? 1 : 0;
+
+		succeeded = LoadPrograms(cache, compiler, sourceDirectory, 0, bytecodes, edited);
+	}
+
+	// other flags are other bytecode, every shader misses
+	uint numSharedBytecodes = 0;
+	if (succeeded)
+	{
+		std::vector<std::vector<byte>> flaggedBytecodes;
+		succeeded = LoadPrograms(cache, compiler, sourceDirectory, debugFlags, flaggedBytecodes, flagged);
+
+		for (size_t i = 0; i < flaggedBytecodes.size() && succeeded; i++)
+			numSharedBytecodes += (flaggedBytecodes[i] == bytecodes[i]) ? 1 : 0;
+	}
+
+	std::filesystem::remove_all(studyDirectory, error);
+	if (!succeeded)
+		return false;
+
+	printf("Shader cache with the stub compiler, %u shaders from %s, %u warm rounds\n", numPrograms, pShaderDirectory, numRounds);
+	printf("%-14s %6s %8s %10s %12s\n", "pass", "hits", "misses", "compiles", "ms/shader");
+	const char* pNames[] = { "cold", "warm", "edited source", "other flags" };
+	const CachePass* pPasses[] = { &cold, &warm, &edited, &flagged };
+	const uint numLoads[] = { numPrograms, numPrograms * numRounds, numPrograms, numPrograms };
+	for (uint i = 0; i < 4; i++)
+		printf("%-14s %6u %8u %10u %12.4f\n", pNames[i], pPasses[i]->numHits, pPasses[i]->numMisses, pPasses[i]->numCompiles,
+			pPasses[i]->time / 1000.0 / numLoads[i]);
+
+	if (cold.numMisses != numPrograms || cold.numCompiles != numPrograms)
+	{
+		ERR("The cold cache missed %u of %u shaders", cold.numMisses, numPrograms);
+		succeeded = false;
+	}
+	if (warm.numHits != numLoads[1] || warm.numCompiles != 0)
+	{
+		ERR("The warm cache hit %u of %u loads and compiled %u shaders", warm.numHits, numLoads[1], warm.numCompiles);
+		succeeded = false;
+	}
+	if (edited.numMisses != numEditedPrograms)
+	{
+		ERR("The edit of %s invalidated %u shaders instead of %u", programs[0].pFileName, edited.numMisses, numEditedPrograms);
+		succeeded = false;
+	}
+	if (flagged.numMisses != numPrograms || numSharedBytecodes > 0)
+	{
+		ERR("Other flags missed %u of %u shaders and kept the bytecode of %u", flagged.numMisses, numPrograms, numSharedBytecodes);
+		succeeded = false;
+	}
+
+	return succeeded;
+}
@@ -0,0 +1,137 @@
+// EXTERNAL INCLUDES
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "sharedstatereader.h"
+
+SharedStateReader::SharedStateReader() :
+	pRing(nullptr),
+	ringSize(0),
+	pHeader(nullptr)
+{
+
+}
+
+SharedStateReader::~SharedStateReader()
+{
+	this->Close();
+}
+
+bool SharedStateReader::Open(const char* pName)
+{
+	this->Close();
+
+#if defined(_WIN32)
+	return false;
+#else
+	int file = shm_open(pName, O_RDONLY, 0);
+	if (file < 0)
+		return false;
+
+	struct stat status;
+	void* pRing = MAP_FAILED;
+	if (fstat(file, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(SharedState::Header))
+		pRing = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+
+	if (pRing == MAP_FAILED)
+		return false;
+
+	this->pRing = static_cast<const byte*>(pRing);
+	this->ringSize = static_cast<size_t>(status.st_size);
+	this->pHeader = reinterpret_cast<const SharedState::Header*>(this->pRing);
+
+	// the writer sets the magic once the rest of the header is complete
+	bool isCompatible = (this->pHeader->magic == SharedState::magic);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	isCompatible = isCompatible && this->pHeader->version == SharedState::version &&
+		this->pHeader->particleSize == sizeof(ParticleSimulation::Particle) &&
+		SharedState::GetRingSize(this->pHeader->numSlots, this->pHeader->slotSize) <= this->ringSize;
+
+	if (!isCompatible)
+		this->Close();
+
+	return isCompatible;
+#endif
+}
+
+void SharedStateReader::Close(void)
+{
+#if !defined(_WIN32)
+	if (this->pRing)
+		munmap(const_cast<byte*>(this->pRing), this->ringSize);
+#endif
+
+	this->pRing = nullptr;
+	this->pHeader = nullptr;
+	this->ringSize = 0;
+}
+
+bool SharedStateReader::AcquireLatest(Frame& frame) const
+{
+	// a frame can only be lost here if the writer laps the whole ring in between
+	for (uint attempt = 0; attempt < 4; attempt++)
+	{
+		uint64 numFrames = this->GetNumFrames();
+		if (numFrames == 0)
+			return false;
+
+		if (this->Acquire(numFrames - 1, frame))
+			return true;
+	}
+
+	return false;
+}
+
+bool SharedStateReader::Acquire(uint64 frameNumber, Frame& frame) const
+{
+	if (!this->pHeader)
+		return false;
+
+	const uint slot = static_cast<uint>(frameNumber % this->pHeader->numSlots);
+	const byte* pSlot = this->pRing + sizeof(SharedState::Header) + slot * this->pHeader->slotSize;
+	const SharedState::SlotHeader* pSlotHeader = reinterpret_cast<const SharedState::SlotHeader*>(pSlot);
+
+	// the slot has to hold the completed frame
+	uint64 sequence = pSlotHeader->sequence.load(std::memory_order_acquire);
+	if (sequence != 2 * frameNumber + 2)
+		return false;
+
+	frame.pParticles = reinterpret_cast<const ParticleSimulation::Particle*>(pSlot + sizeof(SharedState::SlotHeader));
+	frame.numParticles = static_cast<size_t>(pSlotHeader->numParticles);
+	frame.frame = frameNumber;
+	frame.step = pSlotHeader->step;
+	frame.timestamp = pSlotHeader->timestamp;
+	frame.publishTime = pSlotHeader->publishTime;
+	frame.sequence = sequence;
+	frame.slot = slot;
+
+	// the header fields were read before the writer got back to this slot
+	return this->IsValid(frame);
+}
+
+bool SharedStateReader::IsValid(const Frame& frame) const
+{
+	const byte* pSlot = this->pRing + sizeof(SharedState::Header) + frame.slot * this->pHeader->slotSize;
+	const SharedState::SlotHeader* pSlotHeader = reinterpret_cast<const SharedState::SlotHeader*>(pSlot);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return pSlotHeader->sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
+
+uint64 SharedStateReader::GetNumFrames(void) const
+{
+	return (this->pHeader) ? this->pHeader->numFrames.load(std::memory_order_acquire) : 0;
+}
+uint SharedStateReader::GetNumSlots(void) const
+{
+	return (this->pHeader) ? this->pHeader->numSlots : 0;
+}
+size_t SharedStateReader::GetMaxParticles(void) const
+{
+	return (this->pHeader) ? static_cast<size_t>(this->pHeader->maxParticles) : 0;
+}
@@ -0,0 +1,156 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <thread>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "sharedstatereader.h"
+#include "sharedstatestudy.h"
+#include "sharedstatewriter.h"
+#include "utils.h"
+
+/**
+ * @brief	This struct defines what the reader saw
+ */
+struct ReaderResult
+{
+	uint64 numFrames;		/**< the intact frames that were read */
+	uint64 numTornFrames;	/**< the frames the writer overwrote while they were read */
+	uint64 numBadFrames;	/**< the intact frames whose particles didn't belong to them */
+	uint64 sumLatency;		/**< from the completion to the acquisition of the intact frames (microseconds) */
+	uint64 maxLatency;
+	uint64 readTime;		/**< the time reading the intact frames took (microseconds) */
+	float checksum;			/**< keeps the reads */
+};
+
+/**
+ * @brief	This helper reads the newest frame of the ring over and over until the writer is done
+ */
+static void ReadFrames(const char* pName, const std::atomic<bool>& isWriting, ReaderResult& result)
+{
+	SharedStateReader reader;
+	if (!reader.Open(pName))
+	{
+		ERR("The shared memory ring %s can't be opened", pName);
+		return;
+	}
+
+	uint64 lastFrame = ~0ull;
+	SharedStateReader::Frame frame;
+	while (isWriting.load(std::memory_order_acquire) || reader.GetNumFrames() - 1 != lastFrame)
+	{
+		if (!reader.AcquireLatest(frame) || frame.frame == lastFrame)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		uint64 acquireTime = Time::Now();
+		uint64 latency = acquireTime - std::min(frame.publishTime, acquireTime);
+
+		// the frame is read right in the ring
+		float sum = 0.0f;
+		for (size_t i = 0; i < frame.numParticles; i++)
+			sum += frame.pParticles[i].nextPosition.x;
+		const float stamp = static_cast<float>(frame.frame);
+		bool isStamped = frame.pParticles[0].position.x == stamp && frame.pParticles[frame.numParticles - 1].position.x == stamp;
+
+		if (reader.IsValid(frame))
+		{
+			result.numFrames++;
+			result.numBadFrames += (isStamped) ? 0 : 1;
+			result.sumLatency += latency;
+			result.maxLatency = std::max(result.maxLatency, latency);
+			result.readTime += Time::Now() - acquireTime;
+			result.checksum += sum;
+		}
+		else
+		{
+			result.numTornFrames++;
+		}
+		lastFrame = frame.frame;
+	}
+}
+
+bool SharedStateStudy::Run(size_t numParticles, uint numFrames, uint numSlots)
+{
+	numParticles = std::max<size_t>(numParticles, 1);
+	numFrames = std::max(numFrames, 1u);
+	numSlots = std::max(numSlots, 2u);
+	bool succeeded = true;
+
+	const char* pName = "/gpuparticles_study";
+	SharedStateWriter writer;
+	if (!writer.Create(pName, numSlots, numParticles))
+	{
+		ERR("The shared memory ring of %u slots of %zu particles can't be created", numSlots, numParticles);
+		return false;
+	}
+
+	std::vector<ParticleSimulation::Particle> particles(numParticles);
+	for (size_t i = 0; i < numParticles; i++)
+	{
+		float coordinate = static_cast<float>(i % 1024) / 1024.0f;
+		particles[i].position = { coordinate, coordinate };
+		particles[i].prevPosition = particles[i].position;
+		particles[i].nextPosition = particles[i].position;
+	}
+
+	std::atomic<bool> isWriting(true);
+	ReaderResult result = {};
+	std::thread readerThread(ReadFrames, pName, std::cref(isWriting), std::ref(result));
+
+	uint64 firstLapTime = 0, maxPublishTime = 0;
+	uint64 startTime = Time::Now();
+	for (uint frame = 0; frame < numFrames; frame++)
+	{
+		particles.front().position.x = static_cast<float>(frame);
+		particles.back().position.x = static_cast<float>(frame);
+
+		uint64 publishStart = Time::Now();
+		writer.Publish(particles.data(), numParticles, frame, frame * static_cast<uint64>(Time::maxTimeStep * 1000000.0f));
+		uint64 publishTime = Time::Now() - publishStart;
+
+		// the first lap of the ring faults its pages in
+		if (frame < numSlots)
+			firstLapTime += publishTime;
+		else
+			maxPublishTime = std::max(maxPublishTime, publishTime);
+	}
+	uint64 writeTime = std::max<uint64>(Time::Now() - startTime, 1);
+
+	isWriting.store(false, std::memory_order_release);
+	readerThread.join();
+	writer.Destroy();
+
+	const double frameSize = static_cast<double>(sizeof(ParticleSimulation::Particle) * numParticles);
+	printf("Shared memory ring of %u slots, %zu particles (%.1f MB) per frame, %u frames\n", numSlots, numParticles, frameSize / 1000000.0, numFrames);
+	printf("writer: %.1f frames/s (%.2f GB/s), %.3f ms per frame, the slowest after the first lap took %.3f ms, the first lap %.3f ms per frame\n",
+		numFrames * 1000000.0 / writeTime, frameSize * numFrames / (writeTime * 1000.0), writeTime / (1000.0 * numFrames), maxPublishTime / 1000.0,
+		firstLapTime / (1000.0 * std::min(numFrames, numSlots)));
+	if (result.numFrames > 0)
+	{
+		printf("reader: %" PRIu64 " intact frames (%.1f frames/s), read in place in %.3f ms per frame (%.2f GB/s)\n", result.numFrames,
+			result.numFrames * 1000000.0 / writeTime, result.readTime / (1000.0 * result.numFrames), frameSize * result.numFrames / (std::max<uint64>(result.readTime, 1) * 1000.0));
+		printf("latency from the completion to the acquisition of a frame: mean %.3f ms, max %.3f ms\n", result.sumLatency / (1000.0 * result.numFrames),
+			result.maxLatency / 1000.0);
+	}
+	printf("%" PRIu64 " frames torn while they were read, %" PRIu64 " frames skipped (checksum %.1f)\n", result.numTornFrames,
+		numFrames - std::min<uint64>(numFrames, result.numFrames + result.numTornFrames), result.checksum);
+
+	if (result.numFrames == 0)
+	{
+		ERR("The reader didn't get an intact frame of %u", numFrames);
+		succeeded = false;
+	}
+	if (result.numBadFrames > 0)
+	{
+		ERR("%" PRIu64 " frames passed the sequence check but held the particles of another frame", result.numBadFrames);
+		succeeded = false;
+	}
+
+	return succeeded;
+}
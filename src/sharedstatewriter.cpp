@@ -0,0 +1,125 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cstring>
+#include <new>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "sharedstatewriter.h"
+#include "utils.h"
+
+SharedStateWriter::SharedStateWriter() :
+	pRing(nullptr),
+	ringSize(0),
+	pHeader(nullptr)
+{
+
+}
+
+SharedStateWriter::~SharedStateWriter()
+{
+	this->Destroy();
+}
+
+bool SharedStateWriter::Create(const char* pName, uint numSlots, size_t maxParticles)
+{
+	this->Destroy();
+
+#if defined(_WIN32)
+	ERR("Shared memory rings need POSIX shared memory");
+	return false;
+#else
+	const size_t slotSize = SharedState::GetSlotSize(maxParticles, sizeof(ParticleSimulation::Particle));
+	const size_t ringSize = SharedState::GetRingSize(numSlots, slotSize);
+
+	// a new object, so no reader maps a ring of the old layout
+	shm_unlink(pName);
+	int file = shm_open(pName, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (file < 0)
+	{
+		ERR("Could not create the shared memory %s", pName);
+		return false;
+	}
+
+	void* pRing = MAP_FAILED;
+	if (ftruncate(file, static_cast<off_t>(ringSize)) == 0)
+		pRing = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	close(file);
+
+	if (pRing == MAP_FAILED)
+	{
+		ERR("Could not map %zu bytes of shared memory %s", ringSize, pName);
+		shm_unlink(pName);
+		return false;
+	}
+
+	this->name = pName;
+	this->pRing = static_cast<byte*>(pRing);
+	this->ringSize = ringSize;
+
+	// the pages are zero, so every slot starts with sequence 0 (never written)
+	this->pHeader = new (this->pRing) SharedState::Header();
+	this->pHeader->numSlots = numSlots;
+	this->pHeader->particleSize = sizeof(ParticleSimulation::Particle);
+	this->pHeader->maxParticles = maxParticles;
+	this->pHeader->slotSize = slotSize;
+	this->pHeader->numFrames.store(0, std::memory_order_relaxed);
+	this->pHeader->version = SharedState::version;
+
+	// readers check the magic last
+	std::atomic_thread_fence(std::memory_order_release);
+	this->pHeader->magic = SharedState::magic;
+
+	return true;
+#endif
+}
+
+void SharedStateWriter::Destroy(void)
+{
+#if !defined(_WIN32)
+	if (!this->pRing)
+		return;
+
+	munmap(this->pRing, this->ringSize);
+	shm_unlink(this->name.c_str());
+#endif
+
+	this->pRing = nullptr;
+	this->pHeader = nullptr;
+	this->ringSize = 0;
+}
+
+void SharedStateWriter::Publish(const ParticleSimulation::Particle* pParticles, size_t numParticles, uint64 step, uint64 timestamp)
+{
+	if (!this->pHeader)
+		return;
+
+	const uint64 frame = this->pHeader->numFrames.load(std::memory_order_relaxed);
+	byte* pSlot = this->pRing + sizeof(SharedState::Header) + (frame % this->pHeader->numSlots) * this->pHeader->slotSize;
+	SharedState::SlotHeader* pSlotHeader = reinterpret_cast<SharedState::SlotHeader*>(pSlot);
+
+	numParticles = std::min<size_t>(numParticles, this->pHeader->maxParticles);
+
+	// readers of the former frame in this slot see that it is being overwritten
+	pSlotHeader->sequence.store(2 * frame + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	memcpy(pSlot + sizeof(SharedState::SlotHeader), pParticles, sizeof(ParticleSimulation::Particle) * numParticles);
+	pSlotHeader->frame = frame;
+	pSlotHeader->step = step;
+	pSlotHeader->timestamp = timestamp;
+	pSlotHeader->numParticles = numParticles;
+	pSlotHeader->publishTime = Time::Now();
+
+	pSlotHeader->sequence.store(2 * frame + 2, std::memory_order_release);
+	this->pHeader->numFrames.store(frame + 1, std::memory_order_release);
+}
+
+uint64 SharedStateWriter::GetNumFrames(void) const
+{
+	return (this->pHeader) ? this->pHeader->numFrames.load(std::memory_order_relaxed) : 0;
+}
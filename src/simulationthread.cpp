@@ -0,0 +1,150 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <chrono>
+// INTERNAL INCLUDES
+#include "simulationthread.h"
+#include "utils.h"
+
+constexpr double maxLag = 250000.0; /**< the simulation clock never falls further behind than this (microseconds) */
+
+SimulationThread::SimulationThread(ParticleSimulation* pSimulation, InputEventQueue* pInputEvents, TripleBuffer<SimulationSnapshot>* pSnapshots) :
+	pSimulation(pSimulation),
+	pInputEvents(pInputEvents),
+	pSnapshots(pSnapshots),
+	isRunning(false),
+	numSteps(0),
+	simulatedTime(0),
+	lastStepTime(0),
+	numTimeBins(0),
+	particleBudget(0),
+	renderDecimation(1),
+	isQualityChanged(false)
+{
+
+}
+
+SimulationThread::~SimulationThread()
+{
+	this->Stop();
+}
+
+void SimulationThread::Start(const Settings& settings)
+{
+	LOG("Starting simulation thread");
+
+	this->settings = settings;
+	this->numSteps.store(0, std::memory_order_relaxed);
+	this->simulatedTime.store(0, std::memory_order_relaxed);
+	this->isRunning.store(true, std::memory_order_relaxed);
+	this->thread = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop(void)
+{
+	if (!this->thread.joinable())
+		return;
+
+	LOG("Stopping simulation thread");
+
+	this->isRunning.store(false, std::memory_order_relaxed);
+	this->thread.join();
+}
+
+void SimulationThread::SetQuality(const FrameGovernor::Quality& quality)
+{
+	this->numTimeBins.store(quality.numTimeBins, std::memory_order_relaxed);
+	this->particleBudget.store(quality.particleBudget, std::memory_order_relaxed);
+	this->renderDecimation.store(std::max(quality.renderDecimation, 1u), std::memory_order_relaxed);
+	this->isQualityChanged.store(true, std::memory_order_release);
+}
+
+uint64 SimulationThread::GetNumSteps(void) const
+{
+	return this->numSteps.load(std::memory_order_relaxed);
+}
+uint64 SimulationThread::GetSimulatedTime(void) const
+{
+	return this->simulatedTime.load(std::memory_order_relaxed);
+}
+uint64 SimulationThread::GetLastStepTime(void) const
+{
+	return this->lastStepTime.load(std::memory_order_relaxed);
+}
+
+void SimulationThread::Run(void)
+{
+	const TimestepController::Settings& timestepSettings = this->settings.timestepSettings;
+	TimestepController timestepController(timestepSettings);
+
+	// every step estimates the timestep of the next one while its particles are cached
+	if (this->settings.adaptiveTimestep)
+		this->pSimulation->SetTimestepEstimate(timestepSettings.accuracy, timestepSettings.softening);
+
+	// the simulation clock is the wall clock time the current state belongs to
+	double simulationClock = static_cast<double>(Time::Now());
+	uint renderDecimation = 1;
+
+	while (this->isRunning.load(std::memory_order_relaxed))
+	{
+		// pick the timestep of this step
+		float timestep = this->settings.timestep;
+		if (this->settings.adaptiveTimestep)
+			timestep = timestepController.NextTimestep(this->pSimulation->EstimateTimestep(timestepSettings.accuracy, timestepSettings.softening));
+
+		const double stepDuration = static_cast<double>(timestep) * 1000000.0;
+
+		if (this->settings.throttle)
+		{
+			double now = static_cast<double>(Time::Now());
+
+			// drop the time we can't catch up on
+			if (now - simulationClock > maxLag)
+				simulationClock = now - maxLag;
+
+			// wait until the wall clock reached the end of this step
+			while (simulationClock + stepDuration > now && this->isRunning.load(std::memory_order_relaxed))
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64>(simulationClock + stepDuration - now)));
+				now = static_cast<double>(Time::Now());
+			}
+		}
+
+		simulationClock += stepDuration;
+
+		// a new quality applies from this step on
+		if (this->isQualityChanged.exchange(false, std::memory_order_acquire))
+		{
+			this->pSimulation->SetTimeBins(this->numTimeBins.load(std::memory_order_relaxed));
+			this->pSimulation->SetParticleBudget(this->particleBudget.load(std::memory_order_relaxed));
+			renderDecimation = this->renderDecimation.load(std::memory_order_relaxed);
+		}
+
+		// apply the input of this step and simulate it
+		uint64 stepStartTime = Time::Now();
+
+		this->pSimulation->Step(timestep, this->pInputEvents, static_cast<uint64>(simulationClock));
+
+		if (this->settings.pStepTimes)
+			this->settings.pStepTimes->Observe((Time::Now() - stepStartTime) / 1000000.0);
+		if (this->settings.pStepCounter)
+			this->settings.pStepCounter->Add();
+
+		// publish the completed state (the presenter may only get every n-th one)
+		if (this->numSteps.load(std::memory_order_relaxed) % renderDecimation == 0)
+		{
+			SimulationSnapshot& snapshot = this->pSnapshots->GetBackBuffer();
+			this->pSimulation->WriteSnapshot(snapshot);
+			snapshot.timestamp = static_cast<uint64>(simulationClock);
+			this->pSnapshots->Publish();
+		}
+		this->lastStepTime.store(Time::Now() - stepStartTime, std::memory_order_relaxed);
+
+		if (this->settings.pSharedState)
+			this->settings.pSharedState->Publish(this->pSimulation->GetParticles(), this->pSimulation->GetNumParticles(), this->pSimulation->GetNumSteps(), static_cast<uint64>(simulationClock));
+		if (this->settings.pStreamServer)
+			this->settings.pStreamServer->Publish(this->pSimulation->GetParticles(), this->pSimulation->GetParticleIDs(), this->pSimulation->GetNumParticles(), this->pSimulation->GetNumSteps());
+
+		this->numSteps.fetch_add(1, std::memory_order_relaxed);
+		this->simulatedTime.fetch_add(static_cast<uint64>(stepDuration), std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,215 @@
+// EXTERNAL INCLUDES
+#include <cfloat>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "integrators.h"
+#include "slabsimulation.h"
+#include "transport.h"
+#include "utils.h"
+
+/**
+ * @brief	This helper appends particles to a message
+ */
+static void AppendParticles(std::vector<byte>& message, const std::vector<ParticleSimulation::Particle>& particles)
+{
+	size_t offset = message.size();
+	message.resize(offset + sizeof(ParticleSimulation::Particle) * particles.size());
+	if (!particles.empty())
+		memcpy(message.data() + offset, particles.data(), sizeof(ParticleSimulation::Particle) * particles.size());
+}
+
+SlabSimulation::SlabSimulation(Transport* pTransport, float domainMin, float domainMax, float haloWidth) :
+	pTransport(pTransport),
+	slabMin(-FLT_MAX),
+	slabMax(FLT_MAX),
+	haloWidth(haloWidth),
+	constants(),
+	numMigratedParticles(0),
+	integrationTime(0),
+	exchangeTime(0)
+{
+	const uint rank = pTransport->GetRank();
+	const uint numRanks = pTransport->GetNumRanks();
+	const float slabWidth = (domainMax - domainMin) / static_cast<float>(numRanks);
+
+	// the outer slabs take every particle that left the domain
+	if (rank > 0)
+		this->slabMin = domainMin + slabWidth * static_cast<float>(rank);
+	if (rank + 1 < numRanks)
+		this->slabMax = domainMin + slabWidth * static_cast<float>(rank + 1);
+}
+
+void SlabSimulation::SetupParticles(size_t numParticles)
+{
+	this->particles.clear();
+	this->haloParticles.clear();
+	this->numMigratedParticles = 0;
+
+	for (size_t i = 0; i < numParticles; i++)
+	{
+		float column = float(i % 1000);
+		float row = float(i / 50);
+
+		ParticleSimulation::Particle particle;
+		particle.position = { (column * 0.0009f) - 0.5f, (row * 0.0009f) - 0.5f };
+		particle.prevPosition = particle.position;
+		particle.nextPosition = particle.position;
+
+		if (particle.nextPosition.x >= this->slabMin && particle.nextPosition.x < this->slabMax)
+			this->particles.push_back(particle);
+	}
+
+	// Initial simulation constants (the same as ParticleSimulation)
+	this->constants.numParticles = static_cast<uint>(numParticles);
+	this->constants.lastTimestep = 1.0f;
+	this->constants.timestep = 1.0f;
+	this->constants.gravitySource = Math::Vec2{ 0.0f, 0.0f };
+	this->constants.gravityStrength = 9.81f;
+	this->constants.damping = 0.9948f;
+}
+
+bool SlabSimulation::Step(float timestep)
+{
+	uint64 startTime = Time::Now();
+
+	this->constants.lastTimestep = this->constants.timestep;
+	this->constants.timestep = timestep;
+
+	Integrators::StepConstants stepConstants;
+	stepConstants.gravitySource = this->constants.gravitySource;
+	stepConstants.gravityStrength = this->constants.gravityStrength;
+	stepConstants.lastTimestep = this->constants.lastTimestep;
+	stepConstants.timestep = this->constants.timestep;
+	stepConstants.damping = powf(this->constants.damping, timestep / Time::maxTimeStep);
+
+	// the position Verlet doesn't use the velocity (the compensated one would need
+	// one per particle that migrates with it, so the slabs always accumulate in floats)
+	Math::Vec2 velocity = Math::Vec2::zero;
+	for (ParticleSimulation::Particle& particle : this->particles)
+		Integrators::FloatPositionVerlet::Integrate(particle, velocity, stepConstants);
+
+	uint64 endTime = Time::Now();
+	this->integrationTime += endTime - startTime;
+	startTime = endTime;
+
+	// keep the particles of this slab, the others go to the neighbour on their side
+	std::vector<ParticleSimulation::Particle> leaving[2];
+	size_t numKept = 0;
+
+	for (const ParticleSimulation::Particle& particle : this->particles)
+	{
+		if (particle.nextPosition.x < this->slabMin)
+			leaving[0].push_back(particle);
+		else if (particle.nextPosition.x >= this->slabMax)
+			leaving[1].push_back(particle);
+		else
+			this->particles[numKept++] = particle;
+	}
+
+	this->particles.resize(numKept);
+	this->numMigratedParticles += leaving[0].size() + leaving[1].size();
+
+	// every message holds the migrating particles followed by the halo
+	std::vector<byte> messages[2];
+	for (uint side = 0; side < 2; side++)
+	{
+		uint64 numLeaving = leaving[side].size();
+		messages[side].resize(sizeof(uint64));
+		memcpy(messages[side].data(), &numLeaving, sizeof(uint64));
+		AppendParticles(messages[side], leaving[side]);
+	}
+
+	if (this->haloWidth > 0.0f)
+	{
+		std::vector<ParticleSimulation::Particle> halo[2];
+		for (const ParticleSimulation::Particle& particle : this->particles)
+		{
+			if (particle.nextPosition.x < this->slabMin + this->haloWidth)
+				halo[0].push_back(particle);
+			if (particle.nextPosition.x >= this->slabMax - this->haloWidth)
+				halo[1].push_back(particle);
+		}
+
+		AppendParticles(messages[0], halo[0]);
+		AppendParticles(messages[1], halo[1]);
+	}
+
+	// even ranks talk to their right neighbour first and odd ranks to their left one,
+	// so every pair of neighbours exchanges at the same time
+	const uint rank = this->pTransport->GetRank();
+	const uint numRanks = this->pTransport->GetNumRanks();
+	bool succeeded = true;
+
+	this->haloParticles.clear();
+	for (uint phase = 0; phase < 2; phase++)
+	{
+		uint side = (rank + phase + 1) % 2;
+
+		if (side == 0 && rank > 0)
+			succeeded &= this->ExchangeWith(rank - 1, messages[0]);
+		else if (side == 1 && rank + 1 < numRanks)
+			succeeded &= this->ExchangeWith(rank + 1, messages[1]);
+	}
+
+	this->exchangeTime += Time::Now() - startTime;
+
+	return succeeded;
+}
+
+size_t SlabSimulation::GetNumParticles(void) const
+{
+	return this->particles.size();
+}
+const std::vector<ParticleSimulation::Particle>& SlabSimulation::GetParticles(void) const
+{
+	return this->particles;
+}
+const std::vector<ParticleSimulation::Particle>& SlabSimulation::GetHaloParticles(void) const
+{
+	return this->haloParticles;
+}
+uint64 SlabSimulation::GetNumMigratedParticles(void) const
+{
+	return this->numMigratedParticles;
+}
+uint64 SlabSimulation::GetIntegrationTime(void) const
+{
+	return this->integrationTime;
+}
+uint64 SlabSimulation::GetExchangeTime(void) const
+{
+	return this->exchangeTime;
+}
+
+bool SlabSimulation::ExchangeWith(uint rank, const std::vector<byte>& sendData)
+{
+	if (!this->pTransport->Exchange(rank, sendData, this->receiveData))
+		return false;
+
+	// a message is the number of migrating particles followed by whole particles, at least that many
+	const size_t receiveSize = this->receiveData.size();
+	if (receiveSize < sizeof(uint64) || (receiveSize - sizeof(uint64)) % sizeof(ParticleSimulation::Particle) != 0)
+	{
+		ERR("Rank %u sent a malformed message of %zu bytes", rank, receiveSize);
+		return false;
+	}
+
+	const size_t numParticles = (receiveSize - sizeof(uint64)) / sizeof(ParticleSimulation::Particle);
+	const ParticleSimulation::Particle* pParticles = reinterpret_cast<const ParticleSimulation::Particle*>(this->receiveData.data() + sizeof(uint64));
+	uint64 numArriving;
+	memcpy(&numArriving, this->receiveData.data(), sizeof(uint64));
+
+	if (numArriving > numParticles)
+	{
+		ERR("Rank %u announced %" PRIu64 " migrating particles but sent %zu", rank, numArriving, numParticles);
+		return false;
+	}
+
+	this->particles.insert(this->particles.end(), pParticles, pParticles + numArriving);
+	this->haloParticles.insert(this->haloParticles.end(), pParticles + numArriving, pParticles + numParticles);
+
+	return true;
+}
@@ -0,0 +1,179 @@
+// EXTERNAL INCLUDES
+#if !defined(_WIN32)
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "sockettransport.h"
+#include "utils.h"
+
+#if !defined(_WIN32)
+
+SocketTransport* SocketTransport::Spawn(uint numRanks)
+{
+	// sockets[a * numRanks + b] is the end of rank a towards rank b
+	std::vector<int> sockets(numRanks * numRanks, -1);
+
+	for (uint a = 0; a < numRanks; a++)
+	{
+		for (uint b = a + 1; b < numRanks; b++)
+		{
+			int pair[2];
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+			{
+				ERR("Could not create the sockets between rank %u and %u", a, b);
+				for (int socket : sockets)
+					if (socket >= 0)
+						close(socket);
+				return nullptr;
+			}
+
+			sockets[a * numRanks + b] = pair[0];
+			sockets[b * numRanks + a] = pair[1];
+		}
+	}
+
+	std::vector<int> processIDs(numRanks, -1);
+	uint rank = 0;
+
+	for (uint child = 1; child < numRanks; child++)
+	{
+		int processID = fork();
+		if (processID == 0)
+		{
+			rank = child;
+			break;
+		}
+		if (processID < 0)
+			ERR("Could not fork rank %u", child);
+
+		processIDs[child] = processID;
+	}
+
+	// every process keeps the ends of its own rank only
+	std::vector<int> ownSockets(numRanks, -1);
+	for (uint a = 0; a < numRanks; a++)
+	{
+		for (uint b = 0; b < numRanks; b++)
+		{
+			int socket = sockets[a * numRanks + b];
+			if (a == rank)
+				ownSockets[b] = socket;
+			else if (socket >= 0)
+				close(socket);
+		}
+	}
+
+	if (rank != 0)
+		processIDs.clear();
+
+	return new SocketTransport(rank, ownSockets, processIDs);
+}
+
+SocketTransport::SocketTransport(uint rank, const std::vector<int>& sockets, const std::vector<int>& processIDs) :
+	rank(rank),
+	sockets(sockets),
+	processIDs(processIDs)
+{
+
+}
+
+SocketTransport::~SocketTransport()
+{
+	for (int socket : this->sockets)
+		if (socket >= 0)
+			close(socket);
+}
+
+bool SocketTransport::WaitForRanks(void)
+{
+	bool succeeded = true;
+
+	for (uint rank = 1; rank < this->processIDs.size(); rank++)
+	{
+		int status = 0;
+		if (this->processIDs[rank] < 0 || waitpid(this->processIDs[rank], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		{
+			WARN("Rank %u failed", rank);
+			succeeded = false;
+		}
+	}
+
+	this->processIDs.clear();
+
+	return succeeded;
+}
+
+uint SocketTransport::GetRank(void) const
+{
+	return this->rank;
+}
+uint SocketTransport::GetNumRanks(void) const
+{
+	return static_cast<uint>(this->sockets.size());
+}
+
+bool SocketTransport::Exchange(uint rank, const std::vector<byte>& sendData, std::vector<byte>& receiveData)
+{
+	const int socket = this->sockets[rank];
+
+	// every message starts with its size
+	uint64 sendSize = sendData.size();
+	uint64 receiveSize = 0;
+	size_t numSent = 0;
+	size_t numReceived = 0;
+	bool hasReceiveSize = false;
+
+	const size_t sendEnd = sizeof(uint64) + sendData.size();
+	auto isReceiving = [&] { return !hasReceiveSize || numReceived < sizeof(uint64) + receiveSize; };
+
+	while (numSent < sendEnd || isReceiving())
+	{
+		pollfd pollSocket = { socket, 0, 0 };
+		pollSocket.events = static_cast<short>(((numSent < sendEnd) ? POLLOUT : 0) | ((isReceiving()) ? POLLIN : 0));
+
+		if (poll(&pollSocket, 1, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		if (pollSocket.revents & POLLOUT)
+		{
+			const byte* pData = (numSent < sizeof(uint64)) ? reinterpret_cast<const byte*>(&sendSize) + numSent : sendData.data() + (numSent - sizeof(uint64));
+			size_t size = (numSent < sizeof(uint64)) ? sizeof(uint64) - numSent : sendEnd - numSent;
+
+			ssize_t result = send(socket, pData, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				return false;
+			if (result > 0)
+				numSent += static_cast<size_t>(result);
+		}
+
+		if (pollSocket.revents & (POLLIN | POLLHUP | POLLERR))
+		{
+			byte* pData = (numReceived < sizeof(uint64)) ? reinterpret_cast<byte*>(&receiveSize) + numReceived : receiveData.data() + (numReceived - sizeof(uint64));
+			size_t size = (numReceived < sizeof(uint64)) ? sizeof(uint64) - numReceived : sizeof(uint64) + receiveSize - numReceived;
+
+			ssize_t result = recv(socket, pData, size, MSG_DONTWAIT);
+			if (result == 0 || (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+				return false;
+			if (result > 0)
+				numReceived += static_cast<size_t>(result);
+
+			if (!hasReceiveSize && numReceived == sizeof(uint64))
+			{
+				receiveData.resize(static_cast<size_t>(receiveSize));
+				hasReceiveSize = true;
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,149 @@
+// EXTERNAL INCLUDES
+#include <cstdio>
+#include <cstring>
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "streamclient.h"
+#include "utils.h"
+
+#if defined(_WIN32)
+typedef SOCKET SocketHandle;
+#define CLOSE_SOCKET closesocket
+#else
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define CLOSE_SOCKET close
+#endif
+
+constexpr uint32 maxMessageSize = 1u << 30;	/**< larger sizes mean the stream is broken */
+
+StreamClient::StreamClient() :
+	socket(static_cast<uint64>(INVALID_SOCKET)),
+	numReceivedBytes(0)
+{
+
+}
+
+StreamClient::~StreamClient()
+{
+	this->Close();
+}
+
+bool StreamClient::Connect(const char* pHost, uint16 port)
+{
+	this->Close();
+
+#if defined(_WIN32)
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+		return false;
+#endif
+
+	char service[8];
+	snprintf(service, sizeof(service), "%u", port);
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* pAddresses = nullptr;
+	if (getaddrinfo(pHost, service, &hints, &pAddresses) != 0)
+	{
+		ERR("Could not resolve %s", pHost);
+		return false;
+	}
+
+	SocketHandle connectedSocket = INVALID_SOCKET;
+	for (addrinfo* pAddress = pAddresses; pAddress && connectedSocket == INVALID_SOCKET; pAddress = pAddress->ai_next)
+	{
+		connectedSocket = ::socket(pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol);
+		if (connectedSocket != INVALID_SOCKET && connect(connectedSocket, pAddress->ai_addr, static_cast<int>(pAddress->ai_addrlen)) != 0)
+		{
+			CLOSE_SOCKET(connectedSocket);
+			connectedSocket = INVALID_SOCKET;
+		}
+	}
+	freeaddrinfo(pAddresses);
+
+	if (connectedSocket == INVALID_SOCKET)
+	{
+		ERR("Could not connect to the stream on %s:%u", pHost, port);
+		return false;
+	}
+
+	this->socket = static_cast<uint64>(connectedSocket);
+	this->decoder = StreamDecoder();
+	this->numReceivedBytes = 0;
+
+	return true;
+}
+
+void StreamClient::Close(void)
+{
+	if (static_cast<SocketHandle>(this->socket) == INVALID_SOCKET)
+		return;
+
+	CLOSE_SOCKET(static_cast<SocketHandle>(this->socket));
+	this->socket = static_cast<uint64>(INVALID_SOCKET);
+
+#if defined(_WIN32)
+	WSACleanup();
+#endif
+}
+
+bool StreamClient::Receive(StreamCodec::FrameHeader& header, std::vector<Math::Vec2>& positions)
+{
+	while (true)
+	{
+		uint32 size = 0;
+		if (!this->ReceiveAll(reinterpret_cast<byte*>(&size), sizeof(size)) || size > maxMessageSize)
+			return false;
+
+		this->message.resize(size);
+		if (!this->ReceiveAll(this->message.data(), size))
+			return false;
+
+		if (!this->decoder.Decode(this->message.data(), size, header, positions))
+		{
+			WARN("Received a broken frame of %u bytes", size);
+			return false;
+		}
+
+		// the hello only sets the decoder up
+		if (header.type != StreamCodec::Hello)
+			return true;
+	}
+}
+
+uint64 StreamClient::GetNumReceivedBytes(void) const
+{
+	return this->numReceivedBytes;
+}
+
+bool StreamClient::ReceiveAll(byte* pData, size_t size)
+{
+	SocketHandle connectedSocket = static_cast<SocketHandle>(this->socket);
+	if (connectedSocket == INVALID_SOCKET)
+		return false;
+
+	size_t numReceived = 0;
+	while (numReceived < size)
+	{
+		int result = recv(connectedSocket, reinterpret_cast<char*>(pData + numReceived), static_cast<int>(size - numReceived), 0);
+		if (result <= 0)
+			return false;
+
+		numReceived += result;
+	}
+
+	this->numReceivedBytes += size;
+	return true;
+}
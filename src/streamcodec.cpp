@@ -0,0 +1,484 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+// INTERNAL INCLUDES
+#include "streamcodec.h"
+
+constexpr uint numSymbols = 18;		/**< the bit lengths of the zigzag coded differences (0 to 17) */
+constexpr uint lengthBits = 5;		/**< the bits of a code length in the table of a frame */
+constexpr size_t predictorSampleSize = 256;		/**< the coordinates in a row the predictors of a delta frame are tried on */
+constexpr size_t predictorSampleStride = 2048;	/**< the distance of two runs of tried coordinates */
+
+/**
+ * @brief	This helper writes bits most significant first
+ */
+class BitWriter
+{
+public:
+
+	BitWriter(std::vector<byte>& bytes) : bytes(bytes), bits(0), numBits(0) { }
+
+	inline void Write(uint32 value, uint numValueBits)
+	{
+		if (numValueBits == 0)
+			return;
+
+		this->bits = (this->bits << numValueBits) | value;
+		this->numBits += numValueBits;
+
+		while (this->numBits >= 8)
+		{
+			this->numBits -= 8;
+			this->bytes.push_back(static_cast<byte>(this->bits >> this->numBits));
+		}
+	}
+	void Flush(void)
+	{
+		if (this->numBits > 0)
+			this->bytes.push_back(static_cast<byte>(this->bits << (8 - this->numBits)));
+		this->numBits = 0;
+	}
+
+private:
+
+	std::vector<byte>& bytes;
+	uint64 bits;
+	uint numBits;
+
+};
+
+/**
+ * @brief	This helper reads bits most significant first
+ */
+class BitReader
+{
+public:
+
+	BitReader(const byte* pData, size_t size) : pData(pData), size(size), position(0) { }
+
+	inline uint32 Read(uint numValueBits)
+	{
+		uint32 value = 0;
+		for (uint i = 0; i < numValueBits; i++)
+			value = (value << 1) | this->ReadBit();
+		return value;
+	}
+	inline uint32 ReadBit(void)
+	{
+		size_t index = this->position >> 3;
+		uint32 bit = (index < this->size) ? (this->pData[index] >> (7 - (this->position & 7))) & 1 : 0;
+		this->position++;
+		return bit;
+	}
+	bool IsOverrun(void) const
+	{
+		return this->position > this->size * 8;
+	}
+
+private:
+
+	const byte* pData;
+	size_t size;
+	size_t position;
+
+};
+
+/**
+ * @brief	This helper calculates the number of significant bits of a value
+ */
+static inline uint BitLength(uint32 value)
+{
+	uint length = 0;
+	while (value >> length)
+		length++;
+	return length;
+}
+
+/**
+ * @brief	This helper calculates Huffman code lengths for the symbol frequencies
+ * 			With 18 symbols no code gets longer than 17 bits.
+ */
+static void BuildCodeLengths(const uint64* pFrequencies, uint8* pLengths)
+{
+	struct Node
+	{
+		uint64 frequency;
+		int parent;
+	};
+
+	Node nodes[2 * numSymbols];
+	int roots[numSymbols];
+	uint numNodes = 0;
+	uint numRoots = 0;
+
+	memset(pLengths, 0, numSymbols);
+	for (uint symbol = 0; symbol < numSymbols; symbol++)
+	{
+		nodes[numNodes] = { pFrequencies[symbol], -1 };
+		if (pFrequencies[symbol] > 0)
+			roots[numRoots++] = static_cast<int>(numNodes);
+		numNodes++;
+	}
+
+	// a single symbol still needs one bit
+	if (numRoots == 1)
+	{
+		pLengths[roots[0]] = 1;
+		return;
+	}
+
+	// merge the two rarest trees until one is left (there are only a few symbols)
+	while (numRoots > 1)
+	{
+		std::sort(roots, roots + numRoots, [&](int lhs, int rhs) { return nodes[lhs].frequency > nodes[rhs].frequency; });
+
+		int rarest = roots[--numRoots];
+		int second = roots[--numRoots];
+		nodes[numNodes] = { nodes[rarest].frequency + nodes[second].frequency, -1 };
+		nodes[rarest].parent = nodes[second].parent = static_cast<int>(numNodes);
+		roots[numRoots++] = static_cast<int>(numNodes);
+		numNodes++;
+	}
+
+	for (uint symbol = 0; symbol < numSymbols; symbol++)
+	{
+		if (pFrequencies[symbol] == 0)
+			continue;
+
+		uint8 length = 0;
+		for (int node = nodes[symbol].parent; node >= 0; node = nodes[node].parent)
+			length++;
+		pLengths[symbol] = length;
+	}
+}
+
+/**
+ * @brief	This helper assigns the canonical codes of the code lengths
+ * 			Shorter codes come first, codes of the same length are ordered by their symbol.
+ */
+static void BuildCodes(const uint8* pLengths, uint32* pCodes)
+{
+	uint32 code = 0;
+	for (uint length = 1; length <= numSymbols; length++)
+	{
+		for (uint symbol = 0; symbol < numSymbols; symbol++)
+		{
+			if (pLengths[symbol] == length)
+				pCodes[symbol] = code++;
+		}
+		code <<= 1;
+	}
+}
+
+/**
+ * @brief	This helper quantizes a coordinate
+ */
+static inline uint16 Quantize(float value, float min, float scale, uint32 maxValue)
+{
+	float quantized = floorf((value - min) * scale + 0.5f);
+	return static_cast<uint16>(std::min(static_cast<float>(maxValue), std::max(0.0f, quantized)));
+}
+
+/**
+ * @brief	This helper calculates the base of a coordinate
+ * @param	last is the coordinate in the last frame
+ * @param	beforeLast is the coordinate in the frame before (the last one again right after a keyframe)
+ */
+static inline int32 PredictBase(StreamCodec::Predictor predictor, uint16 last, uint16 beforeLast, uint32 maxValue)
+{
+	if (predictor == StreamCodec::LastFrame)
+		return last;
+	if (predictor == StreamCodec::Extrapolated)
+		return std::min(static_cast<int32>(maxValue), std::max(0, 2 * static_cast<int32>(last) - static_cast<int32>(beforeLast)));
+
+	return 0;
+}
+
+/**
+ * @brief	This helper predicts a coordinate from its base and the previous particle
+ * 			The prediction stays on the grid, so a difference never needs more bits than a coordinate.
+ * @param	base is the base of the coordinate
+ * @param	previousMiss is how far the previous particle ended up from its base
+ */
+static inline int32 Predict(int32 base, int32 previousMiss, uint32 maxValue)
+{
+	return std::min(static_cast<int32>(maxValue), std::max(0, base + previousMiss));
+}
+
+/**
+ * @brief	This helper zigzag codes a difference, so small differences of both signs get small values
+ */
+static inline uint32 ZigzagCode(int32 difference)
+{
+	return (static_cast<uint32>(difference) << 1) ^ static_cast<uint32>(difference >> 31);
+}
+
+StreamEncoder::StreamEncoder(Math::Vec2 boundsMin, Math::Vec2 boundsMax) :
+	boundsMin(boundsMin),
+	boundsMax(boundsMax),
+	level(0)
+{
+
+}
+
+void StreamEncoder::EncodeHello(std::vector<byte>& frame) const
+{
+	StreamCodec::FrameHeader header = {};
+	header.type = StreamCodec::Hello;
+
+	size_t offset = frame.size();
+	frame.resize(offset + sizeof(header) + 2 * sizeof(Math::Vec2));
+	memcpy(frame.data() + offset, &header, sizeof(header));
+	memcpy(frame.data() + offset + sizeof(header), &this->boundsMin, sizeof(Math::Vec2));
+	memcpy(frame.data() + offset + sizeof(header) + sizeof(Math::Vec2), &this->boundsMax, sizeof(Math::Vec2));
+}
+
+void StreamEncoder::Encode(const Math::Vec2* pPositions, size_t numParticles, uint64 step, uint level, bool keyframe, std::vector<byte>& frame)
+{
+	const StreamCodec::Level& frameLevel = StreamCodec::levels[level];
+	const size_t numSent = StreamCodec::GetNumSentParticles(numParticles, level);
+	const size_t numValues = 2 * numSent;
+	const uint32 maxValue = (1u << frameLevel.bits) - 1;
+	const float scaleX = maxValue / (this->boundsMax.x - this->boundsMin.x);
+	const float scaleY = maxValue / (this->boundsMax.y - this->boundsMin.y);
+
+	// the differences only make sense on the same grid
+	keyframe = keyframe || level != this->level || this->reference.size() != numValues;
+	this->level = level;
+	this->reference.resize(numValues);
+	this->previousReference.resize(numValues);
+	this->values.resize(numValues);
+
+	// quantize the state
+	uint32* pValues = this->values.data();
+	for (size_t i = 0; i < numSent; i++)
+	{
+		const Math::Vec2& position = pPositions[i * frameLevel.stride];
+		pValues[2 * i] = Quantize(position.x, this->boundsMin.x, scaleX, maxValue);
+		pValues[2 * i + 1] = Quantize(position.y, this->boundsMin.y, scaleY, maxValue);
+	}
+
+	// count the differences every predictor leaves in samples, keyframes only have the previous particle
+	const uint numPredictors = (keyframe) ? 1 : StreamCodec::NumPredictors;
+	uint64 frequencies[StreamCodec::NumPredictors][numSymbols] = {};
+	int32 previousMisses[StreamCodec::NumPredictors][2] = {};
+
+	for (size_t sampleBegin = 0; sampleBegin < numValues; sampleBegin += predictorSampleStride)
+	{
+		const size_t sampleEnd = std::min(numValues, sampleBegin + predictorSampleSize);
+		for (size_t index = sampleBegin; index < sampleEnd; index++)
+		{
+			const uint axis = index & 1;
+			const int32 quantized = static_cast<int32>(pValues[index]);
+
+			for (uint predictor = 0; predictor < numPredictors; predictor++)
+			{
+				int32 base = PredictBase(static_cast<StreamCodec::Predictor>(predictor), this->reference[index], this->previousReference[index], maxValue);
+				frequencies[predictor][BitLength(ZigzagCode(quantized - Predict(base, previousMisses[predictor][axis], maxValue)))]++;
+				previousMisses[predictor][axis] = quantized - base;
+			}
+		}
+	}
+
+	// the predictor with the shortest codes and remaining bits wins
+	uint bestPredictor = 0;
+	uint64 bestSize = ~0ull;
+	uint8 lengths[numSymbols];
+	for (uint predictor = 0; predictor < numPredictors; predictor++)
+	{
+		BuildCodeLengths(frequencies[predictor], lengths);
+
+		uint64 size = 0;
+		for (uint symbol = 0; symbol < numSymbols; symbol++)
+			size += frequencies[predictor][symbol] * (lengths[symbol] + ((symbol > 1) ? symbol - 1 : 0));
+
+		if (size < bestSize)
+		{
+			bestPredictor = predictor;
+			bestSize = size;
+		}
+	}
+
+	const StreamCodec::Predictor predictor = static_cast<StreamCodec::Predictor>(bestPredictor);
+	memset(frequencies[bestPredictor], 0, sizeof(frequencies[bestPredictor]));
+
+	int32 previousMiss[2] = { 0, 0 };
+	for (size_t index = 0; index < numValues; index++)
+	{
+		const uint axis = index & 1;
+		const int32 quantized = static_cast<int32>(pValues[index]);
+		int32 base = PredictBase(predictor, this->reference[index], this->previousReference[index], maxValue);
+
+		pValues[index] = ZigzagCode(quantized - Predict(base, previousMiss[axis], maxValue));
+		previousMiss[axis] = quantized - base;
+		frequencies[bestPredictor][BitLength(pValues[index])]++;
+
+		// right after a keyframe the particles are expected to stay
+		this->previousReference[index] = (keyframe) ? static_cast<uint16>(quantized) : this->reference[index];
+		this->reference[index] = static_cast<uint16>(quantized);
+	}
+
+	uint32 codes[numSymbols] = {};
+	BuildCodeLengths(frequencies[bestPredictor], lengths);
+	BuildCodes(lengths, codes);
+
+	StreamCodec::FrameHeader header = {};
+	header.type = (keyframe) ? StreamCodec::Keyframe : StreamCodec::DeltaFrame;
+	header.level = static_cast<uint8>(level);
+	header.predictor = predictor;
+	header.numParticles = static_cast<uint32>(numParticles);
+	header.step = step;
+
+	size_t offset = frame.size();
+	frame.resize(offset + sizeof(header));
+	memcpy(frame.data() + offset, &header, sizeof(header));
+
+	// the code table, then every value as its bit length code and the bits below its leading one
+	BitWriter writer(frame);
+	for (uint symbol = 0; symbol < numSymbols; symbol++)
+		writer.Write(lengths[symbol], lengthBits);
+
+	for (size_t i = 0; i < numValues; i++)
+	{
+		uint32 value = this->values[i];
+		uint length = BitLength(value);
+
+		writer.Write(codes[length], lengths[length]);
+		if (length > 1)
+			writer.Write(value & ((1u << (length - 1)) - 1), length - 1);
+	}
+
+	writer.Flush();
+}
+
+void StreamEncoder::Reset(void)
+{
+	this->reference.clear();
+	this->previousReference.clear();
+}
+
+StreamDecoder::StreamDecoder() :
+	boundsMin(Math::Vec2::zero),
+	boundsMax(Math::Vec2::zero),
+	hasBounds(false),
+	level(0)
+{
+
+}
+
+bool StreamDecoder::Decode(const byte* pData, size_t size, StreamCodec::FrameHeader& header, std::vector<Math::Vec2>& positions)
+{
+	if (size < sizeof(header))
+		return false;
+
+	memcpy(&header, pData, sizeof(header));
+	pData += sizeof(header);
+	size -= sizeof(header);
+
+	if (header.type == StreamCodec::Hello)
+	{
+		if (size < 2 * sizeof(Math::Vec2))
+			return false;
+
+		memcpy(&this->boundsMin, pData, sizeof(Math::Vec2));
+		memcpy(&this->boundsMax, pData + sizeof(Math::Vec2), sizeof(Math::Vec2));
+		this->hasBounds = true;
+		this->reference.clear();
+		this->previousReference.clear();
+		positions.clear();
+		return true;
+	}
+
+	if (!this->hasBounds || header.level >= StreamCodec::numLevels || (header.type != StreamCodec::Keyframe && header.type != StreamCodec::DeltaFrame))
+		return false;
+
+	const StreamCodec::Level& frameLevel = StreamCodec::levels[header.level];
+	const size_t numSent = StreamCodec::GetNumSentParticles(header.numParticles, header.level);
+	const size_t numValues = 2 * numSent;
+	const bool keyframe = (header.type == StreamCodec::Keyframe);
+
+	if (!keyframe && (header.level != this->level || this->reference.size() != numValues))
+		return false;
+	if (header.predictor >= ((keyframe) ? 1 : StreamCodec::NumPredictors))
+		return false;
+
+	this->level = header.level;
+	this->reference.resize(numValues);
+	this->previousReference.resize(numValues);
+
+	// rebuild the canonical codes from the code lengths
+	BitReader reader(pData, size);
+	uint8 lengths[numSymbols];
+	for (uint symbol = 0; symbol < numSymbols; symbol++)
+		lengths[symbol] = static_cast<uint8>(reader.Read(lengthBits));
+
+	uint32 firstCodes[numSymbols + 1] = {};
+	uint32 numCodes[numSymbols + 1] = {};
+	uint32 firstIndices[numSymbols + 1] = {};
+	uint8 sortedSymbols[numSymbols];
+	uint numSorted = 0;
+	uint32 code = 0;
+
+	for (uint length = 1; length <= numSymbols; length++)
+	{
+		firstCodes[length] = code;
+		firstIndices[length] = numSorted;
+		for (uint symbol = 0; symbol < numSymbols; symbol++)
+		{
+			if (lengths[symbol] == length)
+			{
+				sortedSymbols[numSorted++] = static_cast<uint8>(symbol);
+				numCodes[length]++;
+			}
+		}
+		code = (code + numCodes[length]) << 1;
+	}
+
+	const uint32 maxValue = (1u << frameLevel.bits) - 1;
+	const Math::Vec2 step = { (this->boundsMax.x - this->boundsMin.x) / maxValue, (this->boundsMax.y - this->boundsMin.y) / maxValue };
+	const StreamCodec::Predictor predictor = static_cast<StreamCodec::Predictor>(header.predictor);
+	int32 previousMiss[2] = { 0, 0 };
+
+	positions.resize(numSent);
+	for (size_t i = 0; i < numValues; i++)
+	{
+		// walk down the code lengths until the code is complete
+		uint32 symbolCode = 0;
+		uint length = 0;
+		int symbol = -1;
+		while (symbol < 0 && length < numSymbols)
+		{
+			length++;
+			symbolCode = (symbolCode << 1) | reader.ReadBit();
+			if (symbolCode - firstCodes[length] < numCodes[length])
+				symbol = sortedSymbols[firstIndices[length] + symbolCode - firstCodes[length]];
+		}
+
+		if (symbol < 0 || reader.IsOverrun())
+			return false;
+
+		uint32 value = (symbol > 1) ? (1u << (symbol - 1)) | reader.Read(symbol - 1) : static_cast<uint32>(symbol);
+		int32 difference = static_cast<int32>(value >> 1) ^ -static_cast<int32>(value & 1);
+
+		const uint axis = i & 1;
+		int32 base = PredictBase(predictor, this->reference[i], this->previousReference[i], maxValue);
+		int32 quantized = Predict(base, previousMiss[axis], maxValue) + difference;
+
+		// a broken frame could leave the grid
+		if (quantized < 0 || quantized > static_cast<int32>(maxValue))
+			return false;
+
+		previousMiss[axis] = quantized - base;
+		this->previousReference[i] = (keyframe) ? static_cast<uint16>(quantized) : this->reference[i];
+		this->reference[i] = static_cast<uint16>(quantized);
+	}
+
+	if (reader.IsOverrun())
+		return false;
+
+	for (size_t i = 0; i < numSent; i++)
+		positions[i] = { this->boundsMin.x + this->reference[2 * i] * step.x, this->boundsMin.y + this->reference[2 * i + 1] * step.y };
+
+	return true;
+}
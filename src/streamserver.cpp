@@ -0,0 +1,316 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "streamserver.h"
+#include "utils.h"
+
+#if defined(_WIN32)
+typedef SOCKET SocketHandle;
+#define CLOSE_SOCKET closesocket
+#define POLL_SOCKETS WSAPoll
+#define SEND_FLAGS 0
+#else
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define CLOSE_SOCKET close
+#define POLL_SOCKETS poll
+#define SEND_FLAGS MSG_NOSIGNAL	/**< a viewer that hangs up must not kill the process */
+#endif
+
+constexpr int pollTimeout = 5;					/**< how often the server checks for new frames (milliseconds) */
+constexpr double maxBurst = 0.25;				/**< a client saves up at most this many seconds of its budget */
+
+StreamServer::StreamServer() :
+	listenSocket(static_cast<uint64>(INVALID_SOCKET)),
+	isRunning(false),
+	numClients(0),
+	numFrames(0),
+	numDroppedFrames(0),
+	numFrameBytes(0),
+	numFrameParticles(0),
+	encodeTime(0)
+{
+
+}
+
+StreamServer::~StreamServer()
+{
+	this->Stop();
+}
+
+bool StreamServer::Start(uint16 port, const Settings& settings)
+{
+#if defined(_WIN32)
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+		return false;
+#endif
+
+	SocketHandle listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSocket == INVALID_SOCKET)
+		return false;
+
+	int reuse = 1;
+	setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+	// the viewers are remote
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenSocket, 8) != 0)
+	{
+		ERR("Could not listen for viewers on port %u", port);
+		CLOSE_SOCKET(listenSocket);
+		return false;
+	}
+
+	LOG("Streaming particle states on port %u", port);
+
+	this->settings = settings;
+	this->listenSocket = static_cast<uint64>(listenSocket);
+	this->isRunning.store(true, std::memory_order_relaxed);
+	this->thread = std::thread(&StreamServer::Run, this);
+
+	return true;
+}
+
+void StreamServer::Stop(void)
+{
+	if (!this->thread.joinable())
+		return;
+
+	this->isRunning.store(false, std::memory_order_relaxed);
+	this->thread.join();
+
+	for (Client& client : this->clients)
+		CLOSE_SOCKET(static_cast<SocketHandle>(client.socket));
+	this->clients.clear();
+	this->numClients.store(0, std::memory_order_relaxed);
+
+	CLOSE_SOCKET(static_cast<SocketHandle>(this->listenSocket));
+	this->listenSocket = static_cast<uint64>(INVALID_SOCKET);
+
+#if defined(_WIN32)
+	WSACleanup();
+#endif
+}
+
+void StreamServer::Publish(const ParticleSimulation::Particle* pParticles, const uint32* pParticleIDs, size_t numParticles, uint64 step)
+{
+	if (this->numClients.load(std::memory_order_relaxed) == 0)
+		return;
+
+	Frame& frame = this->frames.GetBackBuffer();
+	frame.positions.resize(numParticles);
+	frame.step = step;
+
+	Math::Vec2* pPositions = frame.positions.data();
+	for (size_t i = 0; i < numParticles; i++)
+		pPositions[pParticleIDs[i]] = pParticles[i].nextPosition;
+
+	this->frames.Publish();
+}
+
+uint64 StreamServer::GetNumClients(void) const
+{
+	return this->numClients.load(std::memory_order_relaxed);
+}
+uint64 StreamServer::GetNumFrames(void) const
+{
+	return this->numFrames.load(std::memory_order_relaxed);
+}
+uint64 StreamServer::GetNumDroppedFrames(void) const
+{
+	return this->numDroppedFrames.load(std::memory_order_relaxed);
+}
+uint64 StreamServer::GetNumFrameBytes(void) const
+{
+	return this->numFrameBytes.load(std::memory_order_relaxed);
+}
+uint64 StreamServer::GetNumFrameParticles(void) const
+{
+	return this->numFrameParticles.load(std::memory_order_relaxed);
+}
+uint64 StreamServer::GetEncodeTime(void) const
+{
+	return this->encodeTime.load(std::memory_order_relaxed);
+}
+
+void StreamServer::Run(void)
+{
+	std::vector<pollfd> polls;
+	uint64 lastFrameTime = Time::Now();
+
+	while (this->isRunning.load(std::memory_order_relaxed))
+	{
+		// wait for viewers, for sockets that can take more data or until the next frame may be there
+		polls.resize(1 + this->clients.size());
+		polls[0].fd = static_cast<SocketHandle>(this->listenSocket);
+		polls[0].events = POLLIN;
+		polls[0].revents = 0;
+
+		for (size_t i = 0; i < this->clients.size(); i++)
+		{
+			polls[i + 1].fd = static_cast<SocketHandle>(this->clients[i].socket);
+			polls[i + 1].events = (this->clients[i].pending.empty()) ? POLLIN : POLLIN | POLLOUT;
+			polls[i + 1].revents = 0;
+		}
+
+		POLL_SOCKETS(polls.data(), static_cast<uint>(polls.size()), pollTimeout);
+
+		// viewers never send anything, readable means they hung up
+		for (size_t i = this->clients.size(); i > 0; i--)
+		{
+			Client& client = this->clients[i - 1];
+			bool hungUp = (polls[i].revents & (POLLERR | POLLHUP)) != 0;
+
+			if (polls[i].revents & POLLIN)
+			{
+				char buffer[64];
+				hungUp = hungUp || recv(static_cast<SocketHandle>(client.socket), buffer, sizeof(buffer), 0) <= 0;
+			}
+
+			if (hungUp || !this->Flush(client))
+			{
+				CLOSE_SOCKET(static_cast<SocketHandle>(client.socket));
+				this->clients.erase(this->clients.begin() + (i - 1));
+			}
+		}
+
+		if (polls[0].revents & POLLIN)
+			this->Accept();
+
+		this->numClients.store(this->clients.size(), std::memory_order_relaxed);
+
+		if (!this->frames.Acquire())
+			continue;
+
+		// every client saves up its budget between the frames
+		uint64 now = Time::Now();
+		double budget = this->settings.bytesPerSecond * (now - lastFrameTime) / 1000000.0;
+		lastFrameTime = now;
+
+		const Frame& frame = this->frames.GetFrontBuffer();
+		for (Client& client : this->clients)
+		{
+			client.budget = std::min(client.budget + budget, this->settings.bytesPerSecond * maxBurst);
+			this->Encode(client, frame);
+		}
+	}
+}
+
+void StreamServer::Accept(void)
+{
+	SocketHandle clientSocket = accept(static_cast<SocketHandle>(this->listenSocket), nullptr, nullptr);
+	if (clientSocket == INVALID_SOCKET)
+		return;
+
+	// a slow viewer must never block the others
+#if defined(_WIN32)
+	u_long nonBlocking = 1;
+	ioctlsocket(clientSocket, FIONBIO, &nonBlocking);
+#else
+	fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	int noDelay = 1;
+	setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+	Client client = { static_cast<uint64>(clientSocket), StreamEncoder(this->settings.boundsMin, this->settings.boundsMax), {}, 0, 0.0, 0, 0, 0 };
+	client.budget = this->settings.bytesPerSecond * maxBurst;
+
+	// the viewer learns the quantization grid first
+	std::vector<byte> hello;
+	client.encoder.EncodeHello(hello);
+
+	uint32 size = static_cast<uint32>(hello.size());
+	client.pending.resize(sizeof(size));
+	memcpy(client.pending.data(), &size, sizeof(size));
+	client.pending.insert(client.pending.end(), hello.begin(), hello.end());
+
+	LOG("Viewer connected to the stream");
+	this->clients.push_back(std::move(client));
+}
+
+void StreamServer::Encode(Client& client, const Frame& frame)
+{
+	// a client that is behind or over its budget skips the frame and gets coarser frames
+	if (!client.pending.empty() || client.budget < 0.0)
+	{
+		client.level = std::min(client.level + 1, StreamCodec::numLevels - 1);
+		client.numDeliveredFrames = 0;
+		this->numDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	// and finer frames once it kept up for a while
+	if (++client.numDeliveredFrames >= this->settings.numUpgradeFrames && client.level > 0)
+	{
+		client.level--;
+		client.numDeliveredFrames = 0;
+	}
+
+	bool keyframe = ++client.numDeltaFrames >= this->settings.keyframeInterval;
+	if (keyframe)
+		client.numDeltaFrames = 0;
+
+	uint64 startTime = Time::Now();
+
+	// the size is filled in once the frame is encoded
+	uint32 size = 0;
+	client.pending.resize(sizeof(size));
+	client.encoder.Encode(frame.positions.data(), frame.positions.size(), frame.step, client.level, keyframe, client.pending);
+	size = static_cast<uint32>(client.pending.size() - sizeof(size));
+	memcpy(client.pending.data(), &size, sizeof(size));
+
+	this->encodeTime.fetch_add(Time::Now() - startTime, std::memory_order_relaxed);
+	this->numFrames.fetch_add(1, std::memory_order_relaxed);
+	this->numFrameBytes.fetch_add(client.pending.size(), std::memory_order_relaxed);
+	this->numFrameParticles.fetch_add(frame.positions.size(), std::memory_order_relaxed);
+
+	client.budget -= static_cast<double>(client.pending.size());
+	this->Flush(client);
+}
+
+bool StreamServer::Flush(Client& client)
+{
+	SocketHandle socket = static_cast<SocketHandle>(client.socket);
+
+	while (client.numPendingSent < client.pending.size())
+	{
+		int result = send(socket, reinterpret_cast<const char*>(client.pending.data() + client.numPendingSent),
+			static_cast<int>(client.pending.size() - client.numPendingSent), SEND_FLAGS);
+
+		if (result <= 0)
+		{
+			// a full socket buffer is drained later
+#if defined(_WIN32)
+			return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+			return result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+		}
+
+		client.numPendingSent += result;
+	}
+
+	client.pending.clear();
+	client.numPendingSent = 0;
+	return true;
+}
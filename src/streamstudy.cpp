@@ -0,0 +1,126 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "particlesimulation.h"
+#include "streamcodec.h"
+#include "streamserver.h"
+#include "streamstudy.h"
+#include "threadpool.h"
+#include "utils.h"
+
+constexpr uint numWarmupSteps = 30;	/**< the steps before the first state, the particles leave their start grid */
+
+/**
+ * @brief	This struct defines the coded frames of a level
+ */
+struct LevelResult
+{
+	uint64 keyframeBytes;
+	uint64 deltaBytes;		/**< the bytes of all delta frames */
+	uint64 encodeTime;		/**< the time of all frames in microseconds */
+	uint64 decodeTime;
+	float maxError;			/**< the largest distance of a decoded coordinate to its position, in grid cells */
+	bool isDecoded;			/**< every frame could be decoded */
+};
+
+bool StreamStudy::Run(size_t numParticles, uint numFrames)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	numFrames = std::max(numFrames, 2u);
+	bool succeeded = true;
+
+	ParticleSimulation simulation(numParticles, &threadPool);
+	if (!simulation.SetupParticles())
+		return false;
+	for (uint step = 0; step < numWarmupSteps; step++)
+		simulation.Step(Time::maxTimeStep);
+
+	// the states in id order, like the stream server hands them to its encoders
+	std::vector<std::vector<Math::Vec2>> states(numFrames, std::vector<Math::Vec2>(numParticles));
+	for (uint frame = 0; frame < numFrames; frame++)
+	{
+		simulation.Step(Time::maxTimeStep);
+
+		const ParticleSimulation::Particle* pParticles = simulation.GetParticles();
+		const uint32* pParticleIDs = simulation.GetParticleIDs();
+		for (size_t i = 0; i < numParticles; i++)
+			states[frame][pParticleIDs[i]] = pParticles[i].nextPosition;
+	}
+
+	// the grid of the stream server
+	const StreamServer::Settings serverSettings;
+	const Math::Vec2 boundsMin = serverSettings.boundsMin;
+	const Math::Vec2 boundsMax = serverSettings.boundsMax;
+
+	printf("%u states of %zu particles, %.0f bytes of raw positions per state\n", numFrames, numParticles, 8.0 * numParticles);
+	printf("%6s %5s %7s %15s %15s %13s %11s %11s %11s\n", "level", "bits", "stride", "keyframe bytes", "delta bytes", "bits/particle", "encode ms", "decode ms",
+		"max error");
+
+	std::vector<byte> message;
+	std::vector<Math::Vec2> positions;
+	for (uint level = 0; level < StreamCodec::numLevels; level++)
+	{
+		const StreamCodec::Level& codecLevel = StreamCodec::levels[level];
+		const float maxValue = static_cast<float>((1u << codecLevel.bits) - 1);
+		const Math::Vec2 cellSize = { (boundsMax.x - boundsMin.x) / maxValue, (boundsMax.y - boundsMin.y) / maxValue };
+
+		StreamEncoder encoder(boundsMin, boundsMax);
+		StreamDecoder decoder;
+		StreamCodec::FrameHeader header;
+		LevelResult result = { 0, 0, 0, 0, 0.0f, true };
+
+		message.clear();
+		encoder.EncodeHello(message);
+		result.isDecoded = decoder.Decode(message.data(), message.size(), header, positions);
+
+		for (uint frame = 0; frame < numFrames && result.isDecoded; frame++)
+		{
+			const std::vector<Math::Vec2>& state = states[frame];
+
+			message.clear();
+			uint64 startTime = Time::Now();
+			encoder.Encode(state.data(), numParticles, frame, level, frame == 0, message);
+			result.encodeTime += Time::Now() - startTime;
+			((frame == 0) ? result.keyframeBytes : result.deltaBytes) += message.size();
+
+			startTime = Time::Now();
+			result.isDecoded = decoder.Decode(message.data(), message.size(), header, positions) && positions.size() == StreamCodec::GetNumSentParticles(numParticles, level);
+			result.decodeTime += Time::Now() - startTime;
+
+			// the positions outside the grid are clamped onto its border
+			for (size_t i = 0; i < positions.size() && result.isDecoded; i++)
+			{
+				const Math::Vec2& position = state[i * codecLevel.stride];
+				float errorX = fabsf(positions[i].x - std::min(boundsMax.x, std::max(boundsMin.x, position.x))) / cellSize.x;
+				float errorY = fabsf(positions[i].y - std::min(boundsMax.y, std::max(boundsMin.y, position.y))) / cellSize.y;
+				result.maxError = std::max(result.maxError, std::max(errorX, errorY));
+			}
+		}
+
+		const double meanDeltaBytes = static_cast<double>(result.deltaBytes) / (numFrames - 1);
+		printf("%6u %5u %7u %15" PRIu64 " %15.0f %13.2f %11.3f %11.3f %11.3f\n", level, codecLevel.bits, codecLevel.stride, result.keyframeBytes, meanDeltaBytes,
+			8.0 * meanDeltaBytes / numParticles, result.encodeTime / (1000.0 * numFrames), result.decodeTime / (1000.0 * numFrames), result.maxError);
+
+		if (!result.isDecoded)
+		{
+			ERR("A frame of level %u can't be decoded", level);
+			succeeded = false;
+		}
+		// rounding onto the grid is off by half a cell at most, the float math of the finest grid adds a little
+		if (result.maxError > 0.51f)
+		{
+			ERR("The positions of level %u are decoded %.3f grid cells away from the state", level, result.maxError);
+			succeeded = false;
+		}
+	}
+
+	printf("bits/particle are of the delta frames over all particles of a state, the max error is in grid cells\n");
+
+	return succeeded;
+}
@@ -0,0 +1,40 @@
+// EXTERNAL INCLUDES
+#include <cstring>
+// INTERNAL INCLUDES
+#include "stubshadercompiler.h"
+#include "utils.h"
+
+StubShaderCompiler::StubShaderCompiler() :
+	numCompiles(0)
+{
+
+}
+
+const char* StubShaderCompiler::GetVersion(void) const
+{
+	return "stub-1";
+}
+
+bool StubShaderCompiler::Compile(const std::string& source, [[maybe_unused]] const char* pFileName, const char* pEntryPoint, const char* pShaderModel, uint32 flags, std::vector<byte>& bytecode)
+{
+	this->numCompiles++;
+
+	if (source.find(pEntryPoint) == std::string::npos)
+	{
+		LOG("%s: entry point %s not found", pFileName, pEntryPoint);
+		return false;
+	}
+
+	bytecode.clear();
+	bytecode.insert(bytecode.end(), pEntryPoint, pEntryPoint + strlen(pEntryPoint) + 1);
+	bytecode.insert(bytecode.end(), pShaderModel, pShaderModel + strlen(pShaderModel) + 1);
+	bytecode.insert(bytecode.end(), reinterpret_cast<const byte*>(&flags), reinterpret_cast<const byte*>(&flags) + sizeof(flags));
+	bytecode.insert(bytecode.end(), source.begin(), source.end());
+
+	return true;
+}
+
+uint StubShaderCompiler::GetNumCompiles(void) const
+{
+	return this->numCompiles;
+}
@@ -0,0 +1,167 @@
+// EXTERNAL INCLUDES
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+// INTERNAL INCLUDES
+#include "checkpointstudy.h"
+#include "computestudy.h"
+#include "constraintstudy.h"
+#include "diagnosticsstudy.h"
+#include "dimensionstudy.h"
+#include "governorstudy.h"
+#include "integratorstudy.h"
+#include "logger.h"
+#include "loggerstudy.h"
+#include "npyexport.h"
+#include "numastudy.h"
+#include "obstaclestudy.h"
+#include "pagestudy.h"
+#include "precisionstudy.h"
+#include "scalingstudy.h"
+#include "segmentstudy.h"
+#include "shadercachestudy.h"
+#include "sharedstatestudy.h"
+#include "streamstudy.h"
+#include "studies.h"
+#include "timestepstudy.h"
+#include "types.h"
+#include "worldstudy.h"
+
+/**
+ * @brief	This struct defines the arguments that follow the flag of a study
+ */
+struct StudyArguments
+{
+	int argc;
+	char** argv;
+
+	const char* GetString(int index) const
+	{
+		return (index + 2 < this->argc) ? this->argv[index + 2] : nullptr;
+	}
+	size_t GetSize(int index, size_t defaultValue) const
+	{
+		return (index + 2 < this->argc) ? static_cast<size_t>(atoll(this->argv[index + 2])) : defaultValue;
+	}
+	uint GetUInt(int index, uint defaultValue) const
+	{
+		return (index + 2 < this->argc) ? static_cast<uint>(atoi(this->argv[index + 2])) : defaultValue;
+	}
+	float GetFloat(int index, float defaultValue) const
+	{
+		return (index + 2 < this->argc) ? static_cast<float>(atof(this->argv[index + 2])) : defaultValue;
+	}
+};
+
+/**
+ * @brief	This struct defines a study of the table
+ */
+struct Study
+{
+	const char* pFlag;
+	const char* pArguments;		/**< <required> and [optional] arguments */
+	const char* pDescription;
+	int numRequiredArguments;
+	bool (*pRun)(const StudyArguments& arguments);
+};
+
+static const Study studies[] = {
+#if !defined(_WIN32)
+	// the ranks are forked, no thread may exist before it runs
+	{ "--scaling", "[ranks=4] [particles=50000] [steps=300]", "measures the scaling of the slab decomposition over processes", 0, [](const StudyArguments& arguments) {
+		return ScalingStudy::Run(arguments.GetUInt(0, 4), arguments.GetSize(1, 50000), arguments.GetUInt(2, 300)); } },
+#endif
+	{ "--sharedstate", "[particles=10000000] [frames=200] [slots=4]", "measures publishing into the shared memory ring and reading from it", 0, [](const StudyArguments& arguments) {
+		return SharedStateStudy::Run(arguments.GetSize(0, 10000000), arguments.GetUInt(1, 200), arguments.GetUInt(2, 4)); } },
+	{ "--stream", "[particles=250000] [frames=120]", "measures the codec the states are streamed in", 0, [](const StudyArguments& arguments) {
+		return StreamStudy::Run(arguments.GetSize(0, 250000), arguments.GetUInt(1, 120)); } },
+	{ "--checkpoints", "[particles=1000000] [steps=600] [interval=60]", "measures the checkpoint codec", 0, [](const StudyArguments& arguments) {
+		return CheckpointStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 600), arguments.GetUInt(2, 60)); } },
+	{ "--export", "<path> [particles=1000000] [steps=60]", "writes a simulated state as NumPy arrays (a .npz bundle or a directory of .npy files)", 1, [](const StudyArguments& arguments) {
+		return NpyExport::Run(arguments.GetString(0), arguments.GetSize(1, 1000000), arguments.GetUInt(2, 60)); } },
+	{ "--numa", "[particles=4000000] [steps=60]", "compares the throughput of pinned and unpinned threads on every NUMA node", 0, [](const StudyArguments& arguments) {
+		return NumaStudy::Run(arguments.GetSize(0, 4000000), arguments.GetUInt(1, 60)); } },
+	{ "--pages", "[particles=4000000] [steps=60]", "compares small and huge pages backing the particle memory", 0, [](const StudyArguments& arguments) {
+		return PageStudy::Run(arguments.GetSize(0, 4000000), arguments.GetUInt(1, 60)); } },
+	{ "--precision", "[particles=1000000] [steps=200] [orbit steps=10000000]", "compares the precisions of the integration", 0, [](const StudyArguments& arguments) {
+		return PrecisionStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 200), arguments.GetUInt(2, 10000000)); } },
+	{ "--integrators", "[particles=1000000] [steps=60] [orbits=10]", "compares the cost and the accuracy of the integrators", 0, [](const StudyArguments& arguments) {
+		return IntegratorStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 60), arguments.GetUInt(2, 10)); } },
+	{ "--shadercache", "[shaders=bin] [rounds=100]", "loads the shaders through the shader cache and the stub compiler, cold and warm", 0, [](const StudyArguments& arguments) {
+		const char* pShaderDirectory = arguments.GetString(0);
+		return ShaderCacheStudy::Run((pShaderDirectory) ? pShaderDirectory : "bin", arguments.GetUInt(1, 100)); } },
+	{ "--diagnostics", "[particles=1000000] [steps=60]", "measures the cost of the per-step diagnostics", 0, [](const StudyArguments& arguments) {
+		return DiagnosticsStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 60)); } },
+	{ "--dimensions", "[particles=1000000] [steps=200]", "compares the 2D and the 3D simulation", 0, [](const StudyArguments& arguments) {
+		DimensionStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 200));
+		return true; } },
+	{ "--worlds", "[systems=1024] [particles=1000000] [steps=60]", "compares stepping many systems in one pass with one by one", 0, [](const StudyArguments& arguments) {
+		return WorldStudy::Run(arguments.GetSize(0, 1024), arguments.GetSize(1, 1000000), arguments.GetUInt(2, 60)); } },
+	{ "--compute", "[particles=50000] [steps=200]", "runs the compute shaders on the CPU dispatcher", 0, [](const StudyArguments& arguments) {
+		return ComputeStudy::Run(arguments.GetSize(0, 50000), arguments.GetUInt(1, 200)); } },
+	{ "--constraints", "[particles=1000000] [iterations=10] [steps=30]", "measures the distance constraint solvers", 0, [](const StudyArguments& arguments) {
+		return ConstraintStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 10), arguments.GetUInt(2, 30)); } },
+	{ "--obstacles", "[particles=1000000] [steps=120]", "compares the baked obstacle field with testing every shape", 0, [](const StudyArguments& arguments) {
+		return ObstacleStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 120)); } },
+	{ "--walls", "[particles=1000000] [steps=120]", "measures the swept collision with walls in a bounding volume hierarchy", 0, [](const StudyArguments& arguments) {
+		return SegmentStudy::Run(arguments.GetSize(0, 1000000), arguments.GetUInt(1, 120)); } },
+	{ "--logger", "[calls=100000]", "measures the cost of a log call next to the former synchronous macros", 0, [](const StudyArguments& arguments) {
+		return LoggerStudy::Run(arguments.GetUInt(0, 100000)); } },
+	{ "--governor", "[particles=250000] [frames=3600]", "runs the frame governor against a synthetic load", 0, [](const StudyArguments& arguments) {
+		return GovernorStudy::Run(arguments.GetSize(0, 250000), arguments.GetUInt(1, 3600)); } },
+	{ "--timesteps", "[particles=100000] [seconds=0.5]", "compares the steps of the adaptive timestep with fixed timesteps", 0, [](const StudyArguments& arguments) {
+		return TimestepStudy::Run(arguments.GetSize(0, 100000), arguments.GetFloat(1, 0.5f)); } },
+};
+
+bool Studies::Run(int argc, char** argv, int& exitCode)
+{
+	if (argc < 2)
+		return false;
+
+	if (strcmp(argv[1], "--help") == 0)
+	{
+		PrintUsage();
+		exitCode = 0;
+
+		return true;
+	}
+
+	for (const Study& study : studies)
+	{
+		if (strcmp(argv[1], study.pFlag) != 0)
+			continue;
+
+		if (argc - 2 < study.numRequiredArguments)
+		{
+			printf("usage: %s %s %s\n", argv[0], study.pFlag, study.pArguments);
+			exitCode = 1;
+
+			return true;
+		}
+
+		bool succeeded = study.pRun({ argc, argv });
+		Logger::Flush();
+		exitCode = (succeeded) ? 0 : 1;
+
+		return true;
+	}
+
+	// any other flag is a typo, not a run time
+	if (strncmp(argv[1], "--", 2) == 0)
+	{
+		printf("unknown study %s\n", argv[1]);
+		PrintUsage();
+		exitCode = 1;
+
+		return true;
+	}
+
+	return false;
+}
+
+void Studies::PrintUsage(void)
+{
+	printf("studies:\n");
+	for (const Study& study : studies)
+		printf("  %s %s\n      %s\n", study.pFlag, study.pArguments, study.pDescription);
+}
@@ -0,0 +1,174 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "threadpool.h"
+#include "topology.h"
+#include "utils.h"
+
+ThreadPool::ThreadPool(uint numThreads, bool pinThreads) :
+	areThreadsPinned(pinThreads),
+	pTask(nullptr),
+	generation(0),
+	numPending(0),
+	isStopping(false)
+{
+	std::vector<Topology::NumaNode> nodes = Topology::GetNumaNodes();
+
+	// the processors node by node, so consecutive threads share a node
+	std::vector<uint> processors;
+	std::vector<uint> processorNodes;
+	for (const Topology::NumaNode& node : nodes)
+	{
+		processors.insert(processors.end(), node.processors.begin(), node.processors.end());
+		processorNodes.insert(processorNodes.end(), node.processors.size(), node.index);
+	}
+
+	if (numThreads == 0)
+		numThreads = (pinThreads) ? static_cast<uint>(processors.size()) : std::max(1u, std::thread::hardware_concurrency());
+
+	this->threadStats.resize(numThreads, ThreadStats{ 0, 0 });
+	this->threadNodes.resize(numThreads, nodes.front().index);
+
+	if (pinThreads)
+	{
+		if (numThreads > processors.size())
+			WARN("%u threads share %zu processors", numThreads, processors.size());
+
+		// every thread is a pinned worker
+		for (uint i = 0; i < numThreads; i++)
+		{
+			this->threadNodes[i] = processorNodes[i % processors.size()];
+			this->workers.emplace_back(&ThreadPool::Work, this, i, processors[i % processors.size()]);
+		}
+	}
+	else
+	{
+		// the calling thread is thread 0
+		for (uint i = 1; i < numThreads; i++)
+			this->workers.emplace_back(&ThreadPool::Work, this, i, 0u);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->isStopping = true;
+	}
+	this->wakeCondition.notify_all();
+
+	for (std::thread& worker : this->workers)
+		worker.join();
+}
+
+uint ThreadPool::GetNumThreads(void) const
+{
+	return static_cast<uint>(this->threadStats.size());
+}
+bool ThreadPool::AreThreadsPinned(void) const
+{
+	return this->areThreadsPinned;
+}
+uint ThreadPool::GetThreadNode(uint threadIndex) const
+{
+	return this->threadNodes[threadIndex];
+}
+uint64 ThreadPool::GetBusyTime(uint threadIndex) const
+{
+	return this->threadStats[threadIndex].busyTime;
+}
+uint64 ThreadPool::GetNumProcessedElements(uint threadIndex) const
+{
+	return this->threadStats[threadIndex].numElements;
+}
+
+void ThreadPool::Dispatch(const std::function<void(uint)>& task)
+{
+	// nothing to wake up
+	if (this->workers.empty())
+	{
+		this->RunTask(task, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->pTask = &task;
+		this->numPending = static_cast<uint>(this->workers.size());
+		this->generation++;
+	}
+	this->wakeCondition.notify_all();
+
+	// take part in the work (pinned pools leave it to the workers)
+	if (!this->areThreadsPinned)
+		this->RunTask(task, 0);
+
+	// wait until every worker finished its part
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->doneCondition.wait(lock, [this] { return this->numPending == 0; });
+	this->pTask = nullptr;
+}
+
+void ThreadPool::GetRange(size_t count, uint numThreads, uint threadIndex, size_t& begin, size_t& end)
+{
+	begin = (count * threadIndex) / numThreads;
+	end = (count * (threadIndex + 1)) / numThreads;
+}
+
+void ThreadPool::GetDispatchRange(size_t count, size_t capacity, uint threadIndex, size_t& begin, size_t& end) const
+{
+	// only a pinned thread stays where it touched its part first
+	if (!this->areThreadsPinned || capacity < count)
+	{
+		GetRange(count, this->GetNumThreads(), threadIndex, begin, end);
+		return;
+	}
+
+	GetRange(capacity, this->GetNumThreads(), threadIndex, begin, end);
+	begin = std::min(begin, count);
+	end = std::min(end, count);
+}
+
+void ThreadPool::RunTask(const std::function<void(uint)>& task, uint threadIndex)
+{
+	uint64 startTime = Time::Now();
+	task(threadIndex);
+	this->threadStats[threadIndex].busyTime += Time::Now() - startTime;
+}
+
+void ThreadPool::Work(uint threadIndex, uint processor)
+{
+	uint64 lastGeneration = 0;
+
+	if (this->areThreadsPinned && !Topology::PinCurrentThread(processor))
+		WARN("Could not pin thread %u to processor %u", threadIndex, processor);
+
+	while (true)
+	{
+		const std::function<void(uint)>* pTask;
+
+		// wait for the next dispatch
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->wakeCondition.wait(lock, [&] { return this->isStopping || this->generation != lastGeneration; });
+
+			if (this->isStopping)
+				return;
+
+			lastGeneration = this->generation;
+			pTask = this->pTask;
+		}
+
+		this->RunTask(*pTask, threadIndex);
+
+		// the last worker wakes the dispatching thread
+		bool isLast;
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			isLast = (--this->numPending == 0);
+		}
+		if (isLast)
+			this->doneCondition.notify_one();
+	}
+}
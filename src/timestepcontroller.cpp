@@ -0,0 +1,27 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+// INTERNAL INCLUDES
+#include "timestepcontroller.h"
+
+TimestepController::TimestepController(const Settings& settings) :
+	settings(settings),
+	lastTimestep(settings.minTimestep)
+{
+
+}
+
+float TimestepController::NextTimestep(float estimatedTimestep)
+{
+	// grow slowly so one calm step doesn't jump into a large error,
+	// but shrink immediately when the estimate demands it
+	float timestep = std::min(estimatedTimestep, this->lastTimestep * this->settings.maxGrowth);
+	timestep = std::max(this->settings.minTimestep, std::min(timestep, this->settings.maxTimestep));
+
+	this->lastTimestep = timestep;
+	return timestep;
+}
+
+const TimestepController::Settings& TimestepController::GetSettings(void) const
+{
+	return this->settings;
+}
@@ -0,0 +1,197 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "particlesimulation.h"
+#include "threadpool.h"
+#include "timestepcontroller.h"
+#include "timestepstudy.h"
+#include "utils.h"
+
+/**
+ * @brief	This struct defines a run over the simulated time
+ */
+struct TimestepRun
+{
+	float accuracy;		/**< the accuracy of the adaptive timestep (0 for a fixed timestep) */
+	uint numTimeBins;	/**< the block timesteps of the run */
+	float timestep;		/**< the fixed timestep (the mean timestep of adaptive runs) */
+	uint numSteps;
+	uint64 numUpdates;	/**< the particle updates of all steps and substeps */
+	double time;		/**< the wall clock time of the steps and the estimates in milliseconds */
+	double rmsError;	/**< the root mean square distance to the reference positions */
+	double maxError;	/**< the largest distance to a reference position */
+};
+
+/**
+ * @brief	This helper simulates the duration with a fixed or the adaptive timestep and block timesteps
+ * 			The last step is cut short, so every run ends at the same time.
+ * @param	positions are the returned positions, indexed by the particle IDs
+ */
+static TimestepRun Simulate(ThreadPool& threadPool, size_t numParticles, double duration, float fixedTimestep, uint numTimeBins,
+	const TimestepController::Settings& settings, std::vector<Math::Vec2>& positions)
+{
+	ParticleSimulation simulation(numParticles, &threadPool);
+	simulation.SetTimeBins(numTimeBins, settings.accuracy, settings.softening);
+	if (fixedTimestep <= 0.0f)
+		simulation.SetTimestepEstimate(settings.accuracy, settings.softening);
+	TimestepController controller(settings);
+	TimestepRun run = { (fixedTimestep > 0.0f) ? 0.0f : settings.accuracy, numTimeBins, fixedTimestep, 0, 0, 0.0, 0.0, 0.0 };
+
+	// a run without particles ends nowhere
+	if (!simulation.SetupParticles())
+	{
+		positions.assign(numParticles, Math::Vec2{ NAN, NAN });
+		return run;
+	}
+
+	double simulatedTime = 0.0;
+	uint64 startTime = Time::Now();
+	while (duration - simulatedTime > 1e-7)
+	{
+		float timestep = (fixedTimestep > 0.0f) ? fixedTimestep : controller.NextTimestep(simulation.EstimateTimestep(settings.accuracy, settings.softening));
+		timestep = static_cast<float>(std::min<double>(timestep, duration - simulatedTime));
+
+		simulation.Step(timestep);
+		simulatedTime += timestep;
+		run.numSteps++;
+	}
+	run.time = (Time::Now() - startTime) / 1000.0;
+	run.timestep = static_cast<float>(duration / run.numSteps);
+	run.numUpdates = simulation.GetNumParticleUpdates();
+
+	const ParticleSimulation::Particle* pParticles = simulation.GetParticles();
+	const uint32* pParticleIDs = simulation.GetParticleIDs();
+	positions.resize(numParticles);
+	for (size_t i = 0; i < numParticles; i++)
+		positions[pParticleIDs[i]] = pParticles[i].nextPosition;
+
+	return run;
+}
+
+/**
+ * @brief	This helper measures how far the positions of a run are from the reference positions
+ */
+static void MeasureError(ThreadPool& threadPool, const std::vector<Math::Vec2>& positions, const std::vector<Math::Vec2>& referencePositions, TimestepRun& run)
+{
+	struct Error { double sum2; double max; };
+
+	Error error = threadPool.ParallelReduce(positions.size(), Error{ 0.0, 0.0 }, [&](size_t begin, size_t end) {
+		Error partial = { 0.0, 0.0 };
+		for (size_t i = begin; i < end; i++)
+		{
+			double distance = Math::Distance(positions[i], referencePositions[i]);
+			partial.sum2 += distance * distance;
+			partial.max = (std::isfinite(distance)) ? std::max(partial.max, distance) : INFINITY;
+		}
+		return partial;
+	}, [](Error lhs, Error rhs) { return Error{ lhs.sum2 + rhs.sum2, std::max(lhs.max, rhs.max) }; });
+
+	run.rmsError = sqrt(error.sum2 / static_cast<double>(positions.size()));
+	run.maxError = error.max;
+}
+
+/**
+ * @brief	This helper prints a run next to the fixed timestep that ends as close to the reference with the fewest updates
+ * @return	const TimestepRun* is that fixed timestep (nullptr if none ends as close)
+ */
+static const TimestepRun* PrintRun(const TimestepRun& run, const std::vector<TimestepRun>& fixedRuns)
+{
+	const TimestepRun* pFixedRun = nullptr;
+	for (const TimestepRun& fixedRun : fixedRuns)
+	{
+		if (fixedRun.rmsError <= run.rmsError && (!pFixedRun || fixedRun.numUpdates < pFixedRun->numUpdates))
+			pFixedRun = &fixedRun;
+	}
+
+	char accuracy[16] = "-", fixedUpdates[32] = "-";
+	if (run.accuracy > 0.0f)
+		snprintf(accuracy, sizeof(accuracy), "%.3f", run.accuracy);
+	if (pFixedRun && pFixedRun != &run)
+		snprintf(fixedUpdates, sizeof(fixedUpdates), "%.1f (%.1f ms)", pFixedRun->numUpdates / 1000000.0, pFixedRun->time);
+
+	printf("%-9s %5u %9s %7u %10.1f %11.3f %10.1f %11.3e %11.3e %21s\n", (run.accuracy > 0.0f) ? "adaptive" : "fixed", run.numTimeBins, accuracy, run.numSteps,
+		run.numUpdates / 1000000.0, run.timestep * 1000.0f, run.time, run.rmsError, run.maxError, fixedUpdates);
+
+	return pFixedRun;
+}
+
+bool TimestepStudy::Run(size_t numParticles, float duration)
+{
+	ThreadPool threadPool;
+	numParticles = std::max<size_t>(numParticles, 1);
+	duration = std::max(duration, Time::maxTimeStep);
+	bool succeeded = true;
+
+	const TimestepController::Settings defaultSettings;
+	const uint numTimeBins = 4;
+	std::vector<Math::Vec2> referencePositions, positions;
+
+	// the reference is well below anything the controller picks
+	const float referenceTimestep = defaultSettings.minTimestep / 4.0f;
+	TimestepRun reference = Simulate(threadPool, numParticles, duration, referenceTimestep, 0, defaultSettings, referencePositions);
+
+	printf("%zu particles over %.2f s, reference %u steps of %.3f ms, %u threads\n", numParticles, duration, reference.numSteps, referenceTimestep * 1000.0f,
+		threadPool.GetNumThreads());
+	printf("%-9s %5s %9s %7s %10s %11s %10s %11s %11s %21s\n", "timestep", "bins", "accuracy", "steps", "updates M", "mean dt ms", "time ms", "rms error", "max error",
+		"fixed updates M (ms)");
+
+	// every fixed timestep halves the former, down to the smallest the controller may pick
+	std::vector<TimestepRun> fixedRuns;
+	for (float timestep = defaultSettings.maxTimestep; timestep >= defaultSettings.minTimestep * 0.99f; timestep *= 0.5f)
+	{
+		TimestepRun run = Simulate(threadPool, numParticles, duration, timestep, 0, defaultSettings, positions);
+		MeasureError(threadPool, positions, referencePositions, run);
+		fixedRuns.push_back(run);
+	}
+	for (const TimestepRun& run : fixedRuns)
+		PrintRun(run, {});
+
+	std::vector<TimestepRun> runs;
+	const float accuracies[] = { 0.4f, 0.2f, defaultSettings.accuracy, 0.05f, 0.025f };
+	for (float accuracy : accuracies)
+	{
+		TimestepController::Settings settings = defaultSettings;
+		settings.accuracy = accuracy;
+		runs.push_back(Simulate(threadPool, numParticles, duration, 0.0f, 0, settings, positions));
+		MeasureError(threadPool, positions, referencePositions, runs.back());
+	}
+
+	// the block timesteps at the fixed and at the adaptive timestep of the application
+	runs.push_back(Simulate(threadPool, numParticles, duration, Time::maxTimeStep, numTimeBins, defaultSettings, positions));
+	MeasureError(threadPool, positions, referencePositions, runs.back());
+	runs.push_back(Simulate(threadPool, numParticles, duration, 0.0f, numTimeBins, defaultSettings, positions));
+	MeasureError(threadPool, positions, referencePositions, runs.back());
+
+	for (const TimestepRun& run : runs)
+	{
+		const TimestepRun* pFixedRun = PrintRun(run, fixedRuns);
+
+		if (!std::isfinite(run.maxError))
+		{
+			ERR("The run with an accuracy of %f and %u time bins ends at positions that aren't finite", run.accuracy, run.numTimeBins);
+			succeeded = false;
+		}
+		if (run.accuracy == defaultSettings.accuracy && pFixedRun && pFixedRun->numUpdates < run.numUpdates)
+		{
+			ERR("The adaptive timestep with %u time bins takes %" PRIu64 " updates, a fixed timestep ends as close in %" PRIu64, run.numTimeBins, run.numUpdates,
+				pFixedRun->numUpdates);
+			succeeded = false;
+		}
+	}
+
+	for (const TimestepRun& fixedRun : fixedRuns)
+	{
+		if (!std::isfinite(fixedRun.maxError))
+		{
+			ERR("The fixed timestep of %f s ends at positions that aren't finite", fixedRun.timestep);
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
@@ -0,0 +1,158 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <thread>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cstdio>
+#include <pthread.h>
+#include <sched.h>
+#endif
+// INTERNAL INCLUDES
+#include "topology.h"
+
+#if !defined(_WIN32)
+/**
+ * @brief	This helper parses a kernel list like "0-3,8-11"
+ */
+static std::vector<uint> ParseList(const char* pList)
+{
+	std::vector<uint> processors;
+	uint first, last;
+	int numChars;
+
+	while (sscanf(pList, "%u%n", &first, &numChars) == 1)
+	{
+		pList += numChars;
+		last = first;
+
+		if (*pList == '-' && sscanf(pList + 1, "%u%n", &last, &numChars) == 1)
+			pList += numChars + 1;
+
+		for (uint processor = first; processor <= last; processor++)
+			processors.push_back(processor);
+
+		if (*pList != ',')
+			break;
+		pList++;
+	}
+
+	return processors;
+}
+#endif
+
+std::vector<Topology::NumaNode> Topology::GetNumaNodes(void)
+{
+	std::vector<NumaNode> nodes;
+
+#if defined(_WIN32)
+	ULONG highestNode = 0;
+	if (GetNumaHighestNodeNumber(&highestNode))
+	{
+		for (USHORT node = 0; node <= highestNode; node++)
+		{
+			GROUP_AFFINITY affinity = {};
+			if (!GetNumaNodeProcessorMaskEx(node, &affinity))
+				continue;
+
+			NumaNode numaNode = { node, {} };
+			for (uint bit = 0; bit < 64; bit++)
+			{
+				if (affinity.Mask & (KAFFINITY(1) << bit))
+					numaNode.processors.push_back(affinity.Group * 64 + bit);
+			}
+
+			if (!numaNode.processors.empty())
+				nodes.push_back(numaNode);
+		}
+	}
+#else
+	// only the processors the process may run on (containers, taskset)
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	bool hasAffinity = (sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+
+	std::vector<uint> onlineNodes;
+	if (FILE* pOnline = fopen("/sys/devices/system/node/online", "r"))
+	{
+		char list[4096] = {};
+		if (fgets(list, sizeof(list), pOnline))
+			onlineNodes = ParseList(list);
+		fclose(pOnline);
+	}
+
+	for (uint node : onlineNodes)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+
+		FILE* pFile = fopen(path, "r");
+		if (!pFile)
+			continue;
+
+		char list[4096] = {};
+		bool hasList = (fgets(list, sizeof(list), pFile) != nullptr);
+		fclose(pFile);
+
+		if (!hasList)
+			continue;
+
+		NumaNode numaNode = { node, {} };
+		for (uint processor : ParseList(list))
+		{
+			if (!hasAffinity || (processor < CPU_SETSIZE && CPU_ISSET(processor, &allowed)))
+				numaNode.processors.push_back(processor);
+		}
+
+		if (!numaNode.processors.empty())
+			nodes.push_back(numaNode);
+	}
+#endif
+
+	// no NUMA information, treat the machine as one node
+	if (nodes.empty())
+	{
+		NumaNode numaNode = { 0, {} };
+
+#if !defined(_WIN32)
+		if (hasAffinity)
+		{
+			for (uint processor = 0; processor < CPU_SETSIZE; processor++)
+			{
+				if (CPU_ISSET(processor, &allowed))
+					numaNode.processors.push_back(processor);
+			}
+		}
+#endif
+		if (numaNode.processors.empty())
+		{
+			uint numProcessors = std::max(1u, std::thread::hardware_concurrency());
+			for (uint processor = 0; processor < numProcessors; processor++)
+				numaNode.processors.push_back(processor);
+		}
+
+		nodes.push_back(numaNode);
+	}
+
+	return nodes;
+}
+
+bool Topology::PinCurrentThread(uint processor)
+{
+#if defined(_WIN32)
+	GROUP_AFFINITY affinity = {};
+	affinity.Group = static_cast<WORD>(processor / 64);
+	affinity.Mask = KAFFINITY(1) << (processor % 64);
+
+	return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#else
+	if (processor >= CPU_SETSIZE)
+		return false;
+
+	cpu_set_t processors;
+	CPU_ZERO(&processors);
+	CPU_SET(processor, &processors);
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(processors), &processors) == 0;
+#endif
+}
@@ -3,25 +3,40 @@
 #include <Windows.h>
 #include <Windowsx.h>
 // INTERNAL INCLUDES
+#include "deltatime.h"
 #include "inputevent.h"
 #include "utils.h"
 #include "window.h"
 
-// Reference Callbacks here
-extern MouseClickedScreenSpaceCallback OnMouseClickedScreenSpace;
-extern UpArrowPressedCallback OnUpArrowPressed;
-extern DownArrowPressedCallback OnDownArrowPressed;
-extern RightArrowPressedCallback OnRightArrowPressed;
-extern LeftArrowPressedCallback OnLeftArrowPressed;
+/**
+ * @brief	This helper pushes an input event into the queue of a window
+ * 			The event is timestamped with the current time.
+ * @param	pWindow is the window that received the input
+ * @param	type is the kind of input that was received
+ * @param	position is the screen space position of mouse events
+ */
+static void PushInputEvent(Window* pWindow, InputEvent::Type type, Math::Vec2 position = Math::Vec2::zero)
+{
+	InputEvent event = { type, Time::Now(), position };
 
-// Screen resolution for the mouse position callback
-float gScreenWidth;
-float gScreenHeight;
+	if (!pWindow->GetInputEvents().Push(event))
+		WARN("Input event queue is full, dropping event (%u)", static_cast<uint>(type));
+}
 
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
+	// The window object is attached to the handle on creation
+	Window* pWindow = reinterpret_cast<Window*>(GetWindowLongPtrA(hWnd, GWLP_USERDATA));
+
 	switch (message)
 	{
+		case WM_NCCREATE:
+		{
+			// Attach the window object that was passed to CreateWindowExA
+			CREATESTRUCTA* pCreateStruct = reinterpret_cast<CREATESTRUCTA*>(lParam);
+			SetWindowLongPtrA(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(pCreateStruct->lpCreateParams));
+			break;
+		}
 		case WM_DESTROY:
 		{
 			PostQuitMessage(0);
@@ -29,45 +44,47 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPara
 		}
 		case WM_LBUTTONDOWN:
 		{
+			if (!pWindow)
+				break;
+
 			// Get Mouse parameters
 			int xPos = GET_X_LPARAM(lParam);
 			int yPos = GET_Y_LPARAM(lParam);
+			Math::Vec2 resolution = pWindow->GetResolution();
 			
 			// Calculate Imagespace to Screenspace
 			Math::Vec2 screenSpacePos = {
-				(((float)xPos / gScreenWidth) - 0.5f) * 2.0f,
-				-(((float)yPos / gScreenHeight) - 0.5f) * 2.0f
+				(((float)xPos / resolution.x) - 0.5f) * 2.0f,
+				-(((float)yPos / resolution.y) - 0.5f) * 2.0f
 			};
 
 			// Left Mouse Pressed
-			if (OnMouseClickedScreenSpace)
-				(*OnMouseClickedScreenSpace)(screenSpacePos);
+			PushInputEvent(pWindow, InputEvent::MouseClickedScreenSpace, screenSpacePos);
 
 			break;
 		}
 		case WM_KEYDOWN:
 		{
+			if (!pWindow)
+				break;
+
 			switch (wParam)
 			{
 			case VK_UP:
 				// Up Arrow Pressed
-				if (OnUpArrowPressed)
-					(*OnUpArrowPressed)();
+				PushInputEvent(pWindow, InputEvent::UpArrowPressed);
 				break;
 			case VK_DOWN:
 				// Down Arrow Pressed
-				if (OnDownArrowPressed)
-					(*OnDownArrowPressed)();
+				PushInputEvent(pWindow, InputEvent::DownArrowPressed);
 				break;
 			case VK_RIGHT:
 				// Right Arrow Pressed
-				if (OnRightArrowPressed)
-					(*OnRightArrowPressed)();
+				PushInputEvent(pWindow, InputEvent::RightArrowPressed);
 				break;
 			case VK_LEFT:
 				// Left Arrow Pressed
-				if (OnLeftArrowPressed)
-					(*OnLeftArrowPressed)();
+				PushInputEvent(pWindow, InputEvent::LeftArrowPressed);
 				break;
 			}
 			break;
@@ -82,6 +99,7 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPara
 
 Window::Window(const char* title, Math::Vec2 resolution) :
 	handle(0),
+	resolution(resolution),
 	isClosed(true)
 {
 	// Just initialize here
@@ -100,9 +118,8 @@ void Window::Initialize(const char* title, Math::Vec2 res)
 		rect.top + static_cast<int>(res.y)
 	};
 
-	// Store the resolution in globals
-	gScreenWidth = res.x;
-	gScreenHeight = res.y;
+	// Store the resolution for the mouse position
+	this->resolution = res;
 
 	// Define the window style
 	uint windowStyle = WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX | WS_CLIPCHILDREN | WS_CLIPSIBLINGS;
@@ -141,7 +158,7 @@ void Window::Initialize(const char* title, Math::Vec2 res)
 		rect.bottom - rect.top,
 		NULL, NULL,
 		wc.hInstance,
-		NULL
+		this
 	));
 
 	// Did it work? Do we have a handle?
@@ -175,4 +192,12 @@ void Window::PumpMessages()
 uint64 Window::GetHandle(void) const
 {
 	return this->handle;
+}
+InputEventQueue& Window::GetInputEvents(void)
+{
+	return this->inputEvents;
+}
+Math::Vec2 Window::GetResolution(void) const
+{
+	return this->resolution;
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+// EXTERNAL INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+// INTERNAL INCLUDES
+#include "deltatime.h"
+#include "particleworld.h"
+#include "threadpool.h"
+#include "utils.h"
+#include "worldstudy.h"
+
+constexpr uint numRounds = 3;	/**< both ways are measured this many times, the fastest run counts */
+
+/**
+ * @brief	This helper creates the settings of the systems
+ * 			Every system gets between half and one and a half times the mean
+ * 			number of particles and an attractor and a pull of its own.
+ */
+static std::vector<ParticleWorld::SystemSettings> CreateSystems(size_t numSystems, size_t numParticles)
+{
+	std::vector<ParticleWorld::SystemSettings> systems(numSystems);
+	const size_t meanParticles = std::max<size_t>(numParticles / numSystems, 1);
+	size_t numAssigned = 0;
+
+	for (size_t i = 0; i < numSystems; i++)
+	{
+		ParticleWorld::SystemSettings& settings = systems[i];
+		settings.numParticles = meanParticles / 2 + (meanParticles * ((i * 37) % numSystems)) / numSystems;
+		settings.origin = { static_cast<float>(i % 16) - 7.5f, static_cast<float>(i / 16 % 16) - 7.5f };
+		settings.size = 0.5f;
+		settings.gravitySource = { settings.origin.x + 0.1f, settings.origin.y };
+		settings.gravityStrength = 5.0f + static_cast<float>(i % 7);
+		settings.damping = 0.9948f;
+		numAssigned += settings.numParticles;
+	}
+
+	// the last system takes what the others left over
+	systems.back().numParticles += (numAssigned < numParticles) ? numParticles - numAssigned : 0;
+
+	return systems;
+}
+
+/**
+ * @brief	This helper steps all systems in one world, every step is one parallel pass
+ * @param	world is the world the systems are added to
+ * @return	double is the time per particle and step in nanoseconds
+ */
+static double MeasureBatched(ParticleWorld& world, const std::vector<ParticleWorld::SystemSettings>& systems, uint numSteps)
+{
+	for (const ParticleWorld::SystemSettings& settings : systems)
+	{
+		if (world.AddSystem(settings) == ParticleWorld::invalidSystem)
+			return NAN;
+	}
+
+	uint64 startTime = Time::Now();
+	for (uint step = 0; step < numSteps; step++)
+		world.Step(Time::maxTimeStep);
+
+	return (Time::Now() - startTime) * 1000.0 / (static_cast<double>(world.GetNumParticles()) * numSteps);
+}
+
+/**
+ * @brief	This helper steps every system in a world of its own, every step is one parallel pass per system
+ * @param	worlds are the returned worlds, one per system
+ * @return	double is the time per particle and step in nanoseconds
+ */
+static double MeasurePerSystem(ThreadPool& threadPool, std::vector<ParticleWorld*>& worlds, const std::vector<ParticleWorld::SystemSettings>& systems, uint numSteps)
+{
+	size_t numParticles = 0;
+	for (const ParticleWorld::SystemSettings& settings : systems)
+	{
+		worlds.push_back(new ParticleWorld(settings.numParticles, &threadPool));
+		if (worlds.back()->AddSystem(settings) == ParticleWorld::invalidSystem)
+			return NAN;
+		numParticles += settings.numParticles;
+	}
+
+	uint64 startTime = Time::Now();
+	for (uint step = 0; step < numSteps; step++)
+	{
+		for (ParticleWorld* pWorld : worlds)
+			pWorld->Step(Time::maxTimeStep);
+	}
+
+	return (Time::Now() - startTime) * 1000.0 / (static_cast<double>(numParticles) * numSteps);
+}
+
+bool WorldStudy::Run(size_t numSystems, size_t numParticles, uint numSteps)
+{
+	ThreadPool threadPool;
+	numSystems = std::max<size_t>(numSystems, 1);
+	numParticles = std::max(numParticles, numSystems);
+	numSteps = std::max(numSteps, 1u);
+	bool succeeded = true;
+
+	printf("Position Verlet of %zu particles in up to %zu systems for %u steps, %u threads\n", numParticles, numSystems, numSteps, threadPool.GetNumThreads());
+	printf("%8s %18s %12s %16s %9s\n", "systems", "particles/system", "batched ns", "per system ns", "speedup");
+
+	for (size_t count = 1; ; count = std::min(count * 4, numSystems))
+	{
+		const std::vector<ParticleWorld::SystemSettings> systems = CreateSystems(count, numParticles);
+		size_t numWorldParticles = 0;
+		for (const ParticleWorld::SystemSettings& settings : systems)
+			numWorldParticles += settings.numParticles;
+		double batchedTime = 0.0, perSystemTime = 0.0;
+
+		for (uint round = 0; round < numRounds; round++)
+		{
+			ParticleWorld world(numWorldParticles, &threadPool);
+			std::vector<ParticleWorld*> worlds;
+
+			double time = MeasureBatched(world, systems, numSteps);
+			batchedTime = (round == 0) ? time : std::min(batchedTime, time);
+			time = MeasurePerSystem(threadPool, worlds, systems, numSteps);
+			perSystemTime = (round == 0) ? time : std::min(perSystemTime, time);
+
+			// the batched pass switches the constants where a thread crosses into the next system, the particles move the same
+			for (size_t i = 0; i < count && round == 0; i++)
+			{
+				size_t numBatched = 0, numAlone = 0;
+				const ParticleWorld::Particle* pBatched = world.GetParticles(static_cast<ParticleWorld::SystemID>(i), numBatched);
+				const ParticleWorld::Particle* pAlone = worlds[i]->GetParticles(0, numAlone);
+
+				if (numBatched != numAlone || memcmp(pBatched, pAlone, sizeof(ParticleWorld::Particle) * numBatched) != 0)
+				{
+					ERR("System %zu of %zu ends elsewhere when it is stepped with the others", i, count);
+					succeeded = false;
+					break;
+				}
+			}
+
+			for (ParticleWorld* pWorld : worlds)
+				SAFE_DELETE(pWorld);
+		}
+
+		printf("%8zu %18zu %12.3f %16.3f %8.2fx\n", count, numWorldParticles / count, batchedTime, perSystemTime, perSystemTime / batchedTime);
+
+		if (count == numSystems)
+			break;
+	}
+
+	return succeeded;
+}